@@ -0,0 +1,214 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "leveldb/env.h"
+#include "util/coding.h"
+#include "util/random.h"
+
+// Multi-threaded block cache microbenchmark.  Every thread runs a mix of
+// lookups and inserts over a shared key space against each cache type in
+// turn, and the aggregate throughput is reported.
+//
+// Example:
+//   ./cache_bench --threads=16 --cache_type=lru,clock
+
+// Comma-separated list of cache implementations to compare.
+static const char* FLAGS_cache_type = "lru,clock";
+
+// Number of concurrent threads to run.
+static int FLAGS_threads = 8;
+
+// Number of distinct keys accessed.
+static int FLAGS_num_keys = 1000000;
+
+// Number of operations done by each thread.
+static int FLAGS_ops_per_thread = 1000000;
+
+// Percentage of operations that are lookups; a lookup miss inserts the key.
+static int FLAGS_lookup_percent = 90;
+
+// Charge of each entry, in bytes.
+static int FLAGS_value_size = 4096;
+
+// Cache capacity in bytes.
+static long long FLAGS_cache_size = 1024LL * 1024 * 1024;
+
+// Number of shards as a power of two for the clock cache.  Negative means
+// pick a default based on the cache size.
+static int FLAGS_num_shard_bits = -1;
+
+// Fraction of operations that go to the hottest 1% of the keys.
+static int FLAGS_hot_percent = 0;
+
+// Percentage of operations that read keys never seen before, like a
+// long scan does.
+static int FLAGS_scan_percent = 0;
+
+// If true, build the caches with a TinyLFU admission filter.
+static bool FLAGS_admission_filter = false;
+
+namespace leveldb {
+
+namespace {
+
+void NoopDeleter(const Slice& key, void* value) {}
+
+Cache* NewCache(const std::string& type) {
+  CacheOptions options;
+  options.capacity = FLAGS_cache_size;
+  options.admission_filter = FLAGS_admission_filter;
+  options.estimated_entry_charge = FLAGS_value_size;
+  options.num_shard_bits = FLAGS_num_shard_bits;
+  if (type == "lru") {
+    return NewLRUCache(options);
+  } else if (type == "clock") {
+    return NewClockCache(options);
+  }
+  return nullptr;
+}
+
+struct ThreadResult {
+  long long hits = 0;
+  long long misses = 0;
+};
+
+void Worker(Cache* cache, int tid, ThreadResult* result) {
+  Random rnd(1000 + tid);
+  char key[8];
+  const int hot_keys = FLAGS_num_keys / 100 > 0 ? FLAGS_num_keys / 100 : 1;
+  // Scanned keys lie above the regular key space and are never repeated.
+  uint64_t next_scan_key = FLAGS_num_keys + (uint64_t{1} << 40) * (tid + 1);
+  for (int i = 0; i < FLAGS_ops_per_thread; i++) {
+    uint64_t k;
+    if (FLAGS_scan_percent > 0 &&
+        static_cast<int>(rnd.Uniform(100)) < FLAGS_scan_percent) {
+      k = next_scan_key++;
+    } else if (FLAGS_hot_percent > 0 &&
+               static_cast<int>(rnd.Uniform(100)) < FLAGS_hot_percent) {
+      k = rnd.Uniform(hot_keys);
+    } else {
+      k = rnd.Uniform(FLAGS_num_keys);
+    }
+    EncodeFixed64(key, k);
+    const Slice skey(key, sizeof(key));
+    if (static_cast<int>(rnd.Uniform(100)) < FLAGS_lookup_percent) {
+      Cache::Handle* h = cache->Lookup(skey);
+      if (h != nullptr) {
+        result->hits++;
+        cache->Release(h);
+        continue;
+      }
+      result->misses++;
+    }
+    cache->Release(cache->Insert(skey, nullptr, FLAGS_value_size,
+                                 &NoopDeleter));
+  }
+}
+
+void Run(const std::string& type) {
+  Cache* cache = NewCache(type);
+  if (cache == nullptr) {
+    std::fprintf(stderr, "unknown cache type '%s'\n", type.c_str());
+    std::exit(1);
+  }
+
+  // Warm up so that lookups do not start from an empty cache.
+  char key[8];
+  for (int k = 0; k < FLAGS_num_keys; k++) {
+    EncodeFixed64(key, k);
+    cache->Release(cache->Insert(Slice(key, sizeof(key)), nullptr,
+                                 FLAGS_value_size, &NoopDeleter));
+  }
+
+  std::vector<ThreadResult> results(FLAGS_threads);
+  std::vector<std::thread> threads;
+  const uint64_t start = Env::Default()->NowMicros();
+  for (int t = 0; t < FLAGS_threads; t++) {
+    threads.emplace_back(Worker, cache, t, &results[t]);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const uint64_t elapsed = Env::Default()->NowMicros() - start;
+
+  long long hits = 0, misses = 0;
+  for (const ThreadResult& r : results) {
+    hits += r.hits;
+    misses += r.misses;
+  }
+  const double ops = static_cast<double>(FLAGS_threads) * FLAGS_ops_per_thread;
+  const double secs = elapsed * 1e-6;
+  std::fprintf(stdout,
+               "%-6s : %11.3f micros/op; %12.0f ops/sec; hit rate %5.1f%%; "
+               "usage %zu\n",
+               type.c_str(), elapsed * FLAGS_threads / ops, ops / secs,
+               hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0,
+               cache->TotalCharge());
+  delete cache;
+}
+
+}  // namespace
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    int n;
+    long long ll;
+    char junk;
+    if (std::strncmp(argv[i], "--cache_type=", 13) == 0) {
+      FLAGS_cache_type = argv[i] + 13;
+    } else if (sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_threads = n;
+    } else if (sscanf(argv[i], "--num_keys=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_num_keys = n;
+    } else if (sscanf(argv[i], "--ops_per_thread=%d%c", &n, &junk) == 1) {
+      FLAGS_ops_per_thread = n;
+    } else if (sscanf(argv[i], "--lookup_percent=%d%c", &n, &junk) == 1) {
+      FLAGS_lookup_percent = n;
+    } else if (sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1 &&
+               n > 0) {
+      FLAGS_value_size = n;
+    } else if (sscanf(argv[i], "--cache_size=%lld%c", &ll, &junk) == 1) {
+      FLAGS_cache_size = ll;
+    } else if (sscanf(argv[i], "--num_shard_bits=%d%c", &n, &junk) == 1) {
+      FLAGS_num_shard_bits = n;
+    } else if (sscanf(argv[i], "--hot_percent=%d%c", &n, &junk) == 1) {
+      FLAGS_hot_percent = n;
+    } else if (sscanf(argv[i], "--scan_percent=%d%c", &n, &junk) == 1) {
+      FLAGS_scan_percent = n;
+    } else if (sscanf(argv[i], "--admission_filter=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_admission_filter = n;
+    } else {
+      std::fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+      std::exit(1);
+    }
+  }
+
+  std::fprintf(stdout,
+               "Threads: %d  Keys: %d  Ops/thread: %d  Lookups: %d%%  "
+               "Cache: %lld bytes\n",
+               FLAGS_threads, FLAGS_num_keys, FLAGS_ops_per_thread,
+               FLAGS_lookup_percent, FLAGS_cache_size);
+  std::string types = FLAGS_cache_type;
+  size_t pos = 0;
+  while (pos <= types.size()) {
+    size_t comma = types.find(',', pos);
+    if (comma == std::string::npos) comma = types.size();
+    if (comma > pos) {
+      leveldb::Run(types.substr(pos, comma - pos));
+    }
+    pos = comma + 1;
+  }
+  return 0;
+}
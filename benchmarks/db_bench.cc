@@ -4,17 +4,27 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
+#include "db/filename.h"
 #include "leveldb/cache.h"
 #include "leveldb/comparator.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/merge_operator.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/statistics.h"
 #include "leveldb/write_batch.h"
+#include "nvm_mod/nvm_secondary_cache.h"
 #include "port/port.h"
+#include "util/coding.h"
 #include "util/crc32c.h"
 #include "util/histogram.h"
 #include "util/mutexlock.h"
@@ -32,6 +42,7 @@
 //      fill100K      -- write N/1000 100K values in random order in async mode
 //      deleteseq     -- delete N keys in sequential order
 //      deleterandom  -- delete N keys in random order
+//      mergerandom   -- add 1 to N random 64-bit counters with Merge()
 //      readseq       -- read N times sequentially
 //      readreverse   -- read N times in reverse order
 //      readrandom    -- read N times in random order
@@ -41,6 +52,20 @@
 //      seekordered   -- N ordered seeks
 //      open          -- cost of opening a DB
 //      crc32c        -- repeated crc32c of 4K of data
+//      multireadrandom -- read N random block-sized ranges of the table
+//                         files with MultiRead, --multiread_batch_size at
+//                         a time (1 issues one Read per range)
+//      ycsba ... ycsbf -- the YCSB core workloads, N operations each, run
+//                         against keys loaded by a preceding fillseq:
+//                           a: 50% reads, 50% updates, zipfian keys
+//                           b: 95% reads, 5% updates, zipfian keys
+//                           c: 100% reads, zipfian keys
+//                           d: 95% reads, 5% inserts, latest keys
+//                           e: 95% short scans, 5% inserts, zipfian keys
+//                           f: 50% reads, 50% read-modify-writes, zipfian
+//      mixed         -- N operations mixed as given by --read_percent,
+//                       --update_percent, --insert_percent, --scan_percent
+//                       and --rmw_percent over keys drawn from --key_dist
 //   Meta operations:
 //      compact     -- Compact the entire DB
 //      stats       -- Print DB stats
@@ -70,6 +95,34 @@ static int FLAGS_num = 1000000;
 // Number of read operations to do.  If negative, do FLAGS_num reads.
 static int FLAGS_reads = -1;
 
+// If positive, run fillrandom, overwrite, readrandom, ycsb* and mixed for
+// this many seconds instead of for a fixed number of operations.
+static int FLAGS_duration = 0;
+
+// Distribution that readrandom, fillrandom, overwrite and mixed draw keys
+// from: "uniform", "zipfian" (popular keys scattered over the key space),
+// "latest" (zipfian over recency, favouring the most recently inserted
+// keys) or "hotspot" (see --hotspot_data_fraction).
+static const char* FLAGS_key_dist = "uniform";
+
+// Skew of the zipfian and latest distributions, in (0, 1).
+static double FLAGS_zipfian_const = 0.99;
+
+// For the hotspot distribution: --hotspot_op_fraction of the operations go
+// to the first --hotspot_data_fraction of the keys.
+static double FLAGS_hotspot_data_fraction = 0.2;
+static double FLAGS_hotspot_op_fraction = 0.8;
+
+// Operation mix of the "mixed" benchmark, in percent; must add up to 100.
+static int FLAGS_read_percent = 50;
+static int FLAGS_update_percent = 50;
+static int FLAGS_insert_percent = 0;
+static int FLAGS_scan_percent = 0;
+static int FLAGS_rmw_percent = 0;
+
+// Scans read a uniformly chosen number of entries up to this many.
+static int FLAGS_scan_length = 100;
+
 // Number of concurrent threads to run.
 static int FLAGS_threads = 1;
 
@@ -83,6 +136,28 @@ static double FLAGS_compression_ratio = 0.5;
 // Print histogram of operation timings
 static bool FLAGS_histogram = false;
 
+// Collect DB statistics (leveldb/statistics.h) and print them after each
+// benchmark
+static bool FLAGS_statistics = false;
+
+// If positive, write the throughput and latency percentiles of each kind of
+// operation every this many seconds to --report_file.
+static int FLAGS_report_interval_seconds = 0;
+
+// Format of --report_file: "csv", or "json" for one JSON object per line.
+static const char* FLAGS_report_format = "csv";
+
+// Where interval reports go (default: report.csv or report.json).
+static const char* FLAGS_report_file = nullptr;
+
+// If set, write a JSON summary of every benchmark run to this file at the
+// end: throughput, latency percentiles per kind of operation and, with
+// --statistics, all DB tickers and histograms.
+static const char* FLAGS_json_summary = nullptr;
+
+// Directory for the PERF_LOG trace files.
+static const char* FLAGS_perf_log_dir = "./perf_log";
+
 // Count the number of string comparisons performed
 static bool FLAGS_comparisons = false;
 
@@ -96,6 +171,22 @@ static size_t FLAGS_nvm_write_buffer_size = 0;
 // (initialized to default value by "main")
 static int FLAGS_max_file_size = 0;
 
+// Size of level-1 and the growth factor from one level to the next, and
+// whether level targets follow the size of the last level instead.
+// (initialized to default value by "main")
+static uint64_t FLAGS_max_bytes_for_level_base = 0;
+static double FLAGS_max_bytes_for_level_multiplier = 0;
+static bool FLAGS_level_compaction_dynamic_level_bytes = false;
+
+// Compaction style: 0 for leveled, 1 for universal, and the universal
+// compaction knobs.
+// (initialized to default value by "main")
+static int FLAGS_compaction_style = 0;
+static int FLAGS_universal_size_ratio = 0;
+static int FLAGS_universal_min_merge_width = 0;
+static int FLAGS_universal_max_merge_width = 0;
+static int FLAGS_universal_max_size_amplification_percent = 0;
+
 // Approximate size of user data packed per block (before compression.
 // (initialized to default value by "main")
 static int FLAGS_block_size = 0;
@@ -104,6 +195,75 @@ static int FLAGS_block_size = 0;
 // Negative means use default settings.
 static int FLAGS_cache_size = -1;
 
+// Number of bytes to use as a cache of point lookup results.
+// Zero disables the row cache.
+static int FLAGS_row_cache_size = 0;
+
+// Block cache implementation: "lru" or "clock".
+static const char* FLAGS_cache_type = "lru";
+
+// Number of block cache shards as a power of two (clock cache only).
+// Negative means pick a default based on the cache size.
+static int FLAGS_cache_numshardbits = -1;
+
+// Fraction of the block cache reserved for index and filter blocks.
+static double FLAGS_cache_high_pri_pool_ratio = 0.0;
+
+// If true, the block cache admits new blocks with a TinyLFU filter.
+static bool FLAGS_cache_admission_filter = false;
+
+// Bytes of persistent memory to use as a secondary tier below the block
+// cache.  Zero means no secondary tier.
+static size_t FLAGS_secondary_cache_size = 0;
+
+// File backing the secondary block cache tier.
+// Default: <nvm pmem_path>/block_cache.pool
+static const char* FLAGS_secondary_cache_path = nullptr;
+
+// If false, read table files with pread (or io_uring) instead of mmap.
+static bool FLAGS_allow_mmap_reads = true;
+
+// If true, read table files with direct I/O.
+static bool FLAGS_use_direct_reads = false;
+
+// If true, flushes and compactions use direct I/O for table files.
+static bool FLAGS_use_direct_io_for_flush_and_compaction = false;
+
+// Cap on the bytes per second written by flushes and compactions.
+// Zero means no limit.
+static uint64_t FLAGS_rate_limiter_bytes_per_sec = 0;
+
+// If true, raise the rate limit as level-0 files pile up.
+static bool FLAGS_rate_limiter_auto_tuned = false;
+
+// Largest automatic readahead window of table iterators, in bytes.
+// (initialized to default value by "main")
+static int FLAGS_max_auto_readahead_size = 0;
+
+// Readahead window of compaction inputs, in bytes.
+// (initialized to default value by "main")
+static int FLAGS_compaction_readahead_size = 0;
+
+// Level-0 file counts at which compactions start, writes slow down and
+// writes stop.
+// (initialized to default value by "main")
+static int FLAGS_level0_file_num_compaction_trigger = 0;
+static int FLAGS_level0_slowdown_writes_trigger = 0;
+static int FLAGS_level0_stop_writes_trigger = 0;
+
+// Estimated compaction backlogs, in bytes, at which writes slow down and
+// stop.  Zero disables either limit.
+// (initialized to default value by "main")
+static uint64_t FLAGS_soft_pending_compaction_bytes_limit = 0;
+static uint64_t FLAGS_hard_pending_compaction_bytes_limit = 0;
+
+// Bytes per second writes are paced to once they are slowed down.
+// (initialized to default value by "main")
+static uint64_t FLAGS_delayed_write_rate = 0;
+
+// Number of reads submitted per MultiRead call by "multireadrandom".
+static int FLAGS_multiread_batch_size = 32;
+
 // Maximum number of files to keep open at the same time (use default if == 0)
 static int FLAGS_open_files = 0;
 
@@ -111,6 +271,25 @@ static int FLAGS_open_files = 0;
 // Negative means use default settings.
 static int FLAGS_bloom_bits = -1;
 
+// Layout of the bloom filter data in each table:
+// 0 = per-2KB block-based, 1 = full filter, 2 = partitioned full filter.
+static int FLAGS_filter_format = leveldb::kFullFilter;
+
+// If true, append a hash index to each data block for point lookups.
+static bool FLAGS_data_block_hash_index = false;
+
+// If true, save the block cache keys on close and reload them on open.
+static bool FLAGS_persist_block_cache_keys = false;
+
+// If true, keep index and filter blocks in the block cache.
+static bool FLAGS_cache_index_and_filter_blocks = false;
+
+// If true, pin the cached index and filter blocks of level-0 tables.
+static bool FLAGS_pin_l0_filter_and_index_blocks_in_cache = false;
+
+// If true, write two-level partitioned index blocks.
+static bool FLAGS_partition_index = false;
+
 // Common key prefix length.
 static int FLAGS_key_prefix = 0;
 
@@ -122,7 +301,14 @@ static bool FLAGS_use_existing_db = false;
 // If true, reuse existing log/MANIFEST files when re-opening a database.
 static bool FLAGS_reuse_logs = false;
 
-// If true, use nvm
+// Number of obsolete log files to keep and write over instead of creating
+// new ones.
+static int FLAGS_recycle_log_file_num = 0;
+
+// If true, reserve disk space for each log file when it is created.
+static bool FLAGS_preallocate_log_files = false;
+
+// If true, keep the memtable in NVM (--use_nvm=1, or --nvm)
 static bool FLAGS_use_nvm = false;
 
 // Use the db with the following name.
@@ -212,6 +398,127 @@ class KeyBuffer {
   char buffer_[1024];
 };
 
+enum KeyDistribution { kUniform, kZipfian, kLatest, kHotspot };
+
+static bool ParseKeyDistribution(const char* name, KeyDistribution* dist) {
+  static const char* const kNames[] = {"uniform", "zipfian", "latest",
+                                       "hotspot"};
+  for (int i = 0; i < 4; i++) {
+    if (strcmp(name, kNames[i]) == 0) {
+      *dist = static_cast<KeyDistribution>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Draws keys from [0, limit), where "limit" is the number of keys in the
+// database so far.  The zipfian generators follow Gray et al., "Quickly
+// Generating Billion-Record Synthetic Databases", as YCSB does: ranks are
+// drawn over the "num" keys present at the start of the benchmark, which
+// saves recomputing zeta as keys are inserted.  A generator is immutable,
+// so all threads of a benchmark share one.
+class KeyGenerator {
+ public:
+  KeyGenerator(KeyDistribution dist, int num)
+      : dist_(dist), num_(std::max(num, 1)) {
+    if (dist_ == kZipfian || dist_ == kLatest) {
+      theta_ = FLAGS_zipfian_const;
+      double zetan = 0;
+      for (int i = 1; i <= num_; i++) {
+        zetan += 1.0 / std::pow(i, theta_);
+      }
+      const double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta_);
+      zetan_ = zetan;
+      alpha_ = 1.0 / (1.0 - theta_);
+      eta_ = (1.0 - std::pow(2.0 / num_, 1.0 - theta_)) / (1.0 - zeta2 / zetan);
+    }
+  }
+
+  int Next(Random* rnd, int limit) const {
+    switch (dist_) {
+      case kZipfian:
+        // Scatter the popular ranks over the key space so that they do not
+        // all share the first few blocks.
+        return static_cast<int>(Hash64(NextRank(rnd)) %
+                                std::min(num_, limit));
+      case kLatest:
+        return std::max(limit - 1 - NextRank(rnd), 0);
+      case kHotspot: {
+        const int hot = std::max(
+            static_cast<int>(limit * FLAGS_hotspot_data_fraction), 1);
+        if (hot >= limit || NextDouble(rnd) < FLAGS_hotspot_op_fraction) {
+          return rnd->Uniform(hot);
+        }
+        return hot + rnd->Uniform(limit - hot);
+      }
+      case kUniform:
+      default:
+        return rnd->Uniform(limit);
+    }
+  }
+
+ private:
+  static double NextDouble(Random* rnd) {
+    return rnd->Next() / 2147483647.0;
+  }
+
+  static uint64_t Hash64(uint64_t x) {
+    // FNV-1a over the bytes of x.
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int i = 0; i < 8; i++) {
+      h = (h ^ (x & 0xff)) * 0x100000001b3ull;
+      x >>= 8;
+    }
+    return h;
+  }
+
+  // Returns a rank in [0, num_); rank 0 is the most popular.
+  int NextRank(Random* rnd) const {
+    const double u = NextDouble(rnd);
+    const double uz = u * zetan_;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, theta_)) return 1;
+    const int rank =
+        static_cast<int>(num_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(rank, num_ - 1);
+  }
+
+  const KeyDistribution dist_;
+  const int num_;
+  double theta_ = 0;
+  double zetan_ = 0;
+  double alpha_ = 0;
+  double eta_ = 0;
+};
+
+// Tells a benchmark loop when to stop: after "max_ops" operations or, if
+// "max_seconds" is positive, once that much time has passed.
+class Duration {
+ public:
+  Duration(int max_seconds, int64_t max_ops)
+      : max_micros_(static_cast<uint64_t>(std::max(max_seconds, 0)) * 1000000),
+        max_ops_(max_ops),
+        start_(g_env->NowMicros()),
+        ops_(0) {}
+
+  // Called before each step of "increment" operations.
+  bool Done(int64_t increment) {
+    if (max_micros_ > 0) {
+      return g_env->NowMicros() - start_ >= max_micros_;
+    }
+    const bool done = ops_ >= max_ops_;
+    ops_ += increment;
+    return done;
+  }
+
+ private:
+  const uint64_t max_micros_;
+  const int64_t max_ops_;
+  const uint64_t start_;
+  int64_t ops_;
+};
+
 #if defined(__linux)
 static Slice TrimSpace(Slice s) {
   size_t start = 0;
@@ -234,6 +541,74 @@ static void AppendWithSpace(std::string* str, Slice msg) {
   str->append(msg.data(), msg.size());
 }
 
+enum OperationType {
+  kRead = 0,
+  kWrite,
+  kUpdate,
+  kInsert,
+  kScan,
+  kRmw,
+  kSeek,
+  kDelete,
+  kMerge,
+  kOthers,
+  kNumOperationTypes
+};
+
+static const char* const kOperationTypeNames[kNumOperationTypes] = {
+    "read", "write", "update", "insert", "scan",
+    "rmw",  "seek",  "delete", "merge",  "others"};
+
+// Per-operation latencies are only timed when something reports them.
+static bool MeasureLatency() {
+  return FLAGS_histogram || FLAGS_report_interval_seconds > 0 ||
+         FLAGS_json_summary != nullptr;
+}
+
+static void AppendJsonString(std::string* out, const Slice& value) {
+  out->push_back('"');
+  for (size_t i = 0; i < value.size(); i++) {
+    const char c = value[i];
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[10];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out->append(buf);
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->push_back('"');
+}
+
+// Append "count", the latency percentiles and the maximum of "hist" as the
+// members of a JSON object, without the braces.
+static void AppendLatencyJson(std::string* out, const Histogram& hist) {
+  const bool empty = hist.Count() == 0;
+  char buf[300];
+  std::snprintf(buf, sizeof(buf),
+                "\"count\":%.0f,\"average\":%.3f,\"p50\":%.3f,"
+                "\"p99\":%.3f,\"p99.9\":%.3f,\"max\":%.3f",
+                hist.Count(), hist.Average(), empty ? 0 : hist.Median(),
+                empty ? 0 : hist.Percentile(99),
+                empty ? 0 : hist.Percentile(99.9), empty ? 0 : hist.Max());
+  out->append(buf);
+}
+
+// Latencies a thread recorded since the interval reporter last took them.
+struct IntervalLatencies {
+  port::Mutex mu;
+  Histogram hist[kNumOperationTypes] GUARDED_BY(mu);
+
+  IntervalLatencies() {
+    for (Histogram& h : hist) {
+      h.Clear();
+    }
+  }
+};
+
 class Stats {
  private:
   double start_;
@@ -244,14 +619,24 @@ class Stats {
   int64_t bytes_;
   double last_op_finish_;
   Histogram hist_;
+  Histogram hist_by_type_[kNumOperationTypes];
+  IntervalLatencies* interval_;
   std::string message_;
 
  public:
-  Stats() { Start(); }
+  Stats() : interval_(nullptr) { Start(); }
+
+  // Also record every latency in *interval.
+  void SetIntervalLatencies(IntervalLatencies* interval) {
+    interval_ = interval;
+  }
 
   void Start() {
     next_report_ = 100;
     hist_.Clear();
+    for (Histogram& h : hist_by_type_) {
+      h.Clear();
+    }
     done_ = 0;
     bytes_ = 0;
     seconds_ = 0;
@@ -261,6 +646,9 @@ class Stats {
 
   void Merge(const Stats& other) {
     hist_.Merge(other.hist_);
+    for (int t = 0; t < kNumOperationTypes; t++) {
+      hist_by_type_[t].Merge(other.hist_by_type_[t]);
+    }
     done_ += other.done_;
     bytes_ += other.bytes_;
     seconds_ += other.seconds_;
@@ -278,12 +666,17 @@ class Stats {
 
   void AddMessage(Slice msg) { AppendWithSpace(&message_, msg); }
 
-  void FinishedSingleOp() {
-    if (FLAGS_histogram) {
+  void FinishedSingleOp(OperationType type = kOthers) {
+    if (MeasureLatency()) {
       double now = g_env->NowMicros();
       double micros = now - last_op_finish_;
       hist_.Add(micros);
-      if (micros > 20000) {
+      hist_by_type_[type].Add(micros);
+      if (interval_ != nullptr) {
+        MutexLock l(&interval_->mu);
+        interval_->hist[type].Add(micros);
+      }
+      if (FLAGS_histogram && micros > 20000) {
         std::fprintf(stderr, "long op: %.1f micros%30s\r", micros, "");
         std::fflush(stderr);
       }
@@ -341,10 +734,35 @@ class Stats {
                    hist_.ToString().c_str());
       RECORD_INFO(10, "Microseconds per op:\n%s\n", hist_.ToString().c_str());
     }
-    RECORD_INFO(10, "%s\n", leveldb::benchmark::GetHistogram().c_str());
-    // std::fprintf(stdout, "%s\n", leveldb::benchmark::GetHistogram().c_str());
     std::fflush(stdout);
   }
+
+  // Append the results as a JSON object.  Call after Report().
+  void AppendJson(const Slice& name, std::string* out) const {
+    out->append("{\"benchmark\":");
+    AppendJsonString(out, name);
+    char buf[200];
+    const double elapsed = (finish_ - start_) * 1e-6;
+    std::snprintf(buf, sizeof(buf),
+                  ",\"ops\":%d,\"seconds\":%.3f,\"micros_per_op\":%.3f,"
+                  "\"ops_per_sec\":%.1f,\"mb_per_sec\":%.1f",
+                  done_, elapsed, seconds_ * 1e6 / done_,
+                  elapsed > 0 ? done_ / elapsed : 0.0,
+                  elapsed > 0 ? (bytes_ / 1048576.0) / elapsed : 0.0);
+    out->append(buf);
+    out->append(",\"latency_micros\":{");
+    bool first = true;
+    for (int t = 0; t < kNumOperationTypes; t++) {
+      if (hist_by_type_[t].Count() == 0) continue;
+      if (!first) out->push_back(',');
+      first = false;
+      AppendJsonString(out, kOperationTypeNames[t]);
+      out->append(":{");
+      AppendLatencyJson(out, hist_by_type_[t]);
+      out->push_back('}');
+    }
+    out->append("}}");
+  }
 };
 
 // State shared by all concurrent executions of the same benchmark.
@@ -373,16 +791,134 @@ struct ThreadState {
   Random rand;  // Has different seeds for different threads
   Stats stats;
   SharedState* shared;
+  IntervalLatencies interval;
+
+  ThreadState(int index, int seed) : tid(index), rand(seed), shared(nullptr) {
+    if (FLAGS_report_interval_seconds > 0) {
+      stats.SetIntervalLatencies(&interval);
+    }
+  }
+};
+
+// Every --report_interval_seconds, collects the latencies the threads of a
+// benchmark recorded and writes one line per kind of operation to "out".
+// The last, partial interval is written when the reporter is deleted.
+class IntervalReporter {
+ public:
+  IntervalReporter(FILE* out, bool json, const Slice& benchmark,
+                   const std::vector<ThreadState*>& threads)
+      : out_(out),
+        json_(json),
+        benchmark_(benchmark.ToString()),
+        threads_(threads),
+        start_(g_env->NowMicros()),
+        last_report_(start_),
+        stop_(false),
+        thread_(&IntervalReporter::Run, this) {}
+
+  IntervalReporter(const IntervalReporter&) = delete;
+  IntervalReporter& operator=(const IntervalReporter&) = delete;
+
+  ~IntervalReporter() {
+    const uint64_t end = g_env->NowMicros();
+    stop_.store(true, std::memory_order_release);
+    thread_.join();
+    Report(end);
+  }
+
+ private:
+  void Run() {
+    const uint64_t interval =
+        static_cast<uint64_t>(FLAGS_report_interval_seconds) * 1000000;
+    uint64_t next = start_ + interval;
+    while (!stop_.load(std::memory_order_acquire)) {
+      const uint64_t now = g_env->NowMicros();
+      if (now >= next) {
+        Report(now);
+        next += interval;
+      } else {
+        // Wake up often enough to notice the end of the benchmark.
+        g_env->SleepForMicroseconds(
+            static_cast<int>(std::min<uint64_t>(next - now, 100000)));
+      }
+    }
+  }
+
+  // Write out the latencies recorded until "now".
+  void Report(uint64_t now) {
+    Histogram hist[kNumOperationTypes];
+    for (Histogram& h : hist) {
+      h.Clear();
+    }
+    for (ThreadState* thread : threads_) {
+      MutexLock l(&thread->interval.mu);
+      for (int t = 0; t < kNumOperationTypes; t++) {
+        hist[t].Merge(thread->interval.hist[t]);
+        thread->interval.hist[t].Clear();
+      }
+    }
+    const double seconds = (now - last_report_) * 1e-6;
+    const double elapsed = (now - start_) * 1e-6;
+    last_report_ = now;
+
+    std::string lines;
+    char buf[300];
+    for (int t = 0; t < kNumOperationTypes; t++) {
+      const Histogram& h = hist[t];
+      if (h.Count() == 0) continue;
+      const double ops_per_sec = seconds > 0 ? h.Count() / seconds : 0;
+      if (json_) {
+        lines.append("{\"benchmark\":");
+        AppendJsonString(&lines, benchmark_);
+        std::snprintf(buf, sizeof(buf),
+                      ",\"secs_elapsed\":%.3f,\"op\":\"%s\","
+                      "\"ops_per_sec\":%.1f,",
+                      elapsed, kOperationTypeNames[t], ops_per_sec);
+        lines.append(buf);
+        AppendLatencyJson(&lines, h);
+        lines.append("}\n");
+      } else {
+        std::snprintf(buf, sizeof(buf), "%s,%.3f,%s,%.1f,%.3f,%.3f,%.3f,%.3f\n",
+                      benchmark_.c_str(), elapsed, kOperationTypeNames[t],
+                      ops_per_sec, h.Median(), h.Percentile(99),
+                      h.Percentile(99.9), h.Max());
+        lines.append(buf);
+      }
+    }
+    std::fputs(lines.c_str(), out_);
+    std::fflush(out_);
+  }
+
+  FILE* const out_;
+  const bool json_;
+  const std::string benchmark_;
+  const std::vector<ThreadState*> threads_;
+  const uint64_t start_;
+  uint64_t last_report_;
+  std::atomic<bool> stop_;
+  std::thread thread_;
+};
 
-  ThreadState(int index, int seed) : tid(index), rand(seed), shared(nullptr) {}
+// Percentages of each kind of operation in a mixed workload.
+struct WorkloadMix {
+  int read;
+  int update;
+  int insert;
+  int scan;
+  int rmw;
 };
 
 }  // namespace
 
 class Benchmark {
  private:
+  SecondaryCache* secondary_cache_;
   Cache* cache_;
+  Cache* row_cache_;
+  RateLimiter* rate_limiter_;
   const FilterPolicy* filter_policy_;
+  const MergeOperator* merge_operator_;
+  Statistics* statistics_;
   DB* db_;
   int num_;
   int value_size_;
@@ -392,6 +928,14 @@ class Benchmark {
   int heap_counter_;
   CountComparator count_comparator_;
   int total_thread_count_;
+  KeyDistribution key_dist_;
+  const KeyGenerator* key_gen_;
+  WorkloadMix mix_;
+  // Next key to insert; keys below it have been loaded or inserted.
+  std::atomic<int> next_insert_key_;
+  FILE* report_file_;
+  // Summaries of the benchmarks run so far, for --json_summary.
+  std::string json_summary_;
 
   void PrintHeader() {
     const int kKeySize = 16 + FLAGS_key_prefix;
@@ -402,6 +946,8 @@ class Benchmark {
         FLAGS_value_size,
         static_cast<int>(FLAGS_value_size * FLAGS_compression_ratio + 0.5));
     std::fprintf(stdout, "Entries:    %d\n", num_);
+    std::fprintf(stdout, "KeyDist:    %s\n", FLAGS_key_dist);
+    std::fprintf(stdout, "Memtable:   %s\n", FLAGS_use_nvm ? "NVM" : "DRAM");
     std::fprintf(stdout, "RawSize:    %.1f MB (estimated)\n",
                  ((static_cast<int64_t>(kKeySize + FLAGS_value_size) * num_) /
                   1048576.0));
@@ -472,11 +1018,54 @@ class Benchmark {
   }
 
  public:
+  static SecondaryCache* NewSecondaryCache() {
+    if (FLAGS_secondary_cache_size == 0) {
+      return nullptr;
+    }
+    std::string path = FLAGS_secondary_cache_path != nullptr
+                           ? FLAGS_secondary_cache_path
+                           : Options().nvm_option.pmem_path +
+                                 "/block_cache.pool";
+    NVMSecondaryCache* cache =
+        new NVMSecondaryCache(path, FLAGS_secondary_cache_size);
+    if (!cache->ok()) {
+      std::fprintf(stderr, "cannot map secondary cache file %s\n",
+                   path.c_str());
+      std::exit(1);
+    }
+    return cache;
+  }
+
+  Cache* NewBlockCache() {
+    CacheOptions cache_options;
+    cache_options.capacity = FLAGS_cache_size;
+    cache_options.high_pri_pool_ratio = FLAGS_cache_high_pri_pool_ratio;
+    cache_options.admission_filter = FLAGS_cache_admission_filter;
+    cache_options.secondary_cache = secondary_cache_;
+    cache_options.estimated_entry_charge = FLAGS_block_size;
+    cache_options.num_shard_bits = FLAGS_cache_numshardbits;
+    if (strcmp(FLAGS_cache_type, "clock") == 0) {
+      return NewClockCache(cache_options);
+    }
+    return NewLRUCache(cache_options);
+  }
+
   Benchmark()
-      : cache_(FLAGS_cache_size >= 0 ? NewLRUCache(FLAGS_cache_size) : nullptr),
+      : secondary_cache_(FLAGS_cache_size >= 0 ? NewSecondaryCache()
+                                               : nullptr),
+        cache_(FLAGS_cache_size >= 0 ? NewBlockCache() : nullptr),
+        row_cache_(FLAGS_row_cache_size > 0 ? NewLRUCache(FLAGS_row_cache_size)
+                                            : nullptr),
+        rate_limiter_(FLAGS_rate_limiter_bytes_per_sec > 0
+                          ? NewGenericRateLimiter(
+                                FLAGS_rate_limiter_bytes_per_sec,
+                                FLAGS_rate_limiter_auto_tuned)
+                          : nullptr),
         filter_policy_(FLAGS_bloom_bits >= 0
                            ? NewBloomFilterPolicy(FLAGS_bloom_bits)
                            : nullptr),
+        merge_operator_(NewUInt64AddOperator()),
+        statistics_(FLAGS_statistics ? NewStatistics() : nullptr),
         db_(nullptr),
         num_(FLAGS_num),
         value_size_(FLAGS_value_size),
@@ -484,7 +1073,12 @@ class Benchmark {
         reads_(FLAGS_reads < 0 ? FLAGS_num : FLAGS_reads),
         heap_counter_(0),
         count_comparator_(BytewiseComparator()),
-        total_thread_count_(0) {
+        total_thread_count_(0),
+        key_gen_(nullptr),
+        mix_(),
+        next_insert_key_(FLAGS_num),
+        report_file_(nullptr) {
+    ParseKeyDistribution(FLAGS_key_dist, &key_dist_);
     std::vector<std::string> files;
     g_env->GetChildren(FLAGS_db, &files);
     for (size_t i = 0; i < files.size(); i++) {
@@ -500,12 +1094,24 @@ class Benchmark {
   ~Benchmark() {
     delete db_;
     delete cache_;
+    delete row_cache_;
+    delete rate_limiter_;
+    delete secondary_cache_;
     delete filter_policy_;
+    delete merge_operator_;
+    delete statistics_;
+    delete key_gen_;
+    if (report_file_ != nullptr) {
+      std::fclose(report_file_);
+    }
   }
 
   void Run() {
     PrintHeader();
     Open();
+    if (FLAGS_report_interval_seconds > 0) {
+      OpenReportFile();
+    }
 
     const char* benchmarks = FLAGS_benchmarks;
     while (benchmarks != nullptr) {
@@ -529,6 +1135,7 @@ class Benchmark {
       void (Benchmark::*method)(ThreadState*) = nullptr;
       bool fresh_db = false;
       int num_threads = FLAGS_threads;
+      KeyDistribution key_dist = key_dist_;
 
       if (name == Slice("open")) {
         method = &Benchmark::OpenBench;
@@ -578,6 +1185,27 @@ class Benchmark {
         method = &Benchmark::DeleteSeq;
       } else if (name == Slice("deleterandom")) {
         method = &Benchmark::DeleteRandom;
+      } else if (name == Slice("mergerandom")) {
+        method = &Benchmark::MergeRandom;
+      } else if (name.starts_with("ycsb") && name.size() == 5 &&
+                 name[4] >= 'a' && name[4] <= 'f') {
+        // Read, update, insert, scan and read-modify-write percentages.
+        static const WorkloadMix kYcsbMixes[] = {
+            {50, 50, 0, 0, 0}, {95, 5, 0, 0, 0}, {100, 0, 0, 0, 0},
+            {95, 0, 5, 0, 0},  {0, 0, 5, 95, 0}, {50, 0, 0, 0, 50}};
+        mix_ = kYcsbMixes[name[4] - 'a'];
+        key_dist = name[4] == 'd' ? kLatest : kZipfian;
+        method = &Benchmark::Mixed;
+      } else if (name == Slice("mixed")) {
+        mix_ = {FLAGS_read_percent, FLAGS_update_percent, FLAGS_insert_percent,
+                FLAGS_scan_percent, FLAGS_rmw_percent};
+        if (mix_.read + mix_.update + mix_.insert + mix_.scan + mix_.rmw ==
+            100) {
+          method = &Benchmark::Mixed;
+        } else {
+          std::fprintf(stderr, "mixed: operation percentages must add up to "
+                               "100\n");
+        }
       } else if (name == Slice("readwhilewriting")) {
         num_threads++;  // Add extra thread for writing
         method = &Benchmark::ReadWhileWriting;
@@ -585,6 +1213,8 @@ class Benchmark {
         method = &Benchmark::Compact;
       } else if (name == Slice("crc32c")) {
         method = &Benchmark::Crc32c;
+      } else if (name == Slice("multireadrandom")) {
+        method = &Benchmark::MultiReadRandom;
       } else if (name == Slice("snappycomp")) {
         method = &Benchmark::SnappyCompress;
       } else if (name == Slice("snappyuncomp")) {
@@ -612,15 +1242,21 @@ class Benchmark {
           db_ = nullptr;
           DestroyDB(FLAGS_db, Options());
           Open();
+          next_insert_key_ = FLAGS_num;
         }
       }
-#ifdef PERF_LOG
-      leveldb::benchmark::ClearPerfLog();
-#endif
+      if (statistics_ != nullptr) {
+        statistics_->Reset();
+      }
       if (method != nullptr) {
+        delete key_gen_;
+        key_gen_ = new KeyGenerator(key_dist, FLAGS_num);
         RunBenchmark(num_threads, name, method);
       }
     }
+    if (FLAGS_json_summary != nullptr) {
+      WriteJsonSummary();
+    }
   }
 
  private:
@@ -663,6 +1299,12 @@ class Benchmark {
                     void (Benchmark::*method)(ThreadState*)) {
     SharedState shared(n);
 
+    // Write amplification is reported for benchmarks that change it.
+    std::string write_amp_before;
+    if (db_ != nullptr) {
+      db_->GetProperty("leveldb.write-amplification", &write_amp_before);
+    }
+
     ThreadArg* arg = new ThreadArg[n];
     for (int i = 0; i < n; i++) {
       arg[i].bm = this;
@@ -682,17 +1324,45 @@ class Benchmark {
       shared.cv.Wait();
     }
 
+    IntervalReporter* reporter = nullptr;
+    if (report_file_ != nullptr) {
+      std::vector<ThreadState*> threads;
+      for (int i = 0; i < n; i++) {
+        threads.push_back(arg[i].thread);
+      }
+      reporter = new IntervalReporter(
+          report_file_, strcmp(FLAGS_report_format, "json") == 0, name,
+          threads);
+    }
+
     shared.start = true;
     shared.cv.SignalAll();
     while (shared.num_done < n) {
       shared.cv.Wait();
     }
     shared.mu.Unlock();
+    delete reporter;
 
     for (int i = 1; i < n; i++) {
       arg[0].thread->stats.Merge(arg[i].thread->stats);
     }
+    if (db_ != nullptr) {
+      std::string write_amp;
+      if (db_->GetProperty("leveldb.write-amplification", &write_amp) &&
+          write_amp != write_amp_before && write_amp != "0.00") {
+        arg[0].thread->stats.AddMessage("write-amp " + write_amp);
+      }
+    }
     arg[0].thread->stats.Report(name);
+    if (statistics_ != nullptr) {
+      std::string stats = statistics_->ToString();
+      std::fprintf(stdout, "STATISTICS:\n%s\n", stats.c_str());
+      RECORD_INFO(10, "STATISTICS:\n%s\n", stats.c_str());
+      std::fflush(stdout);
+    }
+    if (FLAGS_json_summary != nullptr) {
+      AppendJsonSummary(name, arg[0].thread->stats);
+    }
     if (FLAGS_comparisons) {
       fprintf(stdout, "Comparisons: %zu\n", count_comparator_.comparisons());
       count_comparator_.reset();
@@ -705,6 +1375,76 @@ class Benchmark {
     delete[] arg;
   }
 
+  void OpenReportFile() {
+    const bool json = strcmp(FLAGS_report_format, "json") == 0;
+    const char* path = FLAGS_report_file != nullptr
+                           ? FLAGS_report_file
+                           : (json ? "report.json" : "report.csv");
+    report_file_ = std::fopen(path, "w");
+    if (report_file_ == nullptr) {
+      std::fprintf(stderr, "cannot open report file %s\n", path);
+      std::exit(1);
+    }
+    if (!json) {
+      std::fprintf(report_file_,
+                   "benchmark,secs_elapsed,op,ops_per_sec,p50_micros,"
+                   "p99_micros,p99.9_micros,max_micros\n");
+    }
+  }
+
+  void AppendJsonSummary(const Slice& name, const Stats& stats) {
+    if (!json_summary_.empty()) {
+      json_summary_.append(",\n");
+    }
+    std::string entry;
+    stats.AppendJson(name, &entry);
+    if (statistics_ != nullptr) {
+      // Splice the DB statistics into the object before its closing brace.
+      entry.pop_back();
+      entry.append(",\"statistics\":{\"tickers\":{");
+      char buf[100];
+      for (int t = 0; t < kTickerEnumMax; t++) {
+        const Ticker ticker = static_cast<Ticker>(t);
+        if (t > 0) entry.push_back(',');
+        AppendJsonString(&entry, TickerName(ticker));
+        std::snprintf(buf, sizeof(buf), ":%llu",
+                      static_cast<unsigned long long>(
+                          statistics_->GetTickerCount(ticker)));
+        entry.append(buf);
+      }
+      entry.append("},\"histograms\":{");
+      for (int h = 0; h < kHistogramEnumMax; h++) {
+        const HistogramType type = static_cast<HistogramType>(h);
+        HistogramData data;
+        statistics_->GetHistogramData(type, &data);
+        if (h > 0) entry.push_back(',');
+        AppendJsonString(&entry, HistogramName(type));
+        char hist[300];
+        std::snprintf(
+            hist, sizeof(hist),
+            ":{\"count\":%llu,\"sum\":%llu,\"average\":%.3f,\"p50\":%.3f,"
+            "\"p95\":%.3f,\"p99\":%.3f,\"p99.9\":%.3f,\"max\":%.3f}",
+            static_cast<unsigned long long>(data.count),
+            static_cast<unsigned long long>(data.sum), data.average,
+            data.median, data.percentile95, data.percentile99,
+            data.percentile999, data.max);
+        entry.append(hist);
+      }
+      entry.append("}}}");
+    }
+    json_summary_.append(entry);
+  }
+
+  void WriteJsonSummary() {
+    FILE* f = std::fopen(FLAGS_json_summary, "w");
+    if (f == nullptr) {
+      std::fprintf(stderr, "cannot open %s\n", FLAGS_json_summary);
+      return;
+    }
+    std::fprintf(f, "{\"benchmarks\":[\n%s\n]}\n", json_summary_.c_str());
+    std::fclose(f);
+  }
+
   void Crc32c(ThreadState* thread) {
     // Checksum about 500MB of data total
     const int size = 4096;
@@ -724,6 +1464,74 @@ class Benchmark {
     thread->stats.AddMessage(label);
   }
 
+  void MultiReadRandom(ThreadState* thread) {
+    // Read the table files directly so that the block cache and the
+    // table format do not hide the cost of the reads themselves.
+    std::vector<std::string> children;
+    g_env->GetChildren(FLAGS_db, &children);
+    FileOptions file_options;
+    file_options.allow_mmap_reads = false;
+    std::vector<RandomAccessFile*> files;
+    std::vector<uint64_t> sizes;
+    const size_t block_size = FLAGS_block_size;
+    for (const std::string& child : children) {
+      uint64_t number;
+      FileType type;
+      uint64_t size;
+      RandomAccessFile* file;
+      const std::string fname = std::string(FLAGS_db) + "/" + child;
+      if (!ParseFileName(child, &number, &type) || type != kTableFile ||
+          !g_env->GetFileSize(fname, &size).ok() || size < block_size ||
+          !g_env->NewRandomAccessFile(fname, file_options, &file).ok()) {
+        continue;
+      }
+      files.push_back(file);
+      sizes.push_back(size);
+    }
+    if (files.empty()) {
+      thread->stats.AddMessage("(no table files)");
+      return;
+    }
+
+    const int batch = FLAGS_multiread_batch_size;
+    std::vector<char> scratch(batch * block_size);
+    std::vector<RandomAccessFile::ReadRequest> reqs(batch);
+    int64_t bytes = 0;
+    for (int i = 0; i < reads_; i += batch) {
+      const int f = thread->rand.Uniform(files.size());
+      const int n = std::min(batch, reads_ - i);
+      for (int j = 0; j < n; j++) {
+        reqs[j].offset =
+            thread->rand.Uniform(sizes[f] - block_size + 1) / 4096 * 4096;
+        reqs[j].n = block_size;
+        reqs[j].scratch = &scratch[j * block_size];
+      }
+      if (n == 1) {
+        reqs[0].status = files[f]->Read(reqs[0].offset, reqs[0].n,
+                                        &reqs[0].result, reqs[0].scratch);
+      } else {
+        files[f]->MultiRead(reqs.data(), n);
+      }
+      for (int j = 0; j < n; j++) {
+        if (!reqs[j].status.ok()) {
+          std::fprintf(stderr, "read error: %s\n",
+                       reqs[j].status.ToString().c_str());
+          std::exit(1);
+        }
+        bytes += reqs[j].result.size();
+        thread->stats.FinishedSingleOp(kRead);
+      }
+    }
+    for (RandomAccessFile* file : files) {
+      delete file;
+    }
+
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%d per batch)", batch);
+    thread->stats.AddMessage(msg);
+    thread->stats.AddBytes(bytes);
+  }
+
   void SnappyCompress(ThreadState* thread) {
     RandomGenerator gen;
     Slice input = gen.Generate(Options().block_size);
@@ -781,6 +1589,18 @@ class Benchmark {
     options.nvm_option.write_buffer_size = FLAGS_nvm_write_buffer_size;
     options.nvm_option.use_nvm_mem_module = FLAGS_use_nvm;
     options.max_file_size = FLAGS_max_file_size;
+    options.max_bytes_for_level_base = FLAGS_max_bytes_for_level_base;
+    options.max_bytes_for_level_multiplier =
+        FLAGS_max_bytes_for_level_multiplier;
+    options.level_compaction_dynamic_level_bytes =
+        FLAGS_level_compaction_dynamic_level_bytes;
+    options.compaction_style =
+        static_cast<CompactionStyle>(FLAGS_compaction_style);
+    options.universal_size_ratio = FLAGS_universal_size_ratio;
+    options.universal_min_merge_width = FLAGS_universal_min_merge_width;
+    options.universal_max_merge_width = FLAGS_universal_max_merge_width;
+    options.universal_max_size_amplification_percent =
+        FLAGS_universal_max_size_amplification_percent;
     options.block_size = FLAGS_block_size;
     options.compression = kNoCompression;
     if (FLAGS_comparisons) {
@@ -788,7 +1608,36 @@ class Benchmark {
     }
     options.max_open_files = FLAGS_open_files;
     options.filter_policy = filter_policy_;
+    options.merge_operator = merge_operator_;
+    options.statistics = statistics_;
+    options.filter_format = static_cast<FilterFormat>(FLAGS_filter_format);
+    options.data_block_hash_index = FLAGS_data_block_hash_index;
+    options.persist_block_cache_keys = FLAGS_persist_block_cache_keys;
+    options.cache_index_and_filter_blocks = FLAGS_cache_index_and_filter_blocks;
+    options.pin_l0_filter_and_index_blocks_in_cache =
+        FLAGS_pin_l0_filter_and_index_blocks_in_cache;
+    options.row_cache = row_cache_;
+    options.rate_limiter = rate_limiter_;
+    options.max_auto_readahead_size = FLAGS_max_auto_readahead_size;
+    options.compaction_readahead_size = FLAGS_compaction_readahead_size;
+    options.level0_file_num_compaction_trigger =
+        FLAGS_level0_file_num_compaction_trigger;
+    options.level0_slowdown_writes_trigger =
+        FLAGS_level0_slowdown_writes_trigger;
+    options.level0_stop_writes_trigger = FLAGS_level0_stop_writes_trigger;
+    options.soft_pending_compaction_bytes_limit =
+        FLAGS_soft_pending_compaction_bytes_limit;
+    options.hard_pending_compaction_bytes_limit =
+        FLAGS_hard_pending_compaction_bytes_limit;
+    options.delayed_write_rate = FLAGS_delayed_write_rate;
+    options.partition_index = FLAGS_partition_index;
     options.reuse_logs = FLAGS_reuse_logs;
+    options.recycle_log_file_num = FLAGS_recycle_log_file_num;
+    options.preallocate_log_files = FLAGS_preallocate_log_files;
+    options.allow_mmap_reads = FLAGS_allow_mmap_reads;
+    options.use_direct_reads = FLAGS_use_direct_reads;
+    options.use_direct_io_for_flush_and_compaction =
+        FLAGS_use_direct_io_for_flush_and_compaction;
     Status s = DB::Open(options, FLAGS_db, &db_);
     if (!s.ok()) {
       std::fprintf(stderr, "open error: %s\n", s.ToString().c_str());
@@ -828,14 +1677,16 @@ class Benchmark {
     uint64_t t_last_time = t_start_time;
     uint64_t t_cur_time;
 
-    for (int i = 0; i < num_; i += entries_per_batch_) {
+    Duration duration(seq ? 0 : FLAGS_duration, num_);
+    for (int i = 0; !duration.Done(entries_per_batch_);
+         i += entries_per_batch_) {
       batch.Clear();
       for (int j = 0; j < entries_per_batch_; j++) {
-        const int k = seq ? i + j : thread->rand.Uniform(FLAGS_num);
+        const int k = seq ? i + j : key_gen_->Next(&thread->rand, FLAGS_num);
         key.Set(k);
         batch.Put(key.slice(), gen.Generate(value_size_));
         bytes += value_size_ + key.slice().size();
-        thread->stats.FinishedSingleOp();
+        thread->stats.FinishedSingleOp(kWrite);
       }
       s = db_->Write(write_options_, &batch);
       if (!s.ok()) {
@@ -877,7 +1728,7 @@ class Benchmark {
     int64_t bytes = 0;
     for (iter->SeekToFirst(); i < reads_ && iter->Valid(); iter->Next()) {
       bytes += iter->key().size() + iter->value().size();
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
       ++i;
     }
     delete iter;
@@ -890,7 +1741,7 @@ class Benchmark {
     int64_t bytes = 0;
     for (iter->SeekToLast(); i < reads_ && iter->Valid(); iter->Prev()) {
       bytes += iter->key().size() + iter->value().size();
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
       ++i;
     }
     delete iter;
@@ -903,17 +1754,21 @@ class Benchmark {
     int found = 0;
     int64_t bytes = 0;
     KeyBuffer key;
-    for (int i = 0; i < reads_; i++) {
-      const int k = thread->rand.Uniform(FLAGS_num);
+    int reads = 0;
+    Duration duration(FLAGS_duration, reads_);
+    while (!duration.Done(1)) {
+      const int k = key_gen_->Next(&thread->rand, FLAGS_num);
       key.Set(k);
       if (db_->Get(options, key.slice(), &value).ok()) {
         bytes += key.slice().size() + value.size();
         found++;
       }
-      thread->stats.FinishedSingleOp();
+      reads++;
+      thread->stats.FinishedSingleOp(kRead);
     }
     char msg[100];
-    std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
+    std::snprintf(msg, sizeof(msg), "(%d of %d found)", found,
+                  FLAGS_duration > 0 ? reads : num_);
     thread->stats.AddMessage(msg);
     thread->stats.AddBytes(bytes);
   }
@@ -927,7 +1782,7 @@ class Benchmark {
       key.Set(k);
       Slice s = Slice(key.slice().data(), key.slice().size() - 1);
       db_->Get(options, s, &value);
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
     }
   }
 
@@ -940,7 +1795,7 @@ class Benchmark {
       const int k = thread->rand.Uniform(range);
       key.Set(k);
       db_->Get(options, key.slice(), &value);
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
     }
   }
 
@@ -955,7 +1810,7 @@ class Benchmark {
       iter->Seek(key.slice());
       if (iter->Valid() && iter->key() == key.slice()) found++;
       delete iter;
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kSeek);
     }
     char msg[100];
     snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
@@ -973,7 +1828,7 @@ class Benchmark {
       key.Set(k);
       iter->Seek(key.slice());
       if (iter->Valid() && iter->key() == key.slice()) found++;
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kSeek);
     }
     delete iter;
     char msg[100];
@@ -992,7 +1847,7 @@ class Benchmark {
         const int k = seq ? i + j : (thread->rand.Uniform(FLAGS_num));
         key.Set(k);
         batch.Delete(key.slice());
-        thread->stats.FinishedSingleOp();
+        thread->stats.FinishedSingleOp(kDelete);
       }
       s = db_->Write(write_options_, &batch);
       if (!s.ok()) {
@@ -1006,6 +1861,30 @@ class Benchmark {
 
   void DeleteRandom(ThreadState* thread) { DoDelete(thread, false); }
 
+  void MergeRandom(ThreadState* thread) {
+    WriteBatch batch;
+    Status s;
+    KeyBuffer key;
+    std::string one;
+    PutFixed64(&one, 1);
+    int64_t bytes = 0;
+    for (int i = 0; i < num_; i += entries_per_batch_) {
+      batch.Clear();
+      for (int j = 0; j < entries_per_batch_; j++) {
+        key.Set(thread->rand.Uniform(FLAGS_num));
+        batch.Merge(key.slice(), one);
+        bytes += key.slice().size() + one.size();
+        thread->stats.FinishedSingleOp(kMerge);
+      }
+      s = db_->Write(write_options_, &batch);
+      if (!s.ok()) {
+        std::fprintf(stderr, "merge error: %s\n", s.ToString().c_str());
+        std::exit(1);
+      }
+    }
+    thread->stats.AddBytes(bytes);
+  }
+
   void ReadWhileWriting(ThreadState* thread) {
     if (thread->tid > 0) {
       ReadRandom(thread);
@@ -1037,6 +1916,81 @@ class Benchmark {
     }
   }
 
+  // Runs reads_ operations, or --duration seconds of them, in the
+  // proportions given by mix_.
+  void Mixed(ThreadState* thread) {
+    ReadOptions options;
+    RandomGenerator gen;
+    std::string value;
+    KeyBuffer key;
+    int64_t bytes = 0;
+    int reads = 0, found = 0, updates = 0, inserts = 0, scans = 0, rmws = 0;
+    Status s;
+    Duration duration(FLAGS_duration, reads_);
+    while (!duration.Done(1)) {
+      int op = thread->rand.Uniform(100);
+      if (op < mix_.insert) {
+        key.Set(next_insert_key_.fetch_add(1, std::memory_order_relaxed));
+        s = db_->Put(write_options_, key.slice(), gen.Generate(value_size_));
+        bytes += key.slice().size() + value_size_;
+        inserts++;
+        thread->stats.FinishedSingleOp(kInsert);
+        if (!s.ok()) break;
+        continue;
+      }
+      op -= mix_.insert;
+      key.Set(key_gen_->Next(
+          &thread->rand, next_insert_key_.load(std::memory_order_relaxed)));
+      OperationType type;
+      if (op < mix_.read) {
+        type = kRead;
+        if (db_->Get(options, key.slice(), &value).ok()) {
+          bytes += key.slice().size() + value.size();
+          found++;
+        }
+        reads++;
+      } else if (op < mix_.read + mix_.update) {
+        type = kUpdate;
+        s = db_->Put(write_options_, key.slice(), gen.Generate(value_size_));
+        bytes += key.slice().size() + value_size_;
+        updates++;
+      } else if (op < mix_.read + mix_.update + mix_.scan) {
+        type = kScan;
+        Iterator* iter = db_->NewIterator(options);
+        const int length = 1 + thread->rand.Uniform(FLAGS_scan_length);
+        iter->Seek(key.slice());
+        for (int i = 0; i < length && iter->Valid(); i++) {
+          bytes += iter->key().size() + iter->value().size();
+          iter->Next();
+        }
+        delete iter;
+        scans++;
+      } else {
+        type = kRmw;
+        if (db_->Get(options, key.slice(), &value).ok()) {
+          bytes += key.slice().size() + value.size();
+          found++;
+        }
+        s = db_->Put(write_options_, key.slice(), gen.Generate(value_size_));
+        bytes += key.slice().size() + value_size_;
+        rmws++;
+      }
+      thread->stats.FinishedSingleOp(type);
+      if (!s.ok()) break;
+    }
+    if (!s.ok()) {
+      std::fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+      std::exit(1);
+    }
+    char msg[200];
+    std::snprintf(msg, sizeof(msg),
+                  "(reads %d, updates %d, inserts %d, scans %d, rmw %d; "
+                  "%d of %d gets found)",
+                  reads, updates, inserts, scans, rmws, found, reads + rmws);
+    thread->stats.AddMessage(msg);
+    thread->stats.AddBytes(bytes);
+  }
+
   void Compact(ThreadState* thread) { db_->CompactRange(nullptr, nullptr); }
 
   void PrintStats(const char* key) {
@@ -1073,15 +2027,36 @@ class Benchmark {
 }  // namespace leveldb
 
 int main(int argc, char** argv) {
-#ifdef PERF_LOG
-  leveldb::benchmark::CreatePerfLog();
-  leveldb::init_log_file();
-#endif
   FLAGS_write_buffer_size = leveldb::Options().write_buffer_size;
   FLAGS_nvm_write_buffer_size = leveldb::Options().nvm_option.write_buffer_size;
   FLAGS_max_file_size = leveldb::Options().max_file_size;
+  FLAGS_max_bytes_for_level_base = leveldb::Options().max_bytes_for_level_base;
+  FLAGS_max_bytes_for_level_multiplier =
+      leveldb::Options().max_bytes_for_level_multiplier;
+  FLAGS_compaction_style = leveldb::Options().compaction_style;
+  FLAGS_universal_size_ratio = leveldb::Options().universal_size_ratio;
+  FLAGS_universal_min_merge_width =
+      leveldb::Options().universal_min_merge_width;
+  FLAGS_universal_max_merge_width =
+      leveldb::Options().universal_max_merge_width;
+  FLAGS_universal_max_size_amplification_percent =
+      leveldb::Options().universal_max_size_amplification_percent;
   FLAGS_block_size = leveldb::Options().block_size;
+  FLAGS_max_auto_readahead_size = leveldb::Options().max_auto_readahead_size;
+  FLAGS_compaction_readahead_size =
+      leveldb::Options().compaction_readahead_size;
   FLAGS_open_files = leveldb::Options().max_open_files;
+  FLAGS_level0_file_num_compaction_trigger =
+      leveldb::Options().level0_file_num_compaction_trigger;
+  FLAGS_level0_slowdown_writes_trigger =
+      leveldb::Options().level0_slowdown_writes_trigger;
+  FLAGS_level0_stop_writes_trigger =
+      leveldb::Options().level0_stop_writes_trigger;
+  FLAGS_soft_pending_compaction_bytes_limit =
+      leveldb::Options().soft_pending_compaction_bytes_limit;
+  FLAGS_hard_pending_compaction_bytes_limit =
+      leveldb::Options().hard_pending_compaction_bytes_limit;
+  FLAGS_delayed_write_rate = leveldb::Options().delayed_write_rate;
   FLAGS_use_nvm = leveldb::Options().nvm_option.use_nvm_mem_module;
   std::string default_db_path;
 
@@ -1090,6 +2065,7 @@ int main(int argc, char** argv) {
     int n;
     unsigned long long ulln;
     char junk;
+    leveldb::KeyDistribution key_dist;
     if (leveldb::Slice(argv[i]).starts_with("--benchmarks=")) {
       FLAGS_benchmarks = argv[i] + strlen("--benchmarks=");
     } else if (sscanf(argv[i], "--compression_ratio=%lf%c", &d, &junk) == 1) {
@@ -1097,6 +2073,21 @@ int main(int argc, char** argv) {
     } else if (sscanf(argv[i], "--histogram=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_histogram = n;
+    } else if (sscanf(argv[i], "--statistics=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_statistics = n;
+    } else if (sscanf(argv[i], "--report_interval_seconds=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_report_interval_seconds = n;
+    } else if (strcmp(argv[i], "--report_format=csv") == 0 ||
+               strcmp(argv[i], "--report_format=json") == 0) {
+      FLAGS_report_format = argv[i] + strlen("--report_format=");
+    } else if (strncmp(argv[i], "--report_file=", 14) == 0) {
+      FLAGS_report_file = argv[i] + 14;
+    } else if (strncmp(argv[i], "--json_summary=", 15) == 0) {
+      FLAGS_json_summary = argv[i] + 15;
+    } else if (strncmp(argv[i], "--perf_log_dir=", 15) == 0) {
+      FLAGS_perf_log_dir = argv[i] + 15;
     } else if (sscanf(argv[i], "--comparisons=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_comparisons = n;
@@ -1106,10 +2097,51 @@ int main(int argc, char** argv) {
     } else if (sscanf(argv[i], "--reuse_logs=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_reuse_logs = n;
+    } else if (sscanf(argv[i], "--recycle_log_file_num=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_recycle_log_file_num = n;
+    } else if (sscanf(argv[i], "--preallocate_log_files=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_preallocate_log_files = n;
     } else if (sscanf(argv[i], "--num=%d%c", &n, &junk) == 1) {
       FLAGS_num = n;
     } else if (sscanf(argv[i], "--reads=%d%c", &n, &junk) == 1) {
       FLAGS_reads = n;
+    } else if (sscanf(argv[i], "--duration=%d%c", &n, &junk) == 1) {
+      FLAGS_duration = n;
+    } else if (strncmp(argv[i], "--key_dist=", 11) == 0 &&
+               leveldb::ParseKeyDistribution(argv[i] + 11, &key_dist)) {
+      FLAGS_key_dist = argv[i] + 11;
+    } else if (sscanf(argv[i], "--zipfian_const=%lf%c", &d, &junk) == 1 &&
+               d > 0 && d < 1) {
+      FLAGS_zipfian_const = d;
+    } else if (sscanf(argv[i], "--hotspot_data_fraction=%lf%c", &d, &junk) ==
+                   1 &&
+               d > 0 && d <= 1) {
+      FLAGS_hotspot_data_fraction = d;
+    } else if (sscanf(argv[i], "--hotspot_op_fraction=%lf%c", &d, &junk) ==
+                   1 &&
+               d >= 0 && d <= 1) {
+      FLAGS_hotspot_op_fraction = d;
+    } else if (sscanf(argv[i], "--read_percent=%d%c", &n, &junk) == 1 &&
+               n >= 0) {
+      FLAGS_read_percent = n;
+    } else if (sscanf(argv[i], "--update_percent=%d%c", &n, &junk) == 1 &&
+               n >= 0) {
+      FLAGS_update_percent = n;
+    } else if (sscanf(argv[i], "--insert_percent=%d%c", &n, &junk) == 1 &&
+               n >= 0) {
+      FLAGS_insert_percent = n;
+    } else if (sscanf(argv[i], "--scan_percent=%d%c", &n, &junk) == 1 &&
+               n >= 0) {
+      FLAGS_scan_percent = n;
+    } else if (sscanf(argv[i], "--rmw_percent=%d%c", &n, &junk) == 1 &&
+               n >= 0) {
+      FLAGS_rmw_percent = n;
+    } else if (sscanf(argv[i], "--scan_length=%d%c", &n, &junk) == 1 &&
+               n > 0) {
+      FLAGS_scan_length = n;
     } else if (sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1) {
       FLAGS_threads = n;
     } else if (sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1) {
@@ -1122,18 +2154,132 @@ int main(int argc, char** argv) {
       FLAGS_nvm_write_buffer_size = ulln;
     } else if (sscanf(argv[i], "--max_file_size=%d%c", &n, &junk) == 1) {
       FLAGS_max_file_size = n;
+    } else if (sscanf(argv[i], "--max_bytes_for_level_base=%llu%c", &ulln,
+                      &junk) == 1) {
+      FLAGS_max_bytes_for_level_base = ulln;
+    } else if (sscanf(argv[i], "--max_bytes_for_level_multiplier=%lf%c", &d,
+                      &junk) == 1) {
+      FLAGS_max_bytes_for_level_multiplier = d;
+    } else if (sscanf(argv[i], "--level_compaction_dynamic_level_bytes=%d%c",
+                      &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_level_compaction_dynamic_level_bytes = n;
+    } else if (sscanf(argv[i], "--compaction_style=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_compaction_style = n;
+    } else if (sscanf(argv[i], "--universal_size_ratio=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_universal_size_ratio = n;
+    } else if (sscanf(argv[i], "--universal_min_merge_width=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_universal_min_merge_width = n;
+    } else if (sscanf(argv[i], "--universal_max_merge_width=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_universal_max_merge_width = n;
+    } else if (sscanf(argv[i],
+                      "--universal_max_size_amplification_percent=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_universal_max_size_amplification_percent = n;
     } else if (sscanf(argv[i], "--block_size=%d%c", &n, &junk) == 1) {
       FLAGS_block_size = n;
     } else if (sscanf(argv[i], "--key_prefix=%d%c", &n, &junk) == 1) {
       FLAGS_key_prefix = n;
     } else if (sscanf(argv[i], "--cache_size=%d%c", &n, &junk) == 1) {
       FLAGS_cache_size = n;
+    } else if (sscanf(argv[i], "--row_cache_size=%d%c", &n, &junk) == 1) {
+      FLAGS_row_cache_size = n;
+    } else if (strncmp(argv[i], "--cache_type=", 13) == 0) {
+      FLAGS_cache_type = argv[i] + 13;
+    } else if (sscanf(argv[i], "--cache_numshardbits=%d%c", &n, &junk) == 1) {
+      FLAGS_cache_numshardbits = n;
+    } else if (sscanf(argv[i], "--cache_high_pri_pool_ratio=%lf%c", &d,
+                      &junk) == 1) {
+      FLAGS_cache_high_pri_pool_ratio = d;
+    } else if (sscanf(argv[i], "--cache_admission_filter=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_cache_admission_filter = n;
+    } else if (sscanf(argv[i], "--secondary_cache_size=%llu%c", &ulln,
+                      &junk) == 1) {
+      FLAGS_secondary_cache_size = ulln;
+    } else if (strncmp(argv[i], "--secondary_cache_path=", 23) == 0) {
+      FLAGS_secondary_cache_path = argv[i] + 23;
     } else if (sscanf(argv[i], "--bloom_bits=%d%c", &n, &junk) == 1) {
       FLAGS_bloom_bits = n;
+    } else if (sscanf(argv[i], "--filter_format=%d%c", &n, &junk) == 1 &&
+               n >= 0 && n <= 2) {
+      FLAGS_filter_format = n;
+    } else if (sscanf(argv[i], "--data_block_hash_index=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_data_block_hash_index = n;
+    } else if (sscanf(argv[i], "--persist_block_cache_keys=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_persist_block_cache_keys = n;
+    } else if (sscanf(argv[i], "--cache_index_and_filter_blocks=%d%c", &n,
+                      &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_cache_index_and_filter_blocks = n;
+    } else if (sscanf(argv[i], "--pin_l0_filter_and_index_blocks_in_cache=%d%c",
+                      &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_pin_l0_filter_and_index_blocks_in_cache = n;
+    } else if (sscanf(argv[i], "--partition_index=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_partition_index = n;
+    } else if (sscanf(argv[i], "--allow_mmap_reads=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_allow_mmap_reads = n;
+    } else if (sscanf(argv[i], "--rate_limiter_bytes_per_sec=%llu%c", &ulln,
+                      &junk) == 1) {
+      FLAGS_rate_limiter_bytes_per_sec = ulln;
+    } else if (sscanf(argv[i], "--rate_limiter_auto_tuned=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_rate_limiter_auto_tuned = n;
+    } else if (sscanf(argv[i], "--max_auto_readahead_size=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_max_auto_readahead_size = n;
+    } else if (sscanf(argv[i], "--compaction_readahead_size=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_compaction_readahead_size = n;
+    } else if (sscanf(argv[i], "--level0_file_num_compaction_trigger=%d%c",
+                      &n, &junk) == 1) {
+      FLAGS_level0_file_num_compaction_trigger = n;
+    } else if (sscanf(argv[i], "--level0_slowdown_writes_trigger=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_level0_slowdown_writes_trigger = n;
+    } else if (sscanf(argv[i], "--level0_stop_writes_trigger=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_level0_stop_writes_trigger = n;
+    } else if (sscanf(argv[i], "--soft_pending_compaction_bytes_limit=%llu%c",
+                      &ulln, &junk) == 1) {
+      FLAGS_soft_pending_compaction_bytes_limit = ulln;
+    } else if (sscanf(argv[i], "--hard_pending_compaction_bytes_limit=%llu%c",
+                      &ulln, &junk) == 1) {
+      FLAGS_hard_pending_compaction_bytes_limit = ulln;
+    } else if (sscanf(argv[i], "--delayed_write_rate=%llu%c", &ulln, &junk) ==
+               1) {
+      FLAGS_delayed_write_rate = ulln;
+    } else if (sscanf(argv[i], "--use_direct_reads=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_direct_reads = n;
+    } else if (sscanf(argv[i], "--use_direct_io_for_flush_and_compaction=%d%c",
+                      &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_direct_io_for_flush_and_compaction = n;
+    } else if (sscanf(argv[i], "--multiread_batch_size=%d%c", &n, &junk) ==
+                   1 &&
+               n > 0) {
+      FLAGS_multiread_batch_size = n;
     } else if (sscanf(argv[i], "--open_files=%d%c", &n, &junk) == 1) {
       FLAGS_open_files = n;
     } else if (strncmp(argv[i], "--db=", 5) == 0) {
       FLAGS_db = argv[i] + 5;
+    } else if (sscanf(argv[i], "--use_nvm=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_nvm = n;
     } else if (strncmp(argv[i], "--nvm", 5) == 0) {
       FLAGS_use_nvm = true;
     } else if (sscanf(argv[i], "--db_size=%d%c", &n, &junk) == 1) {
@@ -1144,6 +2290,9 @@ int main(int argc, char** argv) {
     }
   }
 
+#ifdef PERF_LOG
+  leveldb::init_log_file(FLAGS_perf_log_dir);
+#endif
   leveldb::g_env = leveldb::Env::Default();
 
   // Choose a location for the test database if none given with --db=<path>
@@ -1155,8 +2304,5 @@ int main(int argc, char** argv) {
 
   leveldb::Benchmark benchmark;
   benchmark.Run();
-#ifdef PERF_LOG
-  leveldb::benchmark::ClosePerfLog();
-#endif
   return 0;
 }
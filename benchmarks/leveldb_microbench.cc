@@ -0,0 +1,358 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Micro-benchmarks for the data structures on the hot paths of reads and
+// writes, measured in isolation from the rest of the database.  Run with
+// --benchmark_filter=<regex> to pick benchmarks.  The persistent skiplist
+// maps its file in the test directory, so point TEST_TMPDIR at a DAX
+// mount to measure real persistent memory.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "db/dbformat.h"
+#include "db/skiplist.h"
+#include "leveldb/cache.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/options.h"
+#include "nvm_mod/nvm_option.h"
+#include "nvm_mod/persistent_skiplist.h"
+#include "nvm_mod/pmem_manager.h"
+#include "port/port.h"
+#include "table/block.h"
+#include "table/block_builder.h"
+#include "table/format.h"
+#include "util/allocator.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/mutexlock.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+namespace {
+
+// A bijection on 64-bit integers, so that distinct counters give distinct
+// keys in a random-looking order.
+uint64_t Scramble(uint64_t x) {
+  x *= 0x9e3779b97f4a7c15ull;
+  return x ^ (x >> 29);
+}
+
+struct U64Comparator {
+  int operator()(const uint64_t& a, const uint64_t& b) const {
+    return a < b ? -1 : (a > b ? 1 : 0);
+  }
+};
+
+typedef SkipList<uint64_t, U64Comparator> U64SkipList;
+
+// A skiplist that several threads insert into under a lock, the way
+// writers share a memtable.  Readers need no lock.
+struct SharedSkipList {
+  SharedSkipList() : list(U64Comparator(), &arena), next(0) {}
+
+  port::Mutex mu;
+  Arena arena;
+  U64SkipList list;
+  std::atomic<uint64_t> next;
+};
+
+SharedSkipList* shared_skiplist = nullptr;
+
+void BM_SkipListInsert(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    shared_skiplist = new SharedSkipList;
+  }
+  for (auto _ : state) {
+    const uint64_t key = Scramble(
+        shared_skiplist->next.fetch_add(1, std::memory_order_relaxed));
+    MutexLock l(&shared_skiplist->mu);
+    shared_skiplist->list.Insert(key);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete shared_skiplist;
+    shared_skiplist = nullptr;
+  }
+}
+BENCHMARK(BM_SkipListInsert)->ThreadRange(1, 32)->UseRealTime();
+
+// Seeks in a list of state.range(0) keys.
+void BM_SkipListSeek(benchmark::State& state) {
+  const int num_keys = state.range(0);
+  if (state.thread_index() == 0) {
+    shared_skiplist = new SharedSkipList;
+    MutexLock l(&shared_skiplist->mu);
+    for (int i = 0; i < num_keys; i++) {
+      shared_skiplist->list.Insert(Scramble(i));
+    }
+  }
+  Random rnd(301 + state.thread_index());
+  for (auto _ : state) {
+    // Thread 0 only builds the list before the loop starts.
+    U64SkipList::Iterator iter(&shared_skiplist->list);
+    iter.Seek(Scramble(rnd.Uniform(num_keys)));
+    benchmark::DoNotOptimize(iter.Valid());
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete shared_skiplist;
+    shared_skiplist = nullptr;
+  }
+}
+BENCHMARK(BM_SkipListSeek)->Arg(100000)->ThreadRange(1, 32)->UseRealTime();
+
+// Bump allocation over one heap buffer.  Stands in for PmemManager when
+// measuring the persistent skiplist without the cost of persisting.
+class VolatileAllocator : public Allocator {
+ public:
+  explicit VolatileAllocator(size_t capacity)
+      : start_(new char[capacity]), capacity_(capacity), used_(0) {
+    std::memset(start_, 0, capacity_);
+  }
+  ~VolatileAllocator() override { delete[] start_; }
+
+  char* Allocate(size_t bytes) override {
+    if (bytes > capacity_ - used_) return nullptr;
+    char* result = start_ + used_;
+    used_ += bytes;
+    return result;
+  }
+  char* AllocateAligned(size_t bytes) override {
+    used_ = (used_ + 7) & ~static_cast<size_t>(7);
+    return Allocate(bytes);
+  }
+  size_t MemoryUsage() const override { return used_; }
+  void Clear() override { used_ = 0; }
+  void Sync() override {}
+  void flush(const char* addr, size_t len) override {}
+  char* GetDataStart() override { return start_; }
+
+ private:
+  char* const start_;
+  const size_t capacity_;
+  size_t used_;
+};
+
+// Orders 8-byte keys stored in the allocator by their fixed64 encoding.
+struct Fixed64Comparator {
+  int operator()(const char* a, const char* b) const {
+    const uint64_t x = DecodeFixed64(a);
+    const uint64_t y = DecodeFixed64(b);
+    return x < y ? -1 : (x > y ? 1 : 0);
+  }
+};
+
+typedef PersistentSkipList<Fixed64Comparator> NvmSkipList;
+
+// Inserts into the persistent skiplist, with every update flushed to the
+// mapped file (state.range(0) == 1) or kept in DRAM without flushes (0).
+void BM_NvmSkipListInsert(benchmark::State& state) {
+  const bool persist = state.range(0) != 0;
+  const size_t kBufferSize = 64 << 20;
+  NVMOption nvm_option;
+  // PmemManager maps 2.5 times the write buffer size.
+  nvm_option.write_buffer_size = static_cast<size_t>(kBufferSize / 2.5);
+  std::string filename;
+  Allocator* allocator;
+  if (persist) {
+    Env::Default()->GetTestDirectory(&nvm_option.pmem_path);
+    filename = nvm_option.pmem_path + "/microbench_skiplist.pool";
+    allocator = new PmemManager(&nvm_option, filename);
+  } else {
+    allocator = new VolatileAllocator(kBufferSize);
+  }
+  allocator->Clear();
+  NvmSkipList* list = new NvmSkipList(Fixed64Comparator(), allocator, 0);
+  list->Clear();
+
+  uint64_t i = 0;
+  for (auto _ : state) {
+    if (allocator->MemoryUsage() > kBufferSize - (1 << 20)) {
+      // Start over before the mapping fills up.
+      state.PauseTiming();
+      delete list;
+      allocator->Clear();
+      list = new NvmSkipList(Fixed64Comparator(), allocator, 0);
+      list->Clear();
+      state.ResumeTiming();
+    }
+    char* key = allocator->Allocate(8);
+    EncodeFixed64(key, Scramble(i++));
+    allocator->flush(key, 8);
+    list->Insert(key);
+  }
+  state.SetItemsProcessed(state.iterations());
+  delete list;
+  delete allocator;
+  if (persist) {
+    Env::Default()->RemoveFile(filename);
+  }
+}
+BENCHMARK(BM_NvmSkipListInsert)->Arg(0)->Arg(1);
+
+// Encodes and decodes 1000 varints of up to state.range(0) bytes.
+void BM_Varint64(benchmark::State& state, bool decode) {
+  const int max_bytes = state.range(0);
+  Random rnd(301);
+  std::vector<uint64_t> values(1000);
+  for (uint64_t& v : values) {
+    const int bits = 1 + rnd.Uniform(std::min(7 * max_bytes, 64));
+    v = ((static_cast<uint64_t>(rnd.Next()) << 32) | rnd.Next()) &
+        (bits == 64 ? ~0ull : (1ull << bits) - 1);
+  }
+  std::string encoded;
+  for (uint64_t v : values) {
+    PutVarint64(&encoded, v);
+  }
+  char buf[10 * 1000];
+  for (auto _ : state) {
+    if (decode) {
+      const char* p = encoded.data();
+      const char* limit = p + encoded.size();
+      uint64_t v;
+      while (p < limit) {
+        p = GetVarint64Ptr(p, limit, &v);
+        benchmark::DoNotOptimize(v);
+      }
+    } else {
+      char* p = buf;
+      for (uint64_t v : values) {
+        p = EncodeVarint64(p, v);
+      }
+      benchmark::DoNotOptimize(p);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+  state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+BENCHMARK_CAPTURE(BM_Varint64, Encode, false)->Arg(1)->Arg(5)->Arg(10);
+BENCHMARK_CAPTURE(BM_Varint64, Decode, true)->Arg(1)->Arg(5)->Arg(10);
+
+// Point lookups in a data block of state.range(0) entries, with the hash
+// index (state.range(1) == 1) or binary search over the restart points.
+void BM_BlockSeek(benchmark::State& state) {
+  const int num_entries = state.range(0);
+  InternalKeyComparator icmp(BytewiseComparator());
+  Options options;
+  options.comparator = &icmp;
+  options.data_block_hash_index = state.range(1) != 0;
+  BlockBuilder builder(&options);
+  std::vector<std::string> user_keys;
+  char buf[32];
+  for (int i = 0; i < num_entries; i++) {
+    std::snprintf(buf, sizeof(buf), "%016d", i);
+    user_keys.push_back(buf);
+    std::string key;
+    AppendInternalKey(&key, ParsedInternalKey(buf, 100, kTypeValue));
+    builder.Add(key, std::string(100, 'v'));
+  }
+  const std::string storage = builder.Finish().ToString();
+  BlockContents contents;
+  contents.data = storage;
+  contents.cachable = false;
+  contents.heap_allocated = false;
+  Block block(contents);
+  Iterator* iter = block.NewIterator(&icmp, /*point_lookup=*/true);
+
+  Random rnd(301);
+  for (auto _ : state) {
+    LookupKey lkey(user_keys[rnd.Uniform(num_entries)], 200);
+    iter->Seek(lkey.internal_key());
+    benchmark::DoNotOptimize(iter->Valid());
+  }
+  delete iter;
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlockSeek)->ArgsProduct({{16, 64, 256}, {0, 1}});
+
+// Probes a bloom filter over 10000 keys with keys that were added (hits)
+// and keys that were not (misses).
+void BM_BloomProbe(benchmark::State& state, bool hit) {
+  const FilterPolicy* policy = NewBloomFilterPolicy(10);
+  const int kNumKeys = 10000;
+  std::vector<std::string> keys;
+  char buf[32];
+  for (int i = 0; i < 2 * kNumKeys; i++) {
+    std::snprintf(buf, sizeof(buf), "%016d", i);
+    keys.push_back(buf);
+  }
+  std::vector<Slice> added(keys.begin(), keys.begin() + kNumKeys);
+  std::string filter;
+  policy->CreateFilter(added.data(), kNumKeys, &filter);
+
+  Random rnd(301);
+  const int base = hit ? 0 : kNumKeys;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        policy->KeyMayMatch(keys[base + rnd.Uniform(kNumKeys)], filter));
+  }
+  state.SetItemsProcessed(state.iterations());
+  delete policy;
+}
+BENCHMARK_CAPTURE(BM_BloomProbe, Hit, true);
+BENCHMARK_CAPTURE(BM_BloomProbe, Miss, false);
+
+void BM_Crc32c(benchmark::State& state) {
+  const std::string data(state.range(0), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crc32c::Value(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc32c)->Arg(64)->Arg(4096)->Arg(65536);
+
+void DeleteNothing(const Slice& key, void* value) {}
+
+Cache* shared_cache = nullptr;
+
+// Lookups that hit in an LRU (state.range(0) == 0) or CLOCK (1) cache of
+// 10000 entries.
+void BM_CacheLookup(benchmark::State& state) {
+  const int kNumEntries = 10000;
+  if (state.thread_index() == 0) {
+    CacheOptions options;
+    options.capacity = kNumEntries * 2;
+    options.estimated_entry_charge = 1;
+    shared_cache = state.range(0) == 0 ? NewLRUCache(options)
+                                       : NewClockCache(options);
+    for (int i = 0; i < kNumEntries; i++) {
+      std::string key;
+      PutFixed64(&key, i);
+      shared_cache->Release(shared_cache->Insert(key, nullptr, 1,
+                                                 &DeleteNothing));
+    }
+  }
+  Random rnd(301 + state.thread_index());
+  char key[8];
+  for (auto _ : state) {
+    EncodeFixed64(key, rnd.Uniform(kNumEntries));
+    Cache::Handle* handle = shared_cache->Lookup(Slice(key, sizeof(key)));
+    if (handle != nullptr) {
+      shared_cache->Release(handle);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete shared_cache;
+    shared_cache = nullptr;
+  }
+}
+BENCHMARK(BM_CacheLookup)->Arg(0)->Arg(1)->ThreadRange(1, 32)->UseRealTime();
+
+}  // namespace
+
+}  // namespace leveldb
+
+BENCHMARK_MAIN();
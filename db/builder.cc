@@ -11,9 +11,52 @@
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/rate_limiter.h"
+#include "table/table_internal.h"
 
 namespace leveldb {
 
+namespace {
+
+// Charges every append to a table file against a RateLimiter.
+class RateLimitedFile : public WritableFile {
+ public:
+  // Takes ownership of "file".
+  RateLimitedFile(WritableFile* file, RateLimiter* limiter)
+      : file_(file), limiter_(limiter) {}
+  ~RateLimitedFile() override { delete file_; }
+
+  Status Append(const Slice& data) override {
+    limiter_->Request(data.size());
+    return file_->Append(data);
+  }
+  Status Close() override { return file_->Close(); }
+  Status Flush() override { return file_->Flush(); }
+  Status Sync() override { return file_->Sync(); }
+
+ private:
+  WritableFile* const file_;
+  RateLimiter* const limiter_;
+};
+
+}  // namespace
+
+Status NewTableFile(Env* env, const Options& options, const std::string& fname,
+                    WritableFile** file) {
+  Status s;
+  if (!options.use_direct_io_for_flush_and_compaction) {
+    s = env->NewWritableFile(fname, file);
+  } else {
+    FileOptions file_options;
+    file_options.use_direct_io = true;
+    s = env->NewWritableFile(fname, file_options, file);
+  }
+  if (s.ok() && options.rate_limiter != nullptr) {
+    *file = new RateLimitedFile(*file, options.rate_limiter);
+  }
+  return s;
+}
+
 Status BuildTable(const std::string& dbname, Env* env, const Options& options,
                   TableCache* table_cache, Iterator* iter, FileMetaData* meta) {
   Status s;
@@ -23,13 +66,14 @@ Status BuildTable(const std::string& dbname, Env* env, const Options& options,
   std::string fname = TableFileName(dbname, meta->number);
   if (iter->Valid()) {
     WritableFile* file;
-    s = env->NewWritableFile(fname, &file);
+    s = NewTableFile(env, options, fname, &file);
     if (!s.ok()) {
       return s;
     }
 
     // 新建sstable
     TableBuilder* builder = new TableBuilder(options, file);
+    TableInternal::SetInternalKeys(builder);
     // 因为跳表是有序的，所以第一个key肯定是最小的
     meta->smallest.DecodeFrom(iter->key());
 
@@ -16,6 +16,7 @@ class Env;
 class Iterator;
 class TableCache;
 class VersionEdit;
+class WritableFile;
 
 // Build a Table file from the contents of *iter.  The generated file
 // will be named according to meta->number.  On success, the rest of
@@ -25,6 +26,12 @@ class VersionEdit;
 Status BuildTable(const std::string& dbname, Env* env, const Options& options,
                   TableCache* table_cache, Iterator* iter, FileMetaData* meta);
 
+// Create the file "fname" for a table written by a flush or a compaction,
+// with direct I/O if options.use_direct_io_for_flush_and_compaction is set
+// and throttled by options.rate_limiter.
+Status NewTableFile(Env* env, const Options& options, const std::string& fname,
+                    WritableFile** file);
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_DB_BUILDER_H_
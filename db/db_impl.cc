@@ -8,6 +8,7 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -19,11 +20,14 @@
 #include "db/log_reader.h"
 #include "db/log_writer.h"
 #include "db/memtable.h"
+#include "db/merge_helper.h"
 #include "db/table_cache.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
+#include "leveldb/compaction_filter.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/rate_limiter.h"
 #include "leveldb/status.h"
 #include "leveldb/table.h"
 #include "leveldb/table_builder.h"
@@ -32,11 +36,14 @@
 #include "port/port.h"
 #include "table/block.h"
 #include "table/merger.h"
+#include "table/table_internal.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
 #include "util/my_log.h"
+#include "util/perf_context_imp.h"
+#include "util/statistics.h"
 #ifdef PERF_LOG
 #include "util/perf_log.h"
 #endif
@@ -45,6 +52,11 @@ namespace leveldb {
 
 const int kNumNonTableCacheFiles = 10;
 
+// Longest a single write sleeps while writes are being paced.  Any delay
+// beyond this stays owed in the write controller and is paid by the
+// following writes.
+static const uint64_t kMaxWriteDelayMicros = 1000000;
+
 // Information kept for every waiting writer
 struct DBImpl::Writer {
   explicit Writer(port::Mutex* mu)
@@ -98,6 +110,7 @@ struct DBImpl::CompactionState {
   explicit CompactionState(Compaction* c)
       : compaction(c),
         smallest_snapshot(0),
+        newest_snapshot(0),
         outfile(nullptr),
         builder(nullptr),
         total_bytes(0) {}
@@ -110,6 +123,10 @@ struct DBImpl::CompactionState {
   // we can drop all entries for the same key with sequence numbers < S.
   SequenceNumber smallest_snapshot;
 
+  // Entries with sequence numbers > newest_snapshot are not visible to
+  // any live snapshot.  Zero if there are no snapshots.
+  SequenceNumber newest_snapshot;
+
   std::vector<Output> outputs;
 
   // State kept for output being generated
@@ -136,6 +153,27 @@ Options SanitizeOptions(const std::string& dbname,
   // ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
   ClipToRange(&result.max_file_size, 1 << 20, 1 << 30);
   ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+  ClipToRange(&result.max_bytes_for_level_base, uint64_t{1} << 10,
+              uint64_t{1} << 40);
+  ClipToRange(&result.max_bytes_for_level_multiplier, 2.0, 1000.0);
+  ClipToRange(&result.universal_size_ratio, 0, 1 << 20);
+  ClipToRange(&result.universal_min_merge_width, 2, 1 << 20);
+  ClipToRange(&result.universal_max_merge_width, 0, 1 << 20);
+  ClipToRange(&result.universal_max_size_amplification_percent, 0, 1 << 20);
+  ClipToRange(&result.level0_file_num_compaction_trigger, 1, 1 << 10);
+  ClipToRange(&result.level0_slowdown_writes_trigger,
+              result.level0_file_num_compaction_trigger, 1 << 10);
+  ClipToRange(&result.level0_stop_writes_trigger,
+              result.level0_slowdown_writes_trigger, 1 << 10);
+  if (result.hard_pending_compaction_bytes_limit != 0 &&
+      result.soft_pending_compaction_bytes_limit >
+          result.hard_pending_compaction_bytes_limit) {
+    result.soft_pending_compaction_bytes_limit =
+        result.hard_pending_compaction_bytes_limit;
+  }
+  if (result.delayed_write_rate == 0) {
+    result.delayed_write_rate = Options().delayed_write_rate;
+  }
   if (result.info_log == nullptr) {
     // Open a log file in the same directory as the db
     src.env->CreateDir(dbname);  // In case it does not exist
@@ -178,23 +216,34 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
       logfile_number_(0),
       log_(nullptr),
       seed_(0),
+      write_stall_condition_(kWriteStallNormal),
+      first_recyclable_log_(0),
       tmp_batch_(new WriteBatch),
       background_compaction_scheduled_(false),
+      block_cache_warmup_threads_(0),
       manual_compaction_(nullptr),
       use_nvm_mem_module(raw_options.nvm_option.use_nvm_mem_module),
       current_write_buffer_size(options_.write_buffer_size),
       versions_(new VersionSet(dbname_, &options_, table_cache_,
-                               &internal_comparator_)) {}
+                               &internal_comparator_)),
+      flushed_bytes_(0) {}
 
 DBImpl::~DBImpl() {
   // Wait for background work to finish.
   mutex_.Lock();
   shutting_down_.store(true, std::memory_order_release);
-  while (background_compaction_scheduled_) {
+  while (background_compaction_scheduled_ || block_cache_warmup_threads_ > 0) {
     background_work_finished_signal_.Wait();
   }
+  if (options_.persist_block_cache_keys && db_lock_ != nullptr) {
+    DumpBlockCacheKeys();
+  }
   mutex_.Unlock();
 
+  if (options_.rate_limiter != nullptr) {
+    options_.rate_limiter->SetCompactionPressure(this, 0);
+  }
+
   if (db_lock_ != nullptr) {
     env_->UnlockFile(db_lock_);
   }
@@ -300,6 +349,10 @@ void DBImpl::RemoveObsoleteFiles() {
       bool keep = true;
       switch (type) {
         case kLogFile:
+          keep = ((number >= versions_->LogNumber()) ||
+                  (number == versions_->PrevLogNumber()) ||
+                  KeepLogForRecycling(number));
+          break;
         case kMapFile:
           keep = ((number >= versions_->LogNumber()) ||
                   (number == versions_->PrevLogNumber()));
@@ -320,6 +373,7 @@ void DBImpl::RemoveObsoleteFiles() {
         case kCurrentFile:
         case kDBLockFile:
         case kInfoLogFile:
+        case kBlockCacheKeysFile:
           keep = true;
           break;
       }
@@ -356,6 +410,65 @@ void DBImpl::RemoveObsoleteFiles() {
   mutex_.Lock();
 }
 
+bool DBImpl::KeepLogForRecycling(uint64_t number) {
+  mutex_.AssertHeld();
+  if (first_recyclable_log_ == 0 || number < first_recyclable_log_) {
+    return false;
+  }
+  if (std::find(log_recycle_files_.begin(), log_recycle_files_.end(),
+                number) != log_recycle_files_.end()) {
+    return true;
+  }
+  if (log_recycle_files_.size() >= options_.recycle_log_file_num) {
+    return false;
+  }
+  log_recycle_files_.push_back(number);
+  return true;
+}
+
+Status DBImpl::NewLogFile(uint64_t log_number, WritableFile** file,
+                          log::Writer** writer) {
+  mutex_.AssertHeld();
+  const std::string fname = LogFileName(dbname_, log_number);
+  FileOptions file_options;
+  if (options_.preallocate_log_files) {
+    file_options.preallocation_size =
+        options_.write_buffer_size + options_.write_buffer_size / 10;
+  }
+
+  Status s;
+  bool reused = false;
+  while (!reused && !log_recycle_files_.empty()) {
+    const uint64_t old_number = log_recycle_files_.front();
+    log_recycle_files_.pop_front();
+    reused = env_->ReuseWritableFile(fname, LogFileName(dbname_, old_number),
+                                     file_options, file)
+                 .ok();
+    if (reused) {
+      Log(options_.info_log, "Recycling log #%llu as #%llu\n",
+          static_cast<unsigned long long>(old_number),
+          static_cast<unsigned long long>(log_number));
+    }
+  }
+  if (!reused) {
+    if (file_options.preallocation_size > 0) {
+      s = env_->NewWritableFile(fname, file_options, file);
+    } else {
+      s = env_->NewWritableFile(fname, file);
+    }
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  const bool recycle = options_.recycle_log_file_num > 0;
+  if (recycle && first_recyclable_log_ == 0) {
+    first_recyclable_log_ = log_number;
+  }
+  *writer = new log::Writer(*file, log_number, recycle);
+  return s;
+}
+
 Status DBImpl::Recover(VersionEdit* edit, bool* save_manifest) {
   mutex_.AssertHeld();
 
@@ -548,7 +661,8 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
   // paranoid_checks==false so that corruptions cause entire commits
   // to be skipped instead of propagating bad information (like overly
   // large sequence numbers).
-  log::Reader reader(file, &reporter, true /*checksum*/, 0 /*initial_offset*/);
+  log::Reader reader(file, &reporter, true /*checksum*/, 0 /*initial_offset*/,
+                     log_number);
   Log(options_.info_log, "Recovering log #%llu",
       (unsigned long long)log_number);
 #ifdef PERF_LOG
@@ -591,7 +705,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
     if (mem->ApproximateMemoryUsage() > options_.write_buffer_size) {
       compactions++;
       *save_manifest = true;
-      status = WriteLevel0Table(mem, edit, nullptr);
+      status = WriteLevel0Table(mem, edit, nullptr, nullptr);
       mem->Unref();
       mem = nullptr;
       if (!status.ok()) {
@@ -604,8 +718,10 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
 
   delete file;
 
-  // See if we should keep reusing the last log file.
-  if (status.ok() && options_.reuse_logs && last_log && compactions == 0) {
+  // See if we should keep reusing the last log file.  Recyclable logs may
+  // hold stale data past their end, so they cannot be appended to.
+  if (status.ok() && options_.reuse_logs && last_log && compactions == 0 &&
+      !reader.Recyclable()) {
     assert(logfile_ == nullptr);
     assert(log_ == nullptr);
     assert(mem_ == nullptr);
@@ -632,7 +748,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
     // mem did not get reused; compact it.
     if (status.ok()) {
       *save_manifest = true;
-      status = WriteLevel0Table(mem, edit, nullptr);
+      status = WriteLevel0Table(mem, edit, nullptr, nullptr);
     }
     mem->Unref();
   }
@@ -644,7 +760,7 @@ Status DBImpl::RecoverMapFile(uint64_t map_number, bool* save_manifest,
   mutex_.AssertHeld();
   if (mem_ != nullptr) {
     *save_manifest = true;
-    Status s = WriteLevel0Table(mem_, edit, nullptr);
+    Status s = WriteLevel0Table(mem_, edit, nullptr, nullptr);
     if (!s.ok()) return s;
     mem_->Unref();
     mem_ = nullptr;
@@ -652,7 +768,8 @@ Status DBImpl::RecoverMapFile(uint64_t map_number, bool* save_manifest,
   logfile_number_ = map_number;
   std::string fname = MapFileName(dbname_nvm_, map_number);
   MemTableRep* mem =
-      new MemTableNVM(internal_comparator_, &options_.nvm_option, fname);
+      new MemTableNVM(internal_comparator_, &options_.nvm_option, fname,
+                      options_.statistics);
   mem->Ref();
   *max_sequence = mem->GetMaxSequenceNumber();
   mem_ = mem;
@@ -660,7 +777,7 @@ Status DBImpl::RecoverMapFile(uint64_t map_number, bool* save_manifest,
   return Status::OK();
 }
 Status DBImpl::WriteLevel0Table(MemTableRep* mem, VersionEdit* edit,
-                                Version* base) {
+                                Version* base, FlushJobInfo* info) {
   mutex_.AssertHeld();
   const uint64_t start_micros = env_->NowMicros();
   FileMetaData meta;
@@ -718,6 +835,15 @@ Status DBImpl::WriteLevel0Table(MemTableRep* mem, VersionEdit* edit,
   stats.micros = env_->NowMicros() - start_micros;
   stats.bytes_written = meta.file_size;
   stats_[level].Add(stats);
+  flushed_bytes_ += meta.file_size;
+  RecordTick(options_.statistics, kFlushWriteBytes, meta.file_size);
+  if (info != nullptr) {
+    info->file_number = meta.number;
+    info->file_size = meta.file_size;
+    info->level = level;
+    info->micros = stats.micros;
+    info->status = s;
+  }
   return s;
 }
 
@@ -725,12 +851,24 @@ void DBImpl::CompactMemTable() {
   mutex_.AssertHeld();
   assert(imm_ != nullptr);
 
+  FlushJobInfo info;
+  info.db_name = dbname_;
+  info.from_nvm = imm_->IsPersistent();
+  if (!options_.listeners.empty()) {
+    // Only this thread flushes, so imm_ stays put while unlocked.
+    mutex_.Unlock();
+    for (EventListener* listener : options_.listeners) {
+      listener->OnFlushBegin(this, info);
+    }
+    mutex_.Lock();
+  }
+
   // Save the contents of the memtable as a new Table
   VersionEdit edit;
   Version* base = versions_->current();
   base->Ref();
   // 将数据写入到第0层（实际上不一定是第0层)
-  Status s = WriteLevel0Table(imm_, &edit, base);
+  Status s = WriteLevel0Table(imm_, &edit, base, &info);
   base->Unref();
 
   if (s.ok() && shutting_down_.load(std::memory_order_acquire)) {
@@ -750,9 +888,19 @@ void DBImpl::CompactMemTable() {
     imm_ = nullptr;
     has_imm_.store(false, std::memory_order_release);
     RemoveObsoleteFiles();
+    ReportCompactionPressure();
   } else {
     RecordBackgroundError(s);
   }
+
+  if (!options_.listeners.empty()) {
+    info.status = s;
+    mutex_.Unlock();
+    for (EventListener* listener : options_.listeners) {
+      listener->OnFlushCompleted(this, info);
+    }
+    mutex_.Lock();
+  }
 }
 
 void DBImpl::CompactRange(const Slice* begin, const Slice* end) {
@@ -853,10 +1001,136 @@ void DBImpl::MaybeScheduleCompaction() {
   }
 }
 
+// The BLOCK_CACHE_KEYS file is a sequence of per-table records:
+//    file_number: varint64
+//    file_size:   varint64
+//    count:       varint32
+//    offsets:     count varint64 deltas from the previous offset
+void DBImpl::DumpBlockCacheKeys() {
+  mutex_.AssertHeld();
+  std::map<uint64_t, uint64_t> live;
+  versions_->CurrentFileSizes(&live);
+  std::map<uint64_t, std::vector<uint64_t>> blocks;
+  table_cache_->GetCachedBlocks(&blocks);
+
+  std::string contents;
+  for (const auto& file : blocks) {
+    auto iter = live.find(file.first);
+    if (iter == live.end()) {
+      continue;
+    }
+    PutVarint64(&contents, file.first);
+    PutVarint64(&contents, iter->second);
+    PutVarint32(&contents, static_cast<uint32_t>(file.second.size()));
+    uint64_t prev = 0;
+    for (uint64_t offset : file.second) {
+      PutVarint64(&contents, offset - prev);
+      prev = offset;
+    }
+  }
+
+  const std::string fname = BlockCacheKeysFileName(dbname_);
+  const std::string tmp = fname + ".tmp";
+  Status s = WriteStringToFile(env_, contents, tmp);
+  if (s.ok()) {
+    s = env_->RenameFile(tmp, fname);
+  }
+  if (!s.ok()) {
+    env_->RemoveFile(tmp);
+    Log(options_.info_log, "Dumping block cache keys: %s",
+        s.ToString().c_str());
+  }
+}
+
+void DBImpl::StartBlockCacheWarmup() {
+  mutex_.AssertHeld();
+  const std::string fname = BlockCacheKeysFileName(dbname_);
+  std::string contents;
+  if (!env_->FileExists(fname) ||
+      !ReadFileToString(env_, fname, &contents).ok()) {
+    return;
+  }
+  // The file describes a single restart; tables may be rewritten before
+  // the next one.
+  env_->RemoveFile(fname);
+
+  std::map<uint64_t, uint64_t> live;
+  versions_->CurrentFileSizes(&live);
+  Slice input(contents);
+  BlockCacheWarmup warmup;
+  uint32_t count;
+  while (GetVarint64(&input, &warmup.file_number) &&
+         GetVarint64(&input, &warmup.file_size) &&
+         GetVarint32(&input, &count)) {
+    warmup.offsets.clear();
+    uint64_t offset = 0;
+    uint64_t delta;
+    while (warmup.offsets.size() < count && GetVarint64(&input, &delta)) {
+      offset += delta;
+      warmup.offsets.push_back(offset);
+    }
+    auto iter = live.find(warmup.file_number);
+    if (iter != live.end() && iter->second == warmup.file_size) {
+      block_cache_warmups_.push_back(warmup);
+    }
+  }
+
+  const int kMaxWarmupThreads = 4;
+  while (block_cache_warmup_threads_ < kMaxWarmupThreads &&
+         block_cache_warmup_threads_ <
+             static_cast<int>(block_cache_warmups_.size())) {
+    block_cache_warmup_threads_++;
+    env_->StartThread(&DBImpl::BlockCacheWarmupWork, this);
+  }
+}
+
+void DBImpl::TEST_WaitForBlockCacheWarmup() {
+  MutexLock l(&mutex_);
+  while (block_cache_warmup_threads_ > 0) {
+    background_work_finished_signal_.Wait();
+  }
+}
+
+void DBImpl::BlockCacheWarmupWork(void* db) {
+  reinterpret_cast<DBImpl*>(db)->BlockCacheWarmupCall();
+}
+
+void DBImpl::BlockCacheWarmupCall() {
+  MutexLock l(&mutex_);
+  while (!block_cache_warmups_.empty() &&
+         !shutting_down_.load(std::memory_order_acquire)) {
+    BlockCacheWarmup warmup = block_cache_warmups_.front();
+    block_cache_warmups_.pop_front();
+    mutex_.Unlock();
+    // Errors are harmless: the table may have been compacted away since.
+    table_cache_->WarmBlocks(warmup.file_number, warmup.file_size,
+                             warmup.offsets, &shutting_down_);
+    mutex_.Lock();
+  }
+  block_cache_warmup_threads_--;
+  background_work_finished_signal_.SignalAll();
+}
+
 void DBImpl::BGWork(void* db) {
   reinterpret_cast<DBImpl*>(db)->BackgroundCall();
 }
 
+void DBImpl::ReportCompactionPressure() {
+  mutex_.AssertHeld();
+  if (options_.rate_limiter == nullptr) {
+    return;
+  }
+  // Zero at the compaction trigger, one at the slowdown trigger.
+  const int trigger = options_.level0_file_num_compaction_trigger;
+  const int slowdown = options_.level0_slowdown_writes_trigger;
+  const double pressure =
+      slowdown > trigger
+          ? static_cast<double>(versions_->NumLevelFiles(0) - trigger) /
+                (slowdown - trigger)
+          : 1.0;
+  options_.rate_limiter->SetCompactionPressure(this, pressure);
+}
+
 void DBImpl::BackgroundCall() {
   MutexLock l(&mutex_);
   assert(background_compaction_scheduled_);
@@ -869,6 +1143,7 @@ void DBImpl::BackgroundCall() {
   }
 
   background_compaction_scheduled_ = false;
+  ReportCompactionPressure();
 
   // 递归调用compaction，因为有可能这次compaction产生了过多的sst
   // Previous compaction may have produced too many files in a level,
@@ -937,15 +1212,17 @@ void DBImpl::BackgroundCompaction() {
     assert(c->num_input_files(0) == 1);
     FileMetaData* f = c->input(0, 0);
     c->edit()->RemoveFile(c->level(), f->number);
-    c->edit()->AddFile(c->level() + 1, f->number, f->file_size, f->smallest,
+    c->edit()->AddFile(c->output_level(), f->number, f->file_size, f->smallest,
                        f->largest);
     status = versions_->LogAndApply(c->edit(), &mutex_);
     if (!status.ok()) {
       RecordBackgroundError(status);
+    } else if (c->level() == 0) {
+      table_cache_->UnpinMetaBlocks(f->number);
     }
     VersionSet::LevelSummaryStorage tmp;
     Log(options_.info_log, "Moved #%lld to level-%d %lld bytes %s: %s\n",
-        static_cast<unsigned long long>(f->number), c->level() + 1,
+        static_cast<unsigned long long>(f->number), c->output_level(),
         static_cast<unsigned long long>(f->file_size),
         status.ToString().c_str(), versions_->LevelSummary(&tmp));
 #ifdef PERF_LOG
@@ -953,7 +1230,8 @@ void DBImpl::BackgroundCompaction() {
         (env_->NowMicros() - benchmark::bench_start_time) * 1e-6;
     RECORD_INFO(0, "[now:%.4f]:Moved #%lld to level-%d %lld bytes %s: %s\n",
                 relative_now, static_cast<unsigned long long>(f->number),
-                c->level() + 1, static_cast<unsigned long long>(f->file_size),
+                c->output_level(),
+                static_cast<unsigned long long>(f->file_size),
                 status.ToString().c_str(), versions_->LevelSummary(&tmp));
 #endif
   } else {
@@ -1033,13 +1311,38 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
 
   // Make the output file
   std::string fname = TableFileName(dbname_, file_number);
-  Status s = env_->NewWritableFile(fname, &compact->outfile);
+  Status s = NewTableFile(env_, options_, fname, &compact->outfile);
   if (s.ok()) {
     compact->builder = new TableBuilder(options_, compact->outfile);
+    TableInternal::SetInternalKeys(compact->builder);
   }
   return s;
 }
 
+Status DBImpl::AddCompactionOutput(CompactionState* compact,
+                                   Iterator* input, const Slice& key,
+                                   const Slice& value) {
+  // Open output file if necessary
+  if (compact->builder == nullptr) {
+    Status s = OpenCompactionOutputFile(compact);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  if (compact->builder->NumEntries() == 0) {
+    compact->current_output()->smallest.DecodeFrom(key);
+  }
+  compact->current_output()->largest.DecodeFrom(key);
+  compact->builder->Add(key, value);
+
+  // Close output file if it is big enough
+  if (compact->builder->FileSize() >=
+      compact->compaction->MaxOutputFileSize()) {
+    return FinishCompactionOutputFile(compact, input);
+  }
+  return Status::OK();
+}
+
 Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
                                           Iterator* input) {
   assert(compact != nullptr);
@@ -1105,7 +1408,8 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact) {
   mutex_.AssertHeld();
   Log(options_.info_log, "Compacted %d@%d + %d@%d files => %lld bytes",
       compact->compaction->num_input_files(0), compact->compaction->level(),
-      compact->compaction->num_input_files(1), compact->compaction->level() + 1,
+      compact->compaction->num_input_files(1),
+      compact->compaction->output_level(),
       static_cast<long long>(compact->total_bytes));
 #ifdef PERF_LOG
   double relative_now =
@@ -1114,7 +1418,7 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact) {
               relative_now, compact->compaction->num_input_files(0),
               compact->compaction->level(),
               compact->compaction->num_input_files(1),
-              compact->compaction->level() + 1,
+              compact->compaction->output_level(),
               static_cast<long long>(compact->total_bytes));
 #endif
 
@@ -1122,10 +1426,10 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact) {
   // 删除
   compact->compaction->AddInputDeletions(compact->compaction->edit());
   // 添加
-  const int level = compact->compaction->level();
+  const int level = compact->compaction->output_level();
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     const CompactionState::Output& out = compact->outputs[i];
-    compact->compaction->edit()->AddFile(level + 1, out.number, out.file_size,
+    compact->compaction->edit()->AddFile(level, out.number, out.file_size,
                                          out.smallest, out.largest);
   }
   //应用edit
@@ -1143,14 +1447,14 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   Log(options_.info_log, "Compacting %d@%d + %d@%d files",
       compact->compaction->num_input_files(0), compact->compaction->level(),
       compact->compaction->num_input_files(1),
-      compact->compaction->level() + 1);
+      compact->compaction->output_level());
 #ifdef PERF_LOG
   double relative_now =
       (env_->NowMicros() - benchmark::bench_start_time) * 1e-6;
   RECORD_INFO(0, "[now:%.4f]:Compacting %d@%d + %d@%d files\n",
               relative_now,  compact->compaction->num_input_files(0), compact->compaction->level(),
       compact->compaction->num_input_files(1),
-      compact->compaction->level() + 1);
+      compact->compaction->output_level());
 #endif
 
   assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
@@ -1160,22 +1464,53 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   // 记录最老快照，只能删除比最老快照还老的数据，如何表示最老？用序列号，序列号越小代表数据越旧。
   if (snapshots_.empty()) {
     compact->smallest_snapshot = versions_->LastSequence();
+    compact->newest_snapshot = 0;
   } else {
     compact->smallest_snapshot = snapshots_.oldest()->sequence_number();
+    compact->newest_snapshot = snapshots_.newest()->sequence_number();
   }
 
   // 创建迭代器, 内部通过mergeiterator对本次要compaction的文件做“排序”
   Iterator* input = versions_->MakeInputIterator(compact->compaction);
 
+  CompactionJobInfo info;
+  if (!options_.listeners.empty()) {
+    Compaction* const c = compact->compaction;
+    info.db_name = dbname_;
+    info.base_level = c->level();
+    info.output_level = c->output_level();
+    for (int which = 0; which < 2; which++) {
+      const int level = which == 0 ? c->level() : c->output_level();
+      for (int i = 0; i < c->num_input_files(which); i++) {
+        const FileMetaData* f = c->input(which, i);
+        info.inputs.push_back({level, f->number, f->file_size});
+      }
+    }
+    for (int level = c->level() + 1; level < c->output_level(); level++) {
+      for (const FileMetaData* f : c->middle_inputs(level)) {
+        info.inputs.push_back({level, f->number, f->file_size});
+      }
+    }
+  }
+
   // Release mutex while we're actually doing the compaction work
   mutex_.Unlock();
 
+  for (EventListener* listener : options_.listeners) {
+    listener->OnCompactionBegin(this, info);
+  }
+
   input->SeekToFirst();
   Status status;
   ParsedInternalKey ikey;
   std::string current_user_key;
   bool has_current_user_key = false;
   SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
+  const CompactionFilter* const filter = options_.compaction_filter;
+  std::string filtered_key;
+  std::string filtered_value;
+  const MergeOperator* const merge_operator = options_.merge_operator;
+  MergeHelper merge(user_comparator(), merge_operator);
 
   while (input->Valid() && !shutting_down_.load(std::memory_order_acquire)) {
     // 首先做immtable的dump
@@ -1210,6 +1545,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
     }
 
     Slice key = input->key();
+    Slice value = input->value();
     if (compact->compaction->ShouldStopBefore(key) &&
         compact->builder != nullptr) {
       //检查当前输出文件是否与level+2层文件有过多冲突，如果是就要完成当前输出文件,并产生新的输出文件
@@ -1222,6 +1558,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
     // 丢弃不需要的 kv pairs
     // Handle key/value, add to state, etc.
     bool drop = false;
+    bool merged = false;
     if (!ParseInternalKey(key, &ikey)) {
       // Do not hide error keys
       current_user_key.clear();
@@ -1258,9 +1595,49 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         //     few iterations of this loop (by rule (A) above).
         // Therefore this deletion marker is obsolete and can be dropped.
         drop = true;
+      } else if (filter != nullptr && ikey.type == kTypeValue &&
+                 ikey.sequence > compact->newest_snapshot) {
+        // No snapshot sees this value, so the filter may drop or rewrite
+        // it without changing what a snapshot reads.
+        bool value_changed = false;
+        filtered_value.clear();
+        if (filter->Filter(compact->compaction->level(), ikey.user_key, value,
+                           &filtered_value, &value_changed)) {
+          if (ikey.sequence <= compact->smallest_snapshot &&
+              compact->compaction->IsBaseLevelForKey(ikey.user_key)) {
+            // There are no snapshots, and older values for the key are
+            // dropped by rule (A) or do not exist.
+            drop = true;
+          } else {
+            // Older values kept for snapshots or in higher levels must
+            // stay hidden.
+            filtered_key.clear();
+            AppendInternalKey(&filtered_key,
+                              ParsedInternalKey(ikey.user_key, ikey.sequence,
+                                                kTypeDeletion));
+            key = filtered_key;
+            value = Slice();
+          }
+        } else if (value_changed) {
+          value = filtered_value;
+        }
+      } else if (merge_operator != nullptr && ikey.type == kTypeMerge &&
+                 ikey.sequence <= compact->smallest_snapshot) {
+        // Every snapshot sees this operand and the older entries for the
+        // key, so they can be folded together.  The entries left over
+        // after the first value or deletion are dropped by rule (A).
+        status = merge.MergeUntil(
+            input, compact->compaction->IsBaseLevelForKey(ikey.user_key));
+        merged = true;
       }
 
-      last_sequence_for_key = ikey.sequence;
+      // An operand left unmerged is not a value, so it must not hide the
+      // older entries it applies to.  This happens when the operand is
+      // newer than a snapshot, or when the database was reopened without
+      // a merge operator.
+      if (merged || ikey.type != kTypeMerge) {
+        last_sequence_for_key = ikey.sequence;
+      }
     }
 #if 0
     Log(options_.info_log,
@@ -1272,27 +1649,22 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         (int)last_sequence_for_key, (int)compact->smallest_snapshot);
 #endif
 
-    if (!drop) {
-      // Open output file if necessary
-      if (compact->builder == nullptr) {
-        status = OpenCompactionOutputFile(compact);
-        if (!status.ok()) {
-          break;
-        }
+    if (merged) {
+      // MergeUntil() has already moved input past the merged entries.
+      for (size_t i = 0; status.ok() && i < merge.keys().size(); i++) {
+        status = AddCompactionOutput(compact, input, merge.keys()[i],
+                                     merge.values()[i]);
       }
-      if (compact->builder->NumEntries() == 0) {
-        compact->current_output()->smallest.DecodeFrom(key);
+      if (!status.ok()) {
+        break;
       }
-      compact->current_output()->largest.DecodeFrom(key);
-      compact->builder->Add(key, input->value());
-
-      // Close output file if it is big enough
-      if (compact->builder->FileSize() >=
-          compact->compaction->MaxOutputFileSize()) {
-        status = FinishCompactionOutputFile(compact, input);
-        if (!status.ok()) {
-          break;
-        }
+      continue;
+    }
+
+    if (!drop) {
+      status = AddCompactionOutput(compact, input, key, value);
+      if (!status.ok()) {
+        break;
       }
     }
 
@@ -1319,12 +1691,21 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
       stats.bytes_read += compact->compaction->input(which, i)->file_size;
     }
   }
+  for (int level = compact->compaction->level() + 1;
+       level < compact->compaction->output_level(); level++) {
+    for (FileMetaData* f : compact->compaction->middle_inputs(level)) {
+      stats.bytes_read += f->file_size;
+    }
+  }
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     stats.bytes_written += compact->outputs[i].file_size;
   }
 
+  RecordTick(options_.statistics, kCompactReadBytes, stats.bytes_read);
+  RecordTick(options_.statistics, kCompactWriteBytes, stats.bytes_written);
+
   mutex_.Lock();
-  stats_[compact->compaction->level() + 1].Add(stats);
+  stats_[compact->compaction->output_level()].Add(stats);
 
   //元数据修改
   if (status.ok()) {
@@ -1347,6 +1728,22 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   RECORD_INFO(7, "%.4f,%.4f,%.4f\n", relative_start, relative_end,
               relative_end - relative_start);
 #endif
+
+  if (!options_.listeners.empty()) {
+    for (const CompactionState::Output& out : compact->outputs) {
+      info.outputs.push_back(
+          {compact->compaction->output_level(), out.number, out.file_size});
+    }
+    info.bytes_read = stats.bytes_read;
+    info.bytes_written = stats.bytes_written;
+    info.micros = env_->NowMicros() - start_micros;
+    info.status = status;
+    mutex_.Unlock();
+    for (EventListener* listener : options_.listeners) {
+      listener->OnCompactionCompleted(this, info);
+    }
+    mutex_.Lock();
+  }
   return status;
 }
 
@@ -1415,8 +1812,12 @@ int64_t DBImpl::TEST_MaxNextLevelOverlappingBytes() {
 
 Status DBImpl::Get(const ReadOptions& options, const Slice& key,
                    std::string* value) {
+  Statistics* const statistics = options_.statistics;
+  StopWatch get_sw(env_, statistics, kDbGetMicros);
   Status s;
+  PerfTimer lock_timer(&perf_context.db_mutex_lock_nanos);
   MutexLock l(&mutex_);
+  lock_timer.Stop();
   SequenceNumber snapshot;
 
   // 确定是从哪个snapshot种读取
@@ -1441,37 +1842,46 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
 
   bool have_stat_update = false;
   Version::GetStats stats;
+  MergeContext merge_context;
 
   // Unlock while reading from files and memtables
   {
     mutex_.Unlock();
     LookupKey lkey(key, snapshot);
-#ifdef PERF_LOG
+    // First look in the memtable, then in the immutable memtable (if any).
+    //先向memtable中查询，再向imm查询
     bool found;
-    uint64_t start_micros = env_->NowMicros();
-    found = mem->Get(lkey, value, &seq, &s);
-    if (!found) found = imm != NULL && imm->Get(lkey, value, &seq, &s);
-    benchmark::LogMicros(benchmark::GET_MEMTABLE,
-                         env_->NowMicros() - start_micros);
-    if (!found) {
-      start_micros = env_->NowMicros();
-      s = current->Get(options, lkey, value, &stats);
-      benchmark::LogMicros(benchmark::GET_VERSION,
-                           env_->NowMicros() - start_micros);
-      have_stat_update = true;
+    {
+      StopWatch sw(env_, statistics, kGetMemtableMicros);
+      {
+        PerfTimer timer(&perf_context.get_from_memtable_nanos);
+        found = mem->Get(lkey, value, &seq, &s, &merge_context);
+      }
+      if (!found && imm != nullptr) {
+        PerfTimer timer(&perf_context.get_from_imm_nanos);
+        found = imm->Get(lkey, value, &seq, &s, &merge_context);
+      }
     }
-#else
-    // First look in the memtable, then in the immutable memtable (if any).
-    if (mem->Get(lkey, value, &seq, &s)) {  //先向memtable中查询
-      // Done
-    } else if (imm != nullptr &&
-               imm->Get(lkey, value, &seq, &s)) {  //再向imm查询
-      // Done
+    RecordTick(statistics, found ? kMemtableHit : kMemtableMiss);
+    if (found) {
+      PerfCount(&perf_context.get_from_memtable_count);
     } else {  //最后到外存的sstables中查询
-      s = current->Get(options, lkey, value, &stats);
+      StopWatch sw(env_, statistics, kGetVersionMicros);
+      PerfTimer timer(&perf_context.get_from_output_files_nanos);
+      s = current->Get(options, lkey, value, &stats, &merge_context);
       have_stat_update = true;
     }
-#endif
+    // Apply merge operands to the value they were found on, if any.
+    if (!merge_context.empty() && (s.ok() || s.IsNotFound())) {
+      Slice existing_value(*value);
+      s = merge_context.Merge(options_.merge_operator, key,
+                              s.ok() ? &existing_value : nullptr, value);
+    }
+    RecordTick(statistics, kKeysRead);
+    if (s.ok()) {
+      RecordTick(statistics, kBytesRead, value->size());
+    }
+    PerfTimer relock_timer(&perf_context.db_mutex_lock_nanos);
     mutex_.Lock();
   }
 
@@ -1489,7 +1899,7 @@ Iterator* DBImpl::NewIterator(const ReadOptions& options) {
   SequenceNumber latest_snapshot;
   uint32_t seed;
   Iterator* iter = NewInternalIterator(options, &latest_snapshot, &seed);
-  return NewDBIterator(this, user_comparator(), iter,
+  return NewDBIterator(this, user_comparator(), options_.merge_operator, iter,
                        (options.snapshot != nullptr
                             ? static_cast<const SnapshotImpl*>(options.snapshot)
                                   ->sequence_number()
@@ -1523,8 +1933,24 @@ Status DBImpl::Delete(const WriteOptions& options, const Slice& key) {
   return DB::Delete(options, key);
 }
 
+Status DBImpl::Merge(const WriteOptions& options, const Slice& key,
+                     const Slice& value) {
+  if (options_.merge_operator == nullptr) {
+    return Status::NotSupported("Merge() needs options.merge_operator");
+  }
+  return DB::Merge(options, key, value);
+}
+
 Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates,
                      WriteCallback* callback) {
+  // Without an operator the operands could never be folded into values,
+  // and compactions would treat them as hiding the older entries.
+  if (updates != nullptr && options_.merge_operator == nullptr &&
+      WriteBatchInternal::HasMerge(updates)) {
+    return Status::NotSupported("Merge() needs options.merge_operator");
+  }
+  Statistics* const statistics = options_.statistics;
+  StopWatch write_sw(env_, statistics, kDbWriteMicros);
   // 对于一次写，都将其封装成一个Writer
   Writer w(&mutex_);
   w.batch = updates;
@@ -1544,14 +1970,11 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates,
 
   // 首先要制作出空余空间来写入
   // May temporarily unlock and wait.
-#ifdef PERF_LOG
-  uint64_t micros = env_->NowMicros();
-  Status status = MakeRoomForWrite(updates == nullptr);
-  benchmark::LogMicros(benchmark::FOREGROUND_COMPACTION,
-                       env_->NowMicros() - micros);
-#else
-  Status status = MakeRoomForWrite(updates == nullptr);
-#endif
+  Status status;
+  {
+    StopWatch sw(env_, statistics, kWriteStallMicros);
+    status = MakeRoomForWrite(updates == nullptr);
+  }
 
   uint64_t last_sequence = versions_->LastSequence();
   Writer* last_writer = &w;
@@ -1562,6 +1985,12 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates,
     WriteBatch* write_batch = BuildBatchGroup(&last_writer);
     WriteBatchInternal::SetSequence(write_batch, last_sequence + 1);
     last_sequence += WriteBatchInternal::Count(write_batch);
+    uint64_t delay = 0;
+    if (write_controller_.IsDelayed()) {
+      delay = write_controller_.GetDelay(
+          env_->NowMicros(), WriteBatchInternal::ByteSize(write_batch));
+      delay = std::min(delay, kMaxWriteDelayMicros);
+    }
 
     // Add to log and apply to memtable.  We can release the lock
     // during this phase since &w is currently responsible for logging
@@ -1570,43 +1999,54 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates,
     {
       mutex_.Unlock();
 
+      if (delay > 0) {
+#ifdef PERF_LOG
+        uint64_t start = env_->NowMicros();
+        double relative_start = (start - benchmark::bench_start_time) * 1e-6;
+#endif
+        env_->SleepForMicroseconds(static_cast<int>(delay));
+        RecordTick(statistics, kStallMicros, delay);
+#ifdef PERF_LOG
+        uint64_t end = env_->NowMicros();
+        double relative_end = (end - benchmark::bench_start_time) * 1e-6;
+        RECORD_INFO(3, "%.4f,%.4f,%.4f\n", relative_start, relative_end,
+                    relative_end - relative_start);
+#endif
+      }
+
       bool sync_error = false;
 //添加log
 #ifndef MEM_PERF
-#ifdef PERF_LOG
-      uint64_t micros = env_->NowMicros();
       if (!mem_->IsPersistent()) {
-        status = log_->AddRecord(WriteBatchInternal::Contents(write_batch));
-        if (status.ok() && options.sync) {
-          status = logfile_->Sync();
-          if (!status.ok()) {
-            sync_error = true;
-          }
+        StopWatch sw(env_, statistics, kWriteWalMicros);
+        Slice contents = WriteBatchInternal::Contents(write_batch);
+        {
+          PerfTimer timer(&iostats_context.write_nanos);
+          status = log_->AddRecord(contents);
+        }
+        if (status.ok()) {
+          PerfCount(&iostats_context.bytes_written, contents.size());
         }
-      }
-      benchmark::LogMicros(benchmark::LOG, env_->NowMicros() - micros);
-#else
-      if (!mem_->IsPersistent()) {
-        status = log_->AddRecord(WriteBatchInternal::Contents(write_batch));
         if (status.ok() && options.sync) {
+          PerfTimer timer(&iostats_context.fsync_nanos);
           status = logfile_->Sync();
           if (!status.ok()) {
             sync_error = true;
           }
         }
       }
-#endif
 #endif
 
       //插入到memtable
       if (status.ok()) {
-#ifdef PERF_LOG
-        uint64_t micros = env_->NowMicros();
-        status = WriteBatchInternal::InsertInto(write_batch, mem_);
-        benchmark::LogMicros(benchmark::INSERT, env_->NowMicros() - micros);
-#else
+        StopWatch sw(env_, statistics, kWriteMemtableMicros);
         status = WriteBatchInternal::InsertInto(write_batch, mem_);
-#endif
+      }
+      if (status.ok()) {
+        RecordTick(statistics, kKeysWritten,
+                   WriteBatchInternal::Count(write_batch));
+        RecordTick(statistics, kBytesWritten,
+                   WriteBatchInternal::ByteSize(write_batch));
       }
       mutex_.Lock();
       if (sync_error) {
@@ -1702,6 +2142,64 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
   return result;
 }
 
+void DBImpl::UpdateDelayedWriteRate() {
+  mutex_.AssertHeld();
+  // How far level-0 and the compaction backlog have gone from their soft
+  // limits towards their hard ones; negative if neither has reached it.
+  double pressure = -1;
+  WriteStallCause cause = kWriteStallCauseNone;
+  const int level0_files = versions_->NumLevelFiles(0);
+  const int slowdown = options_.level0_slowdown_writes_trigger;
+  const int stop = options_.level0_stop_writes_trigger;
+  if (level0_files >= slowdown) {
+    pressure = stop > slowdown
+                   ? static_cast<double>(level0_files - slowdown) /
+                         (stop - slowdown)
+                   : 1.0;
+    cause = kWriteStallCauseLevel0Files;
+  }
+  const uint64_t pending = versions_->PendingCompactionBytes();
+  const uint64_t soft = options_.soft_pending_compaction_bytes_limit;
+  const uint64_t hard = options_.hard_pending_compaction_bytes_limit;
+  if (soft != 0 && pending >= soft) {
+    const double backlog_pressure =
+        hard > soft ? static_cast<double>(pending - soft) / (hard - soft)
+                    : 1.0;
+    if (backlog_pressure > pressure) {
+      pressure = backlog_pressure;
+      cause = kWriteStallCausePendingCompactionBytes;
+    }
+  }
+
+  if (pressure < 0) {
+    write_controller_.SetDelayedWriteRate(0);
+    SetWriteStallCondition(kWriteStallNormal, kWriteStallCauseNone);
+    return;
+  }
+  SetWriteStallCondition(kWriteStallDelayed, cause);
+  pressure = std::min(pressure, 1.0);
+  const uint64_t rate = static_cast<uint64_t>(options_.delayed_write_rate *
+                                              (1.0 - 0.9 * pressure));
+  write_controller_.SetDelayedWriteRate(std::max<uint64_t>(rate, 1));
+}
+
+void DBImpl::SetWriteStallCondition(WriteStallCondition condition,
+                                    WriteStallCause cause) {
+  mutex_.AssertHeld();
+  if (condition == write_stall_condition_) {
+    return;
+  }
+  WriteStallInfo info;
+  info.db_name = dbname_;
+  info.previous = write_stall_condition_;
+  info.current = condition;
+  info.cause = cause;
+  write_stall_condition_ = condition;
+  for (EventListener* listener : options_.listeners) {
+    listener->OnStallConditionsChanged(info);
+  }
+}
+
 // REQUIRES: mutex_ is held
 // REQUIRES: this thread is currently at the front of the writer queue
 Status DBImpl::MakeRoomForWrite(bool force) {
@@ -1714,43 +2212,28 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // Yield previous error
       s = bg_error_;
       break;
-    } else if (allow_delay && versions_->NumLevelFiles(0) >=
-                                  config::kL0_SlowdownWritesTrigger) {
-      // 允许当前写延迟，并且level0的个数达到软限制个数
-      // We are getting close to hitting a hard limit on the number of
-      // L0 files.  Rather than delaying a single write by several
-      // seconds when we hit the hard limit, start delaying each
-      // individual write by 1ms to reduce latency variance.  Also,
-      // this delay hands over some CPU to the compaction thread in
-      // case it is sharing the same core as the writer.
-
-#ifdef PERF_LOG
-      uint64_t strat = env_->NowMicros();
-      double relative_start = (strat - benchmark::bench_start_time) * 1e-6;
-#endif
-      mutex_.Unlock();
-      // 让写延迟1ms，休眠期间，让出cpu给compaction thread，
-      //并且不与compaction thread竞争
-      env_->SleepForMicroseconds(1000);
-      allow_delay = false;  // Do not delay a single write more than once
-      mutex_.Lock();
-
-#ifdef PERF_LOG
-      uint64_t end = env_->NowMicros();
-      double relative_end = (end - benchmark::bench_start_time) * 1e-6;
-      RECORD_INFO(3, "%.4f,%.4f,%.4f\n", relative_start, relative_end,
-                  relative_end - relative_start);
-#endif
+    } else if (allow_delay) {
+      // Rather than stopping writes for several seconds when a hard limit
+      // is hit, start pacing them as the limit draws near.  Write() sleeps
+      // accordingly once it knows how much the batch group holds.  This
+      // also hands over some CPU to the compaction thread in case it is
+      // sharing the same core as the writer.
+      UpdateDelayedWriteRate();
+      allow_delay = false;
     } else if (!force &&
                (mem_->ApproximateMemoryUsage() <= current_write_buffer_size)) {
       //有足够的空间
       // There is room in current memtable
+      if (write_stall_condition_ == kWriteStallStopped) {
+        UpdateDelayedWriteRate();
+      }
       break;
     } else if (imm_ != nullptr) {
       // memtable满，等待compactoin
       // We have filled up the current memtable, but the previous
       // one is still being compacted, so we wait.
       Log(options_.info_log, "Current memtable full; waiting...\n");
+      SetWriteStallCondition(kWriteStallStopped, kWriteStallCauseMemtable);
 #ifdef PERF_LOG
       double relative_now =
           (env_->NowMicros() - benchmark::bench_start_time) * 1e-6;
@@ -1761,17 +2244,29 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       uint64_t strat = env_->NowMicros();
       double relative_start = (strat - benchmark::bench_start_time) * 1e-6;
 #endif
+      const uint64_t wait_start = env_->NowMicros();
       background_work_finished_signal_.Wait();
+      RecordTick(options_.statistics, kStallMicros,
+                 env_->NowMicros() - wait_start);
 #ifdef PERF_LOG
       uint64_t end = env_->NowMicros();
       double relative_end = (end - benchmark::bench_start_time) * 1e-6;
       RECORD_INFO(4, "%.4f,%.4f,%.4f\n", relative_start, relative_end,
                   relative_end - relative_start);
 #endif
-    } else if (versions_->NumLevelFiles(0) >= config::kL0_StopWritesTrigger) {
-      // 达到最大L0数（12），卡死后序线程，直到Compaction完成
-      // There are too many level-0 files.
-      Log(options_.info_log, "Too many L0 files; waiting...\n");
+    } else if (versions_->NumLevelFiles(0) >=
+                   options_.level0_stop_writes_trigger ||
+               (options_.hard_pending_compaction_bytes_limit != 0 &&
+                versions_->PendingCompactionBytes() >=
+                    options_.hard_pending_compaction_bytes_limit)) {
+      // 达到最大L0数，卡死后序线程，直到Compaction完成
+      // There are too many level-0 files, or compactions are too far behind.
+      Log(options_.info_log, "Too many L0 files or pending bytes; waiting...\n");
+      SetWriteStallCondition(
+          kWriteStallStopped,
+          versions_->NumLevelFiles(0) >= options_.level0_stop_writes_trigger
+              ? kWriteStallCauseLevel0Files
+              : kWriteStallCausePendingCompactionBytes);
 #ifdef PERF_LOG
       double relative_now =
           (env_->NowMicros() - benchmark::bench_start_time) * 1e-6;
@@ -1781,7 +2276,10 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       uint64_t strat = env_->NowMicros();
       double relative_start = (strat - benchmark::bench_start_time) * 1e-6;
 #endif
+      const uint64_t wait_start = env_->NowMicros();
       background_work_finished_signal_.Wait();
+      RecordTick(options_.statistics, kStallMicros,
+                 env_->NowMicros() - wait_start);
 #ifdef PERF_LOG
       uint64_t end = env_->NowMicros();
       double relative_end = (end - benchmark::bench_start_time) * 1e-6;
@@ -1805,7 +2303,7 @@ Status DBImpl::MakeRoomForWrite(bool force) {
         std::string filename = MapFileName(dbname_nvm_, new_map_number);
 
         mem_ = new MemTableNVM(internal_comparator_, &options_.nvm_option,
-                               filename);
+                               filename, options_.statistics);
         logfile_number_ = new_map_number;
         current_write_buffer_size = options_.nvm_option.write_buffer_size;
         mem_->Clear(GetLatestSequenceNumber());
@@ -1814,7 +2312,8 @@ Status DBImpl::MakeRoomForWrite(bool force) {
         assert(versions_->PrevLogNumber() == 0);
         uint64_t new_log_number = versions_->NewFileNumber();
         WritableFile* lfile = nullptr;
-        s = env_->NewWritableFile(LogFileName(dbname_, new_log_number), &lfile);
+        log::Writer* new_log = nullptr;
+        s = NewLogFile(new_log_number, &lfile, &new_log);
         if (!s.ok()) {
           // Avoid chewing through file number space in a tight loop.
           versions_->ReuseFileNumber(new_log_number);
@@ -1824,13 +2323,23 @@ Status DBImpl::MakeRoomForWrite(bool force) {
         delete logfile_;
         logfile_ = lfile;
         logfile_number_ = new_log_number;
-        log_ = new log::Writer(lfile);
+        log_ = new_log;
         imm_ = mem_;
         has_imm_.store(true, std::memory_order_release);
         mem_ = new MemTable(internal_comparator_, GetLatestSequenceNumber());
         current_write_buffer_size = options_.write_buffer_size;
         mem_->Ref();
       }
+      if (!options_.listeners.empty()) {
+        MemTableSwitchInfo info;
+        info.db_name = dbname_;
+        info.memtable_bytes = imm_->ApproximateMemoryUsage();
+        info.new_file_number = logfile_number_;
+        info.to_nvm = mem_->IsPersistent();
+        for (EventListener* listener : options_.listeners) {
+          listener->OnMemTableSwitched(info);
+        }
+      }
 
       force = false;  // Do not force another compaction if have room
       MaybeScheduleCompaction();
@@ -1883,6 +2392,18 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
   } else if (in == "sstables") {
     *value = versions_->current()->DebugString();
     return true;
+  } else if (in == "write-amplification") {
+    int64_t written = 0;
+    for (int level = 0; level < config::kNumLevels; level++) {
+      written += stats_[level].bytes_written;
+    }
+    char buf[50];
+    std::snprintf(buf, sizeof(buf), "%.2f",
+                  flushed_bytes_ > 0
+                      ? static_cast<double>(written) / flushed_bytes_
+                      : 0.0);
+    value->append(buf);
+    return true;
   } else if (in == "approximate-memory-usage") {
     size_t total_usage = options_.block_cache->TotalCharge();
     if (mem_) {
@@ -1896,6 +2417,12 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
                   static_cast<unsigned long long>(total_usage));
     value->append(buf);
     return true;
+  } else if (in == "statistics") {
+    if (options_.statistics == nullptr) {
+      return false;
+    }
+    *value = options_.statistics->ToString();
+    return true;
   }
 
   return false;
@@ -1952,7 +2479,7 @@ Status DBImpl::GetLatestSequenceForKey(const Slice& key, bool cache_only,
 
   while (true) {
     // mem查询
-    mem->Get(lkey, &value, seq, &s);
+    mem->Get(lkey, &value, seq, &s, nullptr);
     if (*seq != kMaxSequenceNumber) {
       *found_record_for_key = true;
       break;
@@ -1964,7 +2491,7 @@ Status DBImpl::GetLatestSequenceForKey(const Slice& key, bool cache_only,
     }
     // imm查询
     if (imm != nullptr) {  //再向imm查询
-      imm->Get(lkey, &value, seq, &s);
+      imm->Get(lkey, &value, seq, &s, nullptr);
       if (*seq != kMaxSequenceNumber) {
         *found_record_for_key = true;
         break;
@@ -2001,6 +2528,13 @@ Status DB::Delete(const WriteOptions& opt, const Slice& key) {
   return Write(opt, &batch);
 }
 
+Status DB::Merge(const WriteOptions& opt, const Slice& key,
+                 const Slice& value) {
+  WriteBatch batch;
+  batch.Merge(key, value);
+  return Write(opt, &batch);
+}
+
 DB::~DB() = default;
 
 Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
@@ -2020,13 +2554,13 @@ Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
     // Create new log and a corresponding memtable.
     uint64_t new_log_number = impl->versions_->NewFileNumber();
     WritableFile* lfile;
-    s = options.env->NewWritableFile(LogFileName(dbname, new_log_number),
-                                     &lfile);
+    log::Writer* log;
+    s = impl->NewLogFile(new_log_number, &lfile, &log);
     if (s.ok()) {
       edit.SetLogNumber(new_log_number);
       impl->logfile_ = lfile;
       impl->logfile_number_ = new_log_number;
-      impl->log_ = new log::Writer(lfile);
+      impl->log_ = log;
       impl->mem_ = new MemTable(impl->internal_comparator_,
                                 impl->GetLatestSequenceNumber());
       impl->current_write_buffer_size = impl->options_.write_buffer_size;
@@ -2045,6 +2579,9 @@ Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
   if (s.ok()) {
     impl->RemoveObsoleteFiles();
     impl->MaybeScheduleCompaction();
+    if (impl->options_.persist_block_cache_keys) {
+      impl->StartBlockCacheWarmup();
+    }
   }
   impl->mutex_.Unlock();
 
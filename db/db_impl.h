@@ -8,13 +8,16 @@
 #include "db/dbformat.h"
 #include "db/log_writer.h"
 #include "db/snapshot.h"
+#include "db/write_controller.h"
 #include <atomic>
 #include <deque>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/listener.h"
 
 #include "port/port.h"
 #include "port/thread_annotations.h"
@@ -43,6 +46,8 @@ class DBImpl : public DB {
   Status Put(const WriteOptions&, const Slice& key,
              const Slice& value) override;
   Status Delete(const WriteOptions&, const Slice& key) override;
+  Status Merge(const WriteOptions&, const Slice& key,
+               const Slice& value) override;
   Status Write(const WriteOptions& options, WriteBatch* updates,
                WriteCallback* callback = nullptr) override;
   Status Get(const ReadOptions& options, const Slice& key,
@@ -79,6 +84,10 @@ class DBImpl : public DB {
   // file at a level >= 1.
   int64_t TEST_MaxNextLevelOverlappingBytes();
 
+  // Wait until the block cache contents saved by the previous instance
+  // have been read back.
+  void TEST_WaitForBlockCacheWarmup();
+
   // Record a sample of bytes read at the specified internal key.
   // Samples are taken approximately once every config::kReadBytesPeriod
   // bytes.
@@ -114,6 +123,13 @@ class DBImpl : public DB {
     int64_t bytes_written;
   };
 
+  // Data blocks of one table to read back into the block cache at open.
+  struct BlockCacheWarmup {
+    uint64_t file_number;
+    uint64_t file_size;
+    std::vector<uint64_t> offsets;
+  };
+
   Iterator* NewInternalIterator(const ReadOptions&,
                                 SequenceNumber* latest_snapshot,
                                 uint32_t* seed);
@@ -131,6 +147,15 @@ class DBImpl : public DB {
   // Delete any unneeded files and stale in-memory entries.
   void RemoveObsoleteFiles() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Returns true if obsolete log #number should be kept for recycling, and
+  // if so adds it to log_recycle_files_.
+  bool KeepLogForRecycling(uint64_t number) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Creates log #log_number, recycling an obsolete log file if one is
+  // available, and a writer for it.
+  Status NewLogFile(uint64_t log_number, WritableFile** file,
+                    log::Writer** writer) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Compact the in-memory write buffer to disk.  Switches to a new
   // log-file/memtable and writes a new descriptor iff successful.
   // Errors are recorded in bg_error_.
@@ -144,16 +169,39 @@ class DBImpl : public DB {
                         VersionEdit* edit, SequenceNumber* max_sequence)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  Status WriteLevel0Table(MemTableRep* mem, VersionEdit* edit, Version* base)
-      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // If "info" is non-null, the table written is described there.
+  Status WriteLevel0Table(MemTableRep* mem, VersionEdit* edit, Version* base,
+                          FlushJobInfo* info) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   Status MakeRoomForWrite(bool force /* compact even if there is room? */)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   WriteBatch* BuildBatchGroup(Writer** last_writer)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Paces writes according to how close level-0 and the compaction backlog
+  // are to the point where writes stop.
+  void UpdateDelayedWriteRate() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Tell options_.listeners if writes go from normal to delayed to stopped
+  // or back.
+  void SetWriteStallCondition(WriteStallCondition condition,
+                              WriteStallCause cause)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   void RecordBackgroundError(const Status& s);
 
+  // Write the keys of the data blocks in the block cache to the
+  // BLOCK_CACHE_KEYS file.
+  void DumpBlockCacheKeys() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Consume the BLOCK_CACHE_KEYS file, if any, and start the threads that
+  // read the listed blocks back into the block cache.
+  void StartBlockCacheWarmup() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  static void BlockCacheWarmupWork(void* db);
+  void BlockCacheWarmupCall();
+
+  // Tell options_.rate_limiter how close level 0 is to slowing down writes.
+  void ReportCompactionPressure() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   void MaybeScheduleCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   static void BGWork(void* db);
   void BackgroundCall();
@@ -165,6 +213,10 @@ class DBImpl : public DB {
 
   Status OpenCompactionOutputFile(CompactionState* compact);
   Status FinishCompactionOutputFile(CompactionState* compact, Iterator* input);
+  // Append an entry to the current output of "compact", opening a new
+  // output file before it and finishing a full one after it as needed.
+  Status AddCompactionOutput(CompactionState* compact, Iterator* input,
+                             const Slice& key, const Slice& value);
   Status InstallCompactionResults(CompactionState* compact)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
@@ -204,6 +256,16 @@ class DBImpl : public DB {
   log::Writer* log_;
   uint32_t seed_ GUARDED_BY(mutex_);  // For sampling.
 
+  WriteController write_controller_ GUARDED_BY(mutex_);
+  WriteStallCondition write_stall_condition_ GUARDED_BY(mutex_);
+
+  // Obsolete logs kept to be written over by new ones, oldest first.
+  std::deque<uint64_t> log_recycle_files_ GUARDED_BY(mutex_);
+  // Number of the first log this instance wrote in the recyclable format,
+  // or zero.  Only such logs are recycled, since a reader could not tell
+  // stale records in the older format from new ones.
+  uint64_t first_recyclable_log_ GUARDED_BY(mutex_);
+
   // Queue of writers.
   std::deque<Writer*> writers_ GUARDED_BY(mutex_);
   WriteBatch* tmp_batch_ GUARDED_BY(mutex_);
@@ -217,6 +279,11 @@ class DBImpl : public DB {
   // Has a background compaction been scheduled or is running?
   bool background_compaction_scheduled_ GUARDED_BY(mutex_);
 
+  // Tables whose cached blocks remain to be restored, and the number of
+  // threads restoring them.
+  std::deque<BlockCacheWarmup> block_cache_warmups_ GUARDED_BY(mutex_);
+  int block_cache_warmup_threads_ GUARDED_BY(mutex_);
+
   ManualCompaction* manual_compaction_ GUARDED_BY(mutex_);
 
   VersionSet* const versions_ GUARDED_BY(mutex_);
@@ -225,6 +292,10 @@ class DBImpl : public DB {
   Status bg_error_ GUARDED_BY(mutex_);
 
   CompactionStats stats_[config::kNumLevels] GUARDED_BY(mutex_);
+
+  // Bytes written by memtable compactions, against which the bytes
+  // written by all compactions give the write amplification.
+  int64_t flushed_bytes_ GUARDED_BY(mutex_);
 };
 
 // Sanitize db options.  The caller should delete result.info_log if
@@ -4,9 +4,13 @@
 
 #include "db/db_iter.h"
 
+#include <string>
+#include <vector>
+
 #include "db/db_impl.h"
 #include "db/dbformat.h"
 #include "db/filename.h"
+#include "db/merge_helper.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
 #include "port/port.h"
@@ -43,16 +47,21 @@ class DBIter : public Iterator {
   //     the exact entry that yields this->key(), this->value()
   // (2) When moving backwards, the internal iterator is positioned
   //     just before all entries whose user key == this->key().
+  // If this->value() was merged from several entries while moving forward,
+  // the internal iterator is instead positioned just after the entries
+  // that were merged.
   enum Direction { kForward, kReverse };
 
-  DBIter(DBImpl* db, const Comparator* cmp, Iterator* iter, SequenceNumber s,
-         uint32_t seed)
+  DBIter(DBImpl* db, const Comparator* cmp, const MergeOperator* merge_op,
+         Iterator* iter, SequenceNumber s, uint32_t seed)
       : db_(db),
         user_comparator_(cmp),
+        merge_operator_(merge_op),
         iter_(iter),
         sequence_(s),
         direction_(kForward),
         valid_(false),
+        merged_(false),
         rnd_(seed),
         bytes_until_read_sampling_(RandomCompactionPeriod()) {}
 
@@ -63,11 +72,13 @@ class DBIter : public Iterator {
   bool Valid() const override { return valid_; }
   Slice key() const override {
     assert(valid_);
-    return (direction_ == kForward) ? ExtractUserKey(iter_->key()) : saved_key_;
+    return (direction_ == kForward && !merged_) ? ExtractUserKey(iter_->key())
+                                                : saved_key_;
   }
   Slice value() const override {
     assert(valid_);
-    return (direction_ == kForward) ? iter_->value() : saved_value_;
+    return (direction_ == kForward && !merged_) ? iter_->value()
+                                                : saved_value_;
   }
   Status status() const override {
     if (status_.ok()) {
@@ -86,6 +97,7 @@ class DBIter : public Iterator {
  private:
   void FindNextUserEntry(bool skipping, std::string* skip);
   void FindPrevUserEntry();
+  void MergeForward();
   bool ParseKey(ParsedInternalKey* key);
 
   inline void SaveKey(const Slice& k, std::string* dst) {
@@ -108,6 +120,7 @@ class DBIter : public Iterator {
 
   DBImpl* db_;
   const Comparator* const user_comparator_;
+  const MergeOperator* const merge_operator_;
   Iterator* const iter_;
   SequenceNumber const sequence_;
   Status status_;
@@ -115,6 +128,7 @@ class DBIter : public Iterator {
   std::string saved_value_;  // == current raw value when direction_==kReverse
   Direction direction_;
   bool valid_;
+  bool merged_;  // saved_key_/saved_value_ hold a merged entry while forward
   Random rnd_;
   size_t bytes_until_read_sampling_;
 };
@@ -157,6 +171,16 @@ void DBIter::Next() {
       return;
     }
     // saved_key_ already contains the key to skip past.
+  } else if (merged_) {
+    // iter_ is already past the entries for this->key(), and saved_key_
+    // contains the key to skip past.
+    merged_ = false;
+    ClearSavedValue();
+    if (!iter_->Valid()) {
+      valid_ = false;
+      saved_key_.clear();
+      return;
+    }
   } else {
     // Store in saved_key_ the current key so we skip it below.
     SaveKey(ExtractUserKey(iter_->key()), &saved_key_);
@@ -198,6 +222,15 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
             return;
           }
           break;
+        case kTypeMerge:
+          if (skipping &&
+              user_comparator_->Compare(ikey.user_key, *skip) <= 0) {
+            // Entry hidden
+          } else {
+            MergeForward();
+            return;
+          }
+          break;
       }
     }
     iter_->Next();
@@ -206,14 +239,63 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
   valid_ = false;
 }
 
+void DBIter::MergeForward() {
+  // iter_ is at the newest visible entry for a key, which is a merge
+  // operand.  Every older entry for the key is visible too, so collect
+  // them up to the value or deletion the operands apply to.
+  SaveKey(ExtractUserKey(iter_->key()), &saved_key_);
+  ClearSavedValue();
+  MergeContext merge_context;
+  merge_context.PushOperand(iter_->value());
+  bool has_value = false;
+  for (iter_->Next(); iter_->Valid(); iter_->Next()) {
+    ParsedInternalKey ikey;
+    if (!ParseKey(&ikey) ||
+        user_comparator_->Compare(ikey.user_key, saved_key_) != 0 ||
+        ikey.type == kTypeDeletion) {
+      break;
+    }
+    if (ikey.type == kTypeValue) {
+      Slice raw_value = iter_->value();
+      saved_value_.assign(raw_value.data(), raw_value.size());
+      has_value = true;
+      break;
+    }
+    merge_context.PushOperand(iter_->value());
+  }
+
+  Slice existing_value(saved_value_);
+  Status s = merge_context.Merge(merge_operator_, saved_key_,
+                                 has_value ? &existing_value : nullptr,
+                                 &saved_value_);
+  if (!s.ok()) {
+    status_ = s;
+    valid_ = false;
+    saved_key_.clear();
+    ClearSavedValue();
+    return;
+  }
+  merged_ = true;
+  valid_ = true;
+}
+
 void DBIter::Prev() {
   assert(valid_);
 
   if (direction_ == kForward) {  // Switch directions?
     // iter_ is pointing at the current entry.  Scan backwards until
     // the key changes so we can use the normal reverse scanning code.
-    assert(iter_->Valid());  // Otherwise valid_ would have been false
-    SaveKey(ExtractUserKey(iter_->key()), &saved_key_);
+    if (merged_) {
+      // iter_ is past the entries for the current key, which is already
+      // in saved_key_.
+      merged_ = false;
+      if (!iter_->Valid()) {
+        iter_->SeekToLast();
+      }
+    } else {
+      assert(iter_->Valid());  // Otherwise valid_ would have been false
+      SaveKey(ExtractUserKey(iter_->key()), &saved_key_);
+    }
     while (true) {
       iter_->Prev();
       if (!iter_->Valid()) {
@@ -237,6 +319,8 @@ void DBIter::FindPrevUserEntry() {
   assert(direction_ == kReverse);
 
   ValueType value_type = kTypeDeletion;
+  bool has_value = false;            // saved_value_ holds a value
+  std::vector<std::string> operands;  // Merge operands on top, oldest first
   if (iter_->Valid()) {
     do {
       ParsedInternalKey ikey;
@@ -250,7 +334,9 @@ void DBIter::FindPrevUserEntry() {
         if (value_type == kTypeDeletion) {
           saved_key_.clear();
           ClearSavedValue();
-        } else {
+          has_value = false;
+          operands.clear();
+        } else if (value_type == kTypeValue) {
           Slice raw_value = iter_->value();
           if (saved_value_.capacity() > raw_value.size() + 1048576) {
             std::string empty;
@@ -258,12 +344,29 @@ void DBIter::FindPrevUserEntry() {
           }
           SaveKey(ExtractUserKey(iter_->key()), &saved_key_);
           saved_value_.assign(raw_value.data(), raw_value.size());
+          has_value = true;
+          operands.clear();
+        } else {
+          SaveKey(ExtractUserKey(iter_->key()), &saved_key_);
+          operands.push_back(iter_->value().ToString());
         }
       }
       iter_->Prev();
     } while (iter_->Valid());
   }
 
+  if (value_type == kTypeMerge) {
+    std::vector<Slice> operand_slices(operands.begin(), operands.end());
+    Slice existing_value(saved_value_);
+    Status s = FullMerge(merge_operator_, saved_key_,
+                         has_value ? &existing_value : nullptr,
+                         operand_slices, &saved_value_);
+    if (!s.ok()) {
+      status_ = s;
+      value_type = kTypeDeletion;  // Stop here
+    }
+  }
+
   if (value_type == kTypeDeletion) {
     // End
     valid_ = false;
@@ -277,6 +380,7 @@ void DBIter::FindPrevUserEntry() {
 
 void DBIter::Seek(const Slice& target) {
   direction_ = kForward;
+  merged_ = false;
   ClearSavedValue();
   saved_key_.clear();
   AppendInternalKey(&saved_key_,
@@ -291,6 +395,7 @@ void DBIter::Seek(const Slice& target) {
 
 void DBIter::SeekToFirst() {
   direction_ = kForward;
+  merged_ = false;
   ClearSavedValue();
   iter_->SeekToFirst();
   if (iter_->Valid()) {
@@ -302,6 +407,7 @@ void DBIter::SeekToFirst() {
 
 void DBIter::SeekToLast() {
   direction_ = kReverse;
+  merged_ = false;
   ClearSavedValue();
   iter_->SeekToLast();
   FindPrevUserEntry();
@@ -310,9 +416,11 @@ void DBIter::SeekToLast() {
 }  // anonymous namespace
 
 Iterator* NewDBIterator(DBImpl* db, const Comparator* user_key_comparator,
+                        const MergeOperator* merge_operator,
                         Iterator* internal_iter, SequenceNumber sequence,
                         uint32_t seed) {
-  return new DBIter(db, user_key_comparator, internal_iter, sequence, seed);
+  return new DBIter(db, user_key_comparator, merge_operator, internal_iter,
+                    sequence, seed);
 }
 
 }  // namespace leveldb
@@ -10,11 +10,19 @@
 #include "db/write_batch_internal.h"
 #include <atomic>
 #include <cinttypes>
+#include <cstring>
 #include <string>
+#include <thread>
 
 #include "leveldb/cache.h"
+#include "leveldb/compaction_filter.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/listener.h"
+#include "leveldb/merge_operator.h"
+#include "leveldb/perf_context.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/statistics.h"
 #include "leveldb/table.h"
 
 #include "port/port.h"
@@ -124,6 +132,10 @@ class SpecialEnv : public EnvWrapper {
   bool count_random_reads_;
   AtomicCounter random_read_counter_;
 
+  // Copy table reads into the caller's buffer, so that blocks are cachable
+  // even if the base Env serves them from a memory map.
+  bool copy_random_reads_;
+
   explicit SpecialEnv(Env* base)
       : EnvWrapper(base),
         delay_data_sync_(false),
@@ -132,7 +144,8 @@ class SpecialEnv : public EnvWrapper {
         non_writable_(false),
         manifest_sync_error_(false),
         manifest_write_error_(false),
-        count_random_reads_(false) {}
+        count_random_reads_(false),
+        copy_random_reads_(false) {}
 
   Status NewWritableFile(const std::string& f, WritableFile** r) {
     class DataFile : public WritableFile {
@@ -210,21 +223,27 @@ class SpecialEnv : public EnvWrapper {
      private:
       RandomAccessFile* target_;
       AtomicCounter* counter_;
+      bool copy_;
 
      public:
-      CountingFile(RandomAccessFile* target, AtomicCounter* counter)
-          : target_(target), counter_(counter) {}
+      CountingFile(RandomAccessFile* target, AtomicCounter* counter, bool copy)
+          : target_(target), counter_(counter), copy_(copy) {}
       ~CountingFile() override { delete target_; }
       Status Read(uint64_t offset, size_t n, Slice* result,
                   char* scratch) const override {
         counter_->Increment();
-        return target_->Read(offset, n, result, scratch);
+        Status s = target_->Read(offset, n, result, scratch);
+        if (s.ok() && copy_ && result->data() != scratch) {
+          std::memcpy(scratch, result->data(), result->size());
+          *result = Slice(scratch, result->size());
+        }
+        return s;
       }
     };
 
     Status s = target()->NewRandomAccessFile(f, r);
-    if (s.ok() && count_random_reads_) {
-      *r = new CountingFile(*r, &random_read_counter_);
+    if (s.ok() && (count_random_reads_ || copy_random_reads_)) {
+      *r = new CountingFile(*r, &random_read_counter_, copy_random_reads_);
     }
     return s;
   }
@@ -273,6 +292,10 @@ class DBTest : public testing::Test {
       case kReuse:
         options.reuse_logs = true;
         break;
+      case kRecycleLogs:
+        options.recycle_log_file_num = 2;
+        options.preallocate_log_files = true;
+        break;
       case kFilter:
         options.filter_policy = filter_policy_;
         break;
@@ -324,6 +347,10 @@ class DBTest : public testing::Test {
 
   Status Delete(const std::string& k) { return db_->Delete(WriteOptions(), k); }
 
+  Status Merge(const std::string& k, const std::string& v) {
+    return db_->Merge(WriteOptions(), k, v);
+  }
+
   std::string Get(const std::string& k, const Snapshot* snapshot = nullptr) {
     ReadOptions options;
     options.snapshot = snapshot;
@@ -393,6 +420,9 @@ class DBTest : public testing::Test {
             case kTypeDeletion:
               result += "DEL";
               break;
+            case kTypeMerge:
+              result += "MERGE(" + iter->value().ToString() + ")";
+              break;
           }
         }
         iter->Next();
@@ -535,7 +565,14 @@ class DBTest : public testing::Test {
 
  private:
   // Sequence of option configurations to try
-  enum OptionConfig { kDefault, kReuse, kFilter, kUncompressed, kEnd };
+  enum OptionConfig {
+    kDefault,
+    kReuse,
+    kRecycleLogs,
+    kFilter,
+    kUncompressed,
+    kEnd
+  };
 
   const FilterPolicy* filter_policy_;
   int option_config_;
@@ -1127,6 +1164,288 @@ TEST_F(DBTest, CompactionsGenerateMultipleFiles) {
   }
 }
 
+TEST_F(DBTest, DynamicLevelBytes) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 100000;
+  options.compression = kNoCompression;
+  options.max_bytes_for_level_base = 100000;
+  options.level_compaction_dynamic_level_bytes = true;
+  Reopen(&options);
+
+  // A small database compacts straight into the last level.
+  const int last = config::kNumLevels - 1;
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 100; i++) {
+    values.push_back(RandomString(&rnd, 1000));
+    ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+  }
+  dbfull()->TEST_CompactMemTable();
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  ASSERT_EQ(NumTableFilesAtLevel(0), 0);
+  for (int level = 1; level < last; level++) {
+    ASSERT_EQ(NumTableFilesAtLevel(level), 0) << level;
+  }
+  ASSERT_GT(NumTableFilesAtLevel(last), 0);
+
+  // As it grows the base level moves up one level per tenfold growth, and
+  // the levels above it stay empty.  With 3MB and a 100KB base, level-4 is
+  // the highest level that may hold data.
+  for (int i = 100; i < 3000; i++) {
+    values.push_back(RandomString(&rnd, 1000));
+    ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+  }
+  dbfull()->TEST_CompactMemTable();
+  for (int level = 1; level < last - 2; level++) {
+    ASSERT_EQ(NumTableFilesAtLevel(level), 0) << level;
+  }
+  ASSERT_GT(NumTableFilesAtLevel(last), 0);
+  for (int i = 0; i < 3000; i++) {
+    ASSERT_EQ(Get(Key(i)), values[i]);
+  }
+}
+
+TEST_F(DBTest, UniversalCompaction) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 100000;
+  options.compression = kNoCompression;
+  options.compaction_style = kCompactionStyleUniversal;
+  Reopen(&options);
+
+  // Overwrite and delete the same keys across many memtables, so that
+  // merged runs are full of shadowed values.
+  Random rnd(301);
+  std::vector<std::string> values(500);
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < 500; i++) {
+      if ((i + round) % 7 == 0) {
+        values[i].clear();
+        ASSERT_LEVELDB_OK(Delete(Key(i)));
+      } else {
+        values[i] = RandomString(&rnd, 1000);
+        ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+      }
+    }
+  }
+  dbfull()->TEST_CompactMemTable();
+
+  int runs = NumTableFilesAtLevel(0);
+  for (int level = 1; level < config::kNumLevels; level++) {
+    if (NumTableFilesAtLevel(level) > 0) {
+      runs++;
+    }
+  }
+  ASSERT_LE(runs, options.level0_stop_writes_trigger);
+  std::string write_amp;
+  ASSERT_TRUE(db_->GetProperty("leveldb.write-amplification", &write_amp));
+  ASSERT_GE(std::stod(write_amp), 1.0);
+
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < 500; i++) {
+      ASSERT_EQ(Get(Key(i)), values[i].empty() ? "NOT_FOUND" : values[i]);
+    }
+    Reopen(&options);
+  }
+}
+
+TEST_F(DBTest, Statistics) {
+  Statistics* statistics = NewStatistics();
+  const FilterPolicy* filter_policy = NewBloomFilterPolicy(10);
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.filter_policy = filter_policy;
+  options.statistics = statistics;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  ASSERT_LEVELDB_OK(Put("a", "va"));
+  ASSERT_LEVELDB_OK(Put("z", "vz"));
+  ASSERT_EQ("va", Get("a"));
+  ASSERT_EQ(2, statistics->GetTickerCount(kKeysWritten));
+  ASSERT_EQ(1, statistics->GetTickerCount(kMemtableHit));
+  ASSERT_EQ(2, statistics->GetTickerCount(kBytesRead));
+
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_GT(statistics->GetTickerCount(kFlushWriteBytes), 0);
+  ASSERT_EQ("vz", Get("z"));
+  ASSERT_EQ(1, statistics->GetTickerCount(kMemtableMiss));
+  ASSERT_EQ(1, statistics->GetTickerCount(kGetHitL0) +
+                   statistics->GetTickerCount(kGetHitL1AndUp));
+  ASSERT_EQ("NOT_FOUND", Get("m"));
+  ASSERT_EQ(1, statistics->GetTickerCount(kBloomFilterUseful));
+  ASSERT_EQ(3, statistics->GetTickerCount(kKeysRead));
+  ASSERT_NE(std::string::npos,
+            statistics->GetHistogramString(kDbGetMicros).find("COUNT : 3"));
+
+  std::string property;
+  ASSERT_TRUE(db_->GetProperty("leveldb.statistics", &property));
+  ASSERT_NE(std::string::npos,
+            property.find("leveldb.memtable.hit COUNT : 1\n"));
+
+  // Collection can be turned off while the DB is running.
+  statistics->set_stats_level(kStatsDisabled);
+  ASSERT_LEVELDB_OK(Put("b", "vb"));
+  ASSERT_EQ(2, statistics->GetTickerCount(kKeysWritten));
+
+  Close();
+  delete statistics;
+  delete filter_policy;
+}
+
+TEST_F(DBTest, PerfContext) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+  ASSERT_LEVELDB_OK(Put("a", "va"));
+  ASSERT_LEVELDB_OK(Put("z", "vz"));
+  dbfull()->TEST_CompactMemTable();
+
+  PerfContext* perf = GetPerfContext();
+  IOStatsContext* iostats = GetIOStatsContext();
+  perf->Reset();
+  iostats->Reset();
+
+  // Nothing is collected by default.
+  ASSERT_EQ(kPerfDisabled, GetPerfLevel());
+  ASSERT_LEVELDB_OK(Put("m", "vm"));
+  ASSERT_EQ("va", Get("a"));
+  ASSERT_EQ("", perf->ToString(true));
+  ASSERT_EQ("", iostats->ToString(true));
+
+  SetPerfLevel(kPerfEnableCount);
+  ASSERT_LEVELDB_OK(Put("n", "vn"));
+  ASSERT_GT(iostats->bytes_written, 0);
+  ASSERT_EQ(0, iostats->write_nanos);
+  ASSERT_EQ("vm", Get("m"));
+  ASSERT_EQ(1, perf->get_from_memtable_count);
+  ASSERT_EQ("va", Get("a"));
+  ASSERT_EQ(1, perf->table_files_searched_count);
+  ASSERT_GE(perf->block_cache_hit_count + perf->block_read_count, 1);
+  ASSERT_EQ(0, perf->get_from_output_files_nanos);
+
+  SetPerfLevel(kPerfEnableTime);
+  perf->Reset();
+  ASSERT_EQ("vz", Get("z"));
+  ASSERT_GT(perf->get_from_output_files_nanos, 0);
+  uint64_t level_nanos = 0;
+  for (int level = 0; level < kPerfContextLevels; level++) {
+    level_nanos += perf->get_from_level_nanos[level];
+  }
+  ASSERT_GT(level_nanos, 0);
+  ASSERT_LE(level_nanos, perf->get_from_output_files_nanos);
+  ASSERT_NE(std::string::npos,
+            perf->ToString().find("get_from_output_files_nanos = "));
+
+  // The perf level and the contexts belong to the calling thread.
+  std::thread other([this]() {
+    ASSERT_EQ(kPerfDisabled, GetPerfLevel());
+    ASSERT_EQ("vz", Get("z"));
+    ASSERT_EQ(0, GetPerfContext()->table_files_searched_count);
+  });
+  other.join();
+  ASSERT_EQ(1, perf->table_files_searched_count);
+
+  SetPerfLevel(kPerfDisabled);
+}
+
+namespace {
+
+class RecordingListener : public EventListener {
+ public:
+  void OnFlushBegin(DB* db, const FlushJobInfo& info) override {
+    MutexLock l(&mu);
+    flush_begins++;
+  }
+  void OnFlushCompleted(DB* db, const FlushJobInfo& info) override {
+    MutexLock l(&mu);
+    flushes.push_back(info);
+  }
+  void OnCompactionBegin(DB* db, const CompactionJobInfo& info) override {
+    MutexLock l(&mu);
+    compaction_begins++;
+  }
+  void OnCompactionCompleted(DB* db, const CompactionJobInfo& info) override {
+    MutexLock l(&mu);
+    compactions.push_back(info);
+  }
+  void OnStallConditionsChanged(const WriteStallInfo& info) override {
+    MutexLock l(&mu);
+    stalls.push_back(info);
+  }
+  void OnMemTableSwitched(const MemTableSwitchInfo& info) override {
+    MutexLock l(&mu);
+    switches.push_back(info);
+  }
+
+  port::Mutex mu;
+  size_t flush_begins = 0;
+  size_t compaction_begins = 0;
+  std::vector<FlushJobInfo> flushes;
+  std::vector<CompactionJobInfo> compactions;
+  std::vector<WriteStallInfo> stalls;
+  std::vector<MemTableSwitchInfo> switches;
+};
+
+}  // namespace
+
+TEST_F(DBTest, EventListener) {
+  RecordingListener listener;
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.create_if_missing = true;
+  options.write_buffer_size = 100000;
+  options.level0_file_num_compaction_trigger = 1;
+  options.level0_slowdown_writes_trigger = 1;
+  options.listeners.push_back(&listener);
+  DestroyAndReopen(&options);
+
+  Random rnd(301);
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < 200; i++) {
+      ASSERT_LEVELDB_OK(Put(Key(i), RandomString(&rnd, 1000)));
+    }
+  }
+  db_->CompactRange(nullptr, nullptr);
+
+  MutexLock l(&listener.mu);
+  ASSERT_FALSE(listener.switches.empty());
+  ASSERT_GT(listener.switches[0].memtable_bytes, 0);
+
+  ASSERT_FALSE(listener.flushes.empty());
+  ASSERT_EQ(listener.flush_begins, listener.flushes.size());
+  uint64_t flushed_bytes = 0;
+  for (const FlushJobInfo& info : listener.flushes) {
+    ASSERT_EQ(dbname_, info.db_name);
+    ASSERT_LEVELDB_OK(info.status);
+    flushed_bytes += info.file_size;
+  }
+  ASSERT_GT(flushed_bytes, 0);
+
+  ASSERT_FALSE(listener.compactions.empty());
+  ASSERT_EQ(listener.compaction_begins, listener.compactions.size());
+  const CompactionJobInfo& compaction = listener.compactions.back();
+  ASSERT_LEVELDB_OK(compaction.status);
+  ASSERT_FALSE(compaction.inputs.empty());
+  ASSERT_FALSE(compaction.outputs.empty());
+  ASSERT_GT(compaction.bytes_read, 0);
+  ASSERT_GT(compaction.bytes_written, 0);
+  for (const CompactionFileInfo& output : compaction.outputs) {
+    ASSERT_EQ(compaction.output_level, output.level);
+  }
+
+  // Writes are paced as soon as the first flush lands in level-0.
+  bool delayed_by_level0 = false;
+  for (const WriteStallInfo& info : listener.stalls) {
+    ASSERT_NE(info.previous, info.current);
+    if (info.current == kWriteStallDelayed &&
+        info.cause == kWriteStallCauseLevel0Files) {
+      delayed_by_level0 = true;
+    }
+  }
+  ASSERT_TRUE(delayed_by_level0);
+}
+
 TEST_F(DBTest, RepeatedWritesToSameKey) {
   Options options = CurrentOptions();
   options.env = env_;
@@ -1134,8 +1453,8 @@ TEST_F(DBTest, RepeatedWritesToSameKey) {
   Reopen(&options);
 
   // We must have at most one file per level except for level-0,
-  // which may have up to kL0_StopWritesTrigger files.
-  const int kMaxFiles = config::kNumLevels + config::kL0_StopWritesTrigger;
+  // which may have up to level0_stop_writes_trigger files.
+  const int kMaxFiles = config::kNumLevels + options.level0_stop_writes_trigger;
 
   Random rnd(301);
   std::string value = RandomString(&rnd, 2 * options.write_buffer_size);
@@ -1436,6 +1755,276 @@ TEST_F(DBTest, DeletionMarkers2) {
   ASSERT_EQ(AllEntriesFor("foo"), "[ ]");
 }
 
+namespace {
+
+// Drops "drop" values and turns "change" into "changed".
+class DropAndRewriteFilter : public CompactionFilter {
+ public:
+  const char* Name() const override { return "DropAndRewriteFilter"; }
+
+  bool Filter(int level, const Slice& key, const Slice& existing_value,
+              std::string* new_value, bool* value_changed) const override {
+    if (existing_value == "drop") {
+      return true;
+    }
+    if (existing_value == "change") {
+      *new_value = "changed";
+      *value_changed = true;
+    }
+    return false;
+  }
+};
+
+}  // namespace
+
+TEST_F(DBTest, CompactionFilter) {
+  DropAndRewriteFilter filter;
+  Options options = CurrentOptions();
+  options.compaction_filter = &filter;
+  Reopen(&options);
+
+  Put("foo", "v1");
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  const int last = config::kMaxMemCompactLevel;
+  ASSERT_EQ(NumTableFilesAtLevel(last), 1);  // foo => v1 is now in last level
+
+  // Place a table at level last-1 to prevent merging with preceding mutation
+  Put("a", "begin");
+  Put("z", "end");
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ(NumTableFilesAtLevel(last - 1), 1);
+
+  Put("foo", "drop");
+  Put("bar", "change");
+  Put("baz", "keep");
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());  // Moves to level last-2
+  dbfull()->TEST_CompactRange(last - 2, nullptr, nullptr);
+  // foo becomes a deletion: v1 in "last" must stay hidden
+  ASSERT_EQ(AllEntriesFor("foo"), "[ DEL, v1 ]");
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+  ASSERT_EQ("changed", Get("bar"));
+  ASSERT_EQ("keep", Get("baz"));
+
+  dbfull()->TEST_CompactRange(last - 1, nullptr, nullptr);
+  // Merging last-1 w/ last, so we are the base level for everything.
+  ASSERT_EQ(AllEntriesFor("foo"), "[ ]");
+  ASSERT_EQ("changed", Get("bar"));
+  ASSERT_EQ("keep", Get("baz"));
+  Close();
+}
+
+TEST_F(DBTest, CompactionFilterKeepsSnapshotValues) {
+  DropAndRewriteFilter filter;
+  Options options = CurrentOptions();
+  options.compaction_filter = &filter;
+  Reopen(&options);
+
+  Put("foo", "drop");
+  Put("bar", "change");
+  const Snapshot* snapshot = db_->GetSnapshot();
+  Put("bar", "drop");  // Newer than the snapshot
+  Put("baz", "change");
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  const int last = config::kMaxMemCompactLevel;
+  ASSERT_EQ(NumTableFilesAtLevel(last), 1);
+  dbfull()->TEST_CompactRange(last, nullptr, nullptr);
+
+  // Values the snapshot reads are left alone.
+  ASSERT_EQ("drop", Get("foo", snapshot));
+  ASSERT_EQ("change", Get("bar", snapshot));
+  ASSERT_EQ("NOT_FOUND", Get("baz", snapshot));
+  ASSERT_EQ("drop", Get("foo"));
+  // The newer bar becomes a deletion that hides the snapshot's value.
+  ASSERT_EQ(AllEntriesFor("bar"), "[ DEL, change ]");
+  ASSERT_EQ("NOT_FOUND", Get("bar"));
+  ASSERT_EQ("changed", Get("baz"));
+
+  db_->ReleaseSnapshot(snapshot);
+  dbfull()->TEST_CompactRange(last + 1, nullptr, nullptr);
+  ASSERT_EQ(AllEntriesFor("foo"), "[ ]");
+  ASSERT_EQ(AllEntriesFor("bar"), "[ ]");
+  ASSERT_EQ("changed", Get("baz"));
+  Close();
+}
+
+namespace {
+
+// Appends operands to the value, separated by commas.
+class AppendOperator : public MergeOperator {
+ public:
+  const char* Name() const override { return "AppendOperator"; }
+
+  bool FullMerge(const Slice& key, const Slice* existing_value,
+                 const std::vector<Slice>& operands,
+                 std::string* new_value) const override {
+    new_value->clear();
+    if (existing_value != nullptr) {
+      new_value->assign(existing_value->data(), existing_value->size());
+    }
+    for (const Slice& operand : operands) {
+      if (!new_value->empty()) {
+        new_value->push_back(',');
+      }
+      new_value->append(operand.data(), operand.size());
+    }
+    return true;
+  }
+
+  bool PartialMerge(const Slice& key, const Slice& left, const Slice& right,
+                    std::string* new_value) const override {
+    *new_value = left.ToString() + "," + right.ToString();
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_F(DBTest, Merge) {
+  ASSERT_TRUE(Merge("foo", "v1").IsNotSupportedError());
+
+  AppendOperator merge_operator;
+  Options options = CurrentOptions();
+  options.merge_operator = &merge_operator;
+  Reopen(&options);
+
+  ASSERT_LEVELDB_OK(Put("foo", "v1"));
+  ASSERT_LEVELDB_OK(Merge("foo", "v2"));
+  ASSERT_EQ("v1,v2", Get("foo"));
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_LEVELDB_OK(Merge("foo", "v3"));
+  ASSERT_EQ("v1,v2,v3", Get("foo"));
+  ASSERT_EQ("v1,v2", Get("foo", snapshot));
+
+  // Operands without a value, and on top of a deletion.
+  ASSERT_LEVELDB_OK(Merge("bar", "b1"));
+  ASSERT_LEVELDB_OK(Put("baz", "x"));
+  ASSERT_LEVELDB_OK(Delete("baz"));
+  ASSERT_LEVELDB_OK(Merge("baz", "z1"));
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  ASSERT_LEVELDB_OK(Merge("bar", "b2"));
+  ASSERT_EQ("b1,b2", Get("bar"));
+  ASSERT_EQ("z1", Get("baz"));
+
+  Iterator* iter = db_->NewIterator(ReadOptions());
+  iter->SeekToFirst();
+  ASSERT_EQ(IterStatus(iter), "bar->b1,b2");
+  iter->Next();
+  ASSERT_EQ(IterStatus(iter), "baz->z1");
+  iter->Next();
+  ASSERT_EQ(IterStatus(iter), "foo->v1,v2,v3");
+  iter->Prev();
+  ASSERT_EQ(IterStatus(iter), "baz->z1");
+  iter->Prev();
+  ASSERT_EQ(IterStatus(iter), "bar->b1,b2");
+  iter->Next();
+  ASSERT_EQ(IterStatus(iter), "baz->z1");
+  iter->Next();
+  iter->Next();
+  ASSERT_EQ(IterStatus(iter), "(invalid)");
+  iter->SeekToLast();
+  ASSERT_EQ(IterStatus(iter), "foo->v1,v2,v3");
+  iter->Prev();
+  ASSERT_EQ(IterStatus(iter), "baz->z1");
+  iter->Seek("bas");
+  ASSERT_EQ(IterStatus(iter), "baz->z1");
+  delete iter;
+
+  // Compactions fold operands into values, except for what the snapshot
+  // still needs.
+  dbfull()->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(AllEntriesFor("foo"), "[ MERGE(v3), v1,v2 ]");
+  ASSERT_EQ(AllEntriesFor("bar"), "[ MERGE(b2), MERGE(b1) ]");
+  ASSERT_EQ("v1,v2", Get("foo", snapshot));
+  ASSERT_EQ("v1,v2,v3", Get("foo"));
+  ASSERT_EQ("b1,b2", Get("bar"));
+  ASSERT_EQ("z1", Get("baz"));
+  db_->ReleaseSnapshot(snapshot);
+  Close();
+}
+
+TEST_F(DBTest, MergeCompactionKeepsOperandsAboveOlderData) {
+  AppendOperator merge_operator;
+  Options options = CurrentOptions();
+  options.merge_operator = &merge_operator;
+  Reopen(&options);
+
+  Put("foo", "v1");
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  const int last = config::kMaxMemCompactLevel;
+  ASSERT_EQ(NumTableFilesAtLevel(last), 1);  // foo => v1 is now in last level
+
+  // Place a table at level last-1 to prevent merging with preceding mutation
+  Put("a", "begin");
+  Put("z", "end");
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ(NumTableFilesAtLevel(last - 1), 1);
+
+  Merge("foo", "v2");
+  Merge("foo", "v3");
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());  // Moves to level last-2
+  dbfull()->TEST_CompactRange(last - 2, nullptr, nullptr);
+  // v1 is out of reach, so the operands are only combined.
+  ASSERT_EQ(AllEntriesFor("foo"), "[ MERGE(v2,v3), v1 ]");
+  ASSERT_EQ("v1,v2,v3", Get("foo"));
+
+  dbfull()->TEST_CompactRange(last - 1, nullptr, nullptr);
+  ASSERT_EQ(AllEntriesFor("foo"), "[ v1,v2,v3 ]");
+  Close();
+}
+
+TEST_F(DBTest, MergeWithoutOperatorKeepsOlderValues) {
+  ASSERT_LEVELDB_OK(Put("foo", "v1"));
+  WriteBatch batch;
+  batch.Merge("foo", "v2");
+  ASSERT_TRUE(db_->Write(WriteOptions(), &batch).IsNotSupportedError());
+  ASSERT_EQ("v1", Get("foo"));
+
+  // Operands written while an operator was set survive a reopen without
+  // one, and must not hide the value under them.
+  AppendOperator merge_operator;
+  Options options = CurrentOptions();
+  options.merge_operator = &merge_operator;
+  Reopen(&options);
+  ASSERT_LEVELDB_OK(db_->Write(WriteOptions(), &batch));
+  options.merge_operator = nullptr;
+  Reopen(&options);
+  dbfull()->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(AllEntriesFor("foo"), "[ MERGE(v2), v1 ]");
+
+  options.merge_operator = &merge_operator;
+  Reopen(&options);
+  ASSERT_EQ("v1,v2", Get("foo"));
+  Close();
+}
+
+TEST_F(DBTest, MergeCounter) {
+  const MergeOperator* merge_operator = NewUInt64AddOperator();
+  Options options = CurrentOptions();
+  options.merge_operator = merge_operator;
+  Reopen(&options);
+
+  std::string one;
+  PutFixed64(&one, 1);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_LEVELDB_OK(Merge("counter", one));
+    if (i % 30 == 29) {
+      ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+    }
+  }
+  ASSERT_EQ(100u, DecodeFixed64(Get("counter").data()));
+  dbfull()->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(100u, DecodeFixed64(Get("counter").data()));
+
+  // Operands of the wrong size cannot be added up.
+  ASSERT_LEVELDB_OK(Merge("counter", "x"));
+  std::string value;
+  ASSERT_TRUE(db_->Get(ReadOptions(), "counter", &value).IsCorruption());
+
+  Close();
+  delete merge_operator;
+}
+
 TEST_F(DBTest, OverlapInLevel0) {
   do {
     ASSERT_EQ(config::kMaxMemCompactLevel, 2) << "Fix test to match config";
@@ -1898,14 +2487,68 @@ TEST_F(DBTest, FilesDeletedAfterCompaction) {
 }
 
 TEST_F(DBTest, BloomFilter) {
+  const FilterFormat kFormats[] = {kBlockBasedFilter, kFullFilter};
+  for (FilterFormat format : kFormats) {
+    env_->count_random_reads_ = true;
+    Options options = CurrentOptions();
+    options.env = env_;
+    options.block_cache = NewLRUCache(0);  // Prevent cache hits
+    options.filter_policy = NewBloomFilterPolicy(10);
+    options.filter_format = format;
+    options.create_if_missing = true;
+    DestroyAndReopen(&options);
+
+    // Populate multiple layers
+    const int N = 10000;
+    for (int i = 0; i < N; i++) {
+      ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
+    }
+    Compact("a", "z");
+    for (int i = 0; i < N; i += 100) {
+      ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
+    }
+    dbfull()->TEST_CompactMemTable();
+
+    // Prevent auto compactions triggered by seeks
+    env_->delay_data_sync_.store(true, std::memory_order_release);
+
+    // Lookup present keys.  Should rarely read from small sstable.
+    env_->random_read_counter_.Reset();
+    for (int i = 0; i < N; i++) {
+      ASSERT_EQ(Key(i), Get(Key(i)));
+    }
+    int reads = env_->random_read_counter_.Read();
+    std::fprintf(stderr, "%d present => %d reads\n", N, reads);
+    ASSERT_GE(reads, N);
+    ASSERT_LE(reads, N + 2 * N / 100);
+
+    // Lookup present keys.  Should rarely read from either sstable.
+    env_->random_read_counter_.Reset();
+    for (int i = 0; i < N; i++) {
+      ASSERT_EQ("NOT_FOUND", Get(Key(i) + ".missing"));
+    }
+    reads = env_->random_read_counter_.Read();
+    std::fprintf(stderr, "%d missing => %d reads\n", N, reads);
+    ASSERT_LE(reads, 3 * N / 100);
+
+    env_->delay_data_sync_.store(false, std::memory_order_release);
+    Close();
+    delete options.block_cache;
+    delete options.filter_policy;
+  }
+}
+
+TEST_F(DBTest, PartitionedBloomFilter) {
   env_->count_random_reads_ = true;
   Options options = CurrentOptions();
   options.env = env_;
   options.block_cache = NewLRUCache(0);  // Prevent cache hits
   options.filter_policy = NewBloomFilterPolicy(10);
-  Reopen(&options);
+  options.filter_format = kPartitionedFilter;
+  options.metadata_block_size = 1024;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
 
-  // Populate multiple layers
   const int N = 10000;
   for (int i = 0; i < N; i++) {
     ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
@@ -1919,31 +2562,377 @@ TEST_F(DBTest, BloomFilter) {
   // Prevent auto compactions triggered by seeks
   env_->delay_data_sync_.store(true, std::memory_order_release);
 
-  // Lookup present keys.  Should rarely read from small sstable.
+  // Missing keys read the top-level filter index and one partition of
+  // each sstable they are looked up in, but should rarely read a data
+  // block.
+  PerfContext* perf = GetPerfContext();
+  SetPerfLevel(kPerfEnableCount);
+  perf->Reset();
   env_->random_read_counter_.Reset();
   for (int i = 0; i < N; i++) {
-    ASSERT_EQ(Key(i), Get(Key(i)));
+    ASSERT_EQ("NOT_FOUND", Get(Key(i) + ".missing"));
   }
   int reads = env_->random_read_counter_.Read();
-  std::fprintf(stderr, "%d present => %d reads\n", N, reads);
-  ASSERT_GE(reads, N);
-  ASSERT_LE(reads, N + 2 * N / 100);
+  const int searched = static_cast<int>(perf->table_files_searched_count);
+  const int data_reads =
+      searched - static_cast<int>(perf->bloom_filter_useful);
+  std::fprintf(stderr, "%d missing => %d reads, %d past the filter\n", N,
+               reads, data_reads);
+  ASSERT_GE(searched, N);
+  ASSERT_LE(reads, 2 * searched + 3 * N / 100);
+  ASSERT_LE(data_reads, 3 * N / 100);
+  SetPerfLevel(kPerfDisabled);
 
-  // Lookup present keys.  Should rarely read from either sstable.
-  env_->random_read_counter_.Reset();
+  env_->delay_data_sync_.store(false, std::memory_order_release);
+  Close();
+  delete options.block_cache;
+  delete options.filter_policy;
+}
+
+TEST_F(DBTest, DataBlockHashIndex) {
+  Options options = CurrentOptions();
+  options.data_block_hash_index = true;
+  options.block_restart_interval = 4;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  const int N = 2000;
   for (int i = 0; i < N; i++) {
+    ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
+  }
+  const Snapshot* snapshot = db_->GetSnapshot();
+  for (int i = 0; i < N; i += 3) {
+    ASSERT_LEVELDB_OK(Put(Key(i), "v2"));
+  }
+  for (int i = 1; i < N; i += 7) {
+    ASSERT_LEVELDB_OK(Delete(Key(i)));
+  }
+  dbfull()->TEST_CompactMemTable();
+  Compact("a", "z");
+
+  for (int i = 0; i < N; i++) {
+    const std::string expected =
+        (i % 7 == 1) ? "NOT_FOUND" : (i % 3 == 0 ? "v2" : Key(i));
+    ASSERT_EQ(expected, Get(Key(i)));
+    ASSERT_EQ(Key(i), Get(Key(i), snapshot));
     ASSERT_EQ("NOT_FOUND", Get(Key(i) + ".missing"));
   }
-  reads = env_->random_read_counter_.Read();
-  std::fprintf(stderr, "%d missing => %d reads\n", N, reads);
-  ASSERT_LE(reads, 3 * N / 100);
+  db_->ReleaseSnapshot(snapshot);
+}
+
+TEST_F(DBTest, PartitionedIndex) {
+  Options options = CurrentOptions();
+  options.partition_index = true;
+  options.metadata_block_size = 256;
+  options.block_size = 512;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  const int N = 5000;
+  for (int i = 0; i < N; i++) {
+    ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
+  }
+  Compact("a", "z");
+  for (int i = 0; i < N; i += 10) {
+    ASSERT_LEVELDB_OK(Put(Key(i), "v2"));
+  }
+  dbfull()->TEST_CompactMemTable();
+
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(i % 10 == 0 ? "v2" : Key(i), Get(Key(i)));
+    ASSERT_EQ("NOT_FOUND", Get(Key(i) + ".missing"));
+  }
+  Iterator* iter = db_->NewIterator(ReadOptions());
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(Key(count), iter->key().ToString());
+    count++;
+  }
+  ASSERT_EQ(N, count);
+  delete iter;
+
+  // Reopening reads only the top-level index of each table.
+  Reopen(&options);
+  ASSERT_EQ(Key(N - 1), Get(Key(N - 1)));
+  ASSERT_EQ("v2", Get(Key(0)));
+}
+
+TEST_F(DBTest, PersistBlockCacheKeys) {
+  env_->count_random_reads_ = true;
+  env_->copy_random_reads_ = true;
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.block_cache = NewLRUCache(8 << 20);
+  options.persist_block_cache_keys = true;
+  options.block_size = 256;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  const int N = 2000;
+  for (int i = 0; i < N; i++) {
+    ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
+  }
+  Compact("a", "z");
+  for (int i = 0; i < N; i += 100) {
+    ASSERT_EQ(Key(i), Get(Key(i)));
+  }
+
+  // Restart with an empty cache.  A temporary file left by an
+  // interrupted dump is removed.
+  Close();
+  ASSERT_TRUE(env_->FileExists(dbname_ + "/BLOCK_CACHE_KEYS"));
+  ASSERT_LEVELDB_OK(
+      WriteStringToFile(env_, "partial", dbname_ + "/BLOCK_CACHE_KEYS.tmp"));
+  delete options.block_cache;
+  options.block_cache = NewLRUCache(8 << 20);
+  Reopen(&options);
+  dbfull()->TEST_WaitForBlockCacheWarmup();
+  ASSERT_TRUE(!env_->FileExists(dbname_ + "/BLOCK_CACHE_KEYS"));
+  ASSERT_TRUE(!env_->FileExists(dbname_ + "/BLOCK_CACHE_KEYS.tmp"));
+  ASSERT_GT(options.block_cache->TotalCharge(), 0);
+
+  // The blocks read before the restart are served from the cache.
+  env_->random_read_counter_.Reset();
+  for (int i = 0; i < N; i += 100) {
+    ASSERT_EQ(Key(i), Get(Key(i)));
+  }
+  ASSERT_EQ(0, env_->random_read_counter_.Read());
+
+  // Other blocks are not.
+  ASSERT_EQ(Key(N / 2 + 50), Get(Key(N / 2 + 50)));
+  ASSERT_GT(env_->random_read_counter_.Read(), 0);
+
+  Close();
+  delete options.block_cache;
+}
+
+TEST_F(DBTest, CacheIndexAndFilterBlocks) {
+  env_->count_random_reads_ = true;
+  env_->copy_random_reads_ = true;
+  for (bool pin : {false, true}) {
+    Options options = CurrentOptions();
+    options.env = env_;
+    options.block_cache = NewLRUCache(1 << 20);
+    options.filter_policy = NewBloomFilterPolicy(10);
+    options.cache_index_and_filter_blocks = true;
+    options.pin_l0_filter_and_index_blocks_in_cache = pin;
+    options.create_if_missing = true;
+    DestroyAndReopen(&options);
+
+    // The first two tables are pushed to levels 2 and 1; the third one
+    // overlaps them and stays in level 0.
+    const int N = 1000;
+    for (int round = 0; round < 3; round++) {
+      for (int i = 0; i < N; i++) {
+        ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
+      }
+      dbfull()->TEST_CompactMemTable();
+    }
+    ASSERT_EQ("1,1,1", FilesPerLevel());
+    for (int i = 0; i < N; i++) {
+      ASSERT_EQ(Key(i), Get(Key(i)));
+    }
+    ASSERT_GT(options.block_cache->TotalCharge(), 0);
+
+    // Unpinned index and filter blocks are evicted like data blocks and
+    // read back on demand.
+    options.block_cache->Prune();
+    env_->random_read_counter_.Reset();
+    ASSERT_EQ(Key(N / 2), Get(Key(N / 2)));
+    if (pin) {
+      ASSERT_EQ(1, env_->random_read_counter_.Read());  // Data block only
+    } else {
+      ASSERT_EQ(3, env_->random_read_counter_.Read());
+    }
+
+    Close();
+    delete options.block_cache;
+    delete options.filter_policy;
+  }
+}
+
+TEST_F(DBTest, UnpinMetaBlocksAfterTrivialMove) {
+  env_->count_random_reads_ = true;
+  env_->copy_random_reads_ = true;
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.block_cache = NewLRUCache(1 << 20);
+  options.filter_policy = NewBloomFilterPolicy(10);
+  options.cache_index_and_filter_blocks = true;
+  options.pin_l0_filter_and_index_blocks_in_cache = true;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  // Leave a table holding "l" and "n" in level 0 with nothing below it
+  // in level 1.
+  ASSERT_LEVELDB_OK(Put("a", "va"));
+  ASSERT_LEVELDB_OK(Put("z", "vz"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_LEVELDB_OK(Put("m", "vm"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_LEVELDB_OK(Put("l", "vl"));
+  ASSERT_LEVELDB_OK(Put("n", "vn"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("1,1,1", FilesPerLevel());
+  dbfull()->TEST_CompactRange(1, nullptr, nullptr);
+  ASSERT_EQ("1,0,1", FilesPerLevel());
+  ASSERT_EQ("vl", Get("l"));
+
+  // Reads of "m" go through the level-0 table first, until the seeks
+  // it costs move the table to level 1.
+  for (int i = 0; i < 1000 && FilesPerLevel() != "0,1,1"; i++) {
+    ASSERT_EQ("vm", Get("m"));
+    DelayMilliseconds(1);
+  }
+  ASSERT_EQ("0,1,1", FilesPerLevel());
+
+  // The moved table no longer holds its index and filter blocks.
+  options.block_cache->Prune();
+  env_->random_read_counter_.Reset();
+  ASSERT_EQ("vl", Get("l"));
+  ASSERT_EQ(3, env_->random_read_counter_.Read());
 
-  env_->delay_data_sync_.store(false, std::memory_order_release);
   Close();
   delete options.block_cache;
   delete options.filter_policy;
 }
 
+TEST_F(DBTest, RowCache) {
+  env_->count_random_reads_ = true;
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.block_cache = NewLRUCache(0);  // Prevent block cache hits
+  options.row_cache = NewLRUCache(1 << 20);
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  ASSERT_LEVELDB_OK(Put("foo", "v1"));
+  ASSERT_LEVELDB_OK(Put("bar", "v1"));
+  dbfull()->TEST_CompactMemTable();
+  const Snapshot* snapshot = db_->GetSnapshot();
+
+  ASSERT_EQ("v1", Get("foo"));
+  env_->random_read_counter_.Reset();
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ(0, env_->random_read_counter_.Read());
+  ASSERT_EQ("NOT_FOUND", Get("missing"));
+
+  // Newer files get their own entries.
+  ASSERT_LEVELDB_OK(Put("foo", "v2"));
+  ASSERT_LEVELDB_OK(Delete("bar"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("v2", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("bar"));
+  ASSERT_EQ("NOT_FOUND", Get("bar"));
+  env_->random_read_counter_.Reset();
+  ASSERT_EQ("v2", Get("foo"));
+  ASSERT_EQ(0, env_->random_read_counter_.Read());
+
+  // Snapshot reads bypass the row cache.
+  ASSERT_EQ("v1", Get("foo", snapshot));
+  ASSERT_EQ("v1", Get("bar", snapshot));
+  db_->ReleaseSnapshot(snapshot);
+
+  Close();
+  delete options.block_cache;
+  delete options.row_cache;
+}
+
+TEST_F(DBTest, DirectIO) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 100000;
+  options.use_direct_reads = true;
+  options.use_direct_io_for_flush_and_compaction = true;
+  Reopen(&options);
+
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 500; i++) {
+    values.push_back(RandomString(&rnd, 1000 + rnd.Uniform(3000)));
+    ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+  }
+  dbfull()->TEST_CompactMemTable();
+  dbfull()->CompactRange(nullptr, nullptr);
+  ASSERT_GT(NumTableFilesAtLevel(2) + NumTableFilesAtLevel(1), 0);
+
+  for (int i = 0; i < 500; i++) {
+    ASSERT_EQ(values[i], Get(Key(i)));
+  }
+  Reopen(&options);
+  Iterator* iter = db_->NewIterator(ReadOptions());
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(values[count], iter->value().ToString());
+    count++;
+  }
+  ASSERT_LEVELDB_OK(iter->status());
+  ASSERT_EQ(500, count);
+  delete iter;
+}
+
+TEST_F(DBTest, RateLimiter) {
+  RateLimiter* limiter = NewGenericRateLimiter(100 << 20);
+  Options options = CurrentOptions();
+  options.rate_limiter = limiter;
+  options.compression = kNoCompression;
+  Reopen(&options);
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_LEVELDB_OK(Put(Key(i), std::string(1000, 'v')));
+  }
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ(1, TotalTableFiles());
+  const int64_t flushed = limiter->GetTotalBytesThrough();
+  ASSERT_GT(flushed, 100000);
+
+  // The compaction rewrites the file through the limiter as well.
+  int level = 0;
+  while (NumTableFilesAtLevel(level) == 0) {
+    level++;
+  }
+  dbfull()->TEST_CompactRange(level, nullptr, nullptr);
+  ASSERT_GT(limiter->GetTotalBytesThrough(), flushed + 100000);
+  ASSERT_EQ(std::string(1000, 'v'), Get(Key(50)));
+
+  Close();
+  delete limiter;
+}
+
+TEST_F(DBTest, RecycleLogFiles) {
+  Options options = CurrentOptions();
+  options.recycle_log_file_num = 2;
+  options.write_buffer_size = 100000;
+  Reopen(&options);
+
+  // Every value is overwritten, so recycled logs hold stale versions past
+  // the end of the records written to them since.
+  for (char c : {'a', 'b'}) {
+    for (int i = 0; i < 1000; i++) {
+      ASSERT_LEVELDB_OK(Put(Key(i), std::string(1000, c)));
+    }
+  }
+  ASSERT_LEVELDB_OK(Put("last", "v"));
+
+  std::vector<std::string> filenames;
+  ASSERT_LEVELDB_OK(env_->GetChildren(dbname_, &filenames));
+  uint64_t number;
+  FileType type;
+  int logs = 0;
+  for (const std::string& filename : filenames) {
+    if (ParseFileName(filename, &number, &type) && type == kLogFile) {
+      logs++;
+    }
+  }
+  // The pool, plus the current log and the one being compacted.
+  ASSERT_LE(logs, 2 + 2);
+
+  Reopen(&options);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(std::string(1000, 'b'), Get(Key(i)));
+  }
+  ASSERT_EQ("v", Get("last"));
+}
+
 // Multi-threaded test:
 namespace {
 
@@ -2095,6 +3084,10 @@ class ModelDB : public DB {
         (*map_)[key.ToString()] = value.ToString();
       }
       void Delete(const Slice& key) override { map_->erase(key.ToString()); }
+      void Merge(const Slice& key, const Slice& value) override {
+        // The model has no merge operator.
+        FAIL() << "Merge() is not supported by ModelDB";
+      }
     };
     Handler handler;
     handler.map_ = &map_;
@@ -73,11 +73,17 @@ std::string OldInfoLogFileName(const std::string& dbname) {
   return dbname + "/LOG.old";
 }
 
+std::string BlockCacheKeysFileName(const std::string& dbname) {
+  return dbname + "/BLOCK_CACHE_KEYS";
+}
+
 // Owned filenames have the form:
 //    dbname/CURRENT
 //    dbname/LOCK
 //    dbname/LOG
 //    dbname/LOG.old
+//    dbname/BLOCK_CACHE_KEYS
+//    dbname/BLOCK_CACHE_KEYS.tmp
 //    dbname/MANIFEST-[0-9]+
 //    dbname/[0-9]+.(log|sst|ldb)
 bool ParseFileName(const std::string& filename, uint64_t* number,
@@ -92,6 +98,13 @@ bool ParseFileName(const std::string& filename, uint64_t* number,
   } else if (rest == "LOG" || rest == "LOG.old") {
     *number = 0;
     *type = kInfoLogFile;
+  } else if (rest == "BLOCK_CACHE_KEYS") {
+    *number = 0;
+    *type = kBlockCacheKeysFile;
+  } else if (rest == "BLOCK_CACHE_KEYS.tmp") {
+    // Left behind by a crash while the keys were being written out.
+    *number = 0;
+    *type = kTempFile;
   } else if (rest.starts_with("MANIFEST-")) {
     rest.remove_prefix(strlen("MANIFEST-"));
     uint64_t num;
@@ -27,7 +27,8 @@ enum FileType {
   kCurrentFile,
   kTempFile,
   kInfoLogFile,  // Either the current one, or an old one
-  kMapFile
+  kMapFile,
+  kBlockCacheKeysFile
 };
 
 std::string MapFileName(const std::string& dbname, uint64_t number);
@@ -71,6 +72,10 @@ std::string InfoLogFileName(const std::string& dbname);
 // Return the name of the old info log file for "dbname".
 std::string OldInfoLogFileName(const std::string& dbname);
 
+// Return the name of the file that lists the blocks of "dbname" that were
+// in the block cache when the db was last closed.
+std::string BlockCacheKeysFileName(const std::string& dbname);
+
 // If filename is a leveldb file, store the type of the file in *type.
 // The number encoded in the filename is stored in *number.  If the
 // filename was successfully parsed, returns true.  Else return false.
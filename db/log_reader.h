@@ -40,8 +40,11 @@ class Reader {
   //
   // The Reader will start reading at the first record located at physical
   // position >= initial_offset within the file.
+  //
+  // "log_number" is the number of the log file being read.  Recyclable
+  // records tagged with any other number are stale, and end the log.
   Reader(SequentialFile* file, Reporter* reporter, bool checksum,
-         uint64_t initial_offset);
+         uint64_t initial_offset, uint64_t log_number = 0);
 
   Reader(const Reader&) = delete;
   Reader& operator=(const Reader&) = delete;
@@ -60,6 +63,10 @@ class Reader {
   // Undefined before the first call to ReadRecord.
   uint64_t LastRecordOffset();
 
+  // Returns true if records in the recyclable format have been read, in
+  // which case the file may hold stale data past the end of the log.
+  bool Recyclable() const { return recyclable_; }
+
  private:
   // Extend record types with the following special values
   enum {
@@ -77,8 +84,10 @@ class Reader {
   // Returns true on success. Handles reporting.
   bool SkipToInitialBlock();
 
-  // Return type, or one of the preceding special values
-  unsigned int ReadPhysicalRecord(Slice* result);
+  // Return type, or one of the preceding special values.  Recyclable
+  // records are returned as their plain counterparts, and "*header_size"
+  // is set to the size of the record's header.
+  unsigned int ReadPhysicalRecord(Slice* result, int* header_size);
 
   // Reports dropped bytes to the reporter.
   // buffer_ must be updated to remove the dropped bytes prior to invocation.
@@ -104,6 +113,11 @@ class Reader {
   // particular, a run of kMiddleType and kLastType records can be silently
   // skipped in this mode
   bool resyncing_;
+
+  uint32_t const log_number_;
+
+  // True once a valid recyclable record has been read
+  bool recyclable_;
 };
 
 }  // namespace log
@@ -54,6 +54,19 @@ class LogTest : public testing::Test {
     writer_ = new Writer(&dest_, dest_.contents_.size());
   }
 
+  // Start writing log #log_number in the recyclable format over the
+  // current contents, as if the file were being recycled.
+  void Recycle(uint64_t log_number) {
+    delete writer_;
+    delete reader_;
+    dest_.pos_ = 0;
+    writer_ = new Writer(&dest_, log_number, true /*recycle_log_files*/);
+    reader_ = new Reader(&source_, &report_, true /*checksum*/,
+                         0 /*initial_offset*/, log_number);
+  }
+
+  bool ReaderSawRecyclable() const { return reader_->Recyclable(); }
+
   void Write(const std::string& msg) {
     ASSERT_TRUE(!reading_) << "Write() after starting to read";
     writer_->AddRecord(Slice(msg));
@@ -159,17 +172,22 @@ class LogTest : public testing::Test {
   }
 
  private:
+  // Writes at pos_, over any existing contents.
   class StringDest : public WritableFile {
    public:
+    StringDest() : pos_(0) {}
+
     Status Close() override { return Status::OK(); }
     Status Flush() override { return Status::OK(); }
     Status Sync() override { return Status::OK(); }
     Status Append(const Slice& slice) override {
-      contents_.append(slice.data(), slice.size());
+      contents_.replace(pos_, slice.size(), slice.data(), slice.size());
+      pos_ += slice.size();
       return Status::OK();
     }
 
     std::string contents_;
+    size_t pos_;
   };
 
   class StringSource : public SequentialFile {
@@ -554,6 +572,58 @@ TEST_F(LogTest, ReadEnd) { CheckOffsetPastEndReturnsNoRecords(0); }
 
 TEST_F(LogTest, ReadPastEnd) { CheckOffsetPastEndReturnsNoRecords(5); }
 
+TEST_F(LogTest, RecyclableFragmentation) {
+  Recycle(7);
+  Write("small");
+  Write(BigString("medium", 50000));
+  Write(BigString("large", 100000));
+  ASSERT_EQ("small", Read());
+  ASSERT_EQ(BigString("medium", 50000), Read());
+  ASSERT_EQ(BigString("large", 100000), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_TRUE(ReaderSawRecyclable());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(LogTest, RecyclableShortTrailer) {
+  // Leave a trailer that could hold a plain header, but not a recyclable one.
+  Recycle(7);
+  const int n = kBlockSize - kRecyclableHeaderSize - 8;
+  Write(BigString("foo", n));
+  ASSERT_EQ(kBlockSize - 8, WrittenBytes());
+  Write("bar");
+  ASSERT_EQ(kBlockSize + kRecyclableHeaderSize + 3, WrittenBytes());
+  ASSERT_EQ(BigString("foo", n), Read());
+  ASSERT_EQ("bar", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(LogTest, RecycledLogIgnoresStaleRecords) {
+  Recycle(1);
+  for (int i = 0; i < 100; i++) {
+    Write(BigString(NumberString(i), 1000));
+  }
+  Recycle(2);
+  Write("foo");
+  Write(BigString("bar", 2000));
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ(BigString("bar", 2000), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(LogTest, RecycledLogIgnoresStaleLegacyRecords) {
+  for (int i = 0; i < 100; i++) {
+    Write(BigString(NumberString(i), 1000));
+  }
+  Recycle(2);
+  Write("foo");
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
 }  // namespace log
 }  // namespace leveldb
 
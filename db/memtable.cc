@@ -5,6 +5,7 @@
 #include "db/memtable.h"
 
 #include "db/dbformat.h"
+#include "db/merge_helper.h"
 
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
@@ -118,11 +119,12 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
 }
 
 bool MemTable::Get(const LookupKey& key, std::string* value,
-                   SequenceNumber* seq, Status* s) {
+                   SequenceNumber* seq, Status* s,
+                   MergeContext* merge_context) {
   Slice memkey = key.memtable_key();
   Table::Iterator iter(&table_);
   iter.Seek(memkey.data());
-  if (iter.Valid()) {
+  for (bool first = true; iter.Valid(); iter.Next(), first = false) {
     // entry format is:
     //    klength  varint32
     //    userkey  char[klength]
@@ -138,21 +140,32 @@ bool MemTable::Get(const LookupKey& key, std::string* value,
 
     // seq
     const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
-    *seq = tag >> 8;
+    if (first) {
+      *seq = tag >> 8;
+    }
 
     if (comparator_.comparator.user_comparator()->Compare(
-            Slice(key_ptr, key_length - 8), key.user_key()) == 0) {
-      // Correct user key
-      switch (static_cast<ValueType>(tag & 0xff)) {
-        case kTypeValue: {
-          Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
-          value->assign(v.data(), v.size());
+            Slice(key_ptr, key_length - 8), key.user_key()) != 0) {
+      break;
+    }
+    // Correct user key
+    switch (static_cast<ValueType>(tag & 0xff)) {
+      case kTypeValue: {
+        Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+        value->assign(v.data(), v.size());
+        return true;
+      }
+      case kTypeDeletion:
+        *s = Status::NotFound(Slice());
+        return true;
+      case kTypeMerge:
+        if (merge_context == nullptr) {
           return true;
         }
-        case kTypeDeletion:
-          *s = Status::NotFound(Slice());
-          return true;
-      }
+        // Keep looking for older operands and the value underneath.
+        merge_context->PushOperand(
+            GetLengthPrefixedSlice(key_ptr + key_length));
+        break;
     }
   }
   return false;
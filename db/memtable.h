@@ -61,9 +61,12 @@ class MemTable : public MemTableRep {
   // If memtable contains a value for key, store it in *value and return true.
   // If memtable contains a deletion for key, store a NotFound() error
   // in *status and return true.
+  // Merge operands found on the way are added to *merge_context; if
+  // merge_context is nullptr, a merge operand ends the lookup like a
+  // value, but *value is left unchanged.
   // Else, return false.
   bool Get(const LookupKey& key, std::string* value, SequenceNumber* seq,
-           Status* s);
+           Status* s, MergeContext* merge_context);
 
   // nvm needs
   void Clear(uint64_t earliest_seq) {}
@@ -2,6 +2,9 @@
 
 #include "db/dbformat.h"
 namespace leveldb {
+
+class MergeContext;
+
 class MemTableRep {
  public:
   explicit MemTableRep() {}
@@ -18,7 +21,8 @@ class MemTableRep {
                    const Slice& value) = 0;
 
   virtual bool Get(const LookupKey& key, std::string* value,
-                   SequenceNumber* seq, Status* s) = 0;
+                   SequenceNumber* seq, Status* s,
+                   MergeContext* merge_context) = 0;
 
   virtual void Clear(uint64_t earliest_seq) = 0;
 
@@ -0,0 +1,105 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/merge_helper.h"
+
+#include "db/dbformat.h"
+#include "leveldb/comparator.h"
+#include "leveldb/iterator.h"
+#include "leveldb/merge_operator.h"
+
+namespace leveldb {
+
+Status FullMerge(const MergeOperator* merge_operator, const Slice& user_key,
+                 const Slice* existing_value,
+                 const std::vector<Slice>& operands, std::string* result) {
+  if (merge_operator == nullptr) {
+    return Status::NotSupported("no merge operator to apply merge for",
+                                user_key);
+  }
+  std::string merged;
+  if (!merge_operator->FullMerge(user_key, existing_value, operands,
+                                 &merged)) {
+    return Status::Corruption("merge failed for", user_key);
+  }
+  result->swap(merged);
+  return Status::OK();
+}
+
+Status MergeContext::Merge(const MergeOperator* merge_operator,
+                           const Slice& user_key, const Slice* existing_value,
+                           std::string* result) const {
+  std::vector<Slice> operands(operands_.rbegin(), operands_.rend());
+  return FullMerge(merge_operator, user_key, existing_value, operands, result);
+}
+
+Status MergeHelper::MergeUntil(Iterator* iter, bool at_bottom) {
+  keys_.clear();
+  values_.clear();
+
+  ParsedInternalKey ikey;
+  if (!ParseInternalKey(iter->key(), &ikey)) {
+    return Status::Corruption("corrupted internal key in MergeUntil");
+  }
+  assert(ikey.type == kTypeMerge);
+  const std::string user_key = ikey.user_key.ToString();
+  const SequenceNumber sequence = ikey.sequence;
+
+  bool found_base = false;
+  bool has_value = false;
+  std::string base_value;
+  for (; iter->Valid(); iter->Next()) {
+    if (!ParseInternalKey(iter->key(), &ikey) ||
+        user_comparator_->Compare(ikey.user_key, user_key) != 0) {
+      break;
+    }
+    if (ikey.type == kTypeMerge) {
+      keys_.push_back(iter->key().ToString());
+      values_.push_back(iter->value().ToString());
+      continue;
+    }
+    found_base = true;
+    if (ikey.type == kTypeValue) {
+      has_value = true;
+      base_value = iter->value().ToString();
+    }
+    iter->Next();
+    break;
+  }
+
+  if (found_base || at_bottom) {
+    std::vector<Slice> operands(values_.rbegin(), values_.rend());
+    Slice existing_value(base_value);
+    std::string merged;
+    Status s = FullMerge(merge_operator_, user_key,
+                         has_value ? &existing_value : nullptr, operands,
+                         &merged);
+    if (!s.ok()) {
+      return s;
+    }
+    keys_.clear();
+    keys_.emplace_back();
+    AppendInternalKey(&keys_.back(),
+                      ParsedInternalKey(user_key, sequence, kTypeValue));
+    values_.assign(1, merged);
+    return Status::OK();
+  }
+
+  // Older records may still be in levels below this compaction, so the
+  // operands stay operands.  Combine them if the operator can.
+  std::string combined = values_.back();
+  for (size_t i = values_.size() - 1; i > 0; i--) {
+    std::string tmp;
+    if (!merge_operator_->PartialMerge(user_key, combined, values_[i - 1],
+                                       &tmp)) {
+      return Status::OK();
+    }
+    combined.swap(tmp);
+  }
+  keys_.resize(1);
+  values_.assign(1, combined);
+  return Status::OK();
+}
+
+}  // namespace leveldb
@@ -0,0 +1,84 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_DB_MERGE_HELPER_H_
+#define STORAGE_LEVELDB_DB_MERGE_HELPER_H_
+
+#include <string>
+#include <vector>
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class Comparator;
+class Iterator;
+class MergeOperator;
+
+// Apply "operands", oldest first, to *existing_value (or to nothing if
+// existing_value is nullptr) with "merge_operator" and store the result
+// in *result.  existing_value may point into *result.
+Status FullMerge(const MergeOperator* merge_operator, const Slice& user_key,
+                 const Slice* existing_value,
+                 const std::vector<Slice>& operands, std::string* result);
+
+// Merge operands met by a point lookup on its way from the newest record
+// of a key down to the value or deletion underneath.
+class MergeContext {
+ public:
+  // Add an operand that is older than all operands added so far.
+  void PushOperand(const Slice& operand) {
+    operands_.emplace_back(operand.data(), operand.size());
+  }
+
+  bool empty() const { return operands_.empty(); }
+
+  // Store in *result the value that the collected operands produce on
+  // top of *existing_value, which may be nullptr and may point into
+  // *result.
+  Status Merge(const MergeOperator* merge_operator, const Slice& user_key,
+               const Slice* existing_value, std::string* result) const;
+
+ private:
+  std::vector<std::string> operands_;  // Newest first
+};
+
+// Folds runs of merge records together during a compaction.
+class MergeHelper {
+ public:
+  MergeHelper(const Comparator* user_comparator,
+              const MergeOperator* merge_operator)
+      : user_comparator_(user_comparator), merge_operator_(merge_operator) {}
+
+  MergeHelper(const MergeHelper&) = delete;
+  MergeHelper& operator=(const MergeHelper&) = delete;
+
+  // REQUIRES: "iter" is positioned at a merge record that every live
+  // snapshot can see.
+  //
+  // Consumes that record and the older records for the same user key, up
+  // to and including the first value or deletion, and leaves "iter" at
+  // the first record not consumed.  "at_bottom" means that no records
+  // for the key exist outside of "iter".
+  //
+  // On success keys() and values() hold the records that replace the
+  // consumed ones, in order: a value if the merge could be completed, a
+  // single merge record if the operands could be combined, or else the
+  // merge records themselves.
+  Status MergeUntil(Iterator* iter, bool at_bottom);
+
+  const std::vector<std::string>& keys() const { return keys_; }
+  const std::vector<std::string>& values() const { return values_; }
+
+ private:
+  const Comparator* const user_comparator_;
+  const MergeOperator* const merge_operator_;
+  std::vector<std::string> keys_;    // Internal keys, newest first
+  std::vector<std::string> values_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_MERGE_HELPER_H_
@@ -37,6 +37,7 @@
 #include "leveldb/comparator.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "table/table_internal.h"
 
 namespace leveldb {
 
@@ -171,7 +172,7 @@ class Repairer {
     // propagating bad information (like overly large sequence
     // numbers).
     log::Reader reader(lfile, &reporter, false /*do not checksum*/,
-                       0 /*initial_offset*/);
+                       0 /*initial_offset*/, log);
 
     // Read all the records and add to a memtable
     std::string scratch;
@@ -303,6 +304,7 @@ class Repairer {
       return;
     }
     TableBuilder* builder = new TableBuilder(options_, file);
+    TableInternal::SetInternalKeys(builder);
 
     // Copy data.
     Iterator* iter = NewTableIterator(t.meta);
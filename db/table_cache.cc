@@ -4,10 +4,15 @@
 
 #include "db/table_cache.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "db/filename.h"
 #include "leveldb/env.h"
 #include "leveldb/table.h"
+#include "table/table_internal.h"
 #include "util/coding.h"
+#include "util/perf_context_imp.h"
 
 namespace leveldb {
 
@@ -23,6 +28,11 @@ static void DeleteEntry(const Slice& key, void* value) {
   delete tf;
 }
 
+static void DeleteTableAndFile(void* arg1, void* arg2) {
+  delete reinterpret_cast<Table*>(arg1);
+  delete reinterpret_cast<RandomAccessFile*>(arg2);
+}
+
 static void UnrefEntry(void* arg1, void* arg2) {
   Cache* cache = reinterpret_cast<Cache*>(arg1);
   Cache::Handle* h = reinterpret_cast<Cache::Handle*>(arg2);
@@ -34,28 +44,52 @@ TableCache::TableCache(const std::string& dbname, const Options& options,
     : env_(options.env),
       dbname_(dbname),
       options_(options),
-      cache_(NewLRUCache(entries)) {}
+      cache_(NewLRUCache(entries)),
+      row_cache_id_(options.row_cache ? options.row_cache->NewId() : 0) {}
 
 TableCache::~TableCache() { delete cache_; }
 
+Status TableCache::OpenTableFile(uint64_t file_number,
+                                 const FileOptions& file_options,
+                                 RandomAccessFile** file) {
+  // Envs that only implement the plain NewRandomAccessFile() still see the
+  // default case.
+  const bool plain =
+      file_options.allow_mmap_reads && !file_options.use_direct_io;
+  const std::string fnames[] = {TableFileName(dbname_, file_number),
+                                SSTTableFileName(dbname_, file_number)};
+  Status s;
+  for (const std::string& fname : fnames) {
+    Status open_status =
+        plain ? env_->NewRandomAccessFile(fname, file)
+              : env_->NewRandomAccessFile(fname, file_options, file);
+    if (open_status.ok()) {
+      return open_status;
+    }
+    if (s.ok()) {
+      s = open_status;  // Report the error for the current file name.
+    }
+  }
+  return s;
+}
+
 Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
                              Cache::Handle** handle) {
   Status s;
   char buf[sizeof(file_number)];
   EncodeFixed64(buf, file_number);
   Slice key(buf, sizeof(buf));
+  PerfTimer timer(&perf_context.find_table_nanos);
   *handle = cache_->Lookup(key);
   if (*handle == nullptr) {
-    std::string fname = TableFileName(dbname_, file_number);
+    PerfTimer open_timer(&iostats_context.open_nanos);
+    FileOptions file_options;
+    file_options.allow_mmap_reads =
+        options_.allow_mmap_reads && !options_.use_direct_reads;
+    file_options.use_direct_io = options_.use_direct_reads;
     RandomAccessFile* file = nullptr;
     Table* table = nullptr;
-    s = env_->NewRandomAccessFile(fname, &file);
-    if (!s.ok()) {
-      std::string old_fname = SSTTableFileName(dbname_, file_number);
-      if (env_->NewRandomAccessFile(old_fname, &file).ok()) {
-        s = Status::OK();
-      }
-    }
+    s = OpenTableFile(file_number, file_options, &file);
     if (s.ok()) {
       s = Table::Open(options_, file, file_size, &table);
     }
@@ -66,6 +100,7 @@ Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
       // We do not cache error results so that if the error is transient,
       // or somebody repairs the file, we recover automatically.
     } else {
+      TableInternal::SetInternalKeys(table);
       TableAndFile* tf = new TableAndFile;
       tf->file = file;
       tf->table = table;
@@ -75,9 +110,20 @@ Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
   return s;
 }
 
+void TableCache::MaybePinMetaBlocks(Table* table, int level) {
+  if (!options_.pin_l0_filter_and_index_blocks_in_cache) {
+    return;
+  }
+  if (level == 0) {
+    table->PinMetaBlocks();
+  } else if (level > 0) {
+    table->UnpinMetaBlocks();
+  }
+}
+
 Iterator* TableCache::NewIterator(const ReadOptions& options,
                                   uint64_t file_number, uint64_t file_size,
-                                  Table** tableptr) {
+                                  Table** tableptr, int level) {
   if (tableptr != nullptr) {
     *tableptr = nullptr;
   }
@@ -89,6 +135,7 @@ Iterator* TableCache::NewIterator(const ReadOptions& options,
   }
 
   Table* table = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+  MaybePinMetaBlocks(table, level);
   Iterator* result = table->NewIterator(options);
   result->RegisterCleanup(&UnrefEntry, cache_, handle);
   if (tableptr != nullptr) {
@@ -97,15 +144,124 @@ Iterator* TableCache::NewIterator(const ReadOptions& options,
   return result;
 }
 
+Iterator* TableCache::NewCompactionIterator(const ReadOptions& options,
+                                            uint64_t file_number,
+                                            uint64_t file_size) {
+  if (!options_.use_direct_io_for_flush_and_compaction ||
+      options_.use_direct_reads) {
+    return NewIterator(options, file_number, file_size);
+  }
+
+  FileOptions file_options;
+  file_options.allow_mmap_reads = false;
+  file_options.use_direct_io = true;
+  RandomAccessFile* file = nullptr;
+  Status s = OpenTableFile(file_number, file_options, &file);
+  if (!s.ok()) {
+    return NewErrorIterator(s);
+  }
+
+  // The scan reads every block once: leave out the block cache, whose
+  // blocks are keyed by the cached table anyway, and the filter.
+  Options table_options = options_;
+  table_options.block_cache = nullptr;
+  table_options.filter_policy = nullptr;
+  Table* table = nullptr;
+  s = Table::Open(table_options, file, file_size, &table);
+  if (!s.ok()) {
+    delete file;
+    return NewErrorIterator(s);
+  }
+  TableInternal::SetInternalKeys(table);
+  Iterator* result = table->NewIterator(options);
+  result->RegisterCleanup(&DeleteTableAndFile, table, file);
+  return result;
+}
+
+namespace {
+
+// State of a lookup that fills the row cache.  A row cache entry is the
+// entry found by the table lookup, encoded as:
+//    key_length: varint32
+//    key:        char[key_length]  (internal key)
+//    value:      char[...]
+struct RowSaver {
+  void* arg;
+  void (*handle_result)(void*, const Slice&, const Slice&);
+  Slice user_key;
+  bool found;
+  std::string row;
+};
+
+void DeleteRow(const Slice& key, void* value) {
+  delete reinterpret_cast<std::string*>(value);
+}
+
+// Forwards the result of a table lookup and keeps a copy of it.
+void SaveRow(void* arg, const Slice& k, const Slice& v) {
+  RowSaver* saver = reinterpret_cast<RowSaver*>(arg);
+  // Only entries for the key itself are worth caching; anything else just
+  // means that the table does not contain the key.
+  if (k.size() >= 8 && ExtractUserKey(k) == saver->user_key) {
+    saver->found = true;
+    PutLengthPrefixedSlice(&saver->row, k);
+    saver->row.append(v.data(), v.size());
+  }
+  (*saver->handle_result)(saver->arg, k, v);
+}
+
+}  // namespace
+
 Status TableCache::Get(const ReadOptions& options, uint64_t file_number,
                        uint64_t file_size, const Slice& k, void* arg,
                        void (*handle_result)(void*, const Slice&,
-                                             const Slice&)) {
+                                             const Slice&),
+                       int level) {
+  // Without a snapshot the lookup sequence is newer than every entry in
+  // the file, so the result depends only on the file and the user key.
+  Cache* row_cache = options_.row_cache;
+  const bool use_row_cache =
+      row_cache != nullptr && options.snapshot == nullptr;
+  std::string row_key;
+  if (use_row_cache) {
+    Slice user_key = ExtractUserKey(k);
+    PutFixed64(&row_key, row_cache_id_);
+    PutFixed64(&row_key, file_number);
+    row_key.append(user_key.data(), user_key.size());
+    Cache::Handle* row_handle = row_cache->Lookup(row_key);
+    if (row_handle != nullptr) {
+      Slice row(*reinterpret_cast<std::string*>(row_cache->Value(row_handle)));
+      Slice found_key;
+      if (GetLengthPrefixedSlice(&row, &found_key)) {
+        (*handle_result)(arg, found_key, row);
+      }
+      row_cache->Release(row_handle);
+      PerfCount(&perf_context.row_cache_hit_count);
+      return Status::OK();
+    }
+  }
+
   Cache::Handle* handle = nullptr;
   Status s = FindTable(file_number, file_size, &handle);
   if (s.ok()) {
     Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
-    s = t->InternalGet(options, k, arg, handle_result);
+    MaybePinMetaBlocks(t, level);
+    if (use_row_cache) {
+      RowSaver saver;
+      saver.arg = arg;
+      saver.handle_result = handle_result;
+      saver.user_key = ExtractUserKey(k);
+      saver.found = false;
+      s = t->InternalGet(options, k, &saver, &SaveRow);
+      if (s.ok() && saver.found) {
+        std::string* row = new std::string;
+        row->swap(saver.row);
+        row_cache->Release(
+            row_cache->Insert(row_key, row, row->size(), &DeleteRow));
+      }
+    } else {
+      s = t->InternalGet(options, k, arg, handle_result);
+    }
     cache_->Release(handle);
   }
   return s;
@@ -117,4 +273,70 @@ void TableCache::Evict(uint64_t file_number) {
   cache_->Erase(Slice(buf, sizeof(buf)));
 }
 
+void TableCache::UnpinMetaBlocks(uint64_t file_number) {
+  char buf[sizeof(file_number)];
+  EncodeFixed64(buf, file_number);
+  Cache::Handle* handle = cache_->Lookup(Slice(buf, sizeof(buf)));
+  if (handle != nullptr) {
+    reinterpret_cast<TableAndFile*>(cache_->Value(handle))
+        ->table->UnpinMetaBlocks();
+    cache_->Release(handle);
+  }
+}
+
+namespace {
+
+struct CachedBlockCollector {
+  std::unordered_map<uint64_t, uint64_t> file_by_cache_id;
+  std::map<uint64_t, std::vector<uint64_t>>* blocks;
+};
+
+}  // namespace
+
+void TableCache::CollectTable(void* arg, const Slice& key, void* value,
+                              void (*deleter)(const Slice&, void*)) {
+  CachedBlockCollector* c = reinterpret_cast<CachedBlockCollector*>(arg);
+  Table* table = reinterpret_cast<TableAndFile*>(value)->table;
+  c->file_by_cache_id[table->CacheId()] = DecodeFixed64(key.data());
+}
+
+void TableCache::CollectBlock(void* arg, const Slice& key, void* value,
+                              void (*deleter)(const Slice&, void*)) {
+  CachedBlockCollector* c = reinterpret_cast<CachedBlockCollector*>(arg);
+  if (key.size() != 16 || !Table::IsCachedBlock(deleter)) {
+    return;
+  }
+  auto iter = c->file_by_cache_id.find(DecodeFixed64(key.data()));
+  if (iter != c->file_by_cache_id.end()) {
+    (*c->blocks)[iter->second].push_back(DecodeFixed64(key.data() + 8));
+  }
+}
+
+void TableCache::GetCachedBlocks(
+    std::map<uint64_t, std::vector<uint64_t>>* blocks) {
+  if (options_.block_cache == nullptr) {
+    return;
+  }
+  CachedBlockCollector collector;
+  collector.blocks = blocks;
+  cache_->ApplyToAllEntries(&CollectTable, &collector);
+  options_.block_cache->ApplyToAllEntries(&CollectBlock, &collector);
+  for (auto& file : *blocks) {
+    std::sort(file.second.begin(), file.second.end());
+  }
+}
+
+Status TableCache::WarmBlocks(uint64_t file_number, uint64_t file_size,
+                              const std::vector<uint64_t>& offsets,
+                              const std::atomic<bool>* stop) {
+  Cache::Handle* handle = nullptr;
+  Status s = FindTable(file_number, file_size, &handle);
+  if (s.ok()) {
+    Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+    s = t->WarmBlocks(offsets, stop);
+    cache_->Release(handle);
+  }
+  return s;
+}
+
 }  // namespace leveldb
@@ -7,18 +7,20 @@
 #ifndef STORAGE_LEVELDB_DB_TABLE_CACHE_H_
 #define STORAGE_LEVELDB_DB_TABLE_CACHE_H_
 
+#include <atomic>
 #include <cstdint>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "db/dbformat.h"
 #include "leveldb/cache.h"
+#include "leveldb/env.h"
 #include "leveldb/table.h"
 #include "port/port.h"
 
 namespace leveldb {
 
-class Env;
-
 class TableCache {
  public:
   TableCache(const std::string& dbname, const Options& options, int entries);
@@ -31,25 +33,67 @@ class TableCache {
   // underlies the returned iterator.  The returned "*tableptr" object is owned
   // by the cache and should not be deleted, and is valid for as long as the
   // returned iterator is live.
+  //
+  // "level" is the level of the file in the current version, or -1 if
+  // unknown.
   Iterator* NewIterator(const ReadOptions& options, uint64_t file_number,
-                        uint64_t file_size, Table** tableptr = nullptr);
+                        uint64_t file_size, Table** tableptr = nullptr,
+                        int level = -1);
+
+  // Return an iterator over the specified file for reading it as
+  // compaction input.  With options.use_direct_io_for_flush_and_compaction
+  // the file is opened separately for direct I/O, so that the scan does not
+  // go through the page cache; that table is not cached and is closed with
+  // the iterator.
+  Iterator* NewCompactionIterator(const ReadOptions& options,
+                                  uint64_t file_number, uint64_t file_size);
 
   // If a seek to internal key "k" in specified file finds an entry,
   // call (*handle_result)(arg, found_key, found_value).
   Status Get(const ReadOptions& options, uint64_t file_number,
              uint64_t file_size, const Slice& k, void* arg,
-             void (*handle_result)(void*, const Slice&, const Slice&));
+             void (*handle_result)(void*, const Slice&, const Slice&),
+             int level = -1);
 
   // Evict any entry for the specified file number
   void Evict(uint64_t file_number);
 
+  // Releases the blocks pinned for the specified file, if it is open,
+  // once the file has moved out of level 0.
+  void UnpinMetaBlocks(uint64_t file_number);
+
+  // Store the offsets of the data blocks of open tables that are held in
+  // options.block_cache in *blocks, keyed by file number.  The offsets of
+  // each file are sorted.
+  void GetCachedBlocks(std::map<uint64_t, std::vector<uint64_t>>* blocks);
+
+  // Read the data blocks at the given sorted "offsets" of the specified file
+  // into options.block_cache.  Stops early once "*stop" becomes true.
+  Status WarmBlocks(uint64_t file_number, uint64_t file_size,
+                    const std::vector<uint64_t>& offsets,
+                    const std::atomic<bool>* stop);
+
  private:
   Status FindTable(uint64_t file_number, uint64_t file_size, Cache::Handle**);
+  Status OpenTableFile(uint64_t file_number, const FileOptions& file_options,
+                       RandomAccessFile** file);
+
+  // Applies the pinning options to a table found at "level": pins the
+  // meta blocks of level-0 tables and unpins those of tables that have
+  // since moved to a deeper level.
+  void MaybePinMetaBlocks(Table* table, int level);
+
+  // Cache::ApplyToAllEntries() callbacks used by GetCachedBlocks().
+  static void CollectTable(void* arg, const Slice& key, void* value,
+                           void (*deleter)(const Slice&, void*));
+  static void CollectBlock(void* arg, const Slice& key, void* value,
+                           void (*deleter)(const Slice&, void*));
 
   Env* const env_;
   const std::string dbname_;
   const Options& options_;
   Cache* cache_;
+  const uint64_t row_cache_id_;  // Prefix of our keys in options_.row_cache
 };
 
 }  // namespace leveldb
@@ -8,9 +8,12 @@
 #include "db/log_reader.h"
 #include "db/log_writer.h"
 #include "db/memtable.h"
+#include "db/merge_helper.h"
 #include "db/table_cache.h"
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <limits>
 
 #include "leveldb/env.h"
 #include "leveldb/table_builder.h"
@@ -19,6 +22,8 @@
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
 #include "util/logging.h"
+#include "util/perf_context_imp.h"
+#include "util/statistics.h"
 
 namespace leveldb {
 
@@ -39,19 +44,6 @@ static int64_t ExpandedCompactionByteSizeLimit(const Options* options) {
   return 25 * TargetFileSize(options);
 }
 
-static double MaxBytesForLevel(const Options* options, int level) {
-  // Note: the result for level zero is not really used since we set
-  // the level-0 compaction threshold based on number of files.
-
-  // Result for both level-0 and level-1
-  double result = 10. * 1048576.0;
-  while (level > 1) {
-    result *= 10;
-    level--;
-  }
-  return result;
-}
-
 static uint64_t MaxFileSizeForLevel(const Options* options, int level) {
   // We could vary per level to reduce number of files?
   return TargetFileSize(options);
@@ -220,6 +212,20 @@ static Iterator* GetFileIterator(void* arg, const ReadOptions& options,
   }
 }
 
+static Iterator* GetCompactionFileIterator(void* arg,
+                                           const ReadOptions& options,
+                                           const Slice& file_value) {
+  TableCache* cache = reinterpret_cast<TableCache*>(arg);
+  if (file_value.size() != 16) {
+    return NewErrorIterator(
+        Status::Corruption("FileReader invoked with unexpected value"));
+  } else {
+    return cache->NewCompactionIterator(options,
+                                        DecodeFixed64(file_value.data()),
+                                        DecodeFixed64(file_value.data() + 8));
+  }
+}
+
 Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
                                             int level) const {
   return NewTwoLevelIterator(
@@ -232,7 +238,7 @@ void Version::AddIterators(const ReadOptions& options,
   // Merge all level zero files together since they may overlap
   for (size_t i = 0; i < files_[0].size(); i++) {
     iters->push_back(vset_->table_cache_->NewIterator(
-        options, files_[0][i]->number, files_[0][i]->file_size));
+        options, files_[0][i]->number, files_[0][i]->file_size, nullptr, 0));
   }
 
   // For levels > 0, we can use a concatenating iterator that sequentially
@@ -252,12 +258,14 @@ enum SaverState {
   kFound,
   kDeleted,
   kCorrupt,
+  kMerge,
 };
 struct Saver {
   SaverState state;
   const Comparator* ucmp;
   Slice user_key;
   std::string* value;
+  MergeContext* merge_context;
 };
 }  // namespace
 static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
@@ -267,9 +275,18 @@ static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
     s->state = kCorrupt;
   } else {
     if (s->ucmp->Compare(parsed_key.user_key, s->user_key) == 0) {
-      s->state = (parsed_key.type == kTypeValue) ? kFound : kDeleted;
-      if (s->state == kFound) {
-        s->value->assign(v.data(), v.size());
+      switch (parsed_key.type) {
+        case kTypeValue:
+          s->state = kFound;
+          s->value->assign(v.data(), v.size());
+          break;
+        case kTypeDeletion:
+          s->state = kDeleted;
+          break;
+        case kTypeMerge:
+          s->state = kMerge;
+          s->merge_context->PushOperand(v);
+          break;
       }
     }
   }
@@ -328,7 +345,8 @@ void Version::ForEachOverlapping(Slice user_key, Slice internal_key, void* arg,
 }
 
 Status Version::Get(const ReadOptions& options, const LookupKey& k,
-                    std::string* value, GetStats* stats) {
+                    std::string* value, GetStats* stats,
+                    MergeContext* merge_context) {
   stats->seek_file = nullptr;
   stats->seek_file_level = -1;
 
@@ -358,18 +376,28 @@ Status Version::Get(const ReadOptions& options, const LookupKey& k,
       state->last_file_read_level = level;
 
       // 从cache中获取
-      state->s = state->vset->table_cache_->Get(*state->options, f->number,
-                                                f->file_size, state->ikey,
-                                                &state->saver, SaveValue);
+      PerfCount(&perf_context.table_files_searched_count);
+      PerfTimer timer(&perf_context.get_from_level_nanos[level]);
+      state->saver.state = kNotFound;
+      state->s = state->vset->table_cache_->Get(
+          *state->options, f->number, f->file_size, state->ikey,
+          &state->saver, SaveValue, level);
+      if (state->s.ok() && state->saver.state == kMerge) {
+        state->s = state->ReadOlderRecords(level, f);
+      }
+      timer.Stop();
       if (!state->s.ok()) {
         state->found = true;
         return false;
       }
       switch (state->saver.state) {
         case kNotFound:
+        case kMerge:
           return true;  // Keep searching in other files
         case kFound:
           state->found = true;
+          RecordTick(state->vset->options_->statistics,
+                     level == 0 ? kGetHitL0 : kGetHitL1AndUp);
           return false;
         case kDeleted:
           return false;
@@ -384,6 +412,25 @@ Status Version::Get(const ReadOptions& options, const LookupKey& k,
       // "control reaches end of non-void function".
       return false;
     }
+
+    // The lookup in "f" found a merge operand.  Older records for the key
+    // may follow it in the same file, so walk them until one of them is
+    // not an operand.
+    Status ReadOlderRecords(int level, FileMetaData* f) {
+      Iterator* iter = vset->table_cache_->NewIterator(
+          *options, f->number, f->file_size, nullptr, level);
+      iter->Seek(ikey);
+      if (iter->Valid()) {
+        iter->Next();  // Skip the operand that was just found
+      }
+      for (; iter->Valid() && saver.state == kMerge; iter->Next()) {
+        saver.state = kNotFound;
+        SaveValue(&saver, iter->key(), iter->value());
+      }
+      Status s = iter->status();
+      delete iter;
+      return s;
+    }
   };
 
   State state;
@@ -400,6 +447,7 @@ Status Version::Get(const ReadOptions& options, const LookupKey& k,
   state.saver.ucmp = vset_->icmp_.user_comparator();
   state.saver.user_key = k.user_key();
   state.saver.value = value;
+  state.saver.merge_context = merge_context;
 
   ForEachOverlapping(state.saver.user_key, state.ikey, &state, &State::Match);
 
@@ -408,7 +456,10 @@ Status Version::Get(const ReadOptions& options, const LookupKey& k,
 
 bool Version::UpdateStats(const GetStats& stats) {
   FileMetaData* f = stats.seek_file;
-  if (f != nullptr) {
+  // Universal compaction merges whole sorted runs; moving a single file
+  // down would break them up.
+  if (f != nullptr &&
+      vset_->options_->compaction_style != kCompactionStyleUniversal) {
     f->allowed_seeks--;
     if (f->allowed_seeks <= 0 && file_to_compact_ == nullptr) {
       file_to_compact_ = f;
@@ -486,6 +537,27 @@ int Version::PickLevelForMemTableOutput(const Slice& smallest_user_key,
     InternalKey limit(largest_user_key, 0, static_cast<ValueType>(0));
     std::vector<FileMetaData*> overlaps;
 
+    if (vset_->options_->compaction_style == kCompactionStyleUniversal) {
+      // Every new table is a sorted run of its own.
+      return 0;
+    }
+    if (vset_->options_->level_compaction_dynamic_level_bytes) {
+      // The levels above the base level are kept empty, so the table either
+      // stays in level-0 or goes straight to the base level.
+      const int base = base_level_;
+      if (OverlapInLevel(base, &smallest_user_key, &largest_user_key)) {
+        return 0;
+      }
+      if (base + 1 < config::kNumLevels) {
+        GetOverlappingInputs(base + 1, &start, &limit, &overlaps);
+        if (TotalFileSize(overlaps) >
+            MaxGrandParentOverlapBytes(vset_->options_)) {
+          return 0;
+        }
+      }
+      return base;
+    }
+
     while (level < config::kMaxMemCompactLevel) {
       // 与level+1有重叠
       if (OverlapInLevel(level + 1, &smallest_user_key, &largest_user_key)) {
@@ -1092,7 +1164,103 @@ void VersionSet::MarkFileNumberUsed(uint64_t number) {
   }
 }
 
+void VersionSet::SetLevelTargets(Version* v) {
+  const double base = options_->max_bytes_for_level_base;
+  double multiplier = options_->max_bytes_for_level_multiplier;
+  const int last = config::kNumLevels - 1;
+
+  // Note: the target for level zero is not really used since we set
+  // the level-0 compaction threshold based on number of files.
+  v->max_bytes_for_level_[0] = base;
+  v->base_level_ = 1;
+  double size = base;
+  if (options_->level_compaction_dynamic_level_bytes) {
+    int first_non_empty = -1;
+    int64_t max_level_bytes = 0;
+    for (int level = 1; level <= last; level++) {
+      const int64_t level_bytes = TotalFileSize(v->files_[level]);
+      if (level_bytes > 0 && first_non_empty < 0) {
+        first_non_empty = level;
+      }
+      max_level_bytes = std::max(max_level_bytes, level_bytes);
+    }
+
+    if (max_level_bytes == 0) {
+      // Nothing below level-0 yet: compact level-0 into the last level.
+      v->base_level_ = last;
+    } else {
+      // Work back from the largest level to find the first level whose
+      // target reaches "base".  Never start above the first level that
+      // already holds data, which would leave files above the base level.
+      size = max_level_bytes;
+      for (int level = last; level > first_non_empty; level--) {
+        size /= multiplier;
+      }
+      v->base_level_ = first_non_empty;
+      while (v->base_level_ > 1 && size > base) {
+        v->base_level_--;
+        size /= multiplier;
+      }
+      if (size > base) {
+        // Even level-1 would be too large: keep it at "base" and spread the
+        // rest of the growth evenly over the levels below it.
+        size = base;
+        multiplier = std::pow(max_level_bytes / base, 1.0 / (last - 1));
+      } else {
+        // Keep a nearly empty base level from churning through tiny
+        // compactions.
+        size = std::max(size, base / multiplier);
+      }
+    }
+  }
+
+  for (int level = 1; level <= last; level++) {
+    if (level < v->base_level_) {
+      v->max_bytes_for_level_[level] = std::numeric_limits<double>::max();
+    } else {
+      v->max_bytes_for_level_[level] = size;
+      size *= multiplier;
+    }
+  }
+}
+
+int Version::NumSortedRuns() const {
+  int runs = files_[0].size();
+  for (int level = 1; level < config::kNumLevels; level++) {
+    if (!files_[level].empty()) {
+      runs++;
+    }
+  }
+  return runs;
+}
+
 void VersionSet::Finalize(Version* v) {
+  SetLevelTargets(v);
+
+  if (options_->compaction_style == kCompactionStyleUniversal) {
+    // Compact once there are too many sorted runs to merge on every read.
+    const int runs = v->NumSortedRuns();
+    v->compaction_level_ = 0;
+    v->compaction_score_ =
+        runs < 2 ? 0
+                 : runs / static_cast<double>(
+                              options_->level0_file_num_compaction_trigger);
+    // Everything outside the oldest run is rewritten sooner or later.
+    v->pending_compaction_bytes_ = 0;
+    if (v->compaction_score_ >= 1) {
+      for (int level = 0; level < config::kNumLevels; level++) {
+        v->pending_compaction_bytes_ += TotalFileSize(v->files_[level]);
+      }
+      for (int level = config::kNumLevels - 1; level > 0; level--) {
+        if (!v->files_[level].empty()) {
+          v->pending_compaction_bytes_ -= TotalFileSize(v->files_[level]);
+          break;
+        }
+      }
+    }
+    return;
+  }
+
   // Precomputed best level for next compaction
   int best_level = -1;
   double best_score = -1;
@@ -1114,13 +1282,12 @@ void VersionSet::Finalize(Version* v) {
 
       // 对于level0，其默认设计的文件数量不超过4
       score = v->files_[level].size() /
-              static_cast<double>(config::kL0_CompactionTrigger);
+              static_cast<double>(options_->level0_file_num_compaction_trigger);
     } else {
       // Compute the ratio of current size to size limit.
       const uint64_t level_bytes = TotalFileSize(v->files_[level]);
       //其他 level 则是根据当前文件大小与 size limit 的比值
-      score =
-          static_cast<double>(level_bytes) / MaxBytesForLevel(options_, level);
+      score = static_cast<double>(level_bytes) / v->max_bytes_for_level_[level];
     }
 
     // 选择得分最高的来做compaction
@@ -1132,6 +1299,25 @@ void VersionSet::Finalize(Version* v) {
 
   v->compaction_level_ = best_level;
   v->compaction_score_ = best_score;
+
+  // Level-0 is moved down in its entirety once it reaches the trigger; each
+  // other level by whatever exceeds its limit, including what it receives
+  // from the level above.
+  uint64_t pending = 0;
+  uint64_t incoming = 0;
+  if (static_cast<int>(v->files_[0].size()) >=
+      options_->level0_file_num_compaction_trigger) {
+    incoming = TotalFileSize(v->files_[0]);
+    pending += incoming;
+  }
+  for (int level = v->base_level_; level < config::kNumLevels - 1; level++) {
+    const double level_bytes = TotalFileSize(v->files_[level]) + incoming;
+    const double limit = v->max_bytes_for_level_[level];
+    incoming = level_bytes > limit ? static_cast<uint64_t>(level_bytes - limit)
+                                   : 0;
+    pending += incoming;
+  }
+  v->pending_compaction_bytes_ = pending;
 }
 
 Status VersionSet::WriteSnapshot(log::Writer* log) {
@@ -1226,6 +1412,14 @@ void VersionSet::AddLiveFiles(std::set<uint64_t>* live) {
   }
 }
 
+void VersionSet::CurrentFileSizes(std::map<uint64_t, uint64_t>* sizes) const {
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (const FileMetaData* f : current_->files_[level]) {
+      (*sizes)[f->number] = f->file_size;
+    }
+  }
+}
+
 int64_t VersionSet::NumLevelBytes(int level) const {
   assert(level >= 0);
   assert(level < config::kNumLevels);
@@ -1288,11 +1482,13 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
   ReadOptions options;
   options.verify_checksums = options_->paranoid_checks;
   options.fill_cache = false;
+  options.readahead_size = options_->compaction_readahead_size;
 
   // Level-0 files have to be merged together.  For other levels,
   // we will make a concatenating iterator per level.
   // TODO(opt): use concatenating iterator for level-0 if there is no overlap
-  const int space = (c->level() == 0 ? c->inputs_[0].size() + 1 : 2);
+  const int space = (c->level() == 0 ? c->inputs_[0].size() + 1 : 2) +
+                    std::max(c->output_level() - c->level() - 1, 0);
   // list中的每个iter，都指向了一个即将被compaction的sstable
   Iterator** list = new Iterator*[space];
   int num = 0;
@@ -1302,18 +1498,25 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
         // 对第0层的files，通过table_cache创建iter
         const std::vector<FileMetaData*>& files = c->inputs_[which];
         for (size_t i = 0; i < files.size(); i++) {
-          list[num++] = table_cache_->NewIterator(options, files[i]->number,
-                                                  files[i]->file_size);
+          list[num++] = table_cache_->NewCompactionIterator(
+              options, files[i]->number, files[i]->file_size);
         }
       } else {
         // 非第0层的fiels，使用TwoLevelIterator来迭代（index iter 和 data iter)
         // Create concatenating iterator for the files from this level
         list[num++] = NewTwoLevelIterator(
             new Version::LevelFileNumIterator(icmp_, &c->inputs_[which]),
-            &GetFileIterator, table_cache_, options);
+            &GetCompactionFileIterator, table_cache_, options);
       }
     }
   }
+  for (int level = c->level() + 1; level < c->output_level(); level++) {
+    if (!c->middle_inputs_[level].empty()) {
+      list[num++] = NewTwoLevelIterator(
+          new Version::LevelFileNumIterator(icmp_, &c->middle_inputs_[level]),
+          &GetCompactionFileIterator, table_cache_, options);
+    }
+  }
   assert(num <= space);
   // 所有需要的compaction
   // file都有一个iter，现在需要归并排序，这通过mergeiteraotr实现
@@ -1323,6 +1526,10 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
 }
 
 Compaction* VersionSet::PickCompaction() {
+  if (options_->compaction_style == kCompactionStyleUniversal) {
+    return PickUniversalCompaction();
+  }
+
   Compaction* c;
   int level;
 
@@ -1337,7 +1544,7 @@ Compaction* VersionSet::PickCompaction() {
     level = current_->compaction_level_;
     assert(level >= 0);
     assert(level + 1 < config::kNumLevels);
-    c = new Compaction(options_, level);
+    c = new Compaction(options_, level, OutputLevel(level));
 
     // 找到第一个文件，其最大key比 compact_pointer_[level]的key大
     // Pick the first file that comes after compact_pointer_[level]
@@ -1357,7 +1564,7 @@ Compaction* VersionSet::PickCompaction() {
   } else if (seek_compaction) {
     //考虑seek_compaction
     level = current_->file_to_compact_level_;
-    c = new Compaction(options_, level);
+    c = new Compaction(options_, level, OutputLevel(level));
     c->inputs_[0].push_back(current_->file_to_compact_);
   } else {
     return nullptr;
@@ -1474,6 +1681,7 @@ void AddBoundaryInputs(const InternalKeyComparator& icmp,
 
 void VersionSet::SetupOtherInputs(Compaction* c) {
   const int level = c->level();
+  const int output_level = c->output_level();
   InternalKey smallest, largest;
 
   // 扩展上边界
@@ -1483,9 +1691,9 @@ void VersionSet::SetupOtherInputs(Compaction* c) {
 
   // 获取level n+1中与 level n的range重叠的sstable，
   // 将这些sstable存放在c->inputs_[1]中
-  current_->GetOverlappingInputs(level + 1, &smallest, &largest,
+  current_->GetOverlappingInputs(output_level, &smallest, &largest,
                                  &c->inputs_[1]);
-  AddBoundaryInputs(icmp_, current_->files_[level + 1], &c->inputs_[1]);
+  AddBoundaryInputs(icmp_, current_->files_[output_level], &c->inputs_[1]);
 
   // Get entire range covered by compaction
   InternalKey all_start, all_limit;
@@ -1516,9 +1724,9 @@ void VersionSet::SetupOtherInputs(Compaction* c) {
       //加入后的第 level n+1层的 compaction sstable 的总大小为多少（即
       // expanded1_size)
       std::vector<FileMetaData*> expanded1;
-      current_->GetOverlappingInputs(level + 1, &new_start, &new_limit,
+      current_->GetOverlappingInputs(output_level, &new_start, &new_limit,
                                      &expanded1);
-      AddBoundaryInputs(icmp_, current_->files_[level + 1], &expanded1);
+      AddBoundaryInputs(icmp_, current_->files_[output_level], &expanded1);
 
       //在 level n 中加入新 sstable，但没有引起 level n+1 的 sstable
       //选择，则加入这个新 sstable。
@@ -1539,9 +1747,9 @@ void VersionSet::SetupOtherInputs(Compaction* c) {
 
   // 计算grandparent files
   // Compute the set of grandparent files that overlap this compaction
-  // (parent == level+1; grandparent == level+2)
-  if (level + 2 < config::kNumLevels) {
-    current_->GetOverlappingInputs(level + 2, &all_start, &all_limit,
+  // (parent == output_level; grandparent == output_level+1)
+  if (output_level + 1 < config::kNumLevels) {
+    current_->GetOverlappingInputs(output_level + 1, &all_start, &all_limit,
                                    &c->grandparents_);
   }
 
@@ -1579,7 +1787,7 @@ Compaction* VersionSet::CompactRange(int level, const InternalKey* begin,
     }
   }
 
-  Compaction* c = new Compaction(options_, level);
+  Compaction* c = new Compaction(options_, level, OutputLevel(level));
   c->input_version_ = current_;
   c->input_version_->Ref();
   c->inputs_[0] = inputs;
@@ -1587,8 +1795,139 @@ Compaction* VersionSet::CompactRange(int level, const InternalKey* begin,
   return c;
 }
 
-Compaction::Compaction(const Options* options, int level)
+namespace {
+
+// A sorted run for universal compaction: a single level-0 file, or a whole
+// non-empty level.
+struct SortedRun {
+  int level;
+  FileMetaData* file;  // The level-0 file, or nullptr for a whole level
+  uint64_t size;
+};
+
+}  // namespace
+
+Compaction* VersionSet::PickUniversalCompaction() {
+  Version* const v = current_;
+
+  // List the sorted runs from newest to oldest, the order reads visit them
+  // in.
+  std::vector<FileMetaData*> level0 = v->files_[0];
+  std::sort(level0.begin(), level0.end(), NewestFirst);
+  std::vector<SortedRun> runs;
+  for (FileMetaData* f : level0) {
+    runs.push_back({0, f, f->file_size});
+  }
+  for (int level = 1; level < config::kNumLevels; level++) {
+    if (!v->files_[level].empty()) {
+      runs.push_back({level, nullptr,
+                      static_cast<uint64_t>(TotalFileSize(v->files_[level]))});
+    }
+  }
+  const size_t n = runs.size();
+  if (n < 2 ||
+      n < static_cast<size_t>(options_->level0_file_num_compaction_trigger)) {
+    return nullptr;
+  }
+
+  const size_t min_width = options_->universal_min_merge_width;
+  const size_t max_width =
+      options_->universal_max_merge_width > 0
+          ? std::max<size_t>(min_width, options_->universal_max_merge_width)
+          : n;
+  const uint64_t ratio = options_->universal_size_ratio;
+  const char* reason;
+  size_t first = 0;
+  size_t last = 0;  // The runs first..last are merged
+
+  // Merge everything once the newer runs take up too much space next to
+  // the oldest one.
+  uint64_t newer_bytes = 0;
+  for (size_t i = 0; i + 1 < n; i++) {
+    newer_bytes += runs[i].size;
+  }
+  const uint64_t amp = options_->universal_max_size_amplification_percent;
+  if (amp > 0 && newer_bytes * 100 >= amp * runs[n - 1].size) {
+    reason = "size amplification";
+    last = n - 1;
+  } else {
+    // Otherwise merge the newest stretch of runs that are each no larger
+    // than the ones before them put together.
+    reason = "size ratio";
+    for (first = 0; first + min_width <= n; first++) {
+      uint64_t sum = runs[first].size;
+      last = first;
+      while (last + 1 < n && last + 1 - first < max_width &&
+             runs[last + 1].size * 100 <= sum * (100 + ratio)) {
+        last++;
+        sum += runs[last].size;
+      }
+      if (last + 1 - first >= min_width) {
+        break;
+      }
+    }
+    if (first + min_width > n) {
+      // Nothing of similar size: merge just enough of the newest runs to get
+      // back under the trigger.
+      reason = "run count";
+      first = 0;
+      const size_t excess =
+          n - options_->level0_file_num_compaction_trigger + 1;
+      last = std::min(n, std::max(min_width, std::min(max_width, excess))) - 1;
+    }
+  }
+
+  // Reads visit level-0 before the other levels, so merged level-0 files
+  // may only move down if every older level-0 file goes with them, and only
+  // to a level above all the remaining runs.
+  if (runs[last].level == 0) {
+    while (last + 1 < n && runs[last + 1].level == 0) {
+      last++;
+    }
+  }
+  int output_level;
+  if (runs[last].level != 0) {
+    output_level = runs[last].level;
+  } else if (last + 1 == n) {
+    output_level = config::kNumLevels - 1;
+  } else if (runs[last + 1].level > 1) {
+    output_level = runs[last + 1].level - 1;
+  } else {
+    // No room above level-1: merge it as well.
+    last++;
+    output_level = 1;
+  }
+
+  const int level = runs[first].level;
+  Compaction* c = new Compaction(options_, level, output_level);
+  for (size_t i = first; i <= last; i++) {
+    const SortedRun& run = runs[i];
+    if (run.level == 0) {
+      c->inputs_[0].push_back(run.file);
+    } else if (run.level == level) {
+      c->inputs_[0] = v->files_[run.level];
+    } else if (run.level == output_level) {
+      c->inputs_[1] = v->files_[run.level];
+    } else {
+      c->middle_inputs_[run.level] = v->files_[run.level];
+    }
+  }
+  c->input_version_ = v;
+  c->input_version_->Ref();
+
+  Log(options_->info_log,
+      "Universal compaction (%s): %d of %d runs to level-%d", reason,
+      static_cast<int>(last + 1 - first), static_cast<int>(n), output_level);
+  return c;
+}
+
+int VersionSet::OutputLevel(int level) const {
+  return level == 0 ? std::max(current_->base_level_, 1) : level + 1;
+}
+
+Compaction::Compaction(const Options* options, int level, int output_level)
     : level_(level),
+      output_level_(output_level),
       max_output_file_size_(MaxFileSizeForLevel(options, level)),
       input_version_(nullptr),
       grandparent_index_(0),
@@ -1610,6 +1949,11 @@ bool Compaction::IsTrivialMove() const {
   // Avoid a move if there is lots of overlapping grandparent data.
   // Otherwise, the move could create a parent file that will require
   // a very expensive merge later on.
+  for (int level = level_ + 1; level < output_level_; level++) {
+    if (!middle_inputs_[level].empty()) {
+      return false;
+    }
+  }
   return (num_input_files(0) == 1 && num_input_files(1) == 0 &&
           TotalFileSize(grandparents_) <=
               MaxGrandParentOverlapBytes(vset->options_));
@@ -1618,7 +1962,13 @@ bool Compaction::IsTrivialMove() const {
 void Compaction::AddInputDeletions(VersionEdit* edit) {
   for (int which = 0; which < 2; which++) {
     for (size_t i = 0; i < inputs_[which].size(); i++) {
-      edit->RemoveFile(level_ + which, inputs_[which][i]->number);
+      edit->RemoveFile(which == 0 ? level_ : output_level_,
+                       inputs_[which][i]->number);
+    }
+  }
+  for (int level = level_ + 1; level < output_level_; level++) {
+    for (size_t i = 0; i < middle_inputs_[level].size(); i++) {
+      edit->RemoveFile(level, middle_inputs_[level][i]->number);
     }
   }
 }
@@ -1626,7 +1976,7 @@ void Compaction::AddInputDeletions(VersionEdit* edit) {
 bool Compaction::IsBaseLevelForKey(const Slice& user_key) {
   // Maybe use binary search to find right entry instead of linear search?
   const Comparator* user_cmp = input_version_->vset_->icmp_.user_comparator();
-  for (int lvl = level_ + 2; lvl < config::kNumLevels; lvl++) {
+  for (int lvl = output_level_ + 1; lvl < config::kNumLevels; lvl++) {
     const std::vector<FileMetaData*>& files = input_version_->files_[lvl];
     while (level_ptrs_[lvl] < files.size()) {
       FileMetaData* f = files[level_ptrs_[lvl]];
@@ -33,6 +33,7 @@ class Writer;
 class Compaction;
 class Iterator;
 class MemTable;
+class MergeContext;
 class TableBuilder;
 class TableCache;
 class Version;
@@ -72,8 +73,11 @@ class Version {
   // REQUIRES: This version has been saved (see VersionSet::SaveTo)
   void AddIterators(const ReadOptions&, std::vector<Iterator*>* iters);
 
+  // Lookup the value for key.  Merge operands met on the way down are
+  // added to *merge_context, and the search goes on below them; *val
+  // then receives the value they apply to, if any.
   Status Get(const ReadOptions&, const LookupKey& key, std::string* val,
-             GetStats* stats);
+             GetStats* stats, MergeContext* merge_context);
 
   // Adds "stats" into the current state.  Returns true if a new
   // compaction may need to be triggered, false otherwise.
@@ -111,6 +115,10 @@ class Version {
 
   int NumFiles(int level) const { return files_[level].size(); }
 
+  // Return the number of sorted runs: one per level-0 file, plus one per
+  // other non-empty level.
+  int NumSortedRuns() const;
+
   // Return a human readable string that describes this version's contents.
   std::string DebugString() const;
 
@@ -128,7 +136,9 @@ class Version {
         file_to_compact_(nullptr),
         file_to_compact_level_(-1),
         compaction_score_(-1),
-        compaction_level_(-1) {}
+        compaction_level_(-1),
+        pending_compaction_bytes_(0),
+        base_level_(1) {}
 
   Version(const Version&) = delete;
   Version& operator=(const Version&) = delete;
@@ -162,6 +172,16 @@ class Version {
   // are initialized by Finalize().
   double compaction_score_;
   int compaction_level_;
+
+  // Rough number of bytes compactions have to move down to bring every
+  // level within its limit.  Initialized by Finalize().
+  uint64_t pending_compaction_bytes_;
+
+  // Level-0 is compacted into base_level_; the levels in between are
+  // empty.  max_bytes_for_level_ holds how many bytes each level may hold
+  // before it is compacted.  Initialized by Finalize().
+  int base_level_;
+  double max_bytes_for_level_[config::kNumLevels];
 };
 
 class VersionSet {
@@ -208,6 +228,12 @@ class VersionSet {
   // Return the combined file size of all files at the specified level.
   int64_t NumLevelBytes(int level) const;
 
+  // Return roughly how many bytes compactions are behind in the current
+  // version.
+  uint64_t PendingCompactionBytes() const {
+    return current_->pending_compaction_bytes_;
+  }
+
   // Return the last sequence number.
   uint64_t LastSequence() const { return last_sequence_; }
 
@@ -262,6 +288,10 @@ class VersionSet {
   // May also mutate some internal state.
   void AddLiveFiles(std::set<uint64_t>* live);
 
+  // Store the number and size of every file in the current version
+  // in *sizes.
+  void CurrentFileSizes(std::map<uint64_t, uint64_t>* sizes) const;
+
   // Return the approximate offset in the database of the data for
   // "key" as of version "v".
   uint64_t ApproximateOffsetOf(Version* v, const InternalKey& key);
@@ -283,6 +313,9 @@ class VersionSet {
 
   void Finalize(Version* v);
 
+  // Fill in v->base_level_ and v->max_bytes_for_level_.
+  void SetLevelTargets(Version* v);
+
   void GetRange(const std::vector<FileMetaData*>& inputs, InternalKey* smallest,
                 InternalKey* largest);
 
@@ -292,6 +325,14 @@ class VersionSet {
 
   void SetupOtherInputs(Compaction* c);
 
+  // Return the level a compaction of "level" in the current version writes
+  // to.
+  int OutputLevel(int level) const;
+
+  // PickCompaction() for Options::compaction_style ==
+  // kCompactionStyleUniversal.
+  Compaction* PickUniversalCompaction();
+
   // Save current contents to *log
   Status WriteSnapshot(log::Writer* log);
 
@@ -326,9 +367,14 @@ class Compaction {
   ~Compaction();
 
   // Return the level that is being compacted.  Inputs from "level"
-  // and "level+1" will be merged to produce a set of "level+1" files.
+  // and "output_level" will be merged to produce a set of "output_level"
+  // files.
   int level() const { return level_; }
 
+  // Return the level the compaction writes to: "level+1", except that
+  // level-0 may be compacted straight into a deeper base level.
+  int output_level() const { return output_level_; }
+
   // Return the object that holds the edits to the descriptor done
   // by this compaction.
   VersionEdit* edit() { return &edit_; }
@@ -336,22 +382,30 @@ class Compaction {
   // "which" must be either 0 or 1
   int num_input_files(int which) const { return inputs_[which].size(); }
 
-  // Return the ith input file at "level()+which" ("which" must be 0 or 1).
+  // Return the ith input file at "level()" or "output_level()" ("which"
+  // must be 0 or 1).
   FileMetaData* input(int which, int i) const { return inputs_[which][i]; }
 
+  // Return the input files at "level", strictly between "level()" and
+  // "output_level()".  Only universal compactions, which merge whole levels,
+  // have any.
+  const std::vector<FileMetaData*>& middle_inputs(int level) const {
+    return middle_inputs_[level];
+  }
+
   // Maximum size of files to build during this compaction.
   uint64_t MaxOutputFileSize() const { return max_output_file_size_; }
 
   // Is this a trivial compaction that can be implemented by just
-  // moving a single input file to the next level (no merging or splitting)
+  // moving a single input file to the output level (no merging or splitting)
   bool IsTrivialMove() const;
 
   // Add all inputs to this compaction as delete operations to *edit.
   void AddInputDeletions(VersionEdit* edit);
 
   // Returns true if the information we have available guarantees that
-  // the compaction is producing data in "level+1" for which no data exists
-  // in levels greater than "level+1".
+  // the compaction is producing data in "output_level" for which no data
+  // exists in levels greater than "output_level".
   bool IsBaseLevelForKey(const Slice& user_key);
 
   // Returns true iff we should stop building the current output
@@ -366,18 +420,20 @@ class Compaction {
   friend class Version;
   friend class VersionSet;
 
-  Compaction(const Options* options, int level);
+  Compaction(const Options* options, int level, int output_level);
 
   int level_;
+  int output_level_;
   uint64_t max_output_file_size_;
   Version* input_version_;
   VersionEdit edit_;
 
-  // Each compaction reads inputs from "level_" and "level_+1"
+  // Each compaction reads inputs from "level_" and "output_level_"
   std::vector<FileMetaData*> inputs_[2];  // The two sets of inputs
+  std::vector<FileMetaData*> middle_inputs_[config::kNumLevels];
 
   // State used to check for number of overlapping grandparent files
-  // (parent == level_ + 1, grandparent == level_ + 2)
+  // (parent == output_level_, grandparent == output_level_ + 1)
   std::vector<FileMetaData*> grandparents_;
   size_t grandparent_index_;  // Index in grandparent_starts_
   bool seen_key_;             // Some output key has been seen
@@ -392,7 +448,7 @@ class Compaction {
   // level_ptrs_ holds indices into input_version_->levels_: our state
   // is that we are positioned at one of the file ranges for each
   // higher level than the ones involved in this compaction (i.e. for
-  // all L >= level_ + 2).
+  // all L > output_level_).
   size_t level_ptrs_[config::kNumLevels];
 };
 
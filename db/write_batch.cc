@@ -8,7 +8,8 @@
 //    data: record[count]
 // record :=
 //    kTypeValue varstring varstring         |
-//    kTypeDeletion varstring
+//    kTypeDeletion varstring                |
+//    kTypeMerge varstring varstring
 // varstring :=
 //    len: varint32
 //    data: uint8[len]
@@ -35,6 +36,10 @@ WriteBatch::~WriteBatch() = default;
 
 WriteBatch::Handler::~Handler() = default;
 
+void WriteBatch::Handler::Merge(const Slice& key, const Slice& value) {
+  Put(key, value);
+}
+
 void WriteBatch::Clear() {
   rep_.clear();
   rep_.resize(kHeader);
@@ -71,6 +76,14 @@ Status WriteBatch::Iterate(Handler* handler) const {
           return Status::Corruption("bad WriteBatch Delete");
         }
         break;
+      case kTypeMerge:
+        if (GetLengthPrefixedSlice(&input, &key) &&
+            GetLengthPrefixedSlice(&input, &value)) {
+          handler->Merge(key, value);
+        } else {
+          return Status::Corruption("bad WriteBatch Merge");
+        }
+        break;
       default:
         return Status::Corruption("unknown WriteBatch tag");
     }
@@ -111,6 +124,13 @@ void WriteBatch::Delete(const Slice& key) {
   PutLengthPrefixedSlice(&rep_, key);
 }
 
+void WriteBatch::Merge(const Slice& key, const Slice& value) {
+  WriteBatchInternal::SetCount(this, WriteBatchInternal::Count(this) + 1);
+  rep_.push_back(static_cast<char>(kTypeMerge));
+  PutLengthPrefixedSlice(&rep_, key);
+  PutLengthPrefixedSlice(&rep_, value);
+}
+
 void WriteBatch::Append(const WriteBatch& source) {
   WriteBatchInternal::Append(this, &source);
 }
@@ -153,6 +173,20 @@ bool WriteBatch::Get(const Slice& key, std::string* value, Status* s) {
           return false;
         }
         break;
+
+      case kTypeMerge:
+        if (GetLengthPrefixedSlice(&input, &key_) &&
+            GetLengthPrefixedSlice(&input, &value_)) {
+          if (key_.compare(key) == 0) {
+            // The operand alone is not the value of the key.
+            *s = Status::NotSupported("merge pending in WriteBatch for", key);
+            return true;
+          }
+        } else {
+          *s = Status::Corruption("bad WriteBatch Merge");
+          return false;
+        }
+        break;
       default:
         *s = Status::Corruption("unknown WriteBatch tag");
         return false;
@@ -175,9 +209,33 @@ class MemTableInserter : public WriteBatch::Handler {
     mem_->Add(sequence_, kTypeDeletion, key, Slice());
     sequence_++;
   }
+  void Merge(const Slice& key, const Slice& value) override {
+    mem_->Add(sequence_, kTypeMerge, key, value);
+    sequence_++;
+  }
+};
+
+class MergeDetector : public WriteBatch::Handler {
+ public:
+  MergeDetector() : found_(false) {}
+
+  bool found() const { return found_; }
+
+  void Put(const Slice& key, const Slice& value) override {}
+  void Delete(const Slice& key) override {}
+  void Merge(const Slice& key, const Slice& value) override { found_ = true; }
+
+ private:
+  bool found_;
 };
 }  // namespace
 
+bool WriteBatchInternal::HasMerge(const WriteBatch* b) {
+  MergeDetector detector;
+  b->Iterate(&detector);
+  return detector.found();
+}
+
 Status WriteBatchInternal::InsertInto(const WriteBatch* b,
                                       MemTableRep* memtable) {
   MemTableInserter inserter;
@@ -36,6 +36,9 @@ class WriteBatchInternal {
 
   static void SetContents(WriteBatch* batch, const Slice& contents);
 
+  // Return true if the batch holds a merge operand.
+  static bool HasMerge(const WriteBatch* batch);
+
   static Status InsertInto(const WriteBatch* batch, MemTableRep* memtable);
 
   static void Append(WriteBatch* dst, const WriteBatch* src);
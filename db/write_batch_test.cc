@@ -37,6 +37,14 @@ static std::string PrintContents(WriteBatch* b) {
         state.append(")");
         count++;
         break;
+      case kTypeMerge:
+        state.append("Merge(");
+        state.append(ikey.user_key.ToString());
+        state.append(", ");
+        state.append(iter->value().ToString());
+        state.append(")");
+        count++;
+        break;
     }
     state.append("@");
     state.append(NumberToString(ikey.sequence));
@@ -72,6 +80,43 @@ TEST(WriteBatchTest, Multiple) {
       PrintContents(&batch));
 }
 
+TEST(WriteBatchTest, Merge) {
+  WriteBatch batch;
+  batch.Put(Slice("foo"), Slice("bar"));
+  batch.Merge(Slice("foo"), Slice("baz"));
+  batch.Merge(Slice("box"), Slice("boo"));
+  WriteBatchInternal::SetSequence(&batch, 100);
+  ASSERT_EQ(3, WriteBatchInternal::Count(&batch));
+  ASSERT_EQ(
+      "Merge(box, boo)@102"
+      "Merge(foo, baz)@101"
+      "Put(foo, bar)@100",
+      PrintContents(&batch));
+}
+
+TEST(WriteBatchTest, HandlerWithoutMerge) {
+  // Handlers that only know about puts and deletions see operands as
+  // plain values.
+  class PutDeleteHandler : public WriteBatch::Handler {
+   public:
+    void Put(const Slice& key, const Slice& value) override {
+      seen.append("Put(" + key.ToString() + ", " + value.ToString() + ")");
+    }
+    void Delete(const Slice& key) override {
+      seen.append("Delete(" + key.ToString() + ")");
+    }
+    std::string seen;
+  };
+
+  WriteBatch batch;
+  batch.Put(Slice("foo"), Slice("bar"));
+  batch.Merge(Slice("foo"), Slice("baz"));
+  batch.Delete(Slice("box"));
+  PutDeleteHandler handler;
+  ASSERT_TRUE(batch.Iterate(&handler).ok());
+  ASSERT_EQ("Put(foo, bar)Put(foo, baz)Delete(box)", handler.seen);
+}
+
 TEST(WriteBatchTest, Corruption) {
   WriteBatch batch;
   batch.Put(Slice("foo"), Slice("bar"));
@@ -0,0 +1,34 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/write_controller.h"
+
+namespace leveldb {
+
+static const uint64_t kMinDelayMicros = 1000;
+
+WriteController::WriteController() : rate_(0), next_write_micros_(0) {}
+
+void WriteController::SetDelayedWriteRate(uint64_t bytes_per_second) {
+  if (rate_ == 0) {
+    // Writes were not being paced: start from a clean slate.
+    next_write_micros_ = 0;
+  }
+  rate_ = bytes_per_second;
+}
+
+uint64_t WriteController::GetDelay(uint64_t now_micros, uint64_t bytes) {
+  if (rate_ == 0) {
+    return 0;
+  }
+  // Time spent idle is not saved up for later bursts.
+  if (next_write_micros_ < now_micros) {
+    next_write_micros_ = now_micros;
+  }
+  next_write_micros_ += static_cast<uint64_t>(bytes * 1e6 / rate_);
+  const uint64_t delay = next_write_micros_ - now_micros;
+  return delay < kMinDelayMicros ? 0 : delay;
+}
+
+}  // namespace leveldb
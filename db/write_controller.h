@@ -0,0 +1,43 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_DB_WRITE_CONTROLLER_H_
+#define STORAGE_LEVELDB_DB_WRITE_CONTROLLER_H_
+
+#include <cstdint>
+
+namespace leveldb {
+
+// Paces writes to a target rate while compactions are falling behind, so
+// that writers see many short sleeps instead of a few long stalls.
+//
+// Not thread-safe: DBImpl calls it with its mutex held.
+class WriteController {
+ public:
+  WriteController();
+
+  WriteController(const WriteController&) = delete;
+  WriteController& operator=(const WriteController&) = delete;
+
+  // Paces writes to "bytes_per_second".  Zero lifts the delay.
+  void SetDelayedWriteRate(uint64_t bytes_per_second);
+
+  bool IsDelayed() const { return rate_ > 0; }
+
+  uint64_t delayed_write_rate() const { return rate_; }
+
+  // Accounts for a write of "bytes" at time "now_micros", and returns how
+  // many microseconds the writer should sleep before going ahead.  Debts
+  // shorter than a millisecond are carried over to later writes rather than
+  // slept off one at a time.
+  uint64_t GetDelay(uint64_t now_micros, uint64_t bytes);
+
+ private:
+  uint64_t rate_;  // Bytes per second, or zero if writes are not delayed
+  uint64_t next_write_micros_;  // When the writes so far are paid for
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_WRITE_CONTROLLER_H_
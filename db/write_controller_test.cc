@@ -0,0 +1,56 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/write_controller.h"
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+TEST(WriteControllerTest, NotDelayed) {
+  WriteController controller;
+  ASSERT_FALSE(controller.IsDelayed());
+  ASSERT_EQ(0, controller.GetDelay(0, 1 << 30));
+}
+
+TEST(WriteControllerTest, PacesWrites) {
+  WriteController controller;
+  controller.SetDelayedWriteRate(1 << 20);  // 1MB/s
+  ASSERT_TRUE(controller.IsDelayed());
+
+  // Small writes run up a debt before anyone has to sleep.
+  uint64_t now = 1000000;
+  ASSERT_EQ(0, controller.GetDelay(now, 512));
+  ASSERT_EQ(0, controller.GetDelay(now, 512));
+  // 1MB more is a second behind.
+  ASSERT_NEAR(1000000, controller.GetDelay(now, 1 << 20), 2000);
+
+  // Having slept it off, the next write is on time again.
+  now += 1001000;
+  ASSERT_EQ(0, controller.GetDelay(now, 512));
+
+  // Idle time does not buy a burst.
+  now += 10000000;
+  ASSERT_NEAR(500000, controller.GetDelay(now, 512 << 10), 1000);
+}
+
+TEST(WriteControllerTest, LiftDelay) {
+  WriteController controller;
+  controller.SetDelayedWriteRate(1 << 20);
+  ASSERT_GT(controller.GetDelay(0, 1 << 20), 0);
+  controller.SetDelayedWriteRate(0);
+  ASSERT_FALSE(controller.IsDelayed());
+  ASSERT_EQ(0, controller.GetDelay(0, 1 << 20));
+
+  // The old debt is forgotten when writes are delayed again.
+  controller.SetDelayedWriteRate(1 << 20);
+  ASSERT_NEAR(1000000, controller.GetDelay(0, 1 << 20), 1000);
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
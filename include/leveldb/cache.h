@@ -19,6 +19,7 @@
 #define STORAGE_LEVELDB_INCLUDE_CACHE_H_
 
 #include <cstdint>
+#include <string>
 
 #include "leveldb/export.h"
 #include "leveldb/slice.h"
@@ -26,11 +27,62 @@
 namespace leveldb {
 
 class LEVELDB_EXPORT Cache;
+class LEVELDB_EXPORT SecondaryCache;
 
 // Create a new cache with a fixed size capacity.  This implementation
 // of Cache uses a least-recently-used eviction policy.
 LEVELDB_EXPORT Cache* NewLRUCache(size_t capacity);
 
+// Options for the caches created by NewLRUCache(const CacheOptions&) and
+// NewClockCache().
+struct LEVELDB_EXPORT CacheOptions {
+  // Combined charge of the entries the cache may hold.
+  size_t capacity = 8 << 20;
+
+  // Fraction of the capacity set aside for entries inserted with
+  // Cache::kHighPriority.  Low-priority entries are evicted first, and
+  // high-priority entries beyond this share are demoted to the
+  // low-priority pool.  Only used by the LRU cache; the CLOCK cache gives
+  // high-priority entries a longer initial countdown instead.
+  double high_pri_pool_ratio = 0.0;
+
+  // If true, a TinyLFU frequency sketch of recent lookups and inserts
+  // decides whether a new low-priority entry is worth evicting an older
+  // one for.  A one-off scan then cannot flush the frequently used
+  // working set out of a full cache.
+  bool admission_filter = false;
+
+  // Typical charge of an entry.  Used to size the frequency sketch and
+  // the slot tables of the CLOCK cache.
+  size_t estimated_entry_charge = 4 * 1024;
+
+  // The CLOCK cache is split into 2^num_shard_bits shards; a negative
+  // value picks a default based on the capacity.  The LRU cache always
+  // uses 16 shards.
+  int num_shard_bits = -1;
+
+  // If non-null, entries evicted for lack of space are copied into this
+  // slower tier first, provided they were inserted with a "saver".
+  // Several caches may share one tier.  Must outlive the cache.
+  SecondaryCache* secondary_cache = nullptr;
+};
+
+LEVELDB_EXPORT Cache* NewLRUCache(const CacheOptions& options);
+
+// Create a new cache with a fixed size capacity that uses the CLOCK
+// eviction policy.  Lookup() and Release() never block, which makes this
+// cache scale better than NewLRUCache() when many threads read through it.
+//
+// Each shard keeps its entries in a fixed number of slots, sized so that
+// a shard full of entries of "estimated_entry_charge" is about 70% full.
+// Inserts that find no free slot return a handle that is not kept in the
+// cache.  The cache is split into 2^num_shard_bits shards; a negative
+// value picks a default based on the capacity.
+LEVELDB_EXPORT Cache* NewClockCache(size_t capacity,
+                                    size_t estimated_entry_charge,
+                                    int num_shard_bits = -1);
+LEVELDB_EXPORT Cache* NewClockCache(const CacheOptions& options);
+
 class LEVELDB_EXPORT Cache {
  public:
   Cache() = default;
@@ -57,6 +109,32 @@ class LEVELDB_EXPORT Cache {
   virtual Handle* Insert(const Slice& key, void* value, size_t charge,
                          void (*deleter)(const Slice& key, void* value)) = 0;
 
+  // Eviction priority of an entry.  Index and filter blocks are inserted
+  // with kHighPriority so that they outlive the data blocks they locate.
+  enum Priority { kHighPriority, kLowPriority };
+
+  // Like Insert() above, with an explicit priority.  The entry may not be
+  // kept in the cache if the cache's admission policy rejects it; the
+  // returned handle is valid either way.
+  //
+  // If "saver" is non-null and the cache has a secondary cache, an entry
+  // evicted for lack of space is first stored in the secondary cache as
+  // the bytes returned by (*saver)(value).
+  //
+  // The default implementation ignores "priority" and "saver".
+  virtual Handle* Insert(const Slice& key, void* value, size_t charge,
+                         void (*deleter)(const Slice& key, void* value),
+                         Priority priority, Slice (*saver)(void* value)) {
+    return Insert(key, value, charge, deleter);
+  }
+
+  // If the secondary cache holds an entry this cache evicted under "key",
+  // copies the bytes its saver returned into *contents and returns true.
+  // Else, or if there is no secondary cache, returns false.
+  virtual bool LookupSecondary(const Slice& key, std::string* contents) {
+    return false;
+  }
+
   // If the cache has no mapping for "key", returns nullptr.
   //
   // Else return a handle that corresponds to the mapping.  The caller
@@ -97,6 +175,15 @@ class LEVELDB_EXPORT Cache {
   // cache.
   virtual size_t TotalCharge() const = 0;
 
+  // Calls (*callback)(arg, key, value, deleter) for every entry in the
+  // cache, including entries in use by clients.  Entries inserted or
+  // removed concurrently may or may not be visited.  The callback must not
+  // call back into the cache.  The default implementation visits nothing.
+  virtual void ApplyToAllEntries(
+      void (*callback)(void* arg, const Slice& key, void* value,
+                       void (*deleter)(const Slice& key, void* value)),
+      void* arg) {}
+
  private:
   void LRU_Remove(Handle* e);
   void LRU_Append(Handle* e);
@@ -106,6 +193,31 @@ class LEVELDB_EXPORT Cache {
   Rep* rep_;
 };
 
+// A slower, larger cache tier that holds copies of entries evicted from
+// a Cache, e.g. in persistent memory.  Entries are plain byte strings;
+// the caller rebuilds its own objects from them.  Implementations must be
+// safe for concurrent use.
+//
+// The keys are chosen by the caches using the tier, which keep the
+// entries of different caches apart.
+class LEVELDB_EXPORT SecondaryCache {
+ public:
+  SecondaryCache() = default;
+
+  SecondaryCache(const SecondaryCache&) = delete;
+  SecondaryCache& operator=(const SecondaryCache&) = delete;
+
+  virtual ~SecondaryCache();
+
+  // Stores a copy of "contents" under "key".  May drop older entries to
+  // make room, or ignore the request.
+  virtual void Insert(const Slice& key, const Slice& contents) = 0;
+
+  // If the tier holds "key", copies its contents into *contents and
+  // returns true.  Else returns false.
+  virtual bool Lookup(const Slice& key, std::string* contents) = 0;
+};
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_INCLUDE_CACHE_H_
@@ -0,0 +1,64 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A database can be configured with a CompactionFilter that sees every
+// value a compaction is about to keep, and may drop it or replace it.
+// Expiring data this way costs no extra writes: stale entries disappear
+// during compactions that happen anyway.
+//
+// Filtering happens in the background, so a value that would be dropped
+// stays readable until a compaction gets to it.  Readers that must never
+// see expired data still have to check for themselves.
+//
+// See NewTTLCompactionFilter() below for a builtin time-to-live filter.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_COMPACTION_FILTER_H_
+#define STORAGE_LEVELDB_INCLUDE_COMPACTION_FILTER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Env;
+class Slice;
+
+class LEVELDB_EXPORT CompactionFilter {
+ public:
+  virtual ~CompactionFilter();
+
+  // Return the name of this filter.  Used for logging.
+  virtual const char* Name() const = 0;
+
+  // Called for each value of "key" that no live snapshot can see, while
+  // compacting "level".  Values written before the newest snapshot was
+  // taken are kept as they are, so snapshots keep reading what they
+  // read before.  Deletions are not passed in.
+  //
+  // Return true to remove the key from the database.  Otherwise, to
+  // replace the value, store the new one in *new_value and set
+  // *value_changed to true.
+  //
+  // May be called concurrently from several compactions, so must be
+  // thread-safe.
+  virtual bool Filter(int level, const Slice& key, const Slice& existing_value,
+                      std::string* new_value, bool* value_changed) const = 0;
+};
+
+// Return a filter that removes values once they are more than
+// "ttl_seconds" old.  Each value must end with the time it was written,
+// in seconds since the epoch of env->NowMicros(), encoded as 8 bytes in
+// little-endian order; shorter values are kept.  The suffix is not
+// stripped on reads.
+//
+// "env" must remain live while the filter is in use.  Callers should
+// delete the result after any database that is using it is closed.
+LEVELDB_EXPORT const CompactionFilter* NewTTLCompactionFilter(
+    uint64_t ttl_seconds, Env* env);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_COMPACTION_FILTER_H_
@@ -77,6 +77,14 @@ class LEVELDB_EXPORT DB {
   // Note: consider setting options.sync = true.
   virtual Status Delete(const WriteOptions& options, const Slice& key) = 0;
 
+  // Record "value" as a merge operand for "key": later reads of "key" see
+  // the result of applying it to the current value with
+  // options.merge_operator.  Returns OK on success, and a non-OK status
+  // on error.
+  // Note: consider setting options.sync = true.
+  virtual Status Merge(const WriteOptions& options, const Slice& key,
+                       const Slice& value);
+
   // Apply the specified updates to the database.
   // Returns OK on success, non-OK on failure.
   // Note: consider setting options.sync = true.
@@ -127,6 +135,12 @@ class LEVELDB_EXPORT DB {
   //     of the sstables that make up the db contents.
   //  "leveldb.approximate-memory-usage" - returns the approximate number of
   //     bytes of memory in use by the DB.
+  //  "leveldb.write-amplification" - returns the bytes written to tables by
+  //     all compactions divided by those written by memtable compactions,
+  //     since the DB was opened.
+  //  "leveldb.statistics" - returns the tickers and histograms collected in
+  //     options.statistics, one per line.  Fails if options.statistics is
+  //     null.
   virtual bool GetProperty(const Slice& property, std::string* value) = 0;
 
   // For each i in [0,n-1], store in "sizes[i]", the approximate
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "leveldb/export.h"
+#include "leveldb/slice.h"
 #include "leveldb/status.h"
 
 // This workaround can be removed when leveldb::Env::DeleteFile is removed.
@@ -45,9 +46,26 @@ class FileLock;
 class Logger;
 class RandomAccessFile;
 class SequentialFile;
-class Slice;
 class WritableFile;
 
+// Options for opening files through an Env.
+struct LEVELDB_EXPORT FileOptions {
+  // If false, random-access files are read with pread() or batched
+  // asynchronous reads rather than through a memory map of the file.
+  bool allow_mmap_reads = true;
+
+  // If true, bypass the operating system's page cache (O_DIRECT), so that
+  // large background transfers do not evict the data foreground reads
+  // depend on.  Envs that cannot do this ignore the option.
+  bool use_direct_io = false;
+
+  // If non-zero, writable files reserve this many bytes of disk space when
+  // they are created, without changing the file size, so that appending
+  // does not have to allocate blocks as it goes.  Envs that cannot do this
+  // ignore the option.
+  uint64_t preallocation_size = 0;
+};
+
 class LEVELDB_EXPORT Env {
  public:
   Env();
@@ -85,6 +103,13 @@ class LEVELDB_EXPORT Env {
   virtual Status NewRandomAccessFile(const std::string& fname,
                                      RandomAccessFile** result) = 0;
 
+  // Like NewRandomAccessFile() above, with explicit options.
+  //
+  // The default implementation ignores "options".
+  virtual Status NewRandomAccessFile(const std::string& fname,
+                                     const FileOptions& options,
+                                     RandomAccessFile** result);
+
   // Create an object that writes to a new file with the specified
   // name.  Deletes any existing file with the same name and creates a
   // new file.  On success, stores a pointer to the new file in
@@ -95,6 +120,25 @@ class LEVELDB_EXPORT Env {
   virtual Status NewWritableFile(const std::string& fname,
                                  WritableFile** result) = 0;
 
+  // Like NewWritableFile() above, with explicit options.
+  //
+  // The default implementation ignores "options".
+  virtual Status NewWritableFile(const std::string& fname,
+                                 const FileOptions& options,
+                                 WritableFile** result);
+
+  // Rename the existing file "old_fname" to "fname" and create an object
+  // that writes to it from the start, without truncating it first.
+  // Overwriting blocks the file already has is cheaper than allocating new
+  // ones.  The caller must cope with stale data past what it writes.
+  //
+  // The default implementation renames the file and then opens it with
+  // NewWritableFile(), which truncates it.
+  virtual Status ReuseWritableFile(const std::string& fname,
+                                   const std::string& old_fname,
+                                   const FileOptions& options,
+                                   WritableFile** result);
+
   // Create an object that either appends to an existing file, or
   // writes to a new file (if the file does not exist to begin with).
   // On success, stores a pointer to the new file in *result and
@@ -269,6 +313,27 @@ class LEVELDB_EXPORT RandomAccessFile {
   // Safe for concurrent use by multiple threads.
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const = 0;
+
+  // A single read of a MultiRead() batch.
+  struct ReadRequest {
+    // Inputs: read up to "n" bytes at "offset" into "scratch[0..n-1]".
+    uint64_t offset;
+    size_t n;
+    char* scratch;
+
+    // Outputs: as for Read().
+    Slice result;
+    Status status;
+  };
+
+  // Perform reqs[0..num_reqs-1], possibly concurrently, and set the result
+  // and status of each request as Read() would.  Lets implementations
+  // submit a whole batch of reads to the operating system at once.
+  //
+  // The default implementation calls Read() for each request in turn.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual void MultiRead(ReadRequest* reqs, size_t num_reqs) const;
 };
 
 // A file abstraction for sequential writing.  The implementation
@@ -349,9 +414,22 @@ class LEVELDB_EXPORT EnvWrapper : public Env {
                              RandomAccessFile** r) override {
     return target_->NewRandomAccessFile(f, r);
   }
+  Status NewRandomAccessFile(const std::string& f, const FileOptions& options,
+                             RandomAccessFile** r) override {
+    return target_->NewRandomAccessFile(f, options, r);
+  }
   Status NewWritableFile(const std::string& f, WritableFile** r) override {
     return target_->NewWritableFile(f, r);
   }
+  Status NewWritableFile(const std::string& f, const FileOptions& options,
+                         WritableFile** r) override {
+    return target_->NewWritableFile(f, options, r);
+  }
+  Status ReuseWritableFile(const std::string& f, const std::string& old_f,
+                           const FileOptions& options,
+                           WritableFile** r) override {
+    return target_->ReuseWritableFile(f, old_f, options, r);
+  }
   Status NewAppendableFile(const std::string& f, WritableFile** r) override {
     return target_->NewAppendableFile(f, r);
   }
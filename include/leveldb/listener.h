@@ -0,0 +1,118 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// An EventListener is told about the background work of a DB as it
+// happens: memtable flushes, compactions, memtable switches and changes
+// in write stalls.  Register listeners in Options::listeners.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_LISTENER_H_
+#define STORAGE_LEVELDB_INCLUDE_LISTENER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/export.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class DB;
+
+// A memtable being written out to a table file.
+struct LEVELDB_EXPORT FlushJobInfo {
+  std::string db_name;
+  // The table file written.  file_size is zero, and level meaningless,
+  // until the flush has completed, and also if the memtable was empty.
+  uint64_t file_number = 0;
+  uint64_t file_size = 0;
+  int level = 0;
+  // True if the memtable lived in non-volatile memory.
+  bool from_nvm = false;
+  uint64_t micros = 0;
+  Status status;
+};
+
+struct LEVELDB_EXPORT CompactionFileInfo {
+  int level;
+  uint64_t file_number;
+  uint64_t file_size;
+};
+
+// A compaction that merges table files into new ones.  Files that are
+// merely moved to another level are not reported.
+struct LEVELDB_EXPORT CompactionJobInfo {
+  std::string db_name;
+  int base_level = 0;
+  int output_level = 0;
+  std::vector<CompactionFileInfo> inputs;
+  // The fields below are only set once the compaction has completed.
+  std::vector<CompactionFileInfo> outputs;
+  uint64_t bytes_read = 0;
+  uint64_t bytes_written = 0;
+  uint64_t micros = 0;
+  Status status;
+};
+
+enum WriteStallCondition {
+  kWriteStallNormal = 0,
+  // Writes are being paced by Options::delayed_write_rate.
+  kWriteStallDelayed,
+  // Writes are blocked until background work catches up.
+  kWriteStallStopped
+};
+
+enum WriteStallCause {
+  kWriteStallCauseNone = 0,
+  // The memtable is full and the previous one is still being flushed.
+  kWriteStallCauseMemtable,
+  // Too many files in level 0.
+  kWriteStallCauseLevel0Files,
+  // Too many bytes waiting to be compacted.
+  kWriteStallCausePendingCompactionBytes
+};
+
+struct LEVELDB_EXPORT WriteStallInfo {
+  std::string db_name;
+  WriteStallCondition previous;
+  WriteStallCondition current;
+  WriteStallCause cause;
+};
+
+// The memtable filled up and was replaced by an empty one.
+struct LEVELDB_EXPORT MemTableSwitchInfo {
+  std::string db_name;
+  // Size of the memtable that is now waiting to be flushed.
+  size_t memtable_bytes;
+  // Number of the log or, for an NVM memtable, of the map file that backs
+  // the new memtable.
+  uint64_t new_file_number;
+  // True if the new memtable lives in non-volatile memory.
+  bool to_nvm;
+};
+
+// All callbacks have empty default implementations and may be called
+// from any thread, including several at once.
+class LEVELDB_EXPORT EventListener {
+ public:
+  virtual ~EventListener();
+
+  // Called on the background thread without any DB lock held.  The
+  // callbacks may call back into "db", but should not block for long:
+  // writes may be waiting for the flush or compaction to finish.
+  virtual void OnFlushBegin(DB* db, const FlushJobInfo& info);
+  virtual void OnFlushCompleted(DB* db, const FlushJobInfo& info);
+  virtual void OnCompactionBegin(DB* db, const CompactionJobInfo& info);
+  virtual void OnCompactionCompleted(DB* db, const CompactionJobInfo& info);
+
+  // Called by a writer while the DB holds its internal lock.  These must
+  // return quickly and must not call into the DB.
+  virtual void OnStallConditionsChanged(const WriteStallInfo& info);
+  virtual void OnMemTableSwitched(const MemTableSwitchInfo& info);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_LISTENER_H_
@@ -0,0 +1,65 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A MergeOperator turns read-modify-write sequences into blind writes.
+// Instead of reading a value, changing it and writing it back, callers
+// write an operand with DB::Merge() or WriteBatch::Merge().  Operands are
+// stored as they are and applied lazily: reads combine them with the
+// value underneath, and compactions fold them together so that they do
+// not pile up.
+//
+// See NewUInt64AddOperator() below for a builtin counter.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_MERGE_OPERATOR_H_
+#define STORAGE_LEVELDB_INCLUDE_MERGE_OPERATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Slice;
+
+class LEVELDB_EXPORT MergeOperator {
+ public:
+  virtual ~MergeOperator();
+
+  // The name of the operator.  Used for logging.
+  virtual const char* Name() const = 0;
+
+  // Apply "operands", oldest first, to "existing_value" and store the
+  // result in *new_value.  existing_value is nullptr if "key" had no
+  // value before the first operand, or if it was deleted.
+  //
+  // Return false if the operands cannot be applied, e.g. because they
+  // are malformed.  Reads of "key" then fail with a corruption error.
+  virtual bool FullMerge(const Slice& key, const Slice* existing_value,
+                         const std::vector<Slice>& operands,
+                         std::string* new_value) const = 0;
+
+  // Combine two consecutive operands, "left" being the older one, into a
+  // single operand with the same effect and store it in *new_value.
+  // Compactions use this to shrink runs of operands whose base value is
+  // not available yet.
+  //
+  // Return false if the operands cannot be combined without the base
+  // value.  The default implementation always does.
+  virtual bool PartialMerge(const Slice& key, const Slice& left,
+                            const Slice& right, std::string* new_value) const;
+};
+
+// Return an operator for 64-bit counters.  Values and operands are
+// unsigned integers encoded as 8 bytes in little-endian order, and
+// merging adds them up, wrapping around on overflow.  A key without a
+// value counts as zero.
+//
+// Callers should delete the result after any database that is using it
+// is closed.
+LEVELDB_EXPORT const MergeOperator* NewUInt64AddOperator();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_MERGE_OPERATOR_H_
@@ -6,6 +6,8 @@
 #define STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "leveldb/export.h"
 
@@ -14,11 +16,16 @@
 namespace leveldb {
 
 class Cache;
+class CompactionFilter;
 class Comparator;
 class Env;
+class EventListener;
 class FilterPolicy;
 class Logger;
+class MergeOperator;
+class RateLimiter;
 class Snapshot;
+class Statistics;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -31,6 +38,34 @@ enum CompressionType {
   kSnappyCompression = 0x1
 };
 
+// When a filter policy is configured, each table stores filter data in
+// one of the following layouts.  Tables written with any layout can be
+// read regardless of the value used by the reader.
+enum FilterFormat {
+  // One filter for every 2KB range of data block offsets.  The index
+  // block must be consulted before the filter can be checked.
+  kBlockBasedFilter = 0x0,
+  // A single filter over every key in the table, checked before the
+  // index block is touched.
+  kFullFilter = 0x1,
+  // A full filter split into partitions of roughly metadata_block_size
+  // bytes.  A small top-level index locates the partition for a key;
+  // both are loaded on demand through the block cache.
+  kPartitionedFilter = 0x2
+};
+
+// How background compactions decide what to merge.
+enum CompactionStyle {
+  // Each level is kept within a size limit by merging parts of it into
+  // the next level.  Low space overhead, high write amplification.
+  kCompactionStyleLevel = 0x0,
+  // Every level-0 file and every non-empty level is a sorted run, and runs
+  // of similar size are merged whole.  Each byte is rewritten far fewer
+  // times, at the cost of up to universal_max_size_amplification_percent
+  // of extra space.
+  kCompactionStyleUniversal = 0x1
+};
+
 // Options to control the behavior of a database (passed to DB::Open)
 struct LEVELDB_EXPORT Options {
   // Create an Options object with default values for all fields.
@@ -70,6 +105,14 @@ struct LEVELDB_EXPORT Options {
   // in the same directory as the DB contents if info_log is null.
   Logger* info_log = nullptr;
 
+  // If non-null, counters and latency histograms of the DB are recorded
+  // here.  See leveldb/statistics.h.  Must outlive the DB.
+  Statistics* statistics = nullptr;
+
+  // Listeners told about flushes, compactions, memtable switches and
+  // write stalls.  See leveldb/listener.h.  Each must outlive the DB.
+  std::vector<EventListener*> listeners;
+
   // -------------------
   // Parameters that affect performance
 
@@ -88,6 +131,35 @@ struct LEVELDB_EXPORT Options {
   // one open file per 2MB of working set).
   int max_open_files = 1000;
 
+  // If false, table files are read with pread(), or with batched
+  // asynchronous reads where the Env supports them, instead of through a
+  // memory map.  Blocks read this way can be kept in the block cache.
+  bool allow_mmap_reads = true;
+
+  // If true, table files are read with direct I/O, bypassing the operating
+  // system's page cache, so the block cache is the only cache of table
+  // data.  Overrides allow_mmap_reads.
+  bool use_direct_reads = false;
+
+  // If true, flushes and compactions write their table files, and
+  // compactions read their input tables, with direct I/O.  Background
+  // transfers then no longer evict the pages foreground reads depend on.
+  bool use_direct_io_for_flush_and_compaction = false;
+
+  // If non-null, flushes and compactions write their table files no faster
+  // than this limiter allows.  The limiter may be shared by several DBs to
+  // cap their combined background writes, and must outlive them.
+  RateLimiter* rate_limiter = nullptr;
+
+  // Table iterators that read several data blocks in a row from disk start
+  // reading ahead of themselves, in windows that double in size up to this
+  // many bytes.  Zero disables automatic readahead.
+  size_t max_auto_readahead_size = 256 * 1024;
+
+  // Compactions read their input tables ahead in windows of this many
+  // bytes.  Zero falls back to automatic readahead.
+  size_t compaction_readahead_size = 2 * 1024 * 1024;
+
   // Control over blocks (user data is stored in a set of blocks, and
   // a block is the unit of reading from disk).
 
@@ -95,6 +167,25 @@ struct LEVELDB_EXPORT Options {
   // If null, leveldb will automatically create and use an 8MB internal cache.
   Cache* block_cache = nullptr;
 
+  // If non-null, use the specified cache for the results of point lookups
+  // in table files, keyed by file number and user key.  A hit serves Get()
+  // without reading or decoding any block of the table.  Only reads
+  // without an explicit snapshot use this cache.  Entries are charged
+  // their encoded size.  No row cache is used by default.
+  Cache* row_cache = nullptr;
+
+  // If true, the index block and the filter of each table live in the
+  // block cache, where they are charged against its capacity and may be
+  // evicted, instead of in memory owned by the open table.  This bounds
+  // the memory used for reads by the block cache capacity, at the cost of
+  // re-reading evicted index and filter blocks.
+  bool cache_index_and_filter_blocks = false;
+
+  // If true, and cache_index_and_filter_blocks is set, the index and filter
+  // blocks of level-0 tables are held in the block cache while the tables
+  // are in level 0.  They still count towards the cache usage.
+  bool pin_l0_filter_and_index_blocks_in_cache = false;
+
   // Approximate size of user data packed per block.  Note that the
   // block size specified here corresponds to uncompressed data.  The
   // actual size of the unit read from disk may be smaller if
@@ -106,6 +197,21 @@ struct LEVELDB_EXPORT Options {
   // leave this parameter alone.
   int block_restart_interval = 16;
 
+  // If true, each data block carries a small hash index mapping user keys
+  // to their restart interval, so point lookups skip the binary search
+  // over restart points and most of the linear scan within the block.
+  // Costs roughly one byte per key.  Blocks written with the index cannot
+  // be read by releases that predate this option.
+  bool data_block_hash_index = false;
+
+  // If true, the keys of the data blocks held in the block cache are
+  // written to a BLOCK_CACHE_KEYS file when the DB is closed, and those
+  // blocks are read back into the block cache by background threads when
+  // the DB is next opened.  Shortens the period of cold reads after a
+  // restart.  Has no effect on blocks that bypass the block cache, e.g.
+  // blocks read through mmap.
+  bool persist_block_cache_keys = false;
+
   // Leveldb will write up to this amount of bytes to a file before
   // switching to a new one.
   // Most clients should leave this parameter alone.  However if your
@@ -116,6 +222,66 @@ struct LEVELDB_EXPORT Options {
   // initially populating a large database.
   size_t max_file_size = 2 * 1024 * 1024;
 
+  // Level-1 is compacted once it holds more than this many bytes, and each
+  // level after it once it holds max_bytes_for_level_multiplier times as
+  // much as the level above.
+  uint64_t max_bytes_for_level_base = 10 * 1048576;
+  double max_bytes_for_level_multiplier = 10;
+
+  // If true, level targets are worked out backwards from the size of the
+  // largest level instead, so that about 1/max_bytes_for_level_multiplier
+  // of the data lives outside the last level whatever the database size.
+  // Level-0 is then compacted straight into the first level whose target
+  // reaches max_bytes_for_level_base; the levels above it are left empty
+  // until the database grows into them.
+  bool level_compaction_dynamic_level_bytes = false;
+
+  // Leveled or universal compaction.  With kCompactionStyleUniversal a
+  // compaction starts once there are level0_file_num_compaction_trigger
+  // sorted runs, and the level size options above are ignored.
+  CompactionStyle compaction_style = kCompactionStyleLevel;
+
+  // Universal compaction only: a run is merged with the newer runs before
+  // it if it is at most this many percent larger than all of them
+  // together.
+  int universal_size_ratio = 1;
+
+  // Universal compaction only: the fewest and the most sorted runs merged
+  // at once.  Zero universal_max_merge_width means no limit.
+  int universal_min_merge_width = 2;
+  int universal_max_merge_width = 0;
+
+  // Universal compaction only: once the runs other than the oldest add up
+  // to this many percent of the oldest, everything is merged into one run.
+  // Zero disables the check.
+  int universal_max_size_amplification_percent = 200;
+
+  // A compaction of level-0 is started once it holds this many files.
+  int level0_file_num_compaction_trigger = 4;
+
+  // Writes are slowed down to delayed_write_rate once level-0 holds this
+  // many files, and further as it fills up towards
+  // level0_stop_writes_trigger.
+  int level0_slowdown_writes_trigger = 8;
+
+  // Writes wait for compactions to catch up once level-0 holds this many
+  // files.
+  int level0_stop_writes_trigger = 12;
+
+  // Writes are slowed down once compactions are estimated to be this many
+  // bytes behind, and further as the backlog grows towards
+  // hard_pending_compaction_bytes_limit.  Zero disables the limit.
+  uint64_t soft_pending_compaction_bytes_limit = 64ull << 30;
+
+  // Writes wait for compactions to catch up once they are estimated to be
+  // this many bytes behind.  Zero disables the limit.
+  uint64_t hard_pending_compaction_bytes_limit = 256ull << 30;
+
+  // Bytes per second writes are paced to once they are slowed down.  The
+  // rate falls to a tenth of this as level-0 or the compaction backlog
+  // approach the point where writes stop.
+  uint64_t delayed_write_rate = 16 << 20;
+
   // Compress blocks using the specified compression algorithm.  This
   // parameter can be changed dynamically.
   //
@@ -138,11 +304,56 @@ struct LEVELDB_EXPORT Options {
   // Default: currently false, but may become true later.
   bool reuse_logs = false;
 
+  // If non-zero, up to this many obsolete log files are kept around and
+  // written over in place of creating new ones.  Overwriting blocks a file
+  // already has spares fsync from updating the file system's metadata.
+  // Records in such logs carry the log number, so that stale data at the
+  // tail of a reused file is recognized and ignored.
+  //
+  // Logs written this way are never reopened by reuse_logs, and cannot be
+  // read by versions of leveldb that predate this option.
+  //
+  // Default: 0
+  size_t recycle_log_file_num = 0;
+
+  // If true, disk space for a memtable's worth of log (write_buffer_size
+  // plus 10%) is reserved when each log file is created, where the Env
+  // supports it.
+  bool preallocate_log_files = false;
+
+  // If non-null, compactions pass the values they keep through this
+  // filter, which may drop or rewrite them.  See NewTTLCompactionFilter()
+  // for expiring old data.  Must outlive the DB.
+  const CompactionFilter* compaction_filter = nullptr;
+
+  // Combines the operands written with DB::Merge() and WriteBatch::Merge()
+  // with the values underneath.  Without one, DB::Merge() and reads of
+  // keys that have operands fail.  See NewUInt64AddOperator() for
+  // counters.  Must outlive the DB.
+  const MergeOperator* merge_operator = nullptr;
+
   // If non-null, use the specified filter policy to reduce disk reads.
   // Many applications will benefit from passing the result of
   // NewBloomFilterPolicy() here.
   const FilterPolicy* filter_policy = nullptr;
 
+  // Layout of the filter data written into new tables when filter_policy
+  // is non-null.  Full filters answer negative point lookups with a single
+  // filter probe and no index block access; partitioned filters do the
+  // same while keeping the resident part of very large filters small.
+  FilterFormat filter_format = kFullFilter;
+
+  // If true, the index of each new table is split into partitions of
+  // roughly metadata_block_size bytes under a small top-level index.  Only
+  // the top-level index is read when the table is opened; partitions are
+  // loaded on demand through the block cache, so large tables open quickly
+  // and only their hot index partitions stay resident.
+  bool partition_index = false;
+
+  // Approximate size of the partitions written for partitioned metadata
+  // (see kPartitionedFilter and partition_index).
+  size_t metadata_block_size = 4 * 1024;
+
   // nvm option
   NVMOption nvm_option;
 };
@@ -164,6 +375,11 @@ struct LEVELDB_EXPORT ReadOptions {
   // not have been released).  If "snapshot" is null, use an implicit
   // snapshot of the state at the beginning of this read operation.
   const Snapshot* snapshot = nullptr;
+
+  // If non-zero, iterators read this many bytes ahead from their first
+  // read from disk on, instead of waiting for a sequential pattern to
+  // emerge.  Useful for long scans.
+  size_t readahead_size = 0;
 };
 
 // Options that control write operations
@@ -0,0 +1,122 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// PerfContext and IOStatsContext break the cost of the operations issued
+// by one thread down into its parts: memtable and table lookups, block
+// cache hits and disk reads, filter checks, mutex waits and file I/O.
+// Both are thread-local, so they describe exactly the operations of the
+// calling thread, and are off by default.  A typical use:
+//
+//   leveldb::SetPerfLevel(leveldb::kPerfEnableTime);
+//   leveldb::GetPerfContext()->Reset();
+//   leveldb::GetIOStatsContext()->Reset();
+//   db->Get(options, key, &value);
+//   if (slow) log(leveldb::GetPerfContext()->ToString(true));
+//
+// Unlike Statistics (see statistics.h), which aggregates over all threads
+// and databases, these contexts are never reset implicitly: counters keep
+// adding up until Reset() is called.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
+#define STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
+
+#include <cstdint>
+#include <string>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+enum PerfLevel {
+  // Collect nothing.
+  kPerfDisabled = 0,
+  // Collect counters only.
+  kPerfEnableCount,
+  // Collect counters and timers.  Timers read a clock twice per timed
+  // section, which is noticeable on operations served from memory.
+  kPerfEnableTime
+};
+
+// Set or get the perf level of the calling thread.
+LEVELDB_EXPORT void SetPerfLevel(PerfLevel level);
+LEVELDB_EXPORT PerfLevel GetPerfLevel();
+
+// Number of levels that PerfContext keeps per-level timers for.
+static const int kPerfContextLevels = 7;
+
+// All times are in nanoseconds.
+struct LEVELDB_EXPORT PerfContext {
+  // Zero all counters.
+  void Reset();
+
+  // Return the counters as "name = value" pairs separated by commas.  If
+  // "exclude_zero_counters" is true, counters that are zero are left out.
+  std::string ToString(bool exclude_zero_counters = false) const;
+
+  // Time spent waiting for the DB mutex in Get().
+  uint64_t db_mutex_lock_nanos;
+
+  // Time spent in the memtable and in the immutable memtable, and the
+  // number of lookups that ended there.
+  uint64_t get_from_memtable_nanos;
+  uint64_t get_from_imm_nanos;
+  uint64_t get_from_memtable_count;
+
+  // Time spent searching persistent (NVM) memtables.  Included in the two
+  // memtable timers above.
+  uint64_t get_from_nvm_memtable_nanos;
+
+  // Time spent in table files, in total and per level, and the number of
+  // table files searched.
+  uint64_t get_from_output_files_nanos;
+  uint64_t get_from_level_nanos[kPerfContextLevels];
+  uint64_t table_files_searched_count;
+
+  // Time spent finding a table in the table cache, including opening it
+  // on a miss, and the number of lookups served by the row cache.
+  uint64_t find_table_nanos;
+  uint64_t row_cache_hit_count;
+
+  // Blocks served by the block cache and by the secondary cache, and
+  // blocks read from table files.
+  uint64_t block_cache_hit_count;
+  uint64_t secondary_cache_hit_count;
+  uint64_t block_read_count;
+  uint64_t block_read_byte;
+  uint64_t block_read_nanos;
+
+  // Time spent probing filters, and the probes that ruled a key out.
+  uint64_t filter_check_nanos;
+  uint64_t bloom_filter_useful;
+};
+
+// File system work done on behalf of the calling thread.  All times are
+// in nanoseconds.
+struct LEVELDB_EXPORT IOStatsContext {
+  // Zero all counters.
+  void Reset();
+
+  // Same format as PerfContext::ToString().
+  std::string ToString(bool exclude_zero_counters = false) const;
+
+  // Table file reads.
+  uint64_t bytes_read;
+  uint64_t read_nanos;
+
+  // Log appends and syncs.
+  uint64_t bytes_written;
+  uint64_t write_nanos;
+  uint64_t fsync_nanos;
+
+  // Time spent opening table files.
+  uint64_t open_nanos;
+};
+
+// Return the contexts of the calling thread.
+LEVELDB_EXPORT PerfContext* GetPerfContext();
+LEVELDB_EXPORT IOStatsContext* GetIOStatsContext();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
@@ -0,0 +1,61 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A RateLimiter caps the rate at which flushes and compactions write table
+// files, so that background I/O does not starve foreground reads.  A single
+// limiter may be shared by several DBs in a process to cap their combined
+// background I/O.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+#define STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+
+#include <cstdint>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class LEVELDB_EXPORT RateLimiter {
+ public:
+  RateLimiter() = default;
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  virtual ~RateLimiter();
+
+  // Blocks the calling thread until "bytes" more bytes may be written.
+  // Safe to call concurrently from several threads.
+  virtual void Request(int64_t bytes) = 0;
+
+  // Changes the rate the limiter was created with.
+  virtual void SetBytesPerSecond(int64_t bytes_per_second) = 0;
+
+  // Returns the current rate, including any auto-tuned increase.
+  virtual int64_t GetBytesPerSecond() const = 0;
+
+  // Returns the total number of bytes requested so far.
+  virtual int64_t GetTotalBytesThrough() const = 0;
+
+  // Reports how far the compactions of the DB identified by "db" are
+  // falling behind: 0 while they keep up, and 1 once enough level-0 files
+  // have piled up for writes to be slowed down.  An auto-tuned limiter runs
+  // faster the higher the pressure reported by any of its DBs.  The default
+  // implementation ignores the report.
+  virtual void SetCompactionPressure(const void* db, double pressure) {}
+};
+
+// Create a token-bucket rate limiter that lets "bytes_per_second" through on
+// average, in bursts of up to a tenth of a second's worth.  REQUIRES:
+// bytes_per_second > 0.
+//
+// If "auto_tuned" is true, the rate grows with the compaction pressure, up
+// to eight times "bytes_per_second" at full pressure, so that throttled
+// compactions cannot cause write stalls.
+LEVELDB_EXPORT RateLimiter* NewGenericRateLimiter(int64_t bytes_per_second,
+                                                  bool auto_tuned = false);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
@@ -0,0 +1,142 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Statistics collects counters ("tickers") and latency histograms from a
+// running database.  Point Options::statistics at an object returned by
+// NewStatistics() to enable it; the same object may be shared by several
+// databases.  Collection can be turned down or off at any time with
+// set_stats_level(), and the collected data can be read with
+// GetTickerCount(), GetHistogramData(), GetHistogramString(), ToString()
+// or through the "leveldb.statistics" property.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+#define STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+enum Ticker {
+  // Time writers spent waiting for room in the memtable or being slowed
+  // down by the write controller.
+  kStallMicros = 0,
+  // Point lookups answered by the memtable or the immutable memtable.
+  kMemtableHit,
+  kMemtableMiss,
+  // Point lookups answered by a table file in level 0 or in a deeper level.
+  kGetHitL0,
+  kGetHitL1AndUp,
+  // Table file reads avoided because a filter ruled the key out.
+  kBloomFilterUseful,
+  // User data passed to Write() and returned by Get().
+  kBytesWritten,
+  kBytesRead,
+  kKeysWritten,
+  kKeysRead,
+  // Table file bytes written by memtable flushes, and bytes read and
+  // written by compactions.
+  kFlushWriteBytes,
+  kCompactReadBytes,
+  kCompactWriteBytes,
+  // Records made durable in a persistent (NVM) memtable.
+  kNvmPersists,
+  kTickerEnumMax
+};
+
+enum HistogramType {
+  kDbGetMicros = 0,
+  kDbWriteMicros,
+  // The parts of a Get(): the memtable lookups and the table file lookups.
+  kGetMemtableMicros,
+  kGetVersionMicros,
+  // The parts of a Write(): the log append and the memtable insert.
+  kWriteWalMicros,
+  kWriteMemtableMicros,
+  // Time spent making room in the memtable before a write.
+  kWriteStallMicros,
+  kHistogramEnumMax
+};
+
+enum StatsLevel {
+  // Collect nothing.
+  kStatsDisabled = 0,
+  // Collect the tickers but no histograms, which need a clock read for
+  // every sample.
+  kStatsExceptTimers,
+  // Collect everything.
+  kStatsAll
+};
+
+// Return a short name for "ticker" or "type", e.g. "leveldb.memtable.hit".
+LEVELDB_EXPORT const char* TickerName(Ticker ticker);
+LEVELDB_EXPORT const char* HistogramName(HistogramType type);
+
+// A snapshot of one histogram.  Percentiles are interpolated within the
+// histogram's buckets; all are zero while the histogram is empty.
+struct LEVELDB_EXPORT HistogramData {
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  double average = 0;
+  double median = 0;
+  double percentile95 = 0;
+  double percentile99 = 0;
+  double percentile999 = 0;
+  double max = 0;
+};
+
+// All methods are thread-safe.
+class LEVELDB_EXPORT Statistics {
+ public:
+  Statistics() : stats_level_(kStatsAll) {}
+
+  Statistics(const Statistics&) = delete;
+  Statistics& operator=(const Statistics&) = delete;
+
+  virtual ~Statistics();
+
+  virtual void RecordTick(Ticker ticker, uint64_t count) = 0;
+  virtual uint64_t GetTickerCount(Ticker ticker) const = 0;
+
+  // Add a sample of "micros" to the histogram "type".
+  virtual void MeasureTime(HistogramType type, uint64_t micros) = 0;
+
+  // Store a summary of the histogram "type" in *data.
+  virtual void GetHistogramData(HistogramType type,
+                                HistogramData* data) const = 0;
+
+  // Return a human readable summary (count, average and percentiles) of
+  // the histogram "type".
+  virtual std::string GetHistogramString(HistogramType type) const = 0;
+
+  // Zero all tickers and histograms.
+  virtual void Reset() = 0;
+
+  // Return all tickers and histograms, one per line.
+  virtual std::string ToString() const;
+
+  StatsLevel stats_level() const {
+    return stats_level_.load(std::memory_order_relaxed);
+  }
+  void set_stats_level(StatsLevel level) {
+    stats_level_.store(level, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<StatsLevel> stats_level_;
+};
+
+// Return a Statistics object whose counters are spread over one shard per
+// CPU, so that threads on different cores rarely touch the same cache line.
+//
+// Callers should delete the result after any database that is using it
+// is closed.
+LEVELDB_EXPORT Statistics* NewStatistics();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
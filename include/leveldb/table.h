@@ -5,8 +5,11 @@
 #ifndef STORAGE_LEVELDB_INCLUDE_TABLE_H_
 #define STORAGE_LEVELDB_INCLUDE_TABLE_H_
 
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
+#include "leveldb/cache.h"
 #include "leveldb/export.h"
 #include "leveldb/iterator.h"
 
@@ -14,6 +17,7 @@ namespace leveldb {
 
 class Block;
 class BlockHandle;
+struct CachedFilter;
 class Footer;
 struct Options;
 class RandomAccessFile;
@@ -60,12 +64,52 @@ class LEVELDB_EXPORT Table {
 
  private:
   friend class TableCache;
+  friend class TableInternal;
   struct Rep;
 
   static Iterator* BlockReader(void*, const ReadOptions&, const Slice&);
+  // Reads through "file" instead of the table's file if it is non-null.
+  static Iterator* BlockReader(void*, const ReadOptions&, const Slice&,
+                               bool point_lookup, bool high_priority,
+                               RandomAccessFile* file = nullptr);
+  // Like BlockReader(), for an iterator that reads ahead: "arg" is the
+  // iterator's readahead state instead of the table.
+  static Iterator* ReadaheadBlockReader(void*, const ReadOptions&,
+                                        const Slice&);
+  // Reads index partitions and the top-level filter index, which are
+  // cached with high priority.
+  static Iterator* MetaBlockReader(void*, const ReadOptions&, const Slice&);
 
   explicit Table(Rep* rep) : rep_(rep) {}
 
+  // Reads the block at "index_value" through the block cache, if any.
+  // Sets *cache_handle to the cache entry that holds *block, or to nullptr
+  // if the caller owns *block.  Blocks missing from the cache are read from
+  // "file", or from the table's file if "file" is null.
+  Status ReadCachedBlock(const ReadOptions&, const Slice& index_value,
+                         bool high_priority, Block** block,
+                         Cache::Handle** cache_handle,
+                         RandomAccessFile* file = nullptr) const;
+
+  // Like ReadCachedBlock() for a filter block or a filter partition.
+  // Returns nullptr on error.  The result must be passed to ReleaseFilter()
+  // along with *cache_handle.
+  CachedFilter* ReadCachedFilter(const ReadOptions&, const Slice& handle_value,
+                                 Cache::Handle** cache_handle) const;
+  void ReleaseFilter(CachedFilter* filter, Cache::Handle* cache_handle) const;
+
+  // Keeps the index block and the filter of this table in the block cache
+  // until UnpinMetaBlocks() is called or the table is closed.  Only has an
+  // effect if options.cache_index_and_filter_blocks is set.
+  void PinMetaBlocks();
+
+  // Lets the blocks pinned by PinMetaBlocks() be evicted again.
+  void UnpinMetaBlocks();
+
+  // Returns an iterator over the index entries of all data blocks, reading
+  // index partitions on demand if the index is partitioned.
+  Iterator* NewIndexIterator(const ReadOptions&) const;
+
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
   // that key is not present.
@@ -73,8 +117,31 @@ class LEVELDB_EXPORT Table {
                      void (*handle_result)(void* arg, const Slice& k,
                                            const Slice& v));
 
+  // Returns false if the table-level filter (full or partitioned) proves
+  // that "key" is absent.  Errors are treated as potential matches.
+  bool KeyMayMatch(const ReadOptions&, const Slice& key);
+  bool PartitionMayMatch(const ReadOptions&, const Slice& partition_handle,
+                         const Slice& key);
+  // Returns false if the block-based filter proves that "key" is absent
+  // from the data block at "block_offset".
+  bool BlockMayMatch(const ReadOptions&, uint64_t block_offset,
+                     const Slice& key);
+
+  // Id that prefixes the block cache keys of this table.
+  uint64_t CacheId() const;
+
+  // Returns true if "deleter" belongs to a block cache entry holding a
+  // Block of some table, as opposed to e.g. a filter partition.
+  static bool IsCachedBlock(void (*deleter)(const Slice& key, void* value));
+
+  // Reads the data blocks that start at "offsets" (sorted ascending) into
+  // the block cache.  Offsets that match no data block are ignored.  Gives
+  // up early once "*stop" becomes true.
+  Status WarmBlocks(const std::vector<uint64_t>& offsets,
+                    const std::atomic<bool>* stop) const;
+
   void ReadMeta(const Footer& footer);
-  void ReadFilter(const Slice& filter_handle_value);
+  void ReadFilter(const Slice& filter_handle_value, bool full_filter);
 
   Rep* const rep_;
 };
@@ -80,9 +80,13 @@ class LEVELDB_EXPORT TableBuilder {
   uint64_t FileSize() const;
 
  private:
+  friend class TableInternal;
+
   bool ok() const { return status().ok(); }
   void WriteBlock(BlockBuilder* block, BlockHandle* handle);
   void WriteRawBlock(const Slice& data, CompressionType, BlockHandle* handle);
+  void MaybeCutIndexPartition(bool force);
+  void MaybeCutFilterPartition(bool force);
 
   struct Rep;
   Rep* rep_;
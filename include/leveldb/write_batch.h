@@ -37,6 +37,9 @@ class LEVELDB_EXPORT WriteBatch {
     virtual ~Handler();
     virtual void Put(const Slice& key, const Slice& value) = 0;
     virtual void Delete(const Slice& key) = 0;
+    // The default implementation passes the operand to Put(), so
+    // handlers that do not know about merges see it as a plain value.
+    virtual void Merge(const Slice& key, const Slice& value);
   };
 
   WriteBatch();
@@ -53,6 +56,10 @@ class LEVELDB_EXPORT WriteBatch {
   // If the database contains a mapping for "key", erase it.  Else do nothing.
   void Delete(const Slice& key);
 
+  // Record "value" as a merge operand for "key".  The database applies it
+  // to the current value of "key" with options.merge_operator.
+  void Merge(const Slice& key, const Slice& value);
+
   bool Get(const Slice& key, std::string* value, Status* s);
 
   // Clear all updates buffered in this batch.
@@ -1,12 +1,15 @@
 #include "memtable_nvm.h"
 
 #include "db/dbformat.h"
+#include "db/merge_helper.h"
 
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
 
 #include "util/coding.h"
+#include "util/perf_context_imp.h"
+#include "util/statistics.h"
 
 namespace leveldb {
 
@@ -18,9 +21,11 @@ static Slice GetLengthPrefixedSlice(const char* data) {
 }
 
 MemTableNVM::MemTableNVM(const InternalKeyComparator& comparator,
-                         const NVMOption* nvm_option, std::string filename)
+                         const NVMOption* nvm_option, std::string filename,
+                         Statistics* statistics)
     : comparator_(comparator),
       refs_(0),
+      statistics_(statistics),
       allocator_(nvm_option, filename),
       table_(comparator_, &allocator_, MEM_TABLE_DATA_OFFSET) {
   earliest_sequence = (uint64_t*)GetPmemMinSequence();
@@ -106,6 +111,7 @@ void MemTableNVM::Add(SequenceNumber s, ValueType type, const Slice& key,
   assert(p + val_size == buf + encoded_len);
   pmem_memcpy_persist(pmem_buf, buf, encoded_len);
   table_.Insert(pmem_buf);
+  RecordTick(statistics_, kNvmPersists);
   if (s > *max_sequence) {
     *max_sequence = s;
     allocator_.flush(reinterpret_cast<const char*>(max_sequence), sizeof(max_sequence));
@@ -113,11 +119,13 @@ void MemTableNVM::Add(SequenceNumber s, ValueType type, const Slice& key,
 }
 
 bool MemTableNVM::Get(const LookupKey& key, std::string* value,
-                      SequenceNumber* seq, Status* s) {
+                      SequenceNumber* seq, Status* s,
+                      MergeContext* merge_context) {
+  PerfTimer timer(&perf_context.get_from_nvm_memtable_nanos);
   Slice memkey = key.memtable_key();
   Table::Iterator iter(&table_);
   iter.Seek(memkey.data());
-  if (iter.Valid()) {
+  for (bool first = true; iter.Valid(); iter.Next(), first = false) {
     // entry format is:
     //    klength  varint32
     //    userkey  char[klength]
@@ -133,21 +141,32 @@ bool MemTableNVM::Get(const LookupKey& key, std::string* value,
 
     // seq
     const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
-    *seq = tag >> 8;
+    if (first) {
+      *seq = tag >> 8;
+    }
 
     if (comparator_.comparator.user_comparator()->Compare(
-            Slice(key_ptr, key_length - 8), key.user_key()) == 0) {
-      // Correct user key
-      switch (static_cast<ValueType>(tag & 0xff)) {
-        case kTypeValue: {
-          Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
-          value->assign(v.data(), v.size());
+            Slice(key_ptr, key_length - 8), key.user_key()) != 0) {
+      break;
+    }
+    // Correct user key
+    switch (static_cast<ValueType>(tag & 0xff)) {
+      case kTypeValue: {
+        Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+        value->assign(v.data(), v.size());
+        return true;
+      }
+      case kTypeDeletion:
+        *s = Status::NotFound(Slice());
+        return true;
+      case kTypeMerge:
+        if (merge_context == nullptr) {
           return true;
         }
-        case kTypeDeletion:
-          *s = Status::NotFound(Slice());
-          return true;
-      }
+        // Keep looking for older operands and the value underneath.
+        merge_context->PushOperand(
+            GetLengthPrefixedSlice(key_ptr + key_length));
+        break;
     }
   }
   return false;
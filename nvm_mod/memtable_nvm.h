@@ -11,6 +11,7 @@
 #include "nvm_mod/pmem_manager.h"
 namespace leveldb {
 class InternalKeyComparator;
+class Statistics;
 class MemTableNVM : public MemTableRep {
  public:
   static const int MAX_SEQUENCE_OFFSET = 0;  // MAX_SEQUENCE偏移量
@@ -34,8 +35,10 @@ class MemTableNVM : public MemTableRep {
  public:
   // MemTables are reference counted.  The initial reference count
   // is zero and the caller must call Ref() at least once.
+  // Records made durable are counted in "statistics" if it is non-null.
   explicit MemTableNVM(const InternalKeyComparator& comparator,
-                       const NVMOption* nvm_option, std::string filename);
+                       const NVMOption* nvm_option, std::string filename,
+                       Statistics* statistics = nullptr);
 
   MemTableNVM(const MemTableNVM&) = delete;
   MemTableNVM& operator=(const MemTableNVM&) = delete;
@@ -73,9 +76,11 @@ class MemTableNVM : public MemTableRep {
   // If memtable contains a value for key, stre it in *value and return true.
   // If memtable contains a deletion for key, store a NotFound() error
   // in *status and return true.
+  // Merge operands found on the way are added to *merge_context, as in
+  // MemTable::Get().
   // Else, return false.
   bool Get(const LookupKey& key, std::string* value, SequenceNumber* seq,
-           Status* s) override;
+           Status* s, MergeContext* merge_context) override;
 
   void Clear(uint64_t earliest_seq) override;
   bool IsPersistent() override { return true; }
@@ -106,6 +111,7 @@ class MemTableNVM : public MemTableRep {
 
   KeyComparator comparator_;
   int refs_;
+  Statistics* const statistics_;
   PmemManager allocator_;
   Table table_;
 };
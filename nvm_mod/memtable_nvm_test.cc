@@ -97,7 +97,7 @@ TEST(MemTableNVMTest, InsertAndLookup) {
       std::string get_value;
       LookupKey lookupkey(key, seq);
       SequenceNumber get_seq;
-      ASSERT_TRUE(memtable.Get(lookupkey, &get_value, &seq, &s));
+      ASSERT_TRUE(memtable.Get(lookupkey, &get_value, &seq, &s, nullptr));
       std::cout << "look up key:" << key << " value:" << get_value << std::endl;
       ASSERT_EQ(value, get_value);
     }
@@ -114,7 +114,7 @@ TEST(MemTableNVMTest, InsertAndLookup) {
       std::string get_value;
       LookupKey lookupkey(key, seq);
       SequenceNumber get_seq;
-      ASSERT_TRUE(memtable.Get(lookupkey, &get_value, &seq, &s));
+      ASSERT_TRUE(memtable.Get(lookupkey, &get_value, &seq, &s, nullptr));
       std::cout << "look up key:" << key << " value:" << get_value << std::endl;
       ASSERT_EQ(value, get_value);
     }
@@ -0,0 +1,115 @@
+#include "nvm_mod/nvm_secondary_cache.h"
+
+#include <libpmem.h>
+
+#include <cstring>
+
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+NVMSecondaryCache::NVMSecondaryCache(const std::string& filename,
+                                     size_t capacity)
+    : base_(nullptr),
+      mapped_len_(0),
+      is_pmem_(0),
+      capacity_(capacity),
+      write_pos_(0),
+      hits_(0),
+      misses_(0) {
+  if (capacity_ > 0) {
+    base_ = static_cast<char*>(pmem_map_file(filename.c_str(), capacity_,
+                                             PMEM_FILE_CREATE, 0666,
+                                             &mapped_len_, &is_pmem_));
+  }
+}
+
+NVMSecondaryCache::~NVMSecondaryCache() {
+  if (base_ != nullptr) {
+    pmem_unmap(base_, mapped_len_);
+  }
+}
+
+void NVMSecondaryCache::Write(char* dst, const char* src, size_t n) {
+  // The contents need not survive a crash, so skip the flushes and just
+  // use non-temporal stores on real persistent memory.
+  if (is_pmem_) {
+    pmem_memcpy_nodrain(dst, src, n);
+  } else {
+    std::memcpy(dst, src, n);
+  }
+}
+
+void NVMSecondaryCache::EvictOldest() {
+  index_.erase(records_.front().key);
+  records_.pop_front();
+}
+
+void NVMSecondaryCache::Insert(const Slice& key, const Slice& contents) {
+  const size_t length = kHeaderSize + key.size() + contents.size();
+  if (base_ == nullptr || length > capacity_) {
+    return;
+  }
+
+  MutexLock l(&mutex_);
+  const std::string k = key.ToString();
+  if (index_.count(k) != 0) {
+    return;  // Already saved; blocks never change under a given key.
+  }
+
+  if (write_pos_ + length > capacity_) {
+    // Wrap around.  Records past the old write position are the oldest
+    // ones left from the previous lap.
+    while (!records_.empty() && records_.front().offset >= write_pos_) {
+      EvictOldest();
+    }
+    write_pos_ = 0;
+  }
+  while (!records_.empty() && records_.front().offset >= write_pos_ &&
+         records_.front().offset < write_pos_ + length) {
+    EvictOldest();
+  }
+
+  char header[kHeaderSize];
+  EncodeFixed32(header, static_cast<uint32_t>(key.size()));
+  EncodeFixed32(header + 4, static_cast<uint32_t>(contents.size()));
+  char* dst = base_ + write_pos_;
+  Write(dst, header, kHeaderSize);
+  Write(dst + kHeaderSize, key.data(), key.size());
+  Write(dst + kHeaderSize + key.size(), contents.data(), contents.size());
+  if (is_pmem_) {
+    pmem_drain();
+  }
+
+  records_.push_back(Record{write_pos_, k});
+  index_[k] = write_pos_;
+  write_pos_ += length;
+}
+
+bool NVMSecondaryCache::Lookup(const Slice& key, std::string* contents) {
+  MutexLock l(&mutex_);
+  auto it = index_.find(key.ToString());
+  if (it == index_.end()) {
+    misses_++;
+    return false;
+  }
+  const char* record = base_ + it->second;
+  const uint32_t key_size = DecodeFixed32(record);
+  const uint32_t value_size = DecodeFixed32(record + 4);
+  contents->assign(record + kHeaderSize + key_size, value_size);
+  hits_++;
+  return true;
+}
+
+uint64_t NVMSecondaryCache::hits() const {
+  MutexLock l(&mutex_);
+  return hits_;
+}
+
+uint64_t NVMSecondaryCache::misses() const {
+  MutexLock l(&mutex_);
+  return misses_;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "leveldb/cache.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+
+namespace leveldb {
+
+// A SecondaryCache kept in a file mapped through libpmem.  On a DAX file
+// system the blocks live in persistent memory; on any other file system
+// the same code runs on an ordinary memory mapping.
+//
+// The file is used as a ring buffer: entries are appended at the write
+// position and the oldest entries are overwritten when it wraps around.
+// The index lives in DRAM, so the contents do not survive a restart (the
+// block cache keys change with every open anyway).  The keys come from
+// the block caches, which keep each other's entries apart, so one file may
+// serve several caches.
+//
+// Record layout at each offset:
+//   key_size:   fixed32
+//   value_size: fixed32
+//   key:        char[key_size]
+//   value:      char[value_size]
+class NVMSecondaryCache : public SecondaryCache {
+ public:
+  // Maps (creating if necessary) "filename" with "capacity" bytes.
+  NVMSecondaryCache(const std::string& filename, size_t capacity);
+
+  NVMSecondaryCache(const NVMSecondaryCache&) = delete;
+  NVMSecondaryCache& operator=(const NVMSecondaryCache&) = delete;
+
+  ~NVMSecondaryCache() override;
+
+  // Returns false if the file could not be mapped.  A cache that failed
+  // to open ignores inserts and never hits.
+  bool ok() const { return base_ != nullptr; }
+
+  void Insert(const Slice& key, const Slice& contents) override;
+  bool Lookup(const Slice& key, std::string* contents) override;
+
+  // Number of lookups that found their key, and that did not.
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+ private:
+  static const size_t kHeaderSize = 8;
+
+  struct Record {
+    size_t offset;
+    std::string key;
+  };
+
+  // Drops the oldest record from the ring and the index.
+  void EvictOldest() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void Write(char* dst, const char* src, size_t n);
+
+  char* base_;
+  size_t mapped_len_;
+  int is_pmem_;
+  const size_t capacity_;
+
+  mutable port::Mutex mutex_;
+  size_t write_pos_ GUARDED_BY(mutex_);
+  // Live records, oldest first.  Offsets increase along the deque except
+  // where the ring wrapped around.
+  std::deque<Record> records_ GUARDED_BY(mutex_);
+  std::unordered_map<std::string, size_t> index_ GUARDED_BY(mutex_);
+  uint64_t hits_ GUARDED_BY(mutex_);
+  uint64_t misses_ GUARDED_BY(mutex_);
+};
+
+}  // namespace leveldb
@@ -0,0 +1,184 @@
+#include "nvm_mod/nvm_secondary_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+
+#include "util/coding.h"
+#include "util/random.h"
+#include "util/testutil.h"
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+static std::string Key(int i) {
+  char buf[100];
+  std::snprintf(buf, sizeof(buf), "key%06d", i);
+  return std::string(buf);
+}
+
+// Copies reads into the caller's buffer, as non-mmap files do, so that
+// blocks go through the block cache.
+class CopyingRandomAccessFile : public RandomAccessFile {
+ public:
+  explicit CopyingRandomAccessFile(RandomAccessFile* target)
+      : target_(target) {}
+  ~CopyingRandomAccessFile() override { delete target_; }
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    Status s = target_->Read(offset, n, result, scratch);
+    if (s.ok() && result->data() != scratch) {
+      std::memcpy(scratch, result->data(), result->size());
+      *result = Slice(scratch, result->size());
+    }
+    return s;
+  }
+
+ private:
+  RandomAccessFile* const target_;
+};
+
+class CopyingEnv : public EnvWrapper {
+ public:
+  CopyingEnv() : EnvWrapper(Env::Default()) {}
+
+  Status NewRandomAccessFile(const std::string& fname,
+                             RandomAccessFile** result) override {
+    Status s = target()->NewRandomAccessFile(fname, result);
+    if (s.ok()) {
+      *result = new CopyingRandomAccessFile(*result);
+    }
+    return s;
+  }
+};
+
+class NVMSecondaryCacheTest : public testing::Test {
+ public:
+  NVMSecondaryCacheTest() {
+    Env::Default()->GetTestDirectory(&dir_);
+    filename_ = dir_ + "/nvm_secondary_cache_test.pool";
+    Env::Default()->RemoveFile(filename_);
+  }
+  ~NVMSecondaryCacheTest() { Env::Default()->RemoveFile(filename_); }
+
+  std::string dir_;
+  std::string filename_;
+};
+
+TEST_F(NVMSecondaryCacheTest, InsertAndLookup) {
+  NVMSecondaryCache cache(filename_, 4096);
+  ASSERT_TRUE(cache.ok());
+
+  std::string value;
+  ASSERT_FALSE(cache.Lookup("a", &value));
+  cache.Insert("a", "apple");
+  cache.Insert("b", std::string(100, 'b'));
+  ASSERT_TRUE(cache.Lookup("a", &value));
+  ASSERT_EQ("apple", value);
+  ASSERT_TRUE(cache.Lookup("b", &value));
+  ASSERT_EQ(std::string(100, 'b'), value);
+
+  // Saved contents are never replaced.
+  cache.Insert("a", "apricot");
+  ASSERT_TRUE(cache.Lookup("a", &value));
+  ASSERT_EQ("apple", value);
+
+  ASSERT_EQ(3, cache.hits());
+  ASSERT_EQ(1, cache.misses());
+}
+
+TEST_F(NVMSecondaryCacheTest, Wraparound) {
+  const size_t kCapacity = 1000;
+  NVMSecondaryCache cache(filename_, kCapacity);
+  ASSERT_TRUE(cache.ok());
+
+  // Each record takes 8 + 4 + 88 = 100 bytes, so about ten fit.
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 95; i++) {
+    std::string key;
+    PutFixed32(&key, i);
+    values.push_back(test::RandomKey(&rnd, 80 + rnd.Uniform(16)));
+    cache.Insert(key, values.back());
+
+    // The newest entries are intact, the oldest are gone.
+    std::string value;
+    int present = 0;
+    for (int j = 0; j <= i; j++) {
+      std::string k;
+      PutFixed32(&k, j);
+      if (cache.Lookup(k, &value)) {
+        ASSERT_EQ(values[j], value) << j;
+        ASSERT_GE(j, i - 10);
+        present++;
+      } else {
+        ASSERT_LT(j, i - 5);
+      }
+    }
+    ASSERT_GE(present, std::min(i + 1, 6));
+  }
+
+  // Too large to ever fit.
+  cache.Insert("huge", std::string(kCapacity, 'x'));
+  std::string value;
+  ASSERT_FALSE(cache.Lookup("huge", &value));
+}
+
+TEST_F(NVMSecondaryCacheTest, BlockCacheTier) {
+  NVMSecondaryCache secondary(filename_, 16 << 20);
+  ASSERT_TRUE(secondary.ok());
+  CacheOptions cache_options;
+  cache_options.capacity = 64 << 10;  // Far smaller than the table data
+  cache_options.secondary_cache = &secondary;
+  Cache* block_cache = NewLRUCache(cache_options);
+
+  std::string dbname = dir_ + "/nvm_secondary_cache_db";
+  CopyingEnv env;
+  Options options;
+  options.env = &env;
+  options.create_if_missing = true;
+  options.block_cache = block_cache;
+  DestroyDB(dbname, options);
+  DB* db;
+  ASSERT_TRUE(DB::Open(options, dbname, &db).ok());
+
+  const int kNum = 5000;
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < kNum; i++) {
+    values.push_back(test::RandomKey(&rnd, 200));
+    ASSERT_TRUE(db->Put(WriteOptions(), Key(i), values.back()).ok());
+  }
+  db->CompactRange(nullptr, nullptr);
+
+  // The first pass fills the block cache, which spills into the secondary
+  // cache; the second pass finds the spilled blocks there.
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < kNum; i++) {
+      std::string value;
+      ASSERT_TRUE(db->Get(ReadOptions(), Key(i), &value).ok());
+      ASSERT_EQ(values[i], value);
+    }
+  }
+  ASSERT_GT(secondary.hits(), 0);
+
+  delete db;
+  DestroyDB(dbname, options);
+  delete block_cache;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -88,6 +88,11 @@ bool Snappy_Uncompress(const char* input_data, size_t input_length,
 // The concatenation of all "data[0,n-1]" fragments is the heap profile.
 bool GetHeapProfile(void (*func)(void*, const char*, int), void* arg);
 
+// Return the index of the CPU the calling thread is running on, or -1 if
+// it cannot be determined.  The result may be stale by the time it is
+// used, so it is only good as a hint.
+int CurrentCpu();
+
 // Extend the CRC to include the first n bytes of buf.
 //
 // Returns zero if the CRC cannot be extended using acceleration, else returns
@@ -28,6 +28,9 @@
 #if HAVE_SNAPPY
 #include <snappy.h>
 #endif  // HAVE_SNAPPY
+#if HAVE_SCHED_GETCPU
+#include <sched.h>
+#endif  // HAVE_SCHED_GETCPU
 
 #include <cassert>
 #include <condition_variable>  // NOLINT
@@ -133,6 +136,14 @@ inline bool GetHeapProfile(void (*func)(void*, const char*, int), void* arg) {
   return false;
 }
 
+inline int CurrentCpu() {
+#if HAVE_SCHED_GETCPU
+  return ::sched_getcpu();
+#else
+  return -1;
+#endif  // HAVE_SCHED_GETCPU
+}
+
 inline uint32_t AcceleratedCRC32C(uint32_t crc, const char* buf, size_t size) {
 #if HAVE_CRC32C
   return ::crc32c::Extend(crc, reinterpret_cast<const uint8_t*>(buf), size);
@@ -17,24 +17,32 @@
 
 namespace leveldb {
 
-inline uint32_t Block::NumRestarts() const {
-  assert(size_ >= sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
-}
-
 Block::Block(const BlockContents& contents)
     : data_(contents.data.data()),
       size_(contents.data.size()),
+      num_restarts_(0),
+      has_hash_index_(false),
       owned_(contents.heap_allocated) {
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
   } else {
-    size_t max_restarts_allowed = (size_ - sizeof(uint32_t)) / sizeof(uint32_t);
-    if (NumRestarts() > max_restarts_allowed) {
-      // The size is too small for NumRestarts()
+    const uint32_t footer = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+    num_restarts_ = footer & ~kDataBlockHashIndexFlag;
+    size_t restarts_limit = size_ - sizeof(uint32_t);
+    if ((footer & kDataBlockHashIndexFlag) != 0) {
+      if (hash_index_.Initialize(data_, restarts_limit, &restarts_limit)) {
+        has_hash_index_ = true;
+      } else {
+        size_ = 0;
+        return;
+      }
+    }
+    size_t max_restarts_allowed = restarts_limit / sizeof(uint32_t);
+    if (num_restarts_ > max_restarts_allowed) {
+      // The size is too small for num_restarts_
       size_ = 0;
     } else {
-      restart_offset_ = size_ - (1 + NumRestarts()) * sizeof(uint32_t);
+      restart_offset_ = restarts_limit - num_restarts_ * sizeof(uint32_t);
     }
   }
 }
@@ -80,6 +88,8 @@ class Block::Iter : public Iterator {
   const char* const data_;       // underlying block contents
   uint32_t const restarts_;      // Offset of restart array (list of fixed32)
   uint32_t const num_restarts_;  // Number of uint32_t entries in restart array
+  const DataBlockHashIndex* const hash_index_;  // nullptr if not in use
+  const bool internal_keys_;  // Whether the index hashes user keys only
 
   // current_ is offset in data_ of current entry.  >= restarts_ if !Valid
   uint32_t current_;
@@ -114,11 +124,14 @@ class Block::Iter : public Iterator {
 
  public:
   Iter(const Comparator* comparator, const char* data, uint32_t restarts,
-       uint32_t num_restarts)
+       uint32_t num_restarts, const DataBlockHashIndex* hash_index,
+       bool internal_keys)
       : comparator_(comparator),
         data_(data),
         restarts_(restarts),
         num_restarts_(num_restarts),
+        hash_index_(hash_index),
+        internal_keys_(internal_keys),
         current_(restarts_),
         restart_index_(num_restarts_) {
     assert(num_restarts_ > 0);
@@ -162,6 +175,10 @@ class Block::Iter : public Iterator {
   }
 
   void Seek(const Slice& target) override {
+    if (hash_index_ != nullptr && SeekWithHashIndex(target)) {
+      return;
+    }
+
     // Binary search in restart array to find the last restart point
     // with a key < target
     uint32_t left = 0;
@@ -247,6 +264,42 @@ class Block::Iter : public Iterator {
     value_.clear();
   }
 
+  // Returns false if the hash index cannot narrow down the search, in
+  // which case the caller falls back to the binary search.
+  bool SeekWithHashIndex(const Slice& target) {
+    const uint8_t entry =
+        hash_index_->Lookup(DataBlockHashKey(target, internal_keys_));
+    if (entry == kCollision || entry >= num_restarts_) {
+      return false;
+    }
+    if (entry == kNoEntry) {
+      // The user key is not in this block.
+      current_ = restarts_;
+      restart_index_ = num_restarts_;
+      return true;
+    }
+
+    // Linear search within the restart interval for first key >= target
+    const uint32_t limit = entry + 1 < num_restarts_
+                               ? GetRestartPoint(entry + 1)
+                               : restarts_;
+    SeekToRestartPoint(entry);
+    while (ParseNextKey()) {
+      if (current_ >= limit) {
+        break;
+      }
+      if (Compare(key_, target) >= 0) {
+        return true;
+      }
+    }
+    if (status_.ok()) {
+      // No visible entry for the user key in its interval.
+      current_ = restarts_;
+      restart_index_ = num_restarts_;
+    }
+    return true;
+  }
+
   bool ParseNextKey() {
     current_ = NextEntryOffset();
     const char* p = data_ + current_;
@@ -277,15 +330,17 @@ class Block::Iter : public Iterator {
   }
 };
 
-Iterator* Block::NewIterator(const Comparator* comparator) {
+Iterator* Block::NewIterator(const Comparator* comparator, bool point_lookup,
+                             bool internal_keys) {
   if (size_ < sizeof(uint32_t)) {
     return NewErrorIterator(Status::Corruption("bad block contents"));
   }
-  const uint32_t num_restarts = NumRestarts();
-  if (num_restarts == 0) {
+  if (num_restarts_ == 0) {
     return NewEmptyIterator();
   } else {
-    return new Iter(comparator, data_, restart_offset_, num_restarts);
+    return new Iter(comparator, data_, restart_offset_, num_restarts_,
+                    point_lookup && has_hash_index_ ? &hash_index_ : nullptr,
+                    internal_keys);
   }
 }
 
@@ -9,6 +9,7 @@
 #include <cstdint>
 
 #include "leveldb/iterator.h"
+#include "table/data_block_hash_index.h"
 
 namespace leveldb {
 
@@ -26,17 +27,29 @@ class Block {
   ~Block();
 
   size_t size() const { return size_; }
-  Iterator* NewIterator(const Comparator* comparator);
+  const char* data() const { return data_; }
+
+  // If "point_lookup" is true, Seek() on the returned iterator uses the
+  // block's hash index (when it has one) to go straight to the restart
+  // interval holding the user key of the target, and leaves the iterator
+  // !Valid() if the index proves that user key absent from the block.
+  // Such iterators are only meant for point lookups: they do not find the
+  // first entry >= target when its user key differs from the target's.
+  // "internal_keys" must match what the builder was told through
+  // BlockBuilder::set_internal_keys().
+  Iterator* NewIterator(const Comparator* comparator,
+                        bool point_lookup = false, bool internal_keys = false);
 
  private:
   class Iter;
 
-  uint32_t NumRestarts() const;
-
   const char* data_;
   size_t size_;
   uint32_t restart_offset_;  // Offset in data_ of restart array
-  bool owned_;               // Block owns data_[]
+  uint32_t num_restarts_;
+  bool has_hash_index_;
+  DataBlockHashIndex hash_index_;
+  bool owned_;  // Block owns data_[]
 };
 
 }  // namespace leveldb
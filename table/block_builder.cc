@@ -25,6 +25,10 @@
 //     restarts: uint32[num_restarts]
 //     num_restarts: uint32
 // restarts[i] contains the offset within the block of the ith restart point.
+//
+// If Options::data_block_hash_index is set, a hash index is inserted
+// between the restart array and num_restarts, and the top bit of the
+// trailing word is set (see data_block_hash_index.h).
 
 #include "table/block_builder.h"
 
@@ -38,7 +42,12 @@
 namespace leveldb {
 
 BlockBuilder::BlockBuilder(const Options* options)
-    : options_(options), restarts_(), counter_(0), finished_(false) {
+    : options_(options),
+      restarts_(),
+      counter_(0),
+      finished_(false),
+      use_hash_index_(options->data_block_hash_index),
+      internal_keys_(false) {
   assert(options->block_restart_interval >= 1);
   restarts_.push_back(0);  // First restart point is at offset 0
 }
@@ -50,12 +59,15 @@ void BlockBuilder::Reset() {
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
+  use_hash_index_ = options_->data_block_hash_index;
+  hash_index_.Reset();
 }
 
 size_t BlockBuilder::CurrentSizeEstimate() const {
   return (buffer_.size() +                       // Raw data buffer
           restarts_.size() * sizeof(uint32_t) +  // Restart array
-          sizeof(uint32_t));                     // Restart array length
+          (use_hash_index_ ? hash_index_.EstimatedSize() : 0) +
+          sizeof(uint32_t));  // Restart array length
 }
 
 Slice BlockBuilder::Finish() {
@@ -63,7 +75,13 @@ Slice BlockBuilder::Finish() {
   for (size_t i = 0; i < restarts_.size(); i++) {
     PutFixed32(&buffer_, restarts_[i]);
   }
-  PutFixed32(&buffer_, restarts_.size());
+  uint32_t footer = restarts_.size();
+  if (use_hash_index_ && restarts_.size() <= kMaxRestartsForHashIndex) {
+    // Blocks with too many restart points to index are left without one.
+    hash_index_.Finish(&buffer_);
+    footer |= kDataBlockHashIndexFlag;
+  }
+  PutFixed32(&buffer_, footer);
   finished_ = true;
   return Slice(buffer_);
 }
@@ -97,6 +115,11 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
   buffer_.append(key.data() + shared, non_shared);
   buffer_.append(value.data(), value.size());
 
+  if (use_hash_index_ && restarts_.size() <= kMaxRestartsForHashIndex) {
+    hash_index_.Add(DataBlockHashKey(key, internal_keys_),
+                    restarts_.size() - 1);
+  }
+
   // Update state
   last_key_.resize(shared);
   last_key_.append(key.data() + shared, non_shared);
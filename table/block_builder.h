@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "leveldb/slice.h"
+#include "table/data_block_hash_index.h"
 
 namespace leveldb {
 
@@ -40,6 +41,12 @@ class BlockBuilder {
   // Return true iff no entries have been added since the last Reset()
   bool empty() const { return buffer_.empty(); }
 
+  // Whether the added keys are DB internal keys; see DataBlockHashKey().
+  // REQUIRES: Add() has not been called.
+  void set_internal_keys(bool internal_keys) {
+    internal_keys_ = internal_keys;
+  }
+
  private:
   const Options* options_;
   std::string buffer_;              // Destination buffer
@@ -47,6 +54,9 @@ class BlockBuilder {
   int counter_;                     // Number of entries emitted since restart
   bool finished_;                   // Has Finish() been called?
   std::string last_key_;
+  bool use_hash_index_;  // Snapshot of options_->data_block_hash_index
+  bool internal_keys_;
+  DataBlockHashIndexBuilder hash_index_;
 };
 
 }  // namespace leveldb
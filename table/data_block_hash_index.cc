@@ -0,0 +1,77 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "table/data_block_hash_index.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "util/hash.h"
+
+namespace leveldb {
+
+// Target number of entries per bucket.
+static const double kUtilRatio = 0.75;
+
+static const uint32_t kHashSeed = 0x5a3c17e9;
+
+static inline uint32_t HashKey(const Slice& hash_key) {
+  return Hash(hash_key.data(), hash_key.size(), kHashSeed);
+}
+
+void DataBlockHashIndexBuilder::Add(const Slice& hash_key,
+                                    uint32_t restart_index) {
+  assert(restart_index < kMaxRestartsForHashIndex);
+  entries_.emplace_back(HashKey(hash_key),
+                        static_cast<uint8_t>(restart_index));
+}
+
+size_t DataBlockHashIndexBuilder::NumBuckets() const {
+  size_t n = static_cast<size_t>(entries_.size() / kUtilRatio) + 1;
+  return std::min<size_t>(n, 0xffff);
+}
+
+size_t DataBlockHashIndexBuilder::EstimatedSize() const {
+  return NumBuckets() + sizeof(uint16_t);
+}
+
+void DataBlockHashIndexBuilder::Finish(std::string* dst) const {
+  const size_t num_buckets = NumBuckets();
+  std::string buckets(num_buckets, static_cast<char>(kNoEntry));
+  for (const auto& entry : entries_) {
+    char& bucket = buckets[entry.first % num_buckets];
+    const uint8_t current = static_cast<uint8_t>(bucket);
+    if (current == kNoEntry) {
+      bucket = static_cast<char>(entry.second);
+    } else if (current != entry.second) {
+      bucket = static_cast<char>(kCollision);
+    }
+  }
+  dst->append(buckets);
+  dst->push_back(static_cast<char>(num_buckets & 0xff));
+  dst->push_back(static_cast<char>(num_buckets >> 8));
+}
+
+bool DataBlockHashIndex::Initialize(const char* data, size_t limit,
+                                    size_t* buckets_start) {
+  if (limit < sizeof(uint16_t)) {
+    return false;
+  }
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data + limit) - 2;
+  const uint16_t num_buckets = static_cast<uint16_t>(p[0] | (p[1] << 8));
+  if (num_buckets == 0 || num_buckets > limit - sizeof(uint16_t)) {
+    return false;
+  }
+  num_buckets_ = num_buckets;
+  *buckets_start = limit - sizeof(uint16_t) - num_buckets;
+  buckets_ = reinterpret_cast<const uint8_t*>(data + *buckets_start);
+  return true;
+}
+
+uint8_t DataBlockHashIndex::Lookup(const Slice& hash_key) const {
+  assert(num_buckets_ > 0);
+  return buckets_[HashKey(hash_key) % num_buckets_];
+}
+
+}  // namespace leveldb
@@ -0,0 +1,93 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// An optional hash index stored at the end of a data block.  It maps the
+// hash of each user key in the block to the restart interval holding that
+// key, so that point lookups can skip the binary search over the restart
+// array.
+//
+// The index is placed between the restart array and the block trailer:
+//     restarts:    uint32[num_restarts]
+//     buckets:     uint8[num_buckets]
+//     num_buckets: uint16
+//     footer:      uint32 (num_restarts | kDataBlockHashIndexFlag)
+// Each bucket holds the index of a restart interval, kNoEntry if no key
+// hashes to it, or kCollision if keys from several intervals do.
+
+#ifndef STORAGE_LEVELDB_TABLE_DATA_BLOCK_HASH_INDEX_H_
+#define STORAGE_LEVELDB_TABLE_DATA_BLOCK_HASH_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+// Set in the block footer when a hash index is present.
+static const uint32_t kDataBlockHashIndexFlag = 1u << 31;
+
+// Bucket values with a special meaning.  Restart interval indexes must be
+// smaller than kMaxRestartsForHashIndex to be representable.
+static const uint8_t kNoEntry = 255;
+static const uint8_t kCollision = 254;
+static const uint32_t kMaxRestartsForHashIndex = 254;
+
+// Returns the part of a block key that is hashed: the user key if the
+// block holds DB internal keys, and the whole key otherwise.
+inline Slice DataBlockHashKey(const Slice& key, bool internal_keys) {
+  if (internal_keys && key.size() >= 8) {
+    return Slice(key.data(), key.size() - 8);
+  }
+  return key;
+}
+
+class DataBlockHashIndexBuilder {
+ public:
+  DataBlockHashIndexBuilder() = default;
+
+  DataBlockHashIndexBuilder(const DataBlockHashIndexBuilder&) = delete;
+  DataBlockHashIndexBuilder& operator=(const DataBlockHashIndexBuilder&) =
+      delete;
+
+  void Add(const Slice& hash_key, uint32_t restart_index);
+
+  // Appends the buckets and bucket count to *dst.
+  void Finish(std::string* dst) const;
+
+  // Returns the number of bytes Finish() would append.
+  size_t EstimatedSize() const;
+
+  void Reset() { entries_.clear(); }
+
+ private:
+  size_t NumBuckets() const;
+
+  std::vector<std::pair<uint32_t, uint8_t>> entries_;  // (hash, restart)
+};
+
+class DataBlockHashIndex {
+ public:
+  DataBlockHashIndex() : buckets_(nullptr), num_buckets_(0) {}
+
+  // Parses the bucket count stored just before "limit" (the block footer).
+  // On success, sets *buckets_start to the offset within "data" where the
+  // buckets begin and returns true.
+  bool Initialize(const char* data, size_t limit, size_t* buckets_start);
+
+  // Returns the restart interval that may hold "hash_key", or kNoEntry or
+  // kCollision.
+  uint8_t Lookup(const Slice& hash_key) const;
+
+ private:
+  const uint8_t* buckets_;
+  uint16_t num_buckets_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_DATA_BLOCK_HASH_INDEX_H_
@@ -15,6 +15,10 @@ namespace leveldb {
 static const size_t kFilterBaseLg = 11;
 static const size_t kFilterBase = 1 << kFilterBaseLg;
 
+// Number of keys a full filter must hold before its size is sampled to
+// calibrate FullFilterBlockBuilder::EstimatedSize().
+static const size_t kFilterCalibrationKeys = 64;
+
 FilterBlockBuilder::FilterBlockBuilder(const FilterPolicy* policy)
     : policy_(policy) {}
 
@@ -103,4 +107,57 @@ bool FilterBlockReader::KeyMayMatch(uint64_t block_offset, const Slice& key) {
   return true;  // Errors are treated as potential matches
 }
 
+
+FullFilterBlockBuilder::FullFilterBlockBuilder(const FilterPolicy* policy)
+    : policy_(policy), bytes_per_key_(0) {}
+
+void FullFilterBlockBuilder::AddKey(const Slice& key) {
+  start_.push_back(keys_.size());
+  keys_.append(key.data(), key.size());
+}
+
+size_t FullFilterBlockBuilder::EstimatedSize() {
+  if (bytes_per_key_ == 0) {
+    if (start_.size() < kFilterCalibrationKeys) {
+      return 0;
+    }
+    // The filter policy is opaque, so sample the size of one filter over
+    // the pending keys and assume it scales linearly with the key count.
+    std::string sample;
+    GenerateFilter(&sample);
+    bytes_per_key_ = static_cast<double>(sample.size()) / start_.size();
+  }
+  return static_cast<size_t>(bytes_per_key_ * start_.size());
+}
+
+Slice FullFilterBlockBuilder::Finish() {
+  result_.clear();
+  if (!start_.empty()) {
+    GenerateFilter(&result_);
+    keys_.clear();
+    start_.clear();
+  }
+  return Slice(result_);
+}
+
+void FullFilterBlockBuilder::GenerateFilter(std::string* dst) {
+  const size_t num_keys = start_.size();
+  tmp_keys_.resize(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    const char* base = keys_.data() + start_[i];
+    size_t length =
+        (i + 1 < num_keys ? start_[i + 1] : keys_.size()) - start_[i];
+    tmp_keys_[i] = Slice(base, length);
+  }
+  policy_->CreateFilter(&tmp_keys_[0], static_cast<int>(num_keys), dst);
+  tmp_keys_.clear();
+}
+
+bool FullFilterBlockReader::KeyMayMatch(const Slice& key) const {
+  if (contents_.empty()) {
+    return true;  // Errors are treated as potential matches
+  }
+  return policy_->KeyMayMatch(key, contents_);
+}
+
 }  // namespace leveldb
@@ -4,7 +4,9 @@
 //
 // A filter block is stored near the end of a Table file.  It contains
 // filters (e.g., bloom filters) for all data blocks in the table combined
-// into a single filter block.
+// into a single filter block.  A table may instead carry one "full"
+// filter over all of its keys, optionally split into partitions that are
+// located through a small top-level index (see doc/table_format.md).
 
 #ifndef STORAGE_LEVELDB_TABLE_FILTER_BLOCK_H_
 #define STORAGE_LEVELDB_TABLE_FILTER_BLOCK_H_
@@ -63,6 +65,57 @@ class FilterBlockReader {
   size_t base_lg_;      // Encoding parameter (see kFilterBaseLg in .cc file)
 };
 
+// A FullFilterBlockBuilder generates a single filter covering every key
+// added since construction (or since the previous call to Finish()).  It is
+// used both for whole-table filters and for the partitions of a
+// partitioned filter.
+//
+// The sequence of calls to FullFilterBlockBuilder must match the regexp:
+//      (AddKey* Finish)*
+class FullFilterBlockBuilder {
+ public:
+  explicit FullFilterBlockBuilder(const FilterPolicy*);
+
+  FullFilterBlockBuilder(const FullFilterBlockBuilder&) = delete;
+  FullFilterBlockBuilder& operator=(const FullFilterBlockBuilder&) = delete;
+
+  void AddKey(const Slice& key);
+
+  // Return true iff no keys have been added since the last Finish().
+  bool empty() const { return start_.empty(); }
+
+  // Returns an estimate of the size of the filter that Finish() would
+  // generate for the keys added so far.  Returns 0 until enough keys
+  // have been seen to calibrate the estimate.
+  size_t EstimatedSize();
+
+  // Build the filter for the pending keys and reset the key set.  The
+  // returned slice remains valid until the next call to Finish().
+  Slice Finish();
+
+ private:
+  void GenerateFilter(std::string* dst);
+
+  const FilterPolicy* policy_;
+  std::string keys_;             // Flattened key contents
+  std::vector<size_t> start_;    // Starting index in keys_ of each key
+  std::string result_;           // Filter data returned by Finish()
+  std::vector<Slice> tmp_keys_;  // policy_->CreateFilter() argument
+  double bytes_per_key_;         // Calibrated by EstimatedSize()
+};
+
+class FullFilterBlockReader {
+ public:
+  // REQUIRES: "contents" and *policy must stay live while *this is live.
+  FullFilterBlockReader(const FilterPolicy* policy, const Slice& contents)
+      : policy_(policy), contents_(contents) {}
+  bool KeyMayMatch(const Slice& key) const;
+
+ private:
+  const FilterPolicy* policy_;
+  Slice contents_;
+};
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_TABLE_FILTER_BLOCK_H_
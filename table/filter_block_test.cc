@@ -119,6 +119,57 @@ TEST_F(FilterBlockTest, MultiChunk) {
   ASSERT_TRUE(!reader.KeyMayMatch(9000, "bar"));
 }
 
+TEST_F(FilterBlockTest, FullFilterEmptyBuilder) {
+  FullFilterBlockBuilder builder(&policy_);
+  ASSERT_TRUE(builder.empty());
+  ASSERT_EQ(0, builder.EstimatedSize());
+  Slice block = builder.Finish();
+  ASSERT_EQ("", EscapeString(block));
+  FullFilterBlockReader reader(&policy_, block);
+  ASSERT_TRUE(reader.KeyMayMatch("foo"));
+}
+
+TEST_F(FilterBlockTest, FullFilter) {
+  FullFilterBlockBuilder builder(&policy_);
+  builder.AddKey("foo");
+  builder.AddKey("bar");
+  builder.AddKey("box");
+  ASSERT_TRUE(!builder.empty());
+  Slice block = builder.Finish();
+  ASSERT_TRUE(builder.empty());
+  FullFilterBlockReader reader(&policy_, block);
+  ASSERT_TRUE(reader.KeyMayMatch("foo"));
+  ASSERT_TRUE(reader.KeyMayMatch("bar"));
+  ASSERT_TRUE(reader.KeyMayMatch("box"));
+  ASSERT_TRUE(!reader.KeyMayMatch("hello"));
+  ASSERT_TRUE(!reader.KeyMayMatch("missing"));
+}
+
+TEST_F(FilterBlockTest, FullFilterPartitions) {
+  FullFilterBlockBuilder builder(&policy_);
+  builder.AddKey("foo");
+  std::string first = builder.Finish().ToString();
+  builder.AddKey("bar");
+  std::string second = builder.Finish().ToString();
+
+  FullFilterBlockReader first_reader(&policy_, first);
+  ASSERT_TRUE(first_reader.KeyMayMatch("foo"));
+  ASSERT_TRUE(!first_reader.KeyMayMatch("bar"));
+  FullFilterBlockReader second_reader(&policy_, second);
+  ASSERT_TRUE(second_reader.KeyMayMatch("bar"));
+  ASSERT_TRUE(!second_reader.KeyMayMatch("foo"));
+}
+
+TEST_F(FilterBlockTest, FullFilterEstimatedSize) {
+  FullFilterBlockBuilder builder(&policy_);
+  for (int i = 0; i < 1000; i++) {
+    builder.AddKey(std::to_string(i));
+  }
+  // TestHashFilter emits four bytes per key.
+  ASSERT_EQ(4000, builder.EstimatedSize());
+  ASSERT_EQ(4000, builder.Finish().size());
+}
+
 }  // namespace leveldb
 
 int main(int argc, char** argv) {
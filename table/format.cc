@@ -4,11 +4,14 @@
 
 #include "table/format.h"
 
+#include <vector>
+
 #include "leveldb/env.h"
 #include "port/port.h"
 #include "table/block.h"
 #include "util/coding.h"
 #include "util/crc32c.h"
+#include "util/perf_context_imp.h"
 
 namespace leveldb {
 
@@ -33,8 +36,10 @@ void Footer::EncodeTo(std::string* dst) const {
   metaindex_handle_.EncodeTo(dst);
   index_handle_.EncodeTo(dst);
   dst->resize(2 * BlockHandle::kMaxEncodedLength);  // Padding
-  PutFixed32(dst, static_cast<uint32_t>(kTableMagicNumber & 0xffffffffu));
-  PutFixed32(dst, static_cast<uint32_t>(kTableMagicNumber >> 32));
+  const uint64_t magic = partitioned_index_ ? kPartitionedIndexTableMagicNumber
+                                            : kTableMagicNumber;
+  PutFixed32(dst, static_cast<uint32_t>(magic & 0xffffffffu));
+  PutFixed32(dst, static_cast<uint32_t>(magic >> 32));
   assert(dst->size() == original_size + kEncodedLength);
   (void)original_size;  // Disable unused variable warning.
 }
@@ -45,9 +50,11 @@ Status Footer::DecodeFrom(Slice* input) {
   const uint32_t magic_hi = DecodeFixed32(magic_ptr + 4);
   const uint64_t magic = ((static_cast<uint64_t>(magic_hi) << 32) |
                           (static_cast<uint64_t>(magic_lo)));
-  if (magic != kTableMagicNumber) {
+  if (magic != kTableMagicNumber &&
+      magic != kPartitionedIndexTableMagicNumber) {
     return Status::Corruption("not an sstable (bad magic number)");
   }
+  partitioned_index_ = (magic == kPartitionedIndexTableMagicNumber);
 
   Status result = metaindex_handle_.DecodeFrom(input);
   if (result.ok()) {
@@ -61,22 +68,11 @@ Status Footer::DecodeFrom(Slice* input) {
   return result;
 }
 
-Status ReadBlock(RandomAccessFile* file, const ReadOptions& options,
-                 const BlockHandle& handle, BlockContents* result) {
-  result->data = Slice();
-  result->cachable = false;
-  result->heap_allocated = false;
-
-  // Read the block contents as well as the type/crc footer.
-  // See table_builder.cc for the code that built this structure.
-  size_t n = static_cast<size_t>(handle.size());
-  char* buf = new char[n + kBlockTrailerSize];
-  Slice contents;
-  Status s = file->Read(handle.offset(), n + kBlockTrailerSize, &contents, buf);
-  if (!s.ok()) {
-    delete[] buf;
-    return s;
-  }
+// Verifies and uncompresses the block of "n" bytes plus trailer that a
+// read into "buf" returned as "contents".  Takes ownership of "buf".
+static Status DecodeBlock(const ReadOptions& options, size_t n, char* buf,
+                          const Slice& contents, BlockContents* result) {
+  Status s;
   if (contents.size() != n + kBlockTrailerSize) {
     delete[] buf;
     return Status::Corruption("truncated block read");
@@ -138,4 +134,63 @@ Status ReadBlock(RandomAccessFile* file, const ReadOptions& options,
   return Status::OK();
 }
 
+Status ReadBlock(RandomAccessFile* file, const ReadOptions& options,
+                 const BlockHandle& handle, BlockContents* result) {
+  result->data = Slice();
+  result->cachable = false;
+  result->heap_allocated = false;
+
+  // Read the block contents as well as the type/crc footer.
+  // See table_builder.cc for the code that built this structure.
+  size_t n = static_cast<size_t>(handle.size());
+  char* buf = new char[n + kBlockTrailerSize];
+  Slice contents;
+  Status s;
+  {
+    PerfTimer block_timer(&perf_context.block_read_nanos);
+    PerfTimer read_timer(&iostats_context.read_nanos);
+    s = file->Read(handle.offset(), n + kBlockTrailerSize, &contents, buf);
+  }
+  if (!s.ok()) {
+    delete[] buf;
+    return s;
+  }
+  PerfCount(&perf_context.block_read_count);
+  PerfCount(&perf_context.block_read_byte, contents.size());
+  PerfCount(&iostats_context.bytes_read, contents.size());
+  return DecodeBlock(options, n, buf, contents, result);
+}
+
+void ReadBlocks(RandomAccessFile* file, const ReadOptions& options,
+                const BlockHandle* handles, size_t num_blocks,
+                BlockContents* results, Status* statuses) {
+  std::vector<RandomAccessFile::ReadRequest> reqs(num_blocks);
+  for (size_t i = 0; i < num_blocks; i++) {
+    results[i].data = Slice();
+    results[i].cachable = false;
+    results[i].heap_allocated = false;
+    reqs[i].offset = handles[i].offset();
+    reqs[i].n = static_cast<size_t>(handles[i].size()) + kBlockTrailerSize;
+    reqs[i].scratch = new char[reqs[i].n];
+  }
+  {
+    PerfTimer block_timer(&perf_context.block_read_nanos);
+    PerfTimer read_timer(&iostats_context.read_nanos);
+    file->MultiRead(reqs.data(), num_blocks);
+  }
+  for (size_t i = 0; i < num_blocks; i++) {
+    if (!reqs[i].status.ok()) {
+      delete[] reqs[i].scratch;
+      statuses[i] = reqs[i].status;
+    } else {
+      PerfCount(&perf_context.block_read_count);
+      PerfCount(&perf_context.block_read_byte, reqs[i].result.size());
+      PerfCount(&iostats_context.bytes_read, reqs[i].result.size());
+      statuses[i] =
+          DecodeBlock(options, static_cast<size_t>(handles[i].size()),
+                      reqs[i].scratch, reqs[i].result, &results[i]);
+    }
+  }
+}
+
 }  // namespace leveldb
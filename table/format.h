@@ -62,12 +62,18 @@ class Footer {
   const BlockHandle& index_handle() const { return index_handle_; }
   void set_index_handle(const BlockHandle& h) { index_handle_ = h; }
 
+  // True iff the index block is the top level of a partitioned index,
+  // i.e. its entries point at index partitions rather than data blocks.
+  bool partitioned_index() const { return partitioned_index_; }
+  void set_partitioned_index(bool p) { partitioned_index_ = p; }
+
   void EncodeTo(std::string* dst) const;
   Status DecodeFrom(Slice* input);
 
  private:
   BlockHandle metaindex_handle_;
   BlockHandle index_handle_;
+  bool partitioned_index_ = false;
 };
 
 // kTableMagicNumber was picked by running
@@ -75,6 +81,12 @@ class Footer {
 // and taking the leading 64 bits.
 static const uint64_t kTableMagicNumber = 0xdb4775248b80fb57ull;
 
+// Magic number of tables with a partitioned index.  It differs from
+// kTableMagicNumber so that readers unaware of partitioned indexes reject
+// such tables instead of misreading index partitions as data blocks.
+static const uint64_t kPartitionedIndexTableMagicNumber =
+    0xdb4775248b80fb58ull;
+
 // 1-byte type + 32-bit crc
 static const size_t kBlockTrailerSize = 5;
 
@@ -89,6 +101,13 @@ struct BlockContents {
 Status ReadBlock(RandomAccessFile* file, const ReadOptions& options,
                  const BlockHandle& handle, BlockContents* result);
 
+// Read the blocks identified by handles[0..num_blocks-1] from "file" in a
+// single RandomAccessFile::MultiRead() batch.  Fills results[i] and sets
+// statuses[i] as ReadBlock() would for handles[i].
+void ReadBlocks(RandomAccessFile* file, const ReadOptions& options,
+                const BlockHandle* handles, size_t num_blocks,
+                BlockContents* results, Status* statuses);
+
 // Implementation details follow.  Clients should ignore,
 
 inline BlockHandle::BlockHandle()
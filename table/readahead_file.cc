@@ -0,0 +1,81 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "table/readahead_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace leveldb {
+
+ReadaheadFile::ReadaheadFile(RandomAccessFile* file, uint64_t file_size,
+                             size_t initial_size, size_t max_size, int trigger)
+    : file_(file),
+      file_size_(file_size),
+      initial_size_(initial_size),
+      max_size_(std::max(initial_size, max_size)),
+      trigger_(trigger),
+      in_memory_(false),
+      window_offset_(0),
+      window_size_(0),
+      next_offset_(0),
+      sequential_reads_(0),
+      readahead_size_(initial_size) {}
+
+ReadaheadFile::~ReadaheadFile() = default;
+
+Status ReadaheadFile::Read(uint64_t offset, size_t n, Slice* result,
+                           char* scratch) const {
+  if (in_memory_) {
+    return file_->Read(offset, n, result, scratch);
+  }
+
+  if (offset < window_offset_ || offset + n > window_offset_ + window_size_) {
+    // Not in the window: read directly, or fetch a new window.
+    if (offset == next_offset_) {
+      sequential_reads_++;
+    } else {
+      sequential_reads_ = 0;
+      readahead_size_ = initial_size_;
+    }
+    next_offset_ = offset + n;
+    if (sequential_reads_ < trigger_ || offset >= file_size_) {
+      return file_->Read(offset, n, result, scratch);
+    }
+
+    size_t size = std::max(n, readahead_size_);
+    if (offset + size > file_size_) {
+      size = std::max<uint64_t>(n, file_size_ - offset);
+    }
+    buf_.resize(size);
+    Slice window;
+    Status s = file_->Read(offset, size, &window, &buf_[0]);
+    window_size_ = 0;
+    if (!s.ok()) {
+      return s;
+    }
+    if (window.data() != buf_.data()) {
+      // The file hands out its own memory; copying it would only cost.
+      in_memory_ = true;
+      std::string().swap(buf_);
+      *result = Slice(window.data(), std::min(n, window.size()));
+      return s;
+    }
+    window_offset_ = offset;
+    window_size_ = window.size();
+    readahead_size_ = std::min(readahead_size_ * 2, max_size_);
+  } else {
+    next_offset_ = offset + n;
+  }
+
+  // Serve from the window.  Callers keep the result beyond the next read,
+  // so it is copied out.
+  const size_t skip = offset - window_offset_;
+  n = std::min(n, window_size_ - skip);
+  std::memcpy(scratch, buf_.data() + skip, n);
+  *result = Slice(scratch, n);
+  return Status::OK();
+}
+
+}  // namespace leveldb
@@ -0,0 +1,63 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_TABLE_READAHEAD_FILE_H_
+#define STORAGE_LEVELDB_TABLE_READAHEAD_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+// A RandomAccessFile that serves sequential reads of "file" from windows
+// read ahead of the caller.
+//
+// Once "trigger" reads in a row have each started where the previous one
+// ended, a read fetches "initial_size" bytes (or more, if the read itself
+// is larger) into a private buffer, and the following reads are served from
+// there.  Each new window is twice the size of the previous one, up to
+// "max_size".  A read elsewhere in the file starts over.  With a trigger of
+// zero, every read outside the window fetches a window.
+//
+// Files that serve reads from memory (e.g. mmap) are passed through.
+//
+// Not thread-safe: meant to be owned by a single iterator.
+class ReadaheadFile : public RandomAccessFile {
+ public:
+  // "file" must outlive this object.  "file_size" bounds the windows.
+  ReadaheadFile(RandomAccessFile* file, uint64_t file_size,
+                size_t initial_size, size_t max_size, int trigger);
+
+  ReadaheadFile(const ReadaheadFile&) = delete;
+  ReadaheadFile& operator=(const ReadaheadFile&) = delete;
+
+  ~ReadaheadFile() override;
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override;
+
+ private:
+  RandomAccessFile* const file_;
+  const uint64_t file_size_;
+  const size_t initial_size_;
+  const size_t max_size_;
+  const int trigger_;
+
+  mutable bool in_memory_;  // True once file_ was seen to return memory.
+  mutable std::string buf_;
+  mutable uint64_t window_offset_;  // File offset of buf_[0]
+  mutable size_t window_size_;      // Valid bytes at the start of buf_
+  mutable uint64_t next_offset_;    // Where the previous read ended
+  mutable int sequential_reads_;
+  mutable size_t readahead_size_;  // Size of the next window
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_READAHEAD_FILE_H_
@@ -4,22 +4,35 @@
 
 #include "leveldb/table.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "leveldb/cache.h"
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
 #include "leveldb/options.h"
+#include "port/port.h"
 #include "table/block.h"
 #include "table/filter_block.h"
 #include "table/format.h"
+#include "table/readahead_file.h"
+#include "table/table_internal.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
+#include "util/mutexlock.h"
+#include "util/perf_context_imp.h"
+#include "util/statistics.h"
 
 namespace leveldb {
 
 struct Table::Rep {
   ~Rep() {
+    for (Cache::Handle* handle : pinned_handles) {
+      options.block_cache->Release(handle);
+    }
     delete filter;
+    delete full_filter;
     delete[] filter_data;
     delete index_block;
   }
@@ -28,13 +41,93 @@ struct Table::Rep {
   Status status;
   RandomAccessFile* file;
   uint64_t cache_id;
-  FilterBlockReader* filter;
+  FilterBlockReader* filter;          // Per-2KB filters (kBlockBasedFilter)
+  FullFilterBlockReader* full_filter;  // Whole-table filter (kFullFilter)
   const char* filter_data;
 
+  // Encoded handle of the top-level index of a partitioned filter, or empty
+  // if the table has none.  The index and its partitions are read lazily
+  // through the block cache.
+  std::string filter_index_handle;
+
+  // If true, the index block and the full or block-based filter are read
+  // on demand through the block cache instead of being owned by the table;
+  // index_block, filter and full_filter are then null.
+  bool cache_meta_blocks;
+  std::string cached_filter_handle;  // Encoded handle of the filter, if any
+  bool cached_full_filter;
+  bool internal_keys;  // See TableInternal::SetInternalKeys()
+
+  // Block cache entries held open by PinMetaBlocks().
+  port::Mutex pin_mutex;
+  std::atomic<bool> pinned;
+  std::vector<Cache::Handle*> pinned_handles;
+
   BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
-  Block* index_block;
+  std::string index_handle;      // Encoded handle to the (top-level) index
+  Block* index_block;  // Top-level index if partitioned_index is set
+  bool partitioned_index;
+  uint64_t file_size;
+};
+
+static void DeleteBlock(void* arg, void* ignored) {
+  delete reinterpret_cast<Block*>(arg);
+}
+
+static void DeleteCachedBlock(const Slice& key, void* value) {
+  Block* block = reinterpret_cast<Block*>(value);
+  delete block;
+}
+
+static Slice SaveCachedBlock(void* value) {
+  Block* block = reinterpret_cast<Block*>(value);
+  return Slice(block->data(), block->size());
+}
+
+static void ReleaseBlock(void* arg, void* h) {
+  Cache* cache = reinterpret_cast<Cache*>(arg);
+  Cache::Handle* handle = reinterpret_cast<Cache::Handle*>(h);
+  cache->Release(handle);
+}
+
+// Cached form of a filter block or of one partition of a partitioned
+// filter.
+struct CachedFilter {
+  Slice data;
+  bool heap_allocated;
 };
 
+static void DeleteFilter(CachedFilter* filter) {
+  if (filter->heap_allocated) {
+    delete[] filter->data.data();
+  }
+  delete filter;
+}
+
+static void DeleteCachedFilter(const Slice& key, void* value) {
+  DeleteFilter(reinterpret_cast<CachedFilter*>(value));
+}
+
+static Slice SaveCachedFilter(void* value) {
+  return reinterpret_cast<CachedFilter*>(value)->data;
+}
+
+// Looks "key" up in the tier below "block_cache".  On a hit, fills
+// *contents with a heap-allocated copy of the saved block.
+static bool ReadFromSecondaryCache(Cache* block_cache, const Slice& key,
+                                   BlockContents* contents) {
+  std::string saved;
+  if (!block_cache->LookupSecondary(key, &saved)) {
+    return false;
+  }
+  char* buf = new char[saved.size()];
+  std::memcpy(buf, saved.data(), saved.size());
+  contents->data = Slice(buf, saved.size());
+  contents->cachable = true;
+  contents->heap_allocated = true;
+  return true;
+}
+
 Status Table::Open(const Options& options, RandomAccessFile* file,
                    uint64_t size, Table** table) {
   *table = nullptr;
@@ -68,10 +161,34 @@ Status Table::Open(const Options& options, RandomAccessFile* file,
     rep->options = options;
     rep->file = file;
     rep->metaindex_handle = footer.metaindex_handle();
+    footer.index_handle().EncodeTo(&rep->index_handle);
     rep->index_block = index_block;
+    rep->partitioned_index = footer.partitioned_index();
+    rep->file_size = size;
     rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
     rep->filter_data = nullptr;
     rep->filter = nullptr;
+    rep->full_filter = nullptr;
+    rep->cache_meta_blocks =
+        options.cache_index_and_filter_blocks && options.block_cache;
+    rep->cached_full_filter = false;
+    rep->internal_keys = false;
+    rep->pinned = false;
+    if (rep->cache_meta_blocks) {
+      // Hand the index block over to the block cache.
+      rep->index_block = nullptr;
+      if (index_block_contents.cachable) {
+        char cache_key_buffer[16];
+        EncodeFixed64(cache_key_buffer, rep->cache_id);
+        EncodeFixed64(cache_key_buffer + 8, footer.index_handle().offset());
+        options.block_cache->Release(options.block_cache->Insert(
+            Slice(cache_key_buffer, sizeof(cache_key_buffer)), index_block,
+            index_block->size(), &DeleteCachedBlock, Cache::kHighPriority,
+            &SaveCachedBlock));
+      } else {
+        delete index_block;
+      }
+    }
     *table = new Table(rep);
     (*table)->ReadMeta(footer);
   }
@@ -97,18 +214,35 @@ void Table::ReadMeta(const Footer& footer) {
   }
   Block* meta = new Block(contents);
 
+  // A table holds at most one kind of filter; look for each of them.
+  static const char* const kFilterPrefixes[] = {"filter.", "fullfilter.",
+                                                "partitionedfilter."};
   Iterator* iter = meta->NewIterator(BytewiseComparator());
-  std::string key = "filter.";
-  key.append(rep_->options.filter_policy->Name());
-  iter->Seek(key);
-  if (iter->Valid() && iter->key() == Slice(key)) {
-    ReadFilter(iter->value());
+  for (int i = 0; i < 3; i++) {
+    std::string key = kFilterPrefixes[i];
+    key.append(rep_->options.filter_policy->Name());
+    iter->Seek(key);
+    if (iter->Valid() && iter->key() == Slice(key)) {
+      if (i == 2) {
+        rep_->filter_index_handle = iter->value().ToString();
+      } else {
+        ReadFilter(iter->value(), i == 1);
+      }
+      break;
+    }
   }
   delete iter;
   delete meta;
 }
 
-void Table::ReadFilter(const Slice& filter_handle_value) {
+void Table::ReadFilter(const Slice& filter_handle_value, bool full_filter) {
+  if (rep_->cache_meta_blocks) {
+    // Read on demand through the block cache.
+    rep_->cached_filter_handle = filter_handle_value.ToString();
+    rep_->cached_full_filter = full_filter;
+    return;
+  }
+
   Slice v = filter_handle_value;
   BlockHandle filter_handle;
   if (!filter_handle.DecodeFrom(&v).ok()) {
@@ -128,34 +262,39 @@ void Table::ReadFilter(const Slice& filter_handle_value) {
   if (block.heap_allocated) {
     rep_->filter_data = block.data.data();  // Will need to delete later
   }
-  rep_->filter = new FilterBlockReader(rep_->options.filter_policy, block.data);
+  if (full_filter) {
+    rep_->full_filter =
+        new FullFilterBlockReader(rep_->options.filter_policy, block.data);
+  } else {
+    rep_->filter =
+        new FilterBlockReader(rep_->options.filter_policy, block.data);
+  }
 }
 
 Table::~Table() { delete rep_; }
 
-static void DeleteBlock(void* arg, void* ignored) {
-  delete reinterpret_cast<Block*>(arg);
-}
-
-static void DeleteCachedBlock(const Slice& key, void* value) {
-  Block* block = reinterpret_cast<Block*>(value);
-  delete block;
-}
-
-static void ReleaseBlock(void* arg, void* h) {
-  Cache* cache = reinterpret_cast<Cache*>(arg);
-  Cache::Handle* handle = reinterpret_cast<Cache::Handle*>(h);
-  cache->Release(handle);
-}
-
 // Convert an index iterator value (i.e., an encoded BlockHandle)
 // into an iterator over the contents of the corresponding block.
 Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
                              const Slice& index_value) {
-  Table* table = reinterpret_cast<Table*>(arg);
-  Cache* block_cache = table->rep_->options.block_cache;
-  Block* block = nullptr;
-  Cache::Handle* cache_handle = nullptr;
+  return BlockReader(arg, options, index_value, false, false);
+}
+
+Iterator* Table::MetaBlockReader(void* arg, const ReadOptions& options,
+                                 const Slice& index_value) {
+  return BlockReader(arg, options, index_value, false, true);
+}
+
+Status Table::ReadCachedBlock(const ReadOptions& options,
+                              const Slice& index_value, bool high_priority,
+                              Block** block, Cache::Handle** cache_handle,
+                              RandomAccessFile* file) const {
+  Cache* block_cache = rep_->options.block_cache;
+  if (file == nullptr) {
+    file = rep_->file;
+  }
+  *block = nullptr;
+  *cache_handle = nullptr;
 
   BlockHandle handle;
   Slice input = index_value;
@@ -167,37 +306,57 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
     BlockContents contents;
     if (block_cache != nullptr) {
       char cache_key_buffer[16];
-      EncodeFixed64(cache_key_buffer, table->rep_->cache_id);
+      EncodeFixed64(cache_key_buffer, rep_->cache_id);
       EncodeFixed64(cache_key_buffer + 8, handle.offset());
       Slice key(cache_key_buffer, sizeof(cache_key_buffer));
-      cache_handle = block_cache->Lookup(key);
-      if (cache_handle != nullptr) {
-        block = reinterpret_cast<Block*>(block_cache->Value(cache_handle));
+      *cache_handle = block_cache->Lookup(key);
+      if (*cache_handle != nullptr) {
+        *block = reinterpret_cast<Block*>(block_cache->Value(*cache_handle));
+        PerfCount(&perf_context.block_cache_hit_count);
       } else {
-        s = ReadBlock(table->rep_->file, options, handle, &contents);
+        if (ReadFromSecondaryCache(block_cache, key, &contents)) {
+          PerfCount(&perf_context.secondary_cache_hit_count);
+        } else {
+          s = ReadBlock(file, options, handle, &contents);
+        }
         if (s.ok()) {
-          block = new Block(contents);
+          *block = new Block(contents);
           if (contents.cachable && options.fill_cache) {
-            cache_handle = block_cache->Insert(key, block, block->size(),
-                                               &DeleteCachedBlock);
+            *cache_handle = block_cache->Insert(
+                key, *block, (*block)->size(), &DeleteCachedBlock,
+                high_priority ? Cache::kHighPriority : Cache::kLowPriority,
+                &SaveCachedBlock);
           }
         }
       }
     } else {
-      s = ReadBlock(table->rep_->file, options, handle, &contents);
+      s = ReadBlock(file, options, handle, &contents);
       if (s.ok()) {
-        block = new Block(contents);
+        *block = new Block(contents);
       }
     }
   }
+  return s;
+}
+
+Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
+                             const Slice& index_value, bool point_lookup,
+                             bool high_priority, RandomAccessFile* file) {
+  Table* table = reinterpret_cast<Table*>(arg);
+  Block* block;
+  Cache::Handle* cache_handle;
+  Status s = table->ReadCachedBlock(options, index_value, high_priority, &block,
+                                    &cache_handle, file);
 
   Iterator* iter;
   if (block != nullptr) {
-    iter = block->NewIterator(table->rep_->options.comparator);
+    iter = block->NewIterator(table->rep_->options.comparator, point_lookup,
+                              table->rep_->internal_keys);
     if (cache_handle == nullptr) {
       iter->RegisterCleanup(&DeleteBlock, block, nullptr);
     } else {
-      iter->RegisterCleanup(&ReleaseBlock, block_cache, cache_handle);
+      iter->RegisterCleanup(&ReleaseBlock, table->rep_->options.block_cache,
+                            cache_handle);
     }
   } else {
     iter = NewErrorIterator(s);
@@ -205,27 +364,373 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
   return iter;
 }
 
+Iterator* Table::NewIndexIterator(const ReadOptions& options) const {
+  Iterator* iter;
+  if (rep_->index_block != nullptr) {
+    iter = rep_->index_block->NewIterator(rep_->options.comparator);
+  } else {
+    iter = MetaBlockReader(const_cast<Table*>(this), options,
+                           rep_->index_handle);
+  }
+  if (rep_->partitioned_index) {
+    // Index partitions are ordinary index-format blocks.
+    iter = NewTwoLevelIterator(iter, &Table::MetaBlockReader,
+                               const_cast<Table*>(this), options);
+  }
+  return iter;
+}
+
+namespace {
+
+// Automatic readahead starts with windows of this many bytes, after this
+// many data blocks were read from disk one after the other.
+constexpr size_t kInitialAutoReadaheadSize = 8 * 1024;
+constexpr int kAutoReadaheadTrigger = 2;
+
+// Per-iterator state of a table iterator that reads ahead.
+struct TableReadahead {
+  TableReadahead(Table* table, RandomAccessFile* file, uint64_t file_size,
+                 size_t initial_size, size_t max_size, int trigger)
+      : table(table),
+        file(file, file_size, initial_size, max_size, trigger) {}
+
+  Table* const table;
+  ReadaheadFile file;
+};
+
+void DeleteReadahead(void* arg, void* ignored) {
+  delete reinterpret_cast<TableReadahead*>(arg);
+}
+
+}  // namespace
+
+Iterator* Table::ReadaheadBlockReader(void* arg, const ReadOptions& options,
+                                      const Slice& index_value) {
+  TableReadahead* readahead = reinterpret_cast<TableReadahead*>(arg);
+  return BlockReader(readahead->table, options, index_value, false, false,
+                     &readahead->file);
+}
+
 Iterator* Table::NewIterator(const ReadOptions& options) const {
-  return NewTwoLevelIterator(
-      rep_->index_block->NewIterator(rep_->options.comparator),
-      &Table::BlockReader, const_cast<Table*>(this), options);
+  size_t initial_size = options.readahead_size;
+  size_t max_size = options.readahead_size;
+  int trigger = 0;
+  if (options.readahead_size == 0) {
+    max_size = rep_->options.max_auto_readahead_size;
+    initial_size = std::min(kInitialAutoReadaheadSize, max_size);
+    trigger = kAutoReadaheadTrigger;
+  }
+  if (max_size == 0) {
+    return NewTwoLevelIterator(NewIndexIterator(options), &Table::BlockReader,
+                               const_cast<Table*>(this), options);
+  }
+
+  TableReadahead* readahead =
+      new TableReadahead(const_cast<Table*>(this), rep_->file, rep_->file_size,
+                         initial_size, max_size, trigger);
+  Iterator* iter = NewTwoLevelIterator(
+      NewIndexIterator(options), &Table::ReadaheadBlockReader, readahead,
+      options);
+  iter->RegisterCleanup(&DeleteReadahead, readahead, nullptr);
+  return iter;
+}
+
+uint64_t Table::CacheId() const { return rep_->cache_id; }
+
+bool Table::IsCachedBlock(void (*deleter)(const Slice& key, void* value)) {
+  return deleter == &DeleteCachedBlock;
+}
+
+// Reads the blocks at "handles" of the table that owns "cache_id" with a
+// single batch of reads and inserts them into "block_cache".
+static Status ReadBlocksIntoCache(Cache* block_cache, uint64_t cache_id,
+                                  RandomAccessFile* file,
+                                  const std::vector<BlockHandle>& handles) {
+  const size_t n = handles.size();
+  std::vector<BlockContents> contents(n);
+  std::vector<Status> statuses(n);
+  ReadBlocks(file, ReadOptions(), handles.data(), n, contents.data(),
+             statuses.data());
+  Status result;
+  for (size_t i = 0; i < n; i++) {
+    if (!statuses[i].ok()) {
+      if (result.ok()) {
+        result = statuses[i];
+      }
+      continue;
+    }
+    Block* block = new Block(contents[i]);
+    if (contents[i].cachable) {
+      char cache_key_buffer[16];
+      EncodeFixed64(cache_key_buffer, cache_id);
+      EncodeFixed64(cache_key_buffer + 8, handles[i].offset());
+      block_cache->Release(block_cache->Insert(
+          Slice(cache_key_buffer, sizeof(cache_key_buffer)), block,
+          block->size(), &DeleteCachedBlock, Cache::kLowPriority,
+          &SaveCachedBlock));
+    } else {
+      delete block;
+    }
+  }
+  return result;
+}
+
+Status Table::WarmBlocks(const std::vector<uint64_t>& offsets,
+                         const std::atomic<bool>* stop) const {
+  Cache* block_cache = rep_->options.block_cache;
+  if (block_cache == nullptr || offsets.empty()) {
+    return Status::OK();
+  }
+
+  // Blocks that are not cached yet are read in batches, which the file may
+  // submit to the operating system all at once.
+  static const size_t kBatchSize = 32;
+  std::vector<BlockHandle> batch;
+  Status s;
+  Iterator* index_iter = NewIndexIterator(ReadOptions());
+  size_t next = 0;
+  for (index_iter->SeekToFirst();
+       s.ok() && index_iter->Valid() && next < offsets.size();
+       index_iter->Next()) {
+    if (stop->load(std::memory_order_acquire)) {
+      batch.clear();
+      break;
+    }
+    BlockHandle handle;
+    Slice input = index_iter->value();
+    if (!handle.DecodeFrom(&input).ok()) {
+      break;
+    }
+    while (next < offsets.size() && offsets[next] < handle.offset()) {
+      next++;
+    }
+    if (next < offsets.size() && offsets[next] == handle.offset()) {
+      char cache_key_buffer[16];
+      EncodeFixed64(cache_key_buffer, rep_->cache_id);
+      EncodeFixed64(cache_key_buffer + 8, handle.offset());
+      Cache::Handle* cache_handle = block_cache->Lookup(
+          Slice(cache_key_buffer, sizeof(cache_key_buffer)));
+      if (cache_handle != nullptr) {
+        block_cache->Release(cache_handle);
+      } else {
+        batch.push_back(handle);
+      }
+      if (batch.size() == kBatchSize) {
+        s = ReadBlocksIntoCache(block_cache, rep_->cache_id, rep_->file, batch);
+        batch.clear();
+      }
+      next++;
+    }
+  }
+  if (s.ok() && !batch.empty()) {
+    s = ReadBlocksIntoCache(block_cache, rep_->cache_id, rep_->file, batch);
+  }
+  if (s.ok()) {
+    s = index_iter->status();
+  }
+  delete index_iter;
+  return s;
+}
+
+CachedFilter* Table::ReadCachedFilter(const ReadOptions& options,
+                                     const Slice& handle_value,
+                                     Cache::Handle** cache_handle) const {
+  Cache* block_cache = rep_->options.block_cache;
+  *cache_handle = nullptr;
+  BlockHandle handle;
+  Slice input = handle_value;
+  if (!handle.DecodeFrom(&input).ok()) {
+    return nullptr;
+  }
+
+  char cache_key_buffer[16];
+  EncodeFixed64(cache_key_buffer, rep_->cache_id);
+  EncodeFixed64(cache_key_buffer + 8, handle.offset());
+  Slice cache_key(cache_key_buffer, sizeof(cache_key_buffer));
+  if (block_cache != nullptr) {
+    *cache_handle = block_cache->Lookup(cache_key);
+    if (*cache_handle != nullptr) {
+      return reinterpret_cast<CachedFilter*>(
+          block_cache->Value(*cache_handle));
+    }
+  }
+
+  BlockContents contents;
+  if (!(block_cache != nullptr &&
+        ReadFromSecondaryCache(block_cache, cache_key, &contents)) &&
+      !ReadBlock(rep_->file, options, handle, &contents).ok()) {
+    return nullptr;
+  }
+  CachedFilter* filter =
+      new CachedFilter{contents.data, contents.heap_allocated};
+  if (block_cache != nullptr && contents.cachable && options.fill_cache) {
+    *cache_handle = block_cache->Insert(
+        cache_key, filter, filter->data.size(), &DeleteCachedFilter,
+        Cache::kHighPriority, &SaveCachedFilter);
+  }
+  return filter;
+}
+
+void Table::ReleaseFilter(CachedFilter* filter,
+                          Cache::Handle* cache_handle) const {
+  if (cache_handle != nullptr) {
+    rep_->options.block_cache->Release(cache_handle);
+  } else {
+    DeleteFilter(filter);
+  }
+}
+
+void Table::PinMetaBlocks() {
+  if (!rep_->cache_meta_blocks ||
+      rep_->pinned.load(std::memory_order_acquire)) {
+    return;
+  }
+  MutexLock l(&rep_->pin_mutex);
+  if (rep_->pinned.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // Blocks that the cache does not keep, e.g. because they are read
+  // through mmap, are simply not pinned.
+  ReadOptions options;
+  Block* block;
+  Cache::Handle* cache_handle;
+  std::vector<const std::string*> meta_blocks = {&rep_->index_handle};
+  if (!rep_->filter_index_handle.empty()) {
+    meta_blocks.push_back(&rep_->filter_index_handle);
+  }
+  for (const std::string* handle : meta_blocks) {
+    if (ReadCachedBlock(options, *handle, true, &block, &cache_handle).ok()) {
+      if (cache_handle != nullptr) {
+        rep_->pinned_handles.push_back(cache_handle);
+      } else {
+        delete block;
+      }
+    }
+  }
+  if (!rep_->cached_filter_handle.empty()) {
+    CachedFilter* filter =
+        ReadCachedFilter(options, rep_->cached_filter_handle, &cache_handle);
+    if (cache_handle != nullptr) {
+      rep_->pinned_handles.push_back(cache_handle);
+    } else if (filter != nullptr) {
+      DeleteFilter(filter);
+    }
+  }
+  rep_->pinned.store(true, std::memory_order_release);
+}
+
+void Table::UnpinMetaBlocks() {
+  if (!rep_->pinned.load(std::memory_order_acquire)) {
+    return;
+  }
+  MutexLock l(&rep_->pin_mutex);
+  for (Cache::Handle* handle : rep_->pinned_handles) {
+    rep_->options.block_cache->Release(handle);
+  }
+  rep_->pinned_handles.clear();
+  rep_->pinned.store(false, std::memory_order_release);
+}
+
+bool Table::PartitionMayMatch(const ReadOptions& options,
+                              const Slice& partition_handle,
+                              const Slice& key) {
+  Cache::Handle* cache_handle;
+  CachedFilter* partition =
+      ReadCachedFilter(options, partition_handle, &cache_handle);
+  if (partition == nullptr) {
+    return true;
+  }
+  FullFilterBlockReader reader(rep_->options.filter_policy, partition->data);
+  const bool may_match = reader.KeyMayMatch(key);
+  ReleaseFilter(partition, cache_handle);
+  return may_match;
+}
+
+bool Table::BlockMayMatch(const ReadOptions& options, uint64_t block_offset,
+                          const Slice& key) {
+  if (rep_->filter != nullptr) {
+    return rep_->filter->KeyMayMatch(block_offset, key);
+  }
+  if (rep_->cached_filter_handle.empty() || rep_->cached_full_filter) {
+    return true;
+  }
+  Cache::Handle* cache_handle;
+  CachedFilter* filter =
+      ReadCachedFilter(options, rep_->cached_filter_handle, &cache_handle);
+  if (filter == nullptr) {
+    return true;
+  }
+  FilterBlockReader reader(rep_->options.filter_policy, filter->data);
+  const bool may_match = reader.KeyMayMatch(block_offset, key);
+  ReleaseFilter(filter, cache_handle);
+  return may_match;
+}
+
+bool Table::KeyMayMatch(const ReadOptions& options, const Slice& key) {
+  if (rep_->full_filter != nullptr) {
+    return rep_->full_filter->KeyMayMatch(key);
+  }
+  if (rep_->cached_full_filter) {
+    Cache::Handle* cache_handle;
+    CachedFilter* filter =
+        ReadCachedFilter(options, rep_->cached_filter_handle, &cache_handle);
+    if (filter == nullptr) {
+      return true;
+    }
+    FullFilterBlockReader reader(rep_->options.filter_policy, filter->data);
+    const bool may_match = reader.KeyMayMatch(key);
+    ReleaseFilter(filter, cache_handle);
+    return may_match;
+  }
+  if (rep_->filter_index_handle.empty()) {
+    return true;
+  }
+
+  // Locate the partition through the top-level filter index, which is an
+  // ordinary index-format block and so is read through BlockReader.
+  bool may_match = true;
+  Iterator* index_iter =
+      MetaBlockReader(this, options, rep_->filter_index_handle);
+  index_iter->Seek(key);
+  if (index_iter->Valid()) {
+    may_match = PartitionMayMatch(options, index_iter->value(), key);
+  } else if (index_iter->status().ok()) {
+    may_match = false;  // key is past the last key in the table
+  }
+  delete index_iter;
+  return may_match;
 }
 
 Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
                           void (*handle_result)(void*, const Slice&,
                                                 const Slice&)) {
   Status s;
-  Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
+  PerfTimer filter_timer(&perf_context.filter_check_nanos);
+  const bool key_may_match = KeyMayMatch(options, k);
+  filter_timer.Stop();
+  if (!key_may_match) {
+    RecordTick(rep_->options.statistics, kBloomFilterUseful);
+    PerfCount(&perf_context.bloom_filter_useful);
+    return s;  // Not found
+  }
+  Iterator* iiter = NewIndexIterator(options);
   iiter->Seek(k);
   if (iiter->Valid()) {
     Slice handle_value = iiter->value();
-    FilterBlockReader* filter = rep_->filter;
     BlockHandle handle;
-    if (filter != nullptr && handle.DecodeFrom(&handle_value).ok() &&
-        !filter->KeyMayMatch(handle.offset(), k)) {
+    PerfTimer block_filter_timer(&perf_context.filter_check_nanos);
+    const bool block_may_match =
+        !handle.DecodeFrom(&handle_value).ok() ||
+        BlockMayMatch(options, handle.offset(), k);
+    block_filter_timer.Stop();
+    if (!block_may_match) {
       // Not found
+      RecordTick(rep_->options.statistics, kBloomFilterUseful);
+      PerfCount(&perf_context.bloom_filter_useful);
     } else {
-      Iterator* block_iter = BlockReader(this, options, iiter->value());
+      Iterator* block_iter =
+          BlockReader(this, options, iiter->value(), true, false);
       block_iter->Seek(k);
       if (block_iter->Valid()) {
         (*handle_result)(arg, block_iter->key(), block_iter->value());
@@ -242,8 +747,7 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
 }
 
 uint64_t Table::ApproximateOffsetOf(const Slice& key) const {
-  Iterator* index_iter =
-      rep_->index_block->NewIterator(rep_->options.comparator);
+  Iterator* index_iter = NewIndexIterator(ReadOptions());
   index_iter->Seek(key);
   uint64_t result;
   if (index_iter->Valid()) {
@@ -268,4 +772,8 @@ uint64_t Table::ApproximateOffsetOf(const Slice& key) const {
   return result;
 }
 
+void TableInternal::SetInternalKeys(Table* table) {
+  table->rep_->internal_keys = true;
+}
+
 }  // namespace leveldb
@@ -13,6 +13,7 @@
 #include "table/block_builder.h"
 #include "table/filter_block.h"
 #include "table/format.h"
+#include "table/table_internal.h"
 #include "util/coding.h"
 #include "util/crc32c.h"
 
@@ -28,11 +29,22 @@ struct TableBuilder::Rep {
         index_block(&index_block_options),
         num_entries(0),
         closed(false),
-        filter_block(opt.filter_policy == nullptr
+        filter_block(opt.filter_policy == nullptr ||
+                             opt.filter_format != kBlockBasedFilter
                          ? nullptr
                          : new FilterBlockBuilder(opt.filter_policy)),
+        full_filter_block(opt.filter_policy == nullptr ||
+                                  opt.filter_format == kBlockBasedFilter
+                              ? nullptr
+                              : new FullFilterBlockBuilder(opt.filter_policy)),
+        filter_index_block(&index_block_options),
+        partition_filters(full_filter_block != nullptr &&
+                          opt.filter_format == kPartitionedFilter),
+        partition_index(opt.partition_index),
+        top_level_index_block(&index_block_options),
         pending_index_entry(false) {
     index_block_options.block_restart_interval = 1;
+    index_block_options.data_block_hash_index = false;
   }
 
   Options options;
@@ -46,6 +58,18 @@ struct TableBuilder::Rep {
   int64_t num_entries;
   bool closed;  // Either Finish() or Abandon() has been called.
   FilterBlockBuilder* filter_block;
+  FullFilterBlockBuilder* full_filter_block;
+
+  // Top-level index of a partitioned filter: maps the index key of the
+  // last data block covered by each partition to the partition's handle.
+  BlockBuilder filter_index_block;
+  bool partition_filters;
+
+  // With a partitioned index, index_block holds the current partition and
+  // top_level_index_block maps the last key of each written partition to
+  // the partition's handle.
+  bool partition_index;
+  BlockBuilder top_level_index_block;
 
   // We do not emit the index entry for a block until we have seen the
   // first key for the next data block.  This allows us to use shorter
@@ -72,6 +96,7 @@ TableBuilder::TableBuilder(const Options& options, WritableFile* file)
 TableBuilder::~TableBuilder() {
   assert(rep_->closed);  // Catch errors where caller forgot to call Finish()
   delete rep_->filter_block;
+  delete rep_->full_filter_block;
   delete rep_;
 }
 
@@ -88,6 +113,7 @@ Status TableBuilder::ChangeOptions(const Options& options) {
   rep_->options = options;
   rep_->index_block_options = options;
   rep_->index_block_options.block_restart_interval = 1;
+  rep_->index_block_options.data_block_hash_index = false;
   return Status::OK();
 }
 
@@ -106,11 +132,16 @@ void TableBuilder::Add(const Slice& key, const Slice& value) {
     r->pending_handle.EncodeTo(&handle_encoding);
     r->index_block.Add(r->last_key, Slice(handle_encoding));
     r->pending_index_entry = false;
+    MaybeCutIndexPartition(false);
+    MaybeCutFilterPartition(false);
   }
 
   if (r->filter_block != nullptr) {
     r->filter_block->AddKey(key);
   }
+  if (r->full_filter_block != nullptr) {
+    r->full_filter_block->AddKey(key);
+  }
 
   r->last_key.assign(key.data(), key.size());
   r->num_entries++;
@@ -193,6 +224,45 @@ void TableBuilder::WriteRawBlock(const Slice& block_contents,
   }
 }
 
+void TableBuilder::MaybeCutIndexPartition(bool force) {
+  Rep* r = rep_;
+  if (!ok() || !r->partition_index || r->index_block.empty()) {
+    return;
+  }
+  if (!force && r->index_block.CurrentSizeEstimate() <
+                    r->options.metadata_block_size) {
+    return;
+  }
+  BlockHandle partition_handle;
+  WriteBlock(&r->index_block, &partition_handle);
+  if (ok()) {
+    std::string handle_encoding;
+    partition_handle.EncodeTo(&handle_encoding);
+    r->top_level_index_block.Add(r->last_key, Slice(handle_encoding));
+  }
+}
+
+void TableBuilder::MaybeCutFilterPartition(bool force) {
+  // Partitions end on data block boundaries so that the index key of the
+  // last block in a partition also bounds the keys held by its filter.
+  Rep* r = rep_;
+  if (!ok() || !r->partition_filters || r->full_filter_block->empty()) {
+    return;
+  }
+  if (!force && r->full_filter_block->EstimatedSize() <
+                    r->options.metadata_block_size) {
+    return;
+  }
+  BlockHandle partition_handle;
+  WriteRawBlock(r->full_filter_block->Finish(), kNoCompression,
+                &partition_handle);
+  if (ok()) {
+    std::string handle_encoding;
+    partition_handle.EncodeTo(&handle_encoding);
+    r->filter_index_block.Add(r->last_key, Slice(handle_encoding));
+  }
+}
+
 Status TableBuilder::status() const { return rep_->status; }
 
 Status TableBuilder::Finish() {
@@ -202,19 +272,43 @@ Status TableBuilder::Finish() {
   r->closed = true;
 
   BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle;
+  const char* filter_prefix = nullptr;
+
+  // The last index entry is needed up front: it also closes the final
+  // partition of a partitioned filter.
+  if (ok() && r->pending_index_entry) {
+    r->options.comparator->FindShortSuccessor(&r->last_key);
+    std::string handle_encoding;
+    r->pending_handle.EncodeTo(&handle_encoding);
+    r->index_block.Add(r->last_key, Slice(handle_encoding));
+    r->pending_index_entry = false;
+  }
 
   // Write filter block
   if (ok() && r->filter_block != nullptr) {
     WriteRawBlock(r->filter_block->Finish(), kNoCompression,
                   &filter_block_handle);
+    filter_prefix = "filter.";
+  } else if (ok() && r->full_filter_block != nullptr) {
+    if (r->partition_filters) {
+      MaybeCutFilterPartition(true);
+      if (ok() && !r->filter_index_block.empty()) {
+        WriteBlock(&r->filter_index_block, &filter_block_handle);
+        filter_prefix = "partitionedfilter.";
+      }
+    } else if (!r->full_filter_block->empty()) {
+      WriteRawBlock(r->full_filter_block->Finish(), kNoCompression,
+                    &filter_block_handle);
+      filter_prefix = "fullfilter.";
+    }
   }
 
   // Write metaindex block
   if (ok()) {
-    BlockBuilder meta_index_block(&r->options);
-    if (r->filter_block != nullptr) {
-      // Add mapping from "filter.Name" to location of filter data
-      std::string key = "filter.";
+    BlockBuilder meta_index_block(&r->index_block_options);
+    if (filter_prefix != nullptr) {
+      // Add mapping from "<prefix>Name" to location of filter data
+      std::string key = filter_prefix;
       key.append(r->options.filter_policy->Name());
       std::string handle_encoding;
       filter_block_handle.EncodeTo(&handle_encoding);
@@ -227,14 +321,14 @@ Status TableBuilder::Finish() {
 
   // Write index block
   if (ok()) {
-    if (r->pending_index_entry) {
-      r->options.comparator->FindShortSuccessor(&r->last_key);
-      std::string handle_encoding;
-      r->pending_handle.EncodeTo(&handle_encoding);
-      r->index_block.Add(r->last_key, Slice(handle_encoding));
-      r->pending_index_entry = false;
+    if (r->partition_index) {
+      MaybeCutIndexPartition(true);
+      if (ok()) {
+        WriteBlock(&r->top_level_index_block, &index_block_handle);
+      }
+    } else {
+      WriteBlock(&r->index_block, &index_block_handle);
     }
-    WriteBlock(&r->index_block, &index_block_handle);
   }
 
   // Write footer
@@ -242,6 +336,7 @@ Status TableBuilder::Finish() {
     Footer footer;
     footer.set_metaindex_handle(metaindex_block_handle);
     footer.set_index_handle(index_block_handle);
+    footer.set_partitioned_index(r->partition_index);
     std::string footer_encoding;
     footer.EncodeTo(&footer_encoding);
     r->status = r->file->Append(footer_encoding);
@@ -262,4 +357,9 @@ uint64_t TableBuilder::NumEntries() const { return rep_->num_entries; }
 
 uint64_t TableBuilder::FileSize() const { return rep_->offset; }
 
+void TableInternal::SetInternalKeys(TableBuilder* builder) {
+  assert(builder->rep_->num_entries == 0);
+  builder->rep_->data_block.set_internal_keys(true);
+}
+
 }  // namespace leveldb
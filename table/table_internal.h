@@ -0,0 +1,30 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_TABLE_TABLE_INTERNAL_H_
+#define STORAGE_LEVELDB_TABLE_TABLE_INTERNAL_H_
+
+#include "leveldb/table.h"
+#include "leveldb/table_builder.h"
+
+namespace leveldb {
+
+// TableInternal provides static methods for setting up the tables of a
+// DB that we don't want in the public Table and TableBuilder interfaces.
+class TableInternal {
+ public:
+  // Mark the keys of the table as DB internal keys.  Their trailing
+  // sequence number and type are left out of the data block hash index,
+  // so that point lookups find every version of a user key.
+  // REQUIRES: Add() has not been called on "builder".
+  static void SetInternalKeys(TableBuilder* builder);
+
+  // Same as above, for reading a table built that way.
+  // REQUIRES: "table" has not been read from since it was opened.
+  static void SetInternalKeys(Table* table);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_TABLE_INTERNAL_H_
@@ -4,6 +4,7 @@
 
 #include "leveldb/table.h"
 
+#include <algorithm>
 #include <map>
 #include <string>
 
@@ -109,14 +110,17 @@ class StringSink : public WritableFile {
 class StringSource : public RandomAccessFile {
  public:
   StringSource(const Slice& contents)
-      : contents_(contents.data(), contents.size()) {}
+      : contents_(contents.data(), contents.size()), reads_(0) {}
 
   ~StringSource() override = default;
 
   uint64_t Size() const { return contents_.size(); }
 
+  int reads() const { return reads_; }
+
   Status Read(uint64_t offset, size_t n, Slice* result,
               char* scratch) const override {
+    reads_++;
     if (offset >= contents_.size()) {
       return Status::InvalidArgument("invalid Read offset");
     }
@@ -130,6 +134,7 @@ class StringSource : public RandomAccessFile {
 
  private:
   std::string contents_;
+  mutable int reads_;
 };
 
 typedef std::map<std::string, std::string, STLLessThan> KVMap;
@@ -745,6 +750,104 @@ TEST(MemTableTest, Simple) {
   memtable->Unref();
 }
 
+static Block* BuildHashIndexedBlock(const Options& options,
+                                   const std::vector<std::string>& keys,
+                                   std::string* storage,
+                                   bool internal_keys = false) {
+  BlockBuilder builder(&options);
+  builder.set_internal_keys(internal_keys);
+  for (const std::string& key : keys) {
+    builder.Add(key, "v" + key);
+  }
+  *storage = builder.Finish().ToString();
+  BlockContents contents;
+  contents.data = *storage;
+  contents.cachable = false;
+  contents.heap_allocated = false;
+  return new Block(contents);
+}
+
+TEST(TableTest, DataBlockHashIndex) {
+  Options options;
+  options.block_restart_interval = 4;
+  options.data_block_hash_index = true;
+  std::vector<std::string> keys;
+  char buf[16];
+  for (int i = 0; i < 200; i += 2) {
+    std::snprintf(buf, sizeof(buf), "k%04d", i);
+    keys.push_back(buf);
+  }
+  std::string storage;
+  Block* block = BuildHashIndexedBlock(options, keys, &storage);
+
+  // Ordinary iteration is unaffected by the index.
+  Iterator* iter = block->NewIterator(options.comparator);
+  size_t count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(keys[count], iter->key().ToString());
+    count++;
+  }
+  ASSERT_EQ(keys.size(), count);
+  delete iter;
+
+  iter = block->NewIterator(options.comparator, true);
+  for (const std::string& key : keys) {
+    iter->Seek(key);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(key, iter->key().ToString());
+    ASSERT_EQ("v" + key, iter->value().ToString());
+  }
+  for (int i = 1; i < 200; i += 2) {
+    std::snprintf(buf, sizeof(buf), "k%04d", i);
+    iter->Seek(buf);
+    ASSERT_TRUE(!iter->Valid() || iter->key() != Slice(buf));
+  }
+  ASSERT_LEVELDB_OK(iter->status());
+  delete iter;
+  delete block;
+}
+
+TEST(TableTest, DataBlockHashIndexInternalKeys) {
+  InternalKeyComparator icmp(BytewiseComparator());
+  Options options;
+  options.comparator = &icmp;
+  options.block_restart_interval = 2;
+  options.data_block_hash_index = true;
+
+  // Several versions of "b" straddle restart intervals.
+  std::vector<std::string> keys;
+  const char* const kUserKeys[] = {"a", "b", "b", "b", "b", "c", "d"};
+  SequenceNumber seq = 100;
+  for (const char* user_key : kUserKeys) {
+    std::string key;
+    AppendInternalKey(&key, ParsedInternalKey(user_key, seq--, kTypeValue));
+    keys.push_back(key);
+  }
+  std::sort(keys.begin(), keys.end(), [&icmp](const std::string& a,
+                                              const std::string& b) {
+    return icmp.Compare(a, b) < 0;
+  });
+  std::string storage;
+  Block* block = BuildHashIndexedBlock(options, keys, &storage, true);
+
+  Iterator* iter = block->NewIterator(&icmp, true, true);
+  for (SequenceNumber snapshot = 96; snapshot <= 100; snapshot++) {
+    LookupKey lkey("b", snapshot);
+    iter->Seek(lkey.internal_key());
+    ASSERT_TRUE(iter->Valid());
+    ParsedInternalKey parsed;
+    ASSERT_TRUE(ParseInternalKey(iter->key(), &parsed));
+    ASSERT_EQ("b", parsed.user_key.ToString());
+    ASSERT_LE(parsed.sequence, snapshot);
+  }
+  LookupKey missing("bb", 100);
+  iter->Seek(missing.internal_key());
+  ASSERT_TRUE(!iter->Valid() ||
+              ExtractUserKey(iter->key()) != Slice("bb"));
+  delete iter;
+  delete block;
+}
+
 static bool Between(uint64_t val, uint64_t low, uint64_t high) {
   bool result = (val >= low) && (val <= high);
   if (!result) {
@@ -784,6 +887,106 @@ TEST(TableTest, ApproximateOffsetOfPlain) {
   ASSERT_TRUE(Between(c.ApproximateOffsetOf("xyz"), 610000, 612000));
 }
 
+TEST(TableTest, PartitionedIndex) {
+  TableConstructor c(BytewiseComparator());
+  char buf[16];
+  for (int i = 0; i < 2000; i++) {
+    std::snprintf(buf, sizeof(buf), "k%06d", i);
+    c.Add(buf, std::string(100, 'a' + (i % 26)));
+  }
+  std::vector<std::string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 256;
+  options.compression = kNoCompression;
+  options.partition_index = true;
+  options.metadata_block_size = 128;
+  c.Finish(options, &keys, &kvmap);
+
+  Iterator* iter = c.NewIterator();
+  KVMap::const_iterator model = kvmap.begin();
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++model) {
+    ASSERT_TRUE(model != kvmap.end());
+    ASSERT_EQ(model->first, iter->key().ToString());
+    ASSERT_EQ(model->second, iter->value().ToString());
+  }
+  ASSERT_TRUE(model == kvmap.end());
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+    --model;
+    ASSERT_EQ(model->first, iter->key().ToString());
+  }
+  ASSERT_TRUE(model == kvmap.begin());
+
+  Random rnd(test::RandomSeed());
+  for (int i = 0; i < 200; i++) {
+    const std::string& key = keys[rnd.Uniform(keys.size())];
+    iter->Seek(key);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(key, iter->key().ToString());
+  }
+  iter->Seek("l");
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_LEVELDB_OK(iter->status());
+  delete iter;
+
+  uint64_t last = 0;
+  for (size_t i = 0; i < keys.size(); i += 100) {
+    uint64_t offset = c.ApproximateOffsetOf(keys[i]);
+    ASSERT_LE(last, offset);
+    last = offset;
+  }
+  ASSERT_TRUE(Between(c.ApproximateOffsetOf("k001000"), 100000, 300000));
+}
+
+TEST(TableTest, Readahead) {
+  Options options;
+  options.block_size = 1024;
+  options.compression = kNoCompression;
+  StringSink sink;
+  TableBuilder builder(options, &sink);
+  char key[16];
+  for (int i = 0; i < 1000; i++) {
+    std::snprintf(key, sizeof(key), "k%06d", i);
+    builder.Add(key, std::string(100, 'a' + (i % 26)));
+  }
+  ASSERT_LEVELDB_OK(builder.Finish());
+  const int num_blocks = 1000 * 100 / 1024;  // At least
+
+  // Returns the number of reads a full scan takes.
+  auto scan = [&](const Options& table_options,
+                  const ReadOptions& read_options) {
+    StringSource source(sink.contents());
+    Table* table;
+    EXPECT_LEVELDB_OK(
+        Table::Open(table_options, &source, source.Size(), &table));
+    const int open_reads = source.reads();
+    Iterator* iter = table->NewIterator(read_options);
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      std::snprintf(key, sizeof(key), "k%06d", count++);
+      EXPECT_EQ(key, iter->key().ToString());
+    }
+    EXPECT_EQ(1000, count);
+    EXPECT_LEVELDB_OK(iter->status());
+    delete iter;
+    delete table;
+    return source.reads() - open_reads;
+  };
+
+  Options no_readahead;
+  no_readahead.max_auto_readahead_size = 0;
+  ASSERT_GE(scan(no_readahead, ReadOptions()), num_blocks);
+
+  // Windows of 8, 16, 32 and then 64KB.
+  Options auto_readahead;
+  auto_readahead.max_auto_readahead_size = 64 * 1024;
+  ASSERT_LE(scan(auto_readahead, ReadOptions()), 8);
+
+  ReadOptions fixed_readahead;
+  fixed_readahead.readahead_size = 1 << 20;
+  ASSERT_EQ(1, scan(no_readahead, fixed_readahead));
+}
+
 static bool SnappyCompressionSupported() {
   std::string out;
   Slice in = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
@@ -0,0 +1,87 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/aligned_buffer.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif  // defined(_WIN32)
+
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+namespace {
+
+char* AlignedAlloc(size_t alignment, size_t size) {
+  void* buf = nullptr;
+#if defined(_WIN32)
+  buf = ::_aligned_malloc(size, alignment);
+#else
+  if (::posix_memalign(&buf, alignment, size) != 0) {
+    buf = nullptr;
+  }
+#endif  // defined(_WIN32)
+  if (buf == nullptr) {
+    std::fprintf(stderr, "aligned allocation of %zu bytes failed\n", size);
+    std::abort();
+  }
+  return static_cast<char*>(buf);
+}
+
+void AlignedFree(char* buf) {
+#if defined(_WIN32)
+  ::_aligned_free(buf);
+#else
+  std::free(buf);
+#endif  // defined(_WIN32)
+}
+
+}  // namespace
+
+AlignedBufferPool::AlignedBufferPool(size_t alignment, size_t buffer_size,
+                                     int max_free)
+    : alignment_(alignment),
+      buffer_size_(AlignUp(buffer_size, alignment)),
+      max_free_(max_free) {
+  assert((alignment & (alignment - 1)) == 0);
+}
+
+AlignedBufferPool::~AlignedBufferPool() {
+  for (char* buf : free_) {
+    AlignedFree(buf);
+  }
+}
+
+char* AlignedBufferPool::Allocate(size_t size) {
+  if (size > buffer_size_) {
+    return AlignedAlloc(alignment_, AlignUp(size, alignment_));
+  }
+  {
+    MutexLock l(&mu_);
+    if (!free_.empty()) {
+      char* buf = free_.back();
+      free_.pop_back();
+      return buf;
+    }
+  }
+  return AlignedAlloc(alignment_, buffer_size_);
+}
+
+void AlignedBufferPool::Release(char* buf, size_t size) {
+  if (size <= buffer_size_) {
+    MutexLock l(&mu_);
+    if (free_.size() < max_free_) {
+      free_.push_back(buf);
+      return;
+    }
+  }
+  AlignedFree(buf);
+}
+
+}  // namespace leveldb
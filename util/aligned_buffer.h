@@ -0,0 +1,85 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_UTIL_ALIGNED_BUFFER_H_
+#define STORAGE_LEVELDB_UTIL_ALIGNED_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "port/port.h"
+#include "port/thread_annotations.h"
+
+namespace leveldb {
+
+// Direct I/O transfers data straight between the device and user memory, so
+// buffers, file offsets and lengths must all be multiples of the device's
+// logical block size.  This alignment works for the devices we run on.
+static const size_t kDirectIOAlignment = 4096;
+
+// Rounds "n" down or up to a multiple of "alignment", a power of two.
+inline uint64_t AlignDown(uint64_t n, size_t alignment) {
+  return n & ~static_cast<uint64_t>(alignment - 1);
+}
+inline uint64_t AlignUp(uint64_t n, size_t alignment) {
+  return AlignDown(n + alignment - 1, alignment);
+}
+
+// Hands out aligned buffers for direct I/O.  Buffers of up to buffer_size()
+// bytes are recycled, so that the steady stream of block reads and file
+// writes does not pay for an aligned allocation each time; larger requests
+// are allocated for the caller and freed on release.
+//
+// Thread-safe.
+class AlignedBufferPool {
+ public:
+  // Buffers are aligned to "alignment", which must be a power of two.  At
+  // most "max_free" released buffers are kept for reuse.
+  AlignedBufferPool(size_t alignment, size_t buffer_size, int max_free);
+  ~AlignedBufferPool();
+
+  AlignedBufferPool(const AlignedBufferPool&) = delete;
+  AlignedBufferPool& operator=(const AlignedBufferPool&) = delete;
+
+  size_t alignment() const { return alignment_; }
+  size_t buffer_size() const { return buffer_size_; }
+
+  // Returns a buffer of at least "size" bytes.
+  char* Allocate(size_t size);
+
+  // Returns a buffer obtained from Allocate(size) to the pool.
+  void Release(char* buf, size_t size);
+
+ private:
+  const size_t alignment_;
+  const size_t buffer_size_;
+  const size_t max_free_;
+
+  port::Mutex mu_;
+  std::vector<char*> free_ GUARDED_BY(mu_);
+};
+
+// A buffer from an AlignedBufferPool that is released on destruction.
+class AlignedBuffer {
+ public:
+  AlignedBuffer(AlignedBufferPool* pool, size_t size)
+      : pool_(pool), data_(pool->Allocate(size)), size_(size) {}
+  ~AlignedBuffer() { pool_->Release(data_, size_); }
+
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  AlignedBufferPool* const pool_;
+  char* const data_;
+  const size_t size_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_ALIGNED_BUFFER_H_
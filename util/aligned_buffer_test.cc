@@ -0,0 +1,59 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/aligned_buffer.h"
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+static bool IsAligned(const char* p, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+TEST(AlignedBufferTest, Rounding) {
+  ASSERT_EQ(0, AlignDown(4095, 4096));
+  ASSERT_EQ(4096, AlignDown(4096, 4096));
+  ASSERT_EQ(0, AlignUp(0, 4096));
+  ASSERT_EQ(4096, AlignUp(1, 4096));
+  ASSERT_EQ(8192, AlignUp(4097, 4096));
+}
+
+TEST(AlignedBufferTest, Recycle) {
+  AlignedBufferPool pool(4096, 10000, 1);
+  ASSERT_EQ(12288, pool.buffer_size());
+
+  char* a = pool.Allocate(100);
+  char* b = pool.Allocate(pool.buffer_size());
+  ASSERT_TRUE(IsAligned(a, 4096));
+  ASSERT_TRUE(IsAligned(b, 4096));
+  ASSERT_NE(a, b);
+  std::memset(b, 'x', pool.buffer_size());
+
+  // Only one free buffer is kept.
+  pool.Release(a, 100);
+  pool.Release(b, pool.buffer_size());
+  ASSERT_EQ(a, pool.Allocate(1));
+  pool.Release(a, 1);
+}
+
+TEST(AlignedBufferTest, Large) {
+  AlignedBufferPool pool(512, 4096, 4);
+  {
+    AlignedBuffer buf(&pool, 100000);
+    ASSERT_TRUE(IsAligned(buf.data(), 512));
+    std::memset(buf.data(), 'x', buf.size());
+  }
+  AlignedBuffer buf(&pool, 10);
+  ASSERT_TRUE(IsAligned(buf.data(), 512));
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -4,19 +4,30 @@
 
 #include "leveldb/cache.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
 
 #include "port/port.h"
 #include "port/thread_annotations.h"
+#include "util/frequency_sketch.h"
 #include "util/hash.h"
 #include "util/mutexlock.h"
+#include "util/secondary_cache_key.h"
 
 namespace leveldb {
 
 Cache::~Cache() {}
 
+SecondaryCache::~SecondaryCache() {}
+
+uint64_t NewSecondaryCacheId() {
+  static std::atomic<uint64_t> last_id(0);
+  return last_id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
 namespace {
 
 // LRU cache implementation
@@ -37,18 +48,35 @@ namespace {
 // Elements are moved between these lists by the Ref() and Unref() methods,
 // when they detect an element in the cache acquiring or losing its only
 // external reference.
+//
+// The unreferenced items are split into a high-priority and a low-priority
+// LRU list.  High-priority items enter the former while its total charge
+// stays within the high-priority pool, and overflow into the newest end of
+// the low-priority list otherwise.  Eviction drains the low-priority list
+// before touching the high-priority one.
+//
+// With an admission filter, an insert that would force an eviction is
+// only admitted if the frequency sketch has seen the new key more often
+// than the entry it would evict.
+//
+// Entries evicted for lack of space are offered to the secondary cache,
+// if any, just before their deleter runs.  Both happen after the shard
+// mutex is released, so lookups do not wait for the slower tier.
 
 // An entry is a variable length heap-allocated structure.  Entries
 // are kept in a circular doubly linked list ordered by access time.
 struct LRUHandle {
   void* value;
   void (*deleter)(const Slice&, void* value);
+  Slice (*saver)(void* value);  // Contents for the secondary cache, if any
   LRUHandle* next_hash;
   LRUHandle* next;
   LRUHandle* prev;
   size_t charge;  // TODO(opt): Only allow uint32_t?
   size_t key_length;
   bool in_cache;     // Whether entry is in the cache.
+  bool high_pri;     // Inserted with Cache::kHighPriority.
+  bool in_high_pool;  // Whether entry is on the high-priority LRU list.
   uint32_t refs;     // References, including cache reference, if present.
   uint32_t hash;     // Hash of key(); used for fast sharding and comparisons
   char key_data[1];  // Beginning of key
@@ -155,11 +183,20 @@ class LRUCache {
 
   // Separate from constructor so caller can easily make an array of LRUCache
   void SetCapacity(size_t capacity) { capacity_ = capacity; }
+  void SetHighPriorityPoolRatio(double ratio) {
+    high_pool_capacity_ = static_cast<size_t>(capacity_ * ratio);
+  }
+  void SetAdmissionFilter(FrequencySketch* sketch) { sketch_ = sketch; }
+  void SetSecondaryCache(SecondaryCache* secondary, uint64_t secondary_id) {
+    secondary_ = secondary;
+    secondary_id_ = secondary_id;
+  }
 
   // Like Cache methods, but with an extra "hash" parameter.
   Cache::Handle* Insert(const Slice& key, uint32_t hash, void* value,
                         size_t charge,
-                        void (*deleter)(const Slice& key, void* value));
+                        void (*deleter)(const Slice& key, void* value),
+                        Cache::Priority priority, Slice (*saver)(void* value));
   Cache::Handle* Lookup(const Slice& key, uint32_t hash);
   void Release(Cache::Handle* handle);
   void Erase(const Slice& key, uint32_t hash);
@@ -168,16 +205,32 @@ class LRUCache {
     MutexLock l(&mutex_);
     return usage_;
   }
+  void ApplyToAllEntries(
+      void (*callback)(void* arg, const Slice& key, void* value,
+                       void (*deleter)(const Slice& key, void* value)),
+      void* arg);
 
  private:
   void LRU_Remove(LRUHandle* e);
   void LRU_Append(LRUHandle* list, LRUHandle* e);
+  // Puts an entry that just lost its last client reference on the
+  // appropriate LRU list.
+  void LRU_Insert(LRUHandle* e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the next entry to evict, or nullptr if all entries are in use.
+  LRUHandle* Victim() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void Ref(LRUHandle* e);
   void Unref(LRUHandle* e);
   bool FinishErase(LRUHandle* e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Stores the entries chained through next_hash in the secondary cache
+  // and frees them.  They must already be out of the cache.
+  void DemoteAndFree(LRUHandle* list) LOCKS_EXCLUDED(mutex_);
 
   // Initialized before use.
   size_t capacity_;
+  size_t high_pool_capacity_;
+  FrequencySketch* sketch_;  // nullptr unless an admission filter is used
+  SecondaryCache* secondary_;
+  uint64_t secondary_id_;
 
   // mutex_ protects the following state.
   mutable port::Mutex mutex_;
@@ -188,6 +241,10 @@ class LRUCache {
   // Entries have refs==1 and in_cache==true.
   LRUHandle lru_ GUARDED_BY(mutex_);
 
+  // Dummy head of high-priority LRU list, ordered like lru_.
+  LRUHandle lru_high_ GUARDED_BY(mutex_);
+  size_t high_pool_usage_ GUARDED_BY(mutex_);
+
   // Dummy head of in-use list.
   // Entries are in use by clients, and have refs >= 2 and in_cache==true.
   LRUHandle in_use_ GUARDED_BY(mutex_);
@@ -195,23 +252,34 @@ class LRUCache {
   HandleTable table_ GUARDED_BY(mutex_);
 };
 
-LRUCache::LRUCache() : capacity_(0), usage_(0) {
+LRUCache::LRUCache()
+    : capacity_(0),
+      high_pool_capacity_(0),
+      sketch_(nullptr),
+      secondary_(nullptr),
+      secondary_id_(0),
+      usage_(0),
+      high_pool_usage_(0) {
   // Make empty circular linked lists.
   lru_.next = &lru_;
   lru_.prev = &lru_;
+  lru_high_.next = &lru_high_;
+  lru_high_.prev = &lru_high_;
   in_use_.next = &in_use_;
   in_use_.prev = &in_use_;
 }
 
 LRUCache::~LRUCache() {
   assert(in_use_.next == &in_use_);  // Error if caller has an unreleased handle
-  for (LRUHandle* e = lru_.next; e != &lru_;) {
-    LRUHandle* next = e->next;
-    assert(e->in_cache);
-    e->in_cache = false;
-    assert(e->refs == 1);  // Invariant of lru_ list.
-    Unref(e);
-    e = next;
+  for (LRUHandle* list : {&lru_, &lru_high_}) {
+    for (LRUHandle* e = list->next; e != list;) {
+      LRUHandle* next = e->next;
+      assert(e->in_cache);
+      e->in_cache = false;
+      assert(e->refs == 1);  // Invariant of lru_ lists.
+      Unref(e);
+      e = next;
+    }
   }
 }
 
@@ -231,15 +299,45 @@ void LRUCache::Unref(LRUHandle* e) {
     (*e->deleter)(e->key(), e->value);
     free(e);
   } else if (e->in_cache && e->refs == 1) {
-    // No longer in use; move to lru_ list.
+    // No longer in use; move to an LRU list.
     LRU_Remove(e);
-    LRU_Append(&lru_, e);
+    LRU_Insert(e);
   }
 }
 
 void LRUCache::LRU_Remove(LRUHandle* e) {
   e->next->prev = e->prev;
   e->prev->next = e->next;
+  if (e->in_high_pool) {
+    high_pool_usage_ -= e->charge;
+    e->in_high_pool = false;
+  }
+}
+
+void LRUCache::LRU_Insert(LRUHandle* e) {
+  if (!e->high_pri || high_pool_capacity_ == 0) {
+    LRU_Append(&lru_, e);
+    return;
+  }
+  LRU_Append(&lru_high_, e);
+  e->in_high_pool = true;
+  high_pool_usage_ += e->charge;
+  // Demote the oldest high-priority entries once the pool is full.
+  while (high_pool_usage_ > high_pool_capacity_ &&
+         lru_high_.next != &lru_high_) {
+    LRUHandle* old = lru_high_.next;
+    LRU_Remove(old);
+    LRU_Append(&lru_, old);
+  }
+}
+
+LRUHandle* LRUCache::Victim() {
+  if (lru_.next != &lru_) {
+    return lru_.next;
+  } else if (lru_high_.next != &lru_high_) {
+    return lru_high_.next;
+  }
+  return nullptr;
 }
 
 void LRUCache::LRU_Append(LRUHandle* list, LRUHandle* e) {
@@ -252,6 +350,9 @@ void LRUCache::LRU_Append(LRUHandle* list, LRUHandle* e) {
 
 Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash) {
   MutexLock l(&mutex_);
+  if (sketch_ != nullptr) {
+    sketch_->Increment(hash);
+  }
   LRUHandle* e = table_.Lookup(key, hash);
   if (e != nullptr) {
     Ref(e);
@@ -267,21 +368,38 @@ void LRUCache::Release(Cache::Handle* handle) {
 Cache::Handle* LRUCache::Insert(const Slice& key, uint32_t hash, void* value,
                                 size_t charge,
                                 void (*deleter)(const Slice& key,
-                                                void* value)) {
-  MutexLock l(&mutex_);
+                                                void* value),
+                                Cache::Priority priority,
+                                Slice (*saver)(void* value)) {
+  LRUHandle* demoted = nullptr;  // Evicted entries, chained by next_hash
+  mutex_.Lock();
 
   LRUHandle* e =
       reinterpret_cast<LRUHandle*>(malloc(sizeof(LRUHandle) - 1 + key.size()));
   e->value = value;
   e->deleter = deleter;
+  e->saver = saver;
   e->charge = charge;
   e->key_length = key.size();
   e->hash = hash;
   e->in_cache = false;
+  e->high_pri = (priority == Cache::kHighPriority);
+  e->in_high_pool = false;
   e->refs = 1;  // for the returned handle.
   std::memcpy(e->key_data, key.data(), key.size());
 
-  if (capacity_ > 0) {
+  bool admit = capacity_ > 0;
+  if (admit && sketch_ != nullptr) {
+    sketch_->Increment(hash);
+    if (!e->high_pri && usage_ + charge > capacity_) {
+      // Only displace an entry that has been used less often.
+      LRUHandle* victim = Victim();
+      admit = victim == nullptr || table_.Lookup(key, hash) != nullptr ||
+              sketch_->Estimate(hash) > sketch_->Estimate(victim->hash);
+    }
+  }
+
+  if (admit) {
     e->refs++;  // for the cache's reference.
     e->in_cache = true;
     LRU_Append(&in_use_, e);
@@ -291,18 +409,43 @@ Cache::Handle* LRUCache::Insert(const Slice& key, uint32_t hash, void* value,
     // next is read by key() in an assert, so it must be initialized
     e->next = nullptr;
   }
-  while (usage_ > capacity_ && lru_.next != &lru_) {
-    LRUHandle* old = lru_.next;
+  LRUHandle* old;
+  while (usage_ > capacity_ && (old = Victim()) != nullptr) {
     assert(old->refs == 1);
+    if (secondary_ != nullptr && old->saver != nullptr) {
+      // Take the entry out of the cache but keep it alive until it has
+      // been demoted below.
+      table_.Remove(old->key(), old->hash);
+      LRU_Remove(old);
+      old->in_cache = false;
+      usage_ -= old->charge;
+      old->next_hash = demoted;
+      demoted = old;
+      continue;
+    }
     bool erased = FinishErase(table_.Remove(old->key(), old->hash));
     if (!erased) {  // to avoid unused variable when compiled NDEBUG
       assert(erased);
     }
   }
+  mutex_.Unlock();
 
+  DemoteAndFree(demoted);
   return reinterpret_cast<Cache::Handle*>(e);
 }
 
+void LRUCache::DemoteAndFree(LRUHandle* list) {
+  while (list != nullptr) {
+    LRUHandle* next = list->next_hash;
+    assert(list->refs == 1 && !list->in_cache);
+    secondary_->Insert(SecondaryCacheKey(secondary_id_, list->key()),
+                       (*list->saver)(list->value));
+    (*list->deleter)(list->key(), list->value);
+    free(list);
+    list = next;
+  }
+}
+
 // If e != nullptr, finish removing *e from the cache; it has already been
 // removed from the hash table.  Return whether e != nullptr.
 bool LRUCache::FinishErase(LRUHandle* e) {
@@ -323,8 +466,8 @@ void LRUCache::Erase(const Slice& key, uint32_t hash) {
 
 void LRUCache::Prune() {
   MutexLock l(&mutex_);
-  while (lru_.next != &lru_) {
-    LRUHandle* e = lru_.next;
+  LRUHandle* e;
+  while ((e = Victim()) != nullptr) {
     assert(e->refs == 1);
     bool erased = FinishErase(table_.Remove(e->key(), e->hash));
     if (!erased) {  // to avoid unused variable when compiled NDEBUG
@@ -333,12 +476,27 @@ void LRUCache::Prune() {
   }
 }
 
+void LRUCache::ApplyToAllEntries(
+    void (*callback)(void* arg, const Slice& key, void* value,
+                     void (*deleter)(const Slice& key, void* value)),
+    void* arg) {
+  MutexLock l(&mutex_);
+  for (LRUHandle* list : {&in_use_, &lru_high_, &lru_}) {
+    for (LRUHandle* e = list->next; e != list; e = e->next) {
+      (*callback)(arg, e->key(), e->value, e->deleter);
+    }
+  }
+}
+
 static const int kNumShardBits = 4;
 static const int kNumShards = 1 << kNumShardBits;
 
 class ShardedLRUCache : public Cache {
  private:
   LRUCache shard_[kNumShards];
+  FrequencySketch* sketch_;
+  SecondaryCache* const secondary_;
+  const uint64_t secondary_id_;
   port::Mutex id_mutex_;
   uint64_t last_id_;
 
@@ -349,17 +507,39 @@ class ShardedLRUCache : public Cache {
   static uint32_t Shard(uint32_t hash) { return hash >> (32 - kNumShardBits); }
 
  public:
-  explicit ShardedLRUCache(size_t capacity) : last_id_(0) {
-    const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+  explicit ShardedLRUCache(const CacheOptions& options)
+      : sketch_(options.admission_filter
+                    ? new FrequencySketch(
+                          options.capacity /
+                          std::max<size_t>(options.estimated_entry_charge, 1))
+                    : nullptr),
+        secondary_(options.secondary_cache),
+        secondary_id_(NewSecondaryCacheId()),
+        last_id_(0) {
+    const size_t per_shard =
+        (options.capacity + (kNumShards - 1)) / kNumShards;
     for (int s = 0; s < kNumShards; s++) {
       shard_[s].SetCapacity(per_shard);
+      shard_[s].SetHighPriorityPoolRatio(options.high_pri_pool_ratio);
+      shard_[s].SetAdmissionFilter(sketch_);
+      shard_[s].SetSecondaryCache(secondary_, secondary_id_);
     }
   }
-  ~ShardedLRUCache() override {}
+  ~ShardedLRUCache() override { delete sketch_; }
   Handle* Insert(const Slice& key, void* value, size_t charge,
                  void (*deleter)(const Slice& key, void* value)) override {
+    return Insert(key, value, charge, deleter, kLowPriority, nullptr);
+  }
+  Handle* Insert(const Slice& key, void* value, size_t charge,
+                 void (*deleter)(const Slice& key, void* value),
+                 Priority priority, Slice (*saver)(void* value)) override {
     const uint32_t hash = HashSlice(key);
-    return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter);
+    return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter,
+                                      priority, saver);
+  }
+  bool LookupSecondary(const Slice& key, std::string* contents) override {
+    return secondary_ != nullptr &&
+           secondary_->Lookup(SecondaryCacheKey(secondary_id_, key), contents);
   }
   Handle* Lookup(const Slice& key) override {
     const uint32_t hash = HashSlice(key);
@@ -392,10 +572,26 @@ class ShardedLRUCache : public Cache {
     }
     return total;
   }
+  void ApplyToAllEntries(
+      void (*callback)(void* arg, const Slice& key, void* value,
+                       void (*deleter)(const Slice& key, void* value)),
+      void* arg) override {
+    for (int s = 0; s < kNumShards; s++) {
+      shard_[s].ApplyToAllEntries(callback, arg);
+    }
+  }
 };
 
 }  // end anonymous namespace
 
-Cache* NewLRUCache(size_t capacity) { return new ShardedLRUCache(capacity); }
+Cache* NewLRUCache(size_t capacity) {
+  CacheOptions options;
+  options.capacity = capacity;
+  return new ShardedLRUCache(options);
+}
+
+Cache* NewLRUCache(const CacheOptions& options) {
+  return new ShardedLRUCache(options);
+}
 
 }  // namespace leveldb
@@ -4,6 +4,8 @@
 
 #include "leveldb/cache.h"
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -221,6 +223,124 @@ TEST_F(CacheTest, ZeroSizeCache) {
   ASSERT_EQ(-1, Lookup(1));
 }
 
+TEST_F(CacheTest, HighPriorityPool) {
+  delete cache_;
+  CacheOptions options;
+  options.capacity = kCacheSize;
+  options.high_pri_pool_ratio = 0.5;
+  cache_ = NewLRUCache(options);
+
+  for (int i = 0; i < 20; i++) {
+    cache_->Release(cache_->Insert(EncodeKey(i), EncodeValue(100 + i), 1,
+                                   &CacheTest::Deleter,
+                                   Cache::kHighPriority, nullptr));
+  }
+  // A flood of low-priority entries only evicts low-priority entries.
+  for (int i = 0; i < 2 * kCacheSize; i++) {
+    Insert(1000 + i, 2000 + i);
+  }
+  for (int i = 0; i < 20; i++) {
+    ASSERT_EQ(100 + i, Lookup(i));
+  }
+  ASSERT_LE(cache_->TotalCharge(), kCacheSize + kCacheSize / 10);
+}
+
+TEST_F(CacheTest, AdmissionFilter) {
+  delete cache_;
+  CacheOptions options;
+  options.capacity = kCacheSize;
+  options.admission_filter = true;
+  options.estimated_entry_charge = 1;
+  cache_ = NewLRUCache(options);
+
+  // A hot working set, looked up many times.
+  for (int i = 0; i < 100; i++) {
+    Insert(i, 100 + i);
+    for (int j = 0; j < 4; j++) {
+      ASSERT_EQ(100 + i, Lookup(i));
+    }
+  }
+
+  // A scan over many keys that are each read once.
+  for (int i = 0; i < 3 * kCacheSize; i++) {
+    ASSERT_EQ(-1, Lookup(10000 + i));
+    Insert(10000 + i, i);
+  }
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(100 + i, Lookup(i));
+  }
+
+  // A key that is asked for repeatedly is eventually admitted.
+  for (int j = 0; j < 8; j++) {
+    Lookup(50000);
+  }
+  Insert(50000, 7);
+  ASSERT_EQ(7, Lookup(50000));
+}
+
+namespace {
+
+// A secondary cache kept in a map.  Not thread-safe.
+class MapSecondaryCache : public SecondaryCache {
+ public:
+  void Insert(const Slice& key, const Slice& contents) override {
+    map_[key.ToString()] = contents.ToString();
+  }
+  bool Lookup(const Slice& key, std::string* contents) override {
+    auto it = map_.find(key.ToString());
+    if (it == map_.end()) {
+      return false;
+    }
+    *contents = it->second;
+    return true;
+  }
+
+ private:
+  std::map<std::string, std::string> map_;
+};
+
+void DeleteString(const Slice& key, void* value) {
+  delete reinterpret_cast<std::string*>(value);
+}
+
+Slice SaveString(void* value) { return *reinterpret_cast<std::string*>(value); }
+
+}  // namespace
+
+TEST_F(CacheTest, SharedSecondaryCache) {
+  MapSecondaryCache secondary;
+  CacheOptions options;
+  options.capacity = 16;  // One entry per shard
+  options.secondary_cache = &secondary;
+  Cache* a = NewLRUCache(options);
+  Cache* b = NewLRUCache(options);
+
+  // Both caches use the same keys for different values.
+  const int kNum = 200;
+  for (int i = 0; i < kNum; i++) {
+    a->Release(a->Insert(EncodeKey(i), new std::string("a" + std::to_string(i)),
+                         1, &DeleteString, Cache::kLowPriority, &SaveString));
+    b->Release(b->Insert(EncodeKey(i), new std::string("b" + std::to_string(i)),
+                         1, &DeleteString, Cache::kLowPriority, &SaveString));
+  }
+
+  int demoted = 0;
+  for (int i = 0; i < kNum; i++) {
+    std::string contents;
+    if (a->LookupSecondary(EncodeKey(i), &contents)) {
+      ASSERT_EQ("a" + std::to_string(i), contents);
+      demoted++;
+    }
+    if (b->LookupSecondary(EncodeKey(i), &contents)) {
+      ASSERT_EQ("b" + std::to_string(i), contents);
+      demoted++;
+    }
+  }
+  ASSERT_GT(demoted, kNum);
+  delete a;
+  delete b;
+}
+
 }  // namespace leveldb
 
 int main(int argc, char** argv) {
@@ -0,0 +1,621 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/frequency_sketch.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+#include "util/secondary_cache_key.h"
+
+namespace leveldb {
+
+namespace {
+
+// CLOCK cache
+//
+// Each shard keeps its entries in a fixed-size open-addressed table of
+// ClockHandle slots, probed linearly from hash & mask.  Slots are never
+// freed while the cache is alive, so readers can inspect any slot without
+// a lock: a reader pins an entry by atomically bumping the reference count
+// in the slot's "meta" word, which only succeeds while the slot is
+// visible, and only then looks at the key.
+//
+// Insert(), Erase(), Prune() and the CLOCK sweep hold the shard mutex so
+// that they do not race with each other.  Lookup() and Release() never
+// take it.  The last Release() of an erased entry frees it right away.
+//
+// Each slot also counts, in "displacements", the entries whose probe
+// sequence passed over it.  A lookup can stop at the first non-matching
+// slot with no displacements.
+//
+// The CLOCK sweep evicts unreferenced entries whose countdown has run out
+// and decrements the countdown of the others.  Lookup() resets the
+// countdown to its maximum, so hot entries survive several sweeps.
+// High-priority entries start with the maximum countdown as well.
+//
+// With an admission filter, the first entry the sweep would evict for a
+// low-priority insert is compared with the new key in the frequency
+// sketch, and the insert is not cached unless the new key is more popular.
+// Entries the sweep evicts are offered to the secondary cache, if any,
+// once Insert() has released the shard mutex.
+
+// Layout of ClockHandle::meta:
+//   bits  0..29: number of references held by clients
+//   bits 30..31: CLOCK countdown
+//   bits 32..33: state
+static const uint64_t kOneRef = 1;
+static const uint64_t kRefMask = (uint64_t{1} << 30) - 1;
+static const int kCountdownShift = 30;
+static const uint64_t kCountdownMask = uint64_t{3} << kCountdownShift;
+static const uint64_t kMaxCountdown = 3;
+static const uint64_t kInitialCountdown = 1;
+static const uint64_t kHighPriorityCountdown = kMaxCountdown;
+static const int kStateShift = 32;
+
+enum SlotState : uint64_t {
+  kEmpty = 0,         // Free for use by Insert()
+  kConstruction = 1,  // Being filled in or torn down by one thread
+  kVisible = 2,       // In the table; Lookup() may return it
+  kInvisible = 3,     // Erased, but still referenced by clients
+};
+
+static inline uint64_t Refs(uint64_t meta) { return meta & kRefMask; }
+static inline uint64_t Countdown(uint64_t meta) {
+  return (meta & kCountdownMask) >> kCountdownShift;
+}
+static inline uint64_t State(uint64_t meta) { return meta >> kStateShift; }
+static inline uint64_t MakeMeta(uint64_t state, uint64_t countdown,
+                                uint64_t refs) {
+  return (state << kStateShift) | (countdown << kCountdownShift) | refs;
+}
+
+struct ClockHandle {
+  std::atomic<uint64_t> meta{0};
+  std::atomic<uint32_t> displacements{0};
+  std::atomic<uint32_t> hash{0};
+
+  // Written only in state kConstruction; stable while a reference is held.
+  bool detached = false;  // Not in the table (the table was full)
+  size_t charge = 0;
+  void* value = nullptr;
+  void (*deleter)(const Slice&, void* value) = nullptr;
+  Slice (*saver)(void* value) = nullptr;
+  char* key_data = nullptr;
+  size_t key_length = 0;
+
+  Slice key() const { return Slice(key_data, key_length); }
+};
+
+// An entry the sweep took out of its slot, waiting to be stored in the
+// secondary cache and freed.
+struct DemotedEntry {
+  char* key_data;
+  size_t key_length;
+  void* value;
+  void (*deleter)(const Slice&, void* value);
+  Slice (*saver)(void* value);
+};
+
+// A single shard of sharded cache.
+class ClockCacheShard {
+ public:
+  ClockCacheShard() : slots_(nullptr), mask_(0), capacity_(0),
+                      max_occupancy_(0), sketch_(nullptr),
+                      secondary_(nullptr), secondary_id_(0), usage_(0),
+                      occupancy_(0), clock_pointer_(0) {}
+  ~ClockCacheShard();
+
+  ClockCacheShard(const ClockCacheShard&) = delete;
+  ClockCacheShard& operator=(const ClockCacheShard&) = delete;
+
+  // Separate from constructor so caller can easily make an array of
+  // ClockCacheShard.  "num_slots" must be a power of two.
+  void Init(size_t capacity, size_t num_slots, FrequencySketch* sketch,
+            SecondaryCache* secondary, uint64_t secondary_id);
+
+  Cache::Handle* Insert(const Slice& key, uint32_t hash, void* value,
+                        size_t charge,
+                        void (*deleter)(const Slice& key, void* value),
+                        Cache::Priority priority, Slice (*saver)(void* value));
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash);
+  void Release(Cache::Handle* handle);
+  void Erase(const Slice& key, uint32_t hash);
+  void Prune();
+  void ApplyToAllEntries(
+      void (*callback)(void* arg, const Slice& key, void* value,
+                       void (*deleter)(const Slice& key, void* value)),
+      void* arg);
+  size_t TotalCharge() const { return usage_.load(std::memory_order_relaxed); }
+
+ private:
+  // Pins *h if it is visible.  If "refresh" is true, also resets its CLOCK
+  // countdown, as a lookup does.
+  static bool TryRef(ClockHandle* h, bool refresh);
+  void Unref(ClockHandle* h);
+
+  // Frees *h if it is visible and unreferenced.  If "demoted" is
+  // non-null and the entry can go to the secondary cache, it is moved to
+  // *demoted instead of being destroyed.
+  bool TryEvict(ClockHandle* h, uint64_t meta,
+                std::vector<DemotedEntry>* demoted);
+
+  // Destroys the entry in *h, which the caller holds in state
+  // kConstruction, and returns the slot to kEmpty.
+  void FreeEntry(ClockHandle* h);
+
+  // Returns the slot of *h, whose entry has been destroyed or moved out,
+  // to kEmpty.
+  void ReleaseSlot(ClockHandle* h);
+
+  // Stores the entries in the secondary cache and destroys them.
+  void DemoteAndFree(const std::vector<DemotedEntry>& demoted)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Returns the visible slot holding "key", pinned, or nullptr.
+  ClockHandle* FindAndRef(const Slice& key, uint32_t hash);
+
+  // Hides *h from lookups and drops the reference held by the caller.
+  void MakeInvisibleAndUnref(ClockHandle* h);
+
+  // Runs the CLOCK sweep until "charge" more fits.  If "admission_hash"
+  // is non-null, returns false without evicting anything when the first
+  // victim is at least as popular as *admission_hash.
+  bool EvictUntilRoomFor(size_t charge, const uint32_t* admission_hash,
+                         std::vector<DemotedEntry>* demoted)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  ClockHandle* slots_;
+  size_t mask_;
+  size_t capacity_;
+  size_t max_occupancy_;  // Inserts evict entries beyond this many slots
+  FrequencySketch* sketch_;  // nullptr unless an admission filter is used
+  SecondaryCache* secondary_;
+  uint64_t secondary_id_;
+  std::atomic<size_t> usage_;
+  std::atomic<size_t> occupancy_;
+
+  // Serializes Insert(), Erase(), Prune() and the CLOCK sweep.
+  port::Mutex mutex_;
+  size_t clock_pointer_ GUARDED_BY(mutex_);
+};
+
+ClockCacheShard::~ClockCacheShard() {
+  for (size_t i = 0; slots_ != nullptr && i <= mask_; i++) {
+    ClockHandle* h = &slots_[i];
+    const uint64_t meta = h->meta.load(std::memory_order_relaxed);
+    if (State(meta) != kEmpty) {
+      assert(Refs(meta) == 0);  // Error if caller has an unreleased handle
+      (*h->deleter)(h->key(), h->value);
+      delete[] h->key_data;
+    }
+  }
+  delete[] slots_;
+}
+
+void ClockCacheShard::Init(size_t capacity, size_t num_slots,
+                           FrequencySketch* sketch,
+                           SecondaryCache* secondary,
+                           uint64_t secondary_id) {
+  assert((num_slots & (num_slots - 1)) == 0);
+  slots_ = new ClockHandle[num_slots];
+  mask_ = num_slots - 1;
+  capacity_ = capacity;
+  // Keep some slots free so that probe sequences stay short.
+  max_occupancy_ = num_slots - num_slots / 8;
+  sketch_ = sketch;
+  secondary_ = secondary;
+  secondary_id_ = secondary_id;
+}
+
+bool ClockCacheShard::TryRef(ClockHandle* h, bool refresh) {
+  uint64_t meta = h->meta.load(std::memory_order_acquire);
+  while (State(meta) == kVisible) {
+    const uint64_t updated =
+        MakeMeta(kVisible, refresh ? kMaxCountdown : Countdown(meta),
+                 Refs(meta) + kOneRef);
+    if (h->meta.compare_exchange_weak(meta, updated,
+                                      std::memory_order_acq_rel)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockCacheShard::Unref(ClockHandle* h) {
+  uint64_t meta = h->meta.fetch_sub(kOneRef, std::memory_order_acq_rel);
+  assert(Refs(meta) > 0);
+  meta -= kOneRef;
+  if (State(meta) == kInvisible && Refs(meta) == 0) {
+    // Last reference to an erased entry.
+    if (h->meta.compare_exchange_strong(meta,
+                                        MakeMeta(kConstruction, 0, 0),
+                                        std::memory_order_acq_rel)) {
+      FreeEntry(h);
+    }
+  }
+}
+
+bool ClockCacheShard::TryEvict(ClockHandle* h, uint64_t meta,
+                               std::vector<DemotedEntry>* demoted) {
+  if (State(meta) != kVisible || Refs(meta) != 0) {
+    return false;
+  }
+  if (!h->meta.compare_exchange_strong(meta, MakeMeta(kConstruction, 0, 0),
+                                       std::memory_order_acq_rel)) {
+    return false;
+  }
+  if (demoted != nullptr && secondary_ != nullptr && h->saver != nullptr) {
+    demoted->push_back(DemotedEntry{h->key_data, h->key_length, h->value,
+                                    h->deleter, h->saver});
+    h->key_data = nullptr;
+    ReleaseSlot(h);
+  } else {
+    FreeEntry(h);
+  }
+  return true;
+}
+
+void ClockCacheShard::FreeEntry(ClockHandle* h) {
+  (*h->deleter)(h->key(), h->value);
+  delete[] h->key_data;
+  h->key_data = nullptr;
+  if (h->detached) {
+    delete h;
+    return;
+  }
+  ReleaseSlot(h);
+}
+
+void ClockCacheShard::ReleaseSlot(ClockHandle* h) {
+  // Undo the displacements recorded when the entry was inserted.
+  const size_t index = h - slots_;
+  for (size_t i = h->hash.load(std::memory_order_relaxed) & mask_; i != index;
+       i = (i + 1) & mask_) {
+    slots_[i].displacements.fetch_sub(1, std::memory_order_relaxed);
+  }
+  usage_.fetch_sub(h->charge, std::memory_order_relaxed);
+  occupancy_.fetch_sub(1, std::memory_order_relaxed);
+  h->meta.store(MakeMeta(kEmpty, 0, 0), std::memory_order_release);
+}
+
+void ClockCacheShard::DemoteAndFree(const std::vector<DemotedEntry>& demoted) {
+  for (const DemotedEntry& d : demoted) {
+    const Slice key(d.key_data, d.key_length);
+    secondary_->Insert(SecondaryCacheKey(secondary_id_, key),
+                       (*d.saver)(d.value));
+    (*d.deleter)(key, d.value);
+    delete[] d.key_data;
+  }
+}
+
+ClockHandle* ClockCacheShard::FindAndRef(const Slice& key, uint32_t hash) {
+  size_t index = hash & mask_;
+  for (size_t probes = 0; probes <= mask_; probes++) {
+    ClockHandle* h = &slots_[index];
+    if (h->hash.load(std::memory_order_relaxed) == hash && TryRef(h, true)) {
+      // The entry cannot change while it is pinned, so check it again.
+      if (h->hash.load(std::memory_order_relaxed) == hash && h->key() == key) {
+        return h;
+      }
+      Unref(h);
+    }
+    if (h->displacements.load(std::memory_order_relaxed) == 0) {
+      break;
+    }
+    index = (index + 1) & mask_;
+  }
+  return nullptr;
+}
+
+void ClockCacheShard::MakeInvisibleAndUnref(ClockHandle* h) {
+  uint64_t meta = h->meta.load(std::memory_order_acquire);
+  while (State(meta) == kVisible &&
+         !h->meta.compare_exchange_weak(
+             meta, MakeMeta(kInvisible, Countdown(meta), Refs(meta)),
+             std::memory_order_acq_rel)) {
+  }
+  Unref(h);
+}
+
+bool ClockCacheShard::EvictUntilRoomFor(size_t charge,
+                                        const uint32_t* admission_hash,
+                                        std::vector<DemotedEntry>* demoted) {
+  // Each entry is visited at most kMaxCountdown + 1 times before it is
+  // either evicted or found to be pinned.
+  const size_t max_steps = (mask_ + 1) * (kMaxCountdown + 1);
+  for (size_t step = 0;
+       step < max_steps &&
+       (usage_.load(std::memory_order_relaxed) + charge > capacity_ ||
+        occupancy_.load(std::memory_order_relaxed) >= max_occupancy_);
+       step++) {
+    ClockHandle* h = &slots_[clock_pointer_];
+    clock_pointer_ = (clock_pointer_ + 1) & mask_;
+    uint64_t meta = h->meta.load(std::memory_order_acquire);
+    if (State(meta) != kVisible || Refs(meta) != 0) {
+      continue;
+    }
+    if (Countdown(meta) > 0) {
+      h->meta.compare_exchange_strong(
+          meta, MakeMeta(kVisible, Countdown(meta) - 1, 0),
+          std::memory_order_acq_rel);
+    } else {
+      if (admission_hash != nullptr) {
+        if (sketch_->Estimate(*admission_hash) <=
+            sketch_->Estimate(h->hash.load(std::memory_order_relaxed))) {
+          return false;
+        }
+        admission_hash = nullptr;
+      }
+      TryEvict(h, meta, demoted);
+    }
+  }
+  return true;
+}
+
+Cache::Handle* ClockCacheShard::Insert(const Slice& key, uint32_t hash,
+                                       void* value, size_t charge,
+                                       void (*deleter)(const Slice& key,
+                                                       void* value),
+                                       Cache::Priority priority,
+                                       Slice (*saver)(void* value)) {
+  std::vector<DemotedEntry> demoted;
+  mutex_.Lock();
+
+  // Any existing entry for the key is replaced.
+  ClockHandle* old = FindAndRef(key, hash);
+  if (old != nullptr) {
+    MakeInvisibleAndUnref(old);
+  }
+
+  // Replacements and high-priority entries skip the admission check.
+  const uint32_t* admission_hash = nullptr;
+  if (sketch_ != nullptr) {
+    sketch_->Increment(hash);
+    if (old == nullptr && priority == Cache::kLowPriority) {
+      admission_hash = &hash;
+    }
+  }
+
+  ClockHandle* h = nullptr;
+  if (capacity_ > 0 && EvictUntilRoomFor(charge, admission_hash, &demoted)) {
+    if (occupancy_.load(std::memory_order_relaxed) < max_occupancy_) {
+      const size_t home = hash & mask_;
+      size_t index = home;
+      for (size_t probes = 0; probes <= mask_; probes++) {
+        uint64_t expected = MakeMeta(kEmpty, 0, 0);
+        if (slots_[index].meta.compare_exchange_strong(
+                expected, MakeMeta(kConstruction, 0, 0),
+                std::memory_order_acq_rel)) {
+          h = &slots_[index];
+          break;
+        }
+        index = (index + 1) & mask_;
+      }
+      if (h != nullptr) {
+        for (size_t i = home; i != index; i = (i + 1) & mask_) {
+          slots_[i].displacements.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  if (h == nullptr) {
+    // Caching is off or the table is full of pinned entries: hand out an
+    // entry that is freed as soon as the caller releases it.
+    h = new ClockHandle;
+    h->detached = true;
+  }
+  h->hash.store(hash, std::memory_order_relaxed);
+  h->charge = charge;
+  h->value = value;
+  h->deleter = deleter;
+  h->saver = saver;
+  h->key_length = key.size();
+  h->key_data = new char[key.size()];
+  std::memcpy(h->key_data, key.data(), key.size());
+  if (h->detached) {
+    h->meta.store(MakeMeta(kInvisible, 0, kOneRef), std::memory_order_release);
+  } else {
+    usage_.fetch_add(charge, std::memory_order_relaxed);
+    occupancy_.fetch_add(1, std::memory_order_relaxed);
+    h->meta.store(MakeMeta(kVisible,
+                           priority == Cache::kHighPriority
+                               ? kHighPriorityCountdown
+                               : kInitialCountdown,
+                           kOneRef),
+                  std::memory_order_release);
+  }
+  mutex_.Unlock();
+
+  DemoteAndFree(demoted);
+  return reinterpret_cast<Cache::Handle*>(h);
+}
+
+Cache::Handle* ClockCacheShard::Lookup(const Slice& key, uint32_t hash) {
+  if (sketch_ != nullptr) {
+    sketch_->Increment(hash);
+  }
+  return reinterpret_cast<Cache::Handle*>(FindAndRef(key, hash));
+}
+
+void ClockCacheShard::Release(Cache::Handle* handle) {
+  Unref(reinterpret_cast<ClockHandle*>(handle));
+}
+
+void ClockCacheShard::Erase(const Slice& key, uint32_t hash) {
+  MutexLock l(&mutex_);
+  ClockHandle* h = FindAndRef(key, hash);
+  if (h != nullptr) {
+    MakeInvisibleAndUnref(h);
+  }
+}
+
+void ClockCacheShard::Prune() {
+  MutexLock l(&mutex_);
+  for (size_t i = 0; i <= mask_; i++) {
+    ClockHandle* h = &slots_[i];
+    TryEvict(h, h->meta.load(std::memory_order_acquire), nullptr);
+  }
+}
+
+void ClockCacheShard::ApplyToAllEntries(
+    void (*callback)(void* arg, const Slice& key, void* value,
+                     void (*deleter)(const Slice& key, void* value)),
+    void* arg) {
+  for (size_t i = 0; i <= mask_; i++) {
+    ClockHandle* h = &slots_[i];
+    // Pin the entry so that it cannot be freed under the callback, but
+    // leave its place in the eviction order alone.
+    if (TryRef(h, false)) {
+      (*callback)(arg, h->key(), h->value, h->deleter);
+      Unref(h);
+    }
+  }
+}
+
+class ShardedClockCache : public Cache {
+ private:
+  ClockCacheShard* shards_;
+  FrequencySketch* sketch_;
+  SecondaryCache* const secondary_;
+  const uint64_t secondary_id_;
+  const int num_shard_bits_;
+  std::atomic<uint64_t> last_id_;
+
+  static inline uint32_t HashSlice(const Slice& s) {
+    return Hash(s.data(), s.size(), 0);
+  }
+
+  // Shards are picked by the top bits of the hash; slots by the bottom.
+  uint32_t Shard(uint32_t hash) const {
+    return num_shard_bits_ > 0 ? hash >> (32 - num_shard_bits_) : 0;
+  }
+
+ public:
+  ShardedClockCache(const CacheOptions& options, int num_shard_bits)
+      : sketch_(nullptr),
+        secondary_(options.secondary_cache),
+        secondary_id_(NewSecondaryCacheId()),
+        num_shard_bits_(num_shard_bits),
+        last_id_(0) {
+    const int num_shards = 1 << num_shard_bits;
+    const size_t per_shard =
+        (options.capacity + (num_shards - 1)) / num_shards;
+    size_t estimated_entry_charge = options.estimated_entry_charge;
+    if (estimated_entry_charge == 0) {
+      estimated_entry_charge = 1;
+    }
+    if (options.admission_filter) {
+      sketch_ = new FrequencySketch(options.capacity / estimated_entry_charge);
+    }
+    // Size the table for ~70% load when the shard is full of entries of
+    // the estimated charge.
+    const size_t wanted_slots = per_shard / estimated_entry_charge * 10 / 7;
+    size_t num_slots = 16;
+    while (num_slots < wanted_slots && num_slots < (size_t{1} << 30)) {
+      num_slots <<= 1;
+    }
+    shards_ = new ClockCacheShard[num_shards];
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].Init(per_shard, num_slots, sketch_, secondary_,
+                      secondary_id_);
+    }
+  }
+  ~ShardedClockCache() override {
+    delete[] shards_;
+    delete sketch_;
+  }
+
+  Handle* Insert(const Slice& key, void* value, size_t charge,
+                 void (*deleter)(const Slice& key, void* value)) override {
+    return Insert(key, value, charge, deleter, kLowPriority, nullptr);
+  }
+  Handle* Insert(const Slice& key, void* value, size_t charge,
+                 void (*deleter)(const Slice& key, void* value),
+                 Priority priority, Slice (*saver)(void* value)) override {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)].Insert(key, hash, value, charge, deleter,
+                                       priority, saver);
+  }
+  bool LookupSecondary(const Slice& key, std::string* contents) override {
+    return secondary_ != nullptr &&
+           secondary_->Lookup(SecondaryCacheKey(secondary_id_, key), contents);
+  }
+  Handle* Lookup(const Slice& key) override {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)].Lookup(key, hash);
+  }
+  void Release(Handle* handle) override {
+    ClockHandle* h = reinterpret_cast<ClockHandle*>(handle);
+    shards_[Shard(h->hash.load(std::memory_order_relaxed))].Release(handle);
+  }
+  void Erase(const Slice& key) override {
+    const uint32_t hash = HashSlice(key);
+    shards_[Shard(hash)].Erase(key, hash);
+  }
+  void* Value(Handle* handle) override {
+    return reinterpret_cast<ClockHandle*>(handle)->value;
+  }
+  uint64_t NewId() override {
+    return last_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  void Prune() override {
+    for (int s = 0; s < (1 << num_shard_bits_); s++) {
+      shards_[s].Prune();
+    }
+  }
+  size_t TotalCharge() const override {
+    size_t total = 0;
+    for (int s = 0; s < (1 << num_shard_bits_); s++) {
+      total += shards_[s].TotalCharge();
+    }
+    return total;
+  }
+  void ApplyToAllEntries(
+      void (*callback)(void* arg, const Slice& key, void* value,
+                       void (*deleter)(const Slice& key, void* value)),
+      void* arg) override {
+    for (int s = 0; s < (1 << num_shard_bits_); s++) {
+      shards_[s].ApplyToAllEntries(callback, arg);
+    }
+  }
+};
+
+}  // end anonymous namespace
+
+Cache* NewClockCache(size_t capacity, size_t estimated_entry_charge,
+                     int num_shard_bits) {
+  CacheOptions options;
+  options.capacity = capacity;
+  options.estimated_entry_charge = estimated_entry_charge;
+  options.num_shard_bits = num_shard_bits;
+  return NewClockCache(options);
+}
+
+Cache* NewClockCache(const CacheOptions& options) {
+  const size_t capacity = options.capacity;
+  int num_shard_bits = options.num_shard_bits;
+  if (num_shard_bits < 0) {
+    // Aim for shards of at least 512KB, up to 64 shards.
+    num_shard_bits = 0;
+    while (num_shard_bits < 6 &&
+           (capacity >> (num_shard_bits + 1)) >= 512 * 1024) {
+      num_shard_bits++;
+    }
+  }
+  if (num_shard_bits > 20) {
+    num_shard_bits = 20;
+  }
+  return new ShardedClockCache(options, num_shard_bits);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,413 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "leveldb/cache.h"
+#include "util/coding.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+static std::string EncodeKey(int k) {
+  std::string result;
+  PutFixed32(&result, k);
+  return result;
+}
+static int DecodeKey(const Slice& k) {
+  assert(k.size() == 4);
+  return DecodeFixed32(k.data());
+}
+static void* EncodeValue(uintptr_t v) { return reinterpret_cast<void*>(v); }
+static int DecodeValue(void* v) { return reinterpret_cast<uintptr_t>(v); }
+
+class ClockCacheTest : public testing::Test {
+ public:
+  static void Deleter(const Slice& key, void* v) {
+    current_->deleted_keys_.push_back(DecodeKey(key));
+    current_->deleted_values_.push_back(DecodeValue(v));
+  }
+
+  static constexpr int kCacheSize = 1000;
+  std::vector<int> deleted_keys_;
+  std::vector<int> deleted_values_;
+  Cache* cache_;
+
+  ClockCacheTest() : cache_(NewClockCache(kCacheSize, 1)) { current_ = this; }
+
+  ~ClockCacheTest() { delete cache_; }
+
+  int Lookup(int key) {
+    Cache::Handle* handle = cache_->Lookup(EncodeKey(key));
+    const int r = (handle == nullptr) ? -1 : DecodeValue(cache_->Value(handle));
+    if (handle != nullptr) {
+      cache_->Release(handle);
+    }
+    return r;
+  }
+
+  void Insert(int key, int value, int charge = 1) {
+    cache_->Release(cache_->Insert(EncodeKey(key), EncodeValue(value), charge,
+                                   &ClockCacheTest::Deleter));
+  }
+
+  Cache::Handle* InsertAndReturnHandle(int key, int value, int charge = 1) {
+    return cache_->Insert(EncodeKey(key), EncodeValue(value), charge,
+                          &ClockCacheTest::Deleter);
+  }
+
+  void Erase(int key) { cache_->Erase(EncodeKey(key)); }
+  static ClockCacheTest* current_;
+};
+ClockCacheTest* ClockCacheTest::current_;
+
+TEST_F(ClockCacheTest, HitAndMiss) {
+  ASSERT_EQ(-1, Lookup(100));
+
+  Insert(100, 101);
+  ASSERT_EQ(101, Lookup(100));
+  ASSERT_EQ(-1, Lookup(200));
+
+  Insert(200, 201);
+  ASSERT_EQ(101, Lookup(100));
+  ASSERT_EQ(201, Lookup(200));
+
+  Insert(100, 102);
+  ASSERT_EQ(102, Lookup(100));
+  ASSERT_EQ(201, Lookup(200));
+
+  ASSERT_EQ(1, deleted_keys_.size());
+  ASSERT_EQ(100, deleted_keys_[0]);
+  ASSERT_EQ(101, deleted_values_[0]);
+}
+
+TEST_F(ClockCacheTest, Erase) {
+  Erase(200);
+  ASSERT_EQ(0, deleted_keys_.size());
+
+  Insert(100, 101);
+  Insert(200, 201);
+  Erase(100);
+  ASSERT_EQ(-1, Lookup(100));
+  ASSERT_EQ(201, Lookup(200));
+  ASSERT_EQ(1, deleted_keys_.size());
+  ASSERT_EQ(100, deleted_keys_[0]);
+
+  Erase(100);
+  ASSERT_EQ(1, deleted_keys_.size());
+}
+
+TEST_F(ClockCacheTest, EntriesArePinned) {
+  Insert(100, 101);
+  Cache::Handle* h1 = cache_->Lookup(EncodeKey(100));
+  ASSERT_EQ(101, DecodeValue(cache_->Value(h1)));
+
+  Insert(100, 102);
+  Cache::Handle* h2 = cache_->Lookup(EncodeKey(100));
+  ASSERT_EQ(102, DecodeValue(cache_->Value(h2)));
+  ASSERT_EQ(0, deleted_keys_.size());
+
+  cache_->Release(h1);
+  ASSERT_EQ(1, deleted_keys_.size());
+  ASSERT_EQ(101, deleted_values_[0]);
+
+  Erase(100);
+  ASSERT_EQ(-1, Lookup(100));
+  ASSERT_EQ(1, deleted_keys_.size());
+
+  cache_->Release(h2);
+  ASSERT_EQ(2, deleted_keys_.size());
+  ASSERT_EQ(102, deleted_values_[1]);
+}
+
+TEST_F(ClockCacheTest, EvictionPolicy) {
+  Insert(100, 101);
+  Insert(200, 201);
+  Insert(300, 301);
+  Cache::Handle* h = cache_->Lookup(EncodeKey(300));
+
+  // Frequently used entry must be kept around,
+  // as must things that are still in use.
+  for (int i = 0; i < kCacheSize + 100; i++) {
+    Insert(1000 + i, 2000 + i);
+    ASSERT_EQ(2000 + i, Lookup(1000 + i));
+    ASSERT_EQ(101, Lookup(100));
+  }
+  ASSERT_EQ(101, Lookup(100));
+  ASSERT_EQ(-1, Lookup(200));
+  ASSERT_EQ(301, Lookup(300));
+  cache_->Release(h);
+}
+
+static void IgnoreEntry(void* arg, const Slice& key, void* value,
+                        void (*deleter)(const Slice& key, void* value)) {}
+
+TEST_F(ClockCacheTest, ApplyToAllEntriesKeepsEvictionOrder) {
+  delete cache_;
+  cache_ = NewClockCache(10, 1, 0);
+  for (int i = 0; i < 10; i++) {
+    Insert(i, 100 + i);
+  }
+  for (int i = 5; i < 10; i++) {
+    ASSERT_EQ(100 + i, Lookup(i));
+  }
+
+  // Visiting the entries must not count as using them.
+  cache_->ApplyToAllEntries(&IgnoreEntry, nullptr);
+  for (int i = 10; i < 15; i++) {
+    Insert(i, 100 + i);
+    ASSERT_EQ(100 + i, Lookup(i));
+  }
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(-1, Lookup(i));
+  }
+  for (int i = 5; i < 15; i++) {
+    ASSERT_EQ(100 + i, Lookup(i));
+  }
+}
+
+TEST_F(ClockCacheTest, UseExceedsCacheSize) {
+  std::vector<Cache::Handle*> h;
+  for (int i = 0; i < kCacheSize + 100; i++) {
+    h.push_back(InsertAndReturnHandle(1000 + i, 2000 + i));
+  }
+  for (int i = 0; i < h.size(); i++) {
+    ASSERT_EQ(2000 + i, Lookup(1000 + i));
+  }
+  for (int i = 0; i < h.size(); i++) {
+    cache_->Release(h[i]);
+  }
+}
+
+TEST_F(ClockCacheTest, HeavyEntries) {
+  const int kLight = 1;
+  const int kHeavy = 10;
+  int added = 0;
+  int index = 0;
+  while (added < 2 * kCacheSize) {
+    const int weight = (index & 1) ? kLight : kHeavy;
+    Insert(index, 1000 + index, weight);
+    added += weight;
+    index++;
+  }
+
+  int cached_weight = 0;
+  for (int i = 0; i < index; i++) {
+    const int weight = (i & 1 ? kLight : kHeavy);
+    int r = Lookup(i);
+    if (r >= 0) {
+      cached_weight += weight;
+      ASSERT_EQ(1000 + i, r);
+    }
+  }
+  ASSERT_LE(cached_weight, kCacheSize + kCacheSize / 10);
+  ASSERT_LE(cache_->TotalCharge(), static_cast<size_t>(kCacheSize));
+}
+
+TEST_F(ClockCacheTest, TableFull) {
+  // A tiny estimated charge gives few slots; once they are all pinned,
+  // inserts hand out handles that are not cached.
+  delete cache_;
+  cache_ = NewClockCache(kCacheSize, kCacheSize, 0);
+
+  std::vector<Cache::Handle*> h;
+  for (int i = 0; i < 100; i++) {
+    h.push_back(InsertAndReturnHandle(i, 1000 + i));
+    ASSERT_EQ(1000 + i, DecodeValue(cache_->Value(h.back())));
+  }
+  ASSERT_LT(cache_->TotalCharge(), 100);
+  for (int i = 0; i < h.size(); i++) {
+    cache_->Release(h[i]);
+  }
+  ASSERT_EQ(100 - cache_->TotalCharge(), deleted_keys_.size());
+}
+
+TEST_F(ClockCacheTest, NewId) {
+  uint64_t a = cache_->NewId();
+  uint64_t b = cache_->NewId();
+  ASSERT_NE(a, b);
+}
+
+TEST_F(ClockCacheTest, Prune) {
+  Insert(1, 100);
+  Insert(2, 200);
+
+  Cache::Handle* handle = cache_->Lookup(EncodeKey(1));
+  ASSERT_TRUE(handle);
+  cache_->Prune();
+  cache_->Release(handle);
+
+  ASSERT_EQ(100, Lookup(1));
+  ASSERT_EQ(-1, Lookup(2));
+}
+
+TEST_F(ClockCacheTest, ZeroSizeCache) {
+  delete cache_;
+  cache_ = NewClockCache(0, 1);
+
+  Insert(1, 100);
+  ASSERT_EQ(-1, Lookup(1));
+  ASSERT_EQ(1, deleted_keys_.size());
+}
+
+TEST_F(ClockCacheTest, HighPriority) {
+  cache_->Release(cache_->Insert(EncodeKey(1), EncodeValue(101), 1,
+                                 &ClockCacheTest::Deleter,
+                                 Cache::kHighPriority, nullptr));
+  Insert(2, 102);
+
+  // Insert until the low-priority entry is evicted.  Lookups would reset
+  // the CLOCK countdowns, so watch the deleter instead.
+  auto evicted = [this](int key) {
+    return std::find(deleted_keys_.begin(), deleted_keys_.end(), key) !=
+           deleted_keys_.end();
+  };
+  for (int i = 0; !evicted(2); i++) {
+    ASSERT_LT(i, 10 * kCacheSize);
+    Insert(1000 + i, 2000 + i);
+  }
+  ASSERT_FALSE(evicted(1));
+  ASSERT_EQ(101, Lookup(1));
+}
+
+TEST_F(ClockCacheTest, AdmissionFilter) {
+  delete cache_;
+  CacheOptions options;
+  options.capacity = kCacheSize;
+  options.admission_filter = true;
+  options.estimated_entry_charge = 1;
+  cache_ = NewClockCache(options);
+
+  for (int i = 0; i < 100; i++) {
+    Insert(i, 100 + i);
+    for (int j = 0; j < 4; j++) {
+      ASSERT_EQ(100 + i, Lookup(i));
+    }
+  }
+  for (int i = 0; i < 3 * kCacheSize; i++) {
+    ASSERT_EQ(-1, Lookup(10000 + i));
+    Insert(10000 + i, i);
+  }
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(100 + i, Lookup(i));
+  }
+  ASSERT_LE(cache_->TotalCharge(), static_cast<size_t>(kCacheSize));
+
+  for (int j = 0; j < 8; j++) {
+    Lookup(50000);
+  }
+  Insert(50000, 7);
+  ASSERT_EQ(7, Lookup(50000));
+}
+
+// A secondary cache kept in a map.  Not thread-safe.
+class MapSecondaryCache : public SecondaryCache {
+ public:
+  void Insert(const Slice& key, const Slice& contents) override {
+    map_[key.ToString()] = contents.ToString();
+  }
+  bool Lookup(const Slice& key, std::string* contents) override {
+    auto it = map_.find(key.ToString());
+    if (it == map_.end()) {
+      return false;
+    }
+    *contents = it->second;
+    return true;
+  }
+
+ private:
+  std::map<std::string, std::string> map_;
+};
+
+static void DeleteString(const Slice& key, void* value) {
+  delete reinterpret_cast<std::string*>(value);
+}
+
+static Slice SaveString(void* value) {
+  return *reinterpret_cast<std::string*>(value);
+}
+
+TEST_F(ClockCacheTest, SecondaryCache) {
+  MapSecondaryCache secondary;
+  CacheOptions options;
+  options.capacity = 10;
+  options.estimated_entry_charge = 1;
+  options.num_shard_bits = 0;
+  options.secondary_cache = &secondary;
+  Cache* cache = NewClockCache(options);
+  Cache* other = NewClockCache(options);
+
+  const int kNum = 100;
+  for (int i = 0; i < kNum; i++) {
+    cache->Release(cache->Insert(EncodeKey(i),
+                                 new std::string(std::to_string(i)), 1,
+                                 &DeleteString, Cache::kLowPriority,
+                                 &SaveString));
+  }
+  int demoted = 0;
+  for (int i = 0; i < kNum; i++) {
+    std::string contents;
+    if (cache->LookupSecondary(EncodeKey(i), &contents)) {
+      ASSERT_EQ(std::to_string(i), contents);
+      demoted++;
+    }
+    // The tier keeps the entries of different caches apart.
+    ASSERT_FALSE(other->LookupSecondary(EncodeKey(i), &contents));
+  }
+  ASSERT_GE(demoted, kNum - 10);
+  delete cache;
+  delete other;
+}
+
+static void CountingDeleter(const Slice& key, void* v) {
+  reinterpret_cast<std::atomic<int>*>(v)->fetch_sub(1);
+}
+
+TEST(ClockCacheConcurrencyTest, ManyThreads) {
+  std::atomic<int> live(0);
+  Cache* cache = NewClockCache(500, 1, 2);
+  const int kThreads = 8;
+  const int kOps = 20000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([cache, &live, t]() {
+      Random rnd(301 + t);
+      for (int i = 0; i < kOps; i++) {
+        const std::string key = EncodeKey(rnd.Uniform(2000));
+        if (rnd.OneIn(4)) {
+          live.fetch_add(1);
+          cache->Release(cache->Insert(key, &live, 1, &CountingDeleter));
+        } else if (rnd.OneIn(20)) {
+          cache->Erase(key);
+        } else {
+          Cache::Handle* h = cache->Lookup(key);
+          if (h != nullptr) {
+            ASSERT_EQ(&live, cache->Value(h));
+            cache->Release(h);
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  cache->Prune();
+  ASSERT_EQ(0, cache->TotalCharge());
+  delete cache;
+  ASSERT_EQ(0, live.load());
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
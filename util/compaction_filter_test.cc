@@ -0,0 +1,64 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/compaction_filter.h"
+
+#include "gtest/gtest.h"
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+#include "util/coding.h"
+
+namespace leveldb {
+
+namespace {
+
+class FixedClockEnv : public EnvWrapper {
+ public:
+  explicit FixedClockEnv(uint64_t now_seconds)
+      : EnvWrapper(Env::Default()), now_seconds_(now_seconds) {}
+
+  uint64_t NowMicros() override { return now_seconds_ * 1000000; }
+
+ private:
+  const uint64_t now_seconds_;
+};
+
+std::string Stamped(const std::string& value, uint64_t write_time) {
+  std::string result = value;
+  PutFixed64(&result, write_time);
+  return result;
+}
+
+}  // namespace
+
+TEST(CompactionFilterTest, TTL) {
+  FixedClockEnv env(1000);
+  const CompactionFilter* filter = NewTTLCompactionFilter(100, &env);
+  std::string new_value;
+  bool value_changed = false;
+
+  ASSERT_FALSE(filter->Filter(1, "k", Stamped("v", 1000), &new_value,
+                              &value_changed));
+  ASSERT_FALSE(filter->Filter(1, "k", Stamped("v", 900), &new_value,
+                              &value_changed));
+  ASSERT_TRUE(filter->Filter(1, "k", Stamped("v", 899), &new_value,
+                             &value_changed));
+  ASSERT_TRUE(filter->Filter(1, "k", Stamped("", 0), &new_value,
+                             &value_changed));
+  // Written "later" than now, e.g. by a host whose clock is ahead.
+  ASSERT_FALSE(filter->Filter(1, "k", Stamped("v", 5000), &new_value,
+                              &value_changed));
+  // Too short to carry a timestamp.
+  ASSERT_FALSE(filter->Filter(1, "k", "short", &new_value, &value_changed));
+  ASSERT_FALSE(value_changed);
+
+  delete filter;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -18,6 +18,30 @@ Env::Env() = default;
 
 Env::~Env() = default;
 
+Status Env::NewRandomAccessFile(const std::string& fname,
+                                const FileOptions& options,
+                                RandomAccessFile** result) {
+  return NewRandomAccessFile(fname, result);
+}
+
+Status Env::NewWritableFile(const std::string& fname,
+                            const FileOptions& options,
+                            WritableFile** result) {
+  return NewWritableFile(fname, result);
+}
+
+Status Env::ReuseWritableFile(const std::string& fname,
+                              const std::string& old_fname,
+                              const FileOptions& options,
+                              WritableFile** result) {
+  Status s = RenameFile(old_fname, fname);
+  if (!s.ok()) {
+    *result = nullptr;
+    return s;
+  }
+  return NewWritableFile(fname, options, result);
+}
+
 Status Env::NewAppendableFile(const std::string& fname, WritableFile** result) {
   return Status::NotSupported("NewAppendableFile", fname);
 }
@@ -32,6 +56,13 @@ SequentialFile::~SequentialFile() = default;
 
 RandomAccessFile::~RandomAccessFile() = default;
 
+void RandomAccessFile::MultiRead(ReadRequest* reqs, size_t num_reqs) const {
+  for (size_t i = 0; i < num_reqs; i++) {
+    reqs[i].status = Read(reqs[i].offset, reqs[i].n, &reqs[i].result,
+                          reqs[i].scratch);
+  }
+}
+
 WritableFile::~WritableFile() = default;
 
 Logger::~Logger() = default;
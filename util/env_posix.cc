@@ -14,6 +14,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
 #include <cstddef>
@@ -34,9 +35,15 @@
 #include "leveldb/status.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
+#include "util/aligned_buffer.h"
 #include "util/env_posix_test_helper.h"
 #include "util/posix_logger.h"
 
+#if HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif  // HAVE_IO_URING
+
 namespace leveldb {
 
 namespace {
@@ -59,6 +66,9 @@ constexpr const int kOpenBaseFlags = 0;
 
 constexpr const size_t kWritableFileBufferSize = 65536;
 
+// Number of idle direct I/O buffers kept for reuse.
+constexpr const int kMaxFreeDirectIOBuffers = 32;
+
 Status PosixError(const std::string& context, int error_number) {
   if (error_number == ENOENT) {
     return Status::NotFound(context, std::strerror(error_number));
@@ -67,6 +77,305 @@ Status PosixError(const std::string& context, int error_number) {
   }
 }
 
+// Reads up to "n" bytes at "offset" of the file open as "fd" with pread().
+Status PosixRead(int fd, const std::string& filename, uint64_t offset,
+                 size_t n, Slice* result, char* scratch) {
+  ssize_t read_size = ::pread(fd, scratch, n, static_cast<off_t>(offset));
+  *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
+  if (read_size < 0) {
+    // An error: return a non-ok status.
+    return PosixError(filename, errno);
+  }
+  return Status::OK();
+}
+
+// Ensures that all the caches associated with the given file descriptor's
+// data are flushed all the way to durable media, and can withstand power
+// failures.
+//
+// The path argument is only used to populate the description string in the
+// returned Status if an error occurs.
+Status SyncFd(int fd, const std::string& fd_path) {
+#if HAVE_FULLFSYNC
+  // On macOS and iOS, fsync() doesn't guarantee durability past power
+  // failures. fcntl(F_FULLFSYNC) is required for that purpose. Some
+  // filesystems don't support fcntl(F_FULLFSYNC), and require a fallback to
+  // fsync().
+  if (::fcntl(fd, F_FULLFSYNC) == 0) {
+    return Status::OK();
+  }
+#endif  // HAVE_FULLFSYNC
+
+#if HAVE_FDATASYNC
+  bool sync_success = ::fdatasync(fd) == 0;
+#else
+  bool sync_success = ::fsync(fd) == 0;
+#endif  // HAVE_FDATASYNC
+
+  if (sync_success) {
+    return Status::OK();
+  }
+  return PosixError(fd_path, errno);
+}
+
+// Opens "filename" so that its reads and writes bypass the page cache, if
+// the platform and file system allow it, and normally otherwise.
+int OpenForDirectIO(const std::string& filename, int flags, mode_t mode) {
+  int fd;
+#if defined(O_DIRECT)
+  fd = ::open(filename.c_str(), flags | O_DIRECT, mode);
+  if (fd >= 0 || errno != EINVAL) {
+    return fd;
+  }
+  // EINVAL: the file system does not support O_DIRECT.
+#endif  // defined(O_DIRECT)
+  fd = ::open(filename.c_str(), flags, mode);
+#if defined(F_NOCACHE)
+  if (fd >= 0) {
+    ::fcntl(fd, F_NOCACHE, 1);
+  }
+#endif  // defined(F_NOCACHE)
+  return fd;
+}
+
+// Reserves disk space for the first "size" bytes of "fd" without changing
+// its size.  Best effort: a failure only means appends allocate as they go.
+void PreallocateFile(int fd, uint64_t size) {
+#if HAVE_FALLOCATE
+  ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+#else
+  (void)fd;
+  (void)size;
+#endif  // HAVE_FALLOCATE
+}
+
+#if HAVE_IO_URING
+// A minimal io_uring instance that submits batches of reads with a single
+// system call and waits for all of them.  Talks to the kernel through the
+// raw system calls, so liburing is not needed.
+//
+// Instances are not thread-safe; see ThreadIoUring().
+class IoUring {
+ public:
+  IoUring()
+      : ring_fd_(-1),
+        sq_ring_(MAP_FAILED),
+        cq_ring_(MAP_FAILED),
+        sqes_(MAP_FAILED) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, kQueueDepth,
+                                        &params));
+    if (fd < 0) {
+      return;  // Not supported by the kernel, or not permitted.
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    sqes_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED ||
+        sqes_ == MAP_FAILED) {
+      Unmap();
+      ::close(fd);
+      return;
+    }
+
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    if (sq_entries_ > kQueueDepth) {
+      sq_entries_ = kQueueDepth;  // ReadBatch() relies on this bound.
+    }
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    ring_fd_ = fd;
+  }
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  ~IoUring() {
+    if (ring_fd_ >= 0) {
+      Unmap();
+      ::close(ring_fd_);
+    }
+  }
+
+  bool ok() const { return ring_fd_ >= 0; }
+
+  // Performs reqs[0..num_reqs-1] on the file open as "fd".  Returns the
+  // number of leading requests that were performed; the caller is
+  // responsible for the rest.
+  size_t Read(int fd, const std::string& filename,
+              RandomAccessFile::ReadRequest* reqs, size_t num_reqs) {
+    size_t done = 0;
+    while (done < num_reqs) {
+      const unsigned batch = static_cast<unsigned>(
+          std::min<size_t>(num_reqs - done, sq_entries_));
+      const unsigned submitted = ReadBatch(fd, filename, reqs + done, batch);
+      done += submitted;
+      if (submitted < batch) {
+        break;
+      }
+    }
+    return done;
+  }
+
+ private:
+  static constexpr unsigned kQueueDepth = 64;
+
+  // Submits reqs[0..num_reqs-1] and waits for them.  Returns the number of
+  // leading requests that were submitted and so performed.
+  unsigned ReadBatch(int fd, const std::string& filename,
+                     RandomAccessFile::ReadRequest* reqs, unsigned num_reqs) {
+    // Only this thread produces submissions, so the tail can be read
+    // without synchronization.
+    unsigned tail = *sq_tail_;
+    for (unsigned i = 0; i < num_reqs; i++) {
+      const unsigned index = tail & sq_mask_;
+      io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+      std::memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uintptr_t>(reqs[i].scratch);
+      sqe->len = static_cast<uint32_t>(reqs[i].n);
+      sqe->off = reqs[i].offset;
+      sqe->user_data = i;
+      sq_array_[index] = index;
+      tail++;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+    unsigned submitted = 0;
+    while (submitted < num_reqs) {
+      int ret = Enter(num_reqs - submitted, 0);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        // Withdraw the entries the kernel did not take, so that a later
+        // io_uring_enter() cannot pick them up, and let the caller fall
+        // back to pread() for them.
+        __atomic_store_n(sq_tail_, tail - (num_reqs - submitted),
+                         __ATOMIC_RELEASE);
+        break;
+      }
+      submitted += ret;
+    }
+
+    bool req_completed[kQueueDepth] = {};
+    unsigned completed = 0;
+    while (completed < submitted) {
+      unsigned head = *cq_head_;
+      const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      if (head == cq_tail) {
+        // Wait for a completion.
+        if (Enter(0, 1) < 0 && errno != EINTR && errno != EAGAIN &&
+            errno != EBUSY) {
+          // The ring is unusable, so the requests still in flight fail.
+          const int error_number = errno;
+          for (unsigned i = 0; i < submitted; i++) {
+            if (!req_completed[i]) {
+              reqs[i].result = Slice(reqs[i].scratch, 0);
+              reqs[i].status = PosixError(filename, error_number);
+            }
+          }
+          break;
+        }
+        continue;
+      }
+      for (; head != cq_tail; head++) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        RandomAccessFile::ReadRequest& req = reqs[cqe.user_data];
+        req_completed[cqe.user_data] = true;
+        if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+          // Kernels before 5.6 lack IORING_OP_READ.
+          req.status =
+              PosixRead(fd, filename, req.offset, req.n, &req.result,
+                        req.scratch);
+        } else if (cqe.res < 0) {
+          req.result = Slice(req.scratch, 0);
+          req.status = PosixError(filename, -cqe.res);
+        } else {
+          req.result = Slice(req.scratch, cqe.res);
+          req.status = Status::OK();
+        }
+        completed++;
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+    return submitted;
+  }
+
+  int Enter(unsigned to_submit, unsigned min_complete) {
+    return static_cast<int>(::syscall(
+        __NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+        min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+  }
+
+  void Unmap() {
+    if (sq_ring_ != MAP_FAILED) ::munmap(sq_ring_, sq_ring_size_);
+    if (cq_ring_ != MAP_FAILED) ::munmap(cq_ring_, cq_ring_size_);
+    if (sqes_ != MAP_FAILED) ::munmap(sqes_, sqes_size_);
+  }
+
+  int ring_fd_;
+  void* sq_ring_;
+  void* cq_ring_;
+  void* sqes_;
+  size_t sq_ring_size_;
+  size_t cq_ring_size_;
+  size_t sqes_size_;
+
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned sq_entries_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+// Returns the calling thread's io_uring instance, or nullptr if io_uring
+// cannot be used.
+IoUring* ThreadIoUring() {
+  static thread_local IoUring ring;
+  return ring.ok() ? &ring : nullptr;
+}
+#endif  // HAVE_IO_URING
+
+// Performs reqs[0..num_reqs-1] on the file open as "fd".  Submits the whole
+// batch through io_uring when available; otherwise, and for any reads
+// io_uring did not take, issues one pread() per request.
+void PosixMultiRead(int fd, const std::string& filename,
+                    RandomAccessFile::ReadRequest* reqs, size_t num_reqs) {
+  size_t done = 0;
+#if HAVE_IO_URING
+  if (num_reqs > 1) {
+    IoUring* ring = ThreadIoUring();
+    if (ring != nullptr) {
+      done = ring->Read(fd, filename, reqs, num_reqs);
+    }
+  }
+#endif  // HAVE_IO_URING
+  for (size_t i = done; i < num_reqs; i++) {
+    reqs[i].status = PosixRead(fd, filename, reqs[i].offset, reqs[i].n,
+                               &reqs[i].result, reqs[i].scratch);
+  }
+}
+
 // Helper class to limit resource usage to avoid exhaustion.
 // Currently used to limit read-only file descriptors and mmap file usage
 // so that we do not run out of file descriptors or virtual memory, or run into
@@ -182,13 +491,7 @@ class PosixRandomAccessFile final : public RandomAccessFile {
 
     assert(fd != -1);
 
-    Status status;
-    ssize_t read_size = ::pread(fd, scratch, n, static_cast<off_t>(offset));
-    *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
-    if (read_size < 0) {
-      // An error: return a non-ok status.
-      status = PosixError(filename_, errno);
-    }
+    Status status = PosixRead(fd, filename_, offset, n, result, scratch);
     if (!has_permanent_fd_) {
       // Close the temporary file descriptor opened earlier.
       assert(fd != fd_);
@@ -197,6 +500,27 @@ class PosixRandomAccessFile final : public RandomAccessFile {
     return status;
   }
 
+  void MultiRead(ReadRequest* reqs, size_t num_reqs) const override {
+    int fd = fd_;
+    if (!has_permanent_fd_) {
+      fd = ::open(filename_.c_str(), O_RDONLY | kOpenBaseFlags);
+      if (fd < 0) {
+        Status status = PosixError(filename_, errno);
+        for (size_t i = 0; i < num_reqs; i++) {
+          reqs[i].result = Slice();
+          reqs[i].status = status;
+        }
+        return;
+      }
+    }
+
+    PosixMultiRead(fd, filename_, reqs, num_reqs);
+    if (!has_permanent_fd_) {
+      assert(fd != fd_);
+      ::close(fd);
+    }
+  }
+
  private:
   const bool has_permanent_fd_;  // If false, the file is opened on every read.
   const int fd_;                 // -1 if has_permanent_fd_ is false.
@@ -248,6 +572,70 @@ class PosixMmapReadableFile final : public RandomAccessFile {
   const std::string filename_;
 };
 
+// Implements random read access in a file opened for direct I/O.  Reads
+// whole aligned pages into a buffer from |buffers| and copies out the
+// requested bytes.
+//
+// Instances of this class are thread-safe, as required by the RandomAccessFile
+// API. Instances are immutable and Read() only calls thread-safe library
+// functions.
+class PosixDirectRandomAccessFile final : public RandomAccessFile {
+ public:
+  // The new instance takes ownership of |fd|. |buffers| must outlive this
+  // instance.
+  PosixDirectRandomAccessFile(std::string filename, int fd,
+                              AlignedBufferPool* buffers)
+      : fd_(fd), buffers_(buffers), filename_(std::move(filename)) {}
+
+  ~PosixDirectRandomAccessFile() override { ::close(fd_); }
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    ReadRequest req;
+    req.offset = offset;
+    req.n = n;
+    req.scratch = scratch;
+    MultiRead(&req, 1);
+    *result = req.result;
+    return req.status;
+  }
+
+  void MultiRead(ReadRequest* reqs, size_t num_reqs) const override {
+    const size_t alignment = buffers_->alignment();
+    std::vector<ReadRequest> aligned(num_reqs);
+    size_t total = 0;
+    for (size_t i = 0; i < num_reqs; i++) {
+      aligned[i].offset = AlignDown(reqs[i].offset, alignment);
+      aligned[i].n =
+          AlignUp(reqs[i].offset + reqs[i].n, alignment) - aligned[i].offset;
+      total += aligned[i].n;
+    }
+    AlignedBuffer buffer(buffers_, total);
+    char* scratch = buffer.data();
+    for (size_t i = 0; i < num_reqs; i++) {
+      aligned[i].scratch = scratch;
+      scratch += aligned[i].n;
+    }
+
+    PosixMultiRead(fd_, filename_, aligned.data(), num_reqs);
+
+    for (size_t i = 0; i < num_reqs; i++) {
+      const Slice& pages = aligned[i].result;
+      const size_t skip = reqs[i].offset - aligned[i].offset;
+      const size_t size =
+          pages.size() > skip ? std::min(reqs[i].n, pages.size() - skip) : 0;
+      std::memcpy(reqs[i].scratch, pages.data() + skip, size);
+      reqs[i].result = Slice(reqs[i].scratch, size);
+      reqs[i].status = aligned[i].status;
+    }
+  }
+
+ private:
+  const int fd_;
+  AlignedBufferPool* const buffers_;
+  const std::string filename_;
+};
+
 class PosixWritableFile final : public WritableFile {
  public:
   PosixWritableFile(std::string filename, int fd)
@@ -362,35 +750,6 @@ class PosixWritableFile final : public WritableFile {
     return status;
   }
 
-  // Ensures that all the caches associated with the given file descriptor's
-  // data are flushed all the way to durable media, and can withstand power
-  // failures.
-  //
-  // The path argument is only used to populate the description string in the
-  // returned Status if an error occurs.
-  static Status SyncFd(int fd, const std::string& fd_path) {
-#if HAVE_FULLFSYNC
-    // On macOS and iOS, fsync() doesn't guarantee durability past power
-    // failures. fcntl(F_FULLFSYNC) is required for that purpose. Some
-    // filesystems don't support fcntl(F_FULLFSYNC), and require a fallback to
-    // fsync().
-    if (::fcntl(fd, F_FULLFSYNC) == 0) {
-      return Status::OK();
-    }
-#endif  // HAVE_FULLFSYNC
-
-#if HAVE_FDATASYNC
-    bool sync_success = ::fdatasync(fd) == 0;
-#else
-    bool sync_success = ::fsync(fd) == 0;
-#endif  // HAVE_FDATASYNC
-
-    if (sync_success) {
-      return Status::OK();
-    }
-    return PosixError(fd_path, errno);
-  }
-
   // Returns the directory name in a path pointing to a file.
   //
   // Returns "." if the path does not contain any directory separator.
@@ -438,6 +797,123 @@ class PosixWritableFile final : public WritableFile {
   const std::string dirname_;  // The directory of filename_.
 };
 
+// Writes a new file opened for direct I/O.  Data is staged in an aligned
+// buffer and written in whole pages: when the buffer fills, and on Sync()
+// and Close(), where the last partial page is padded and written again by
+// the next write.  Close() trims the padding off the end of the file.
+//
+// Flush() does nothing, as pushing out a partial page would only mean
+// writing it again later.  Table files, the only files written this way,
+// are not read before they are closed.
+class PosixDirectWritableFile final : public WritableFile {
+ public:
+  // The new instance takes ownership of |fd|. |buffers| must outlive this
+  // instance.
+  PosixDirectWritableFile(std::string filename, int fd,
+                          AlignedBufferPool* buffers)
+      : buffers_(buffers),
+        buf_(buffers->Allocate(buffers->buffer_size())),
+        pos_(0),
+        file_offset_(0),
+        fd_(fd),
+        filename_(std::move(filename)) {}
+
+  ~PosixDirectWritableFile() override {
+    if (fd_ >= 0) {
+      // Ignoring any potential errors
+      Close();
+    }
+    buffers_->Release(buf_, buffers_->buffer_size());
+  }
+
+  Status Append(const Slice& data) override {
+    const char* write_data = data.data();
+    size_t write_size = data.size();
+    while (write_size > 0) {
+      const size_t copy_size =
+          std::min(write_size, buffers_->buffer_size() - pos_);
+      std::memcpy(buf_ + pos_, write_data, copy_size);
+      write_data += copy_size;
+      write_size -= copy_size;
+      pos_ += copy_size;
+      if (pos_ == buffers_->buffer_size()) {
+        Status status = WriteAligned(pos_);
+        if (!status.ok()) {
+          return status;
+        }
+        file_offset_ += pos_;
+        pos_ = 0;
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Close() override {
+    Status status = WriteTail();
+    if (status.ok() && ::ftruncate(fd_, file_offset_ + pos_) < 0) {
+      status = PosixError(filename_, errno);
+    }
+    const int close_result = ::close(fd_);
+    if (close_result < 0 && status.ok()) {
+      status = PosixError(filename_, errno);
+    }
+    fd_ = -1;
+    return status;
+  }
+
+  Status Flush() override { return Status::OK(); }
+
+  Status Sync() override {
+    Status status = WriteTail();
+    if (!status.ok()) {
+      return status;
+    }
+    return SyncFd(fd_, filename_);
+  }
+
+ private:
+  // Writes buf_[0, size - 1] at file_offset_.  |size| must be aligned.
+  Status WriteAligned(size_t size) {
+    size_t written = 0;
+    while (written < size) {
+      ssize_t write_result =
+          ::pwrite(fd_, buf_ + written, size - written,
+                   static_cast<off_t>(file_offset_ + written));
+      if (write_result < 0) {
+        if (errno == EINTR) {
+          continue;  // Retry
+        }
+        return PosixError(filename_, errno);
+      }
+      written += write_result;
+    }
+    return Status::OK();
+  }
+
+  // Writes the buffered data, padded to whole pages, and keeps the last
+  // partial page at the start of the buffer.
+  Status WriteTail() {
+    const size_t alignment = buffers_->alignment();
+    const size_t size = AlignUp(pos_, alignment);
+    std::memset(buf_ + pos_, 0, size - pos_);
+    Status status = WriteAligned(size);
+    if (status.ok()) {
+      const size_t done = AlignDown(pos_, alignment);
+      std::memmove(buf_, buf_ + done, pos_ - done);
+      file_offset_ += done;
+      pos_ -= done;
+    }
+    return status;
+  }
+
+  AlignedBufferPool* const buffers_;
+  char* const buf_;       // buf_[0, pos_ - 1] is to be written at file_offset_.
+  size_t pos_;
+  uint64_t file_offset_;  // Always aligned.
+  int fd_;
+  const std::string filename_;
+};
+
 int LockOrUnlock(int fd, bool lock) {
   errno = 0;
   struct ::flock file_lock_info;
@@ -513,13 +989,29 @@ class PosixEnv : public Env {
 
   Status NewRandomAccessFile(const std::string& filename,
                              RandomAccessFile** result) override {
+    return NewRandomAccessFile(filename, FileOptions(), result);
+  }
+
+  Status NewRandomAccessFile(const std::string& filename,
+                             const FileOptions& options,
+                             RandomAccessFile** result) override {
     *result = nullptr;
+    if (options.use_direct_io) {
+      int fd = OpenForDirectIO(filename, O_RDONLY | kOpenBaseFlags, 0);
+      if (fd < 0) {
+        return PosixError(filename, errno);
+      }
+      *result =
+          new PosixDirectRandomAccessFile(filename, fd, &direct_io_buffers_);
+      return Status::OK();
+    }
+
     int fd = ::open(filename.c_str(), O_RDONLY | kOpenBaseFlags);
     if (fd < 0) {
       return PosixError(filename, errno);
     }
 
-    if (!mmap_limiter_.Acquire()) {
+    if (!options.allow_mmap_reads || !mmap_limiter_.Acquire()) {
       *result = new PosixRandomAccessFile(filename, fd, &fd_limiter_);
       return Status::OK();
     }
@@ -557,6 +1049,51 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  Status NewWritableFile(const std::string& filename,
+                         const FileOptions& options,
+                         WritableFile** result) override {
+    const int flags = O_TRUNC | O_WRONLY | O_CREAT | kOpenBaseFlags;
+    int fd = options.use_direct_io ? OpenForDirectIO(filename, flags, 0644)
+                                   : ::open(filename.c_str(), flags, 0644);
+    if (fd < 0) {
+      *result = nullptr;
+      return PosixError(filename, errno);
+    }
+
+    if (options.preallocation_size > 0) {
+      PreallocateFile(fd, options.preallocation_size);
+    }
+    if (options.use_direct_io) {
+      *result = new PosixDirectWritableFile(filename, fd, &direct_io_buffers_);
+    } else {
+      *result = new PosixWritableFile(filename, fd);
+    }
+    return Status::OK();
+  }
+
+  Status ReuseWritableFile(const std::string& filename,
+                           const std::string& old_filename,
+                           const FileOptions& options,
+                           WritableFile** result) override {
+    if (options.use_direct_io) {
+      // Direct writes truncate the file when it is closed anyway.
+      return Env::ReuseWritableFile(filename, old_filename, options, result);
+    }
+    Status status = RenameFile(old_filename, filename);
+    if (!status.ok()) {
+      *result = nullptr;
+      return status;
+    }
+    int fd = ::open(filename.c_str(), O_WRONLY | kOpenBaseFlags, 0644);
+    if (fd < 0) {
+      *result = nullptr;
+      return PosixError(filename, errno);
+    }
+
+    *result = new PosixWritableFile(filename, fd);
+    return Status::OK();
+  }
+
   Status NewAppendableFile(const std::string& filename,
                            WritableFile** result) override {
     int fd = ::open(filename.c_str(),
@@ -749,6 +1286,8 @@ class PosixEnv : public Env {
   PosixLockTable locks_;  // Thread-safe.
   Limiter mmap_limiter_;  // Thread-safe.
   Limiter fd_limiter_;    // Thread-safe.
+
+  AlignedBufferPool direct_io_buffers_;  // Thread-safe.
 };
 
 // Return the maximum number of concurrent mmaps.
@@ -783,7 +1322,9 @@ PosixEnv::PosixEnv()
     : background_work_cv_(&background_work_mutex_),
       started_background_thread_(false),
       mmap_limiter_(MaxMmaps()),
-      fd_limiter_(MaxOpenFiles()) {}
+      fd_limiter_(MaxOpenFiles()),
+      direct_io_buffers_(kDirectIOAlignment, kWritableFileBufferSize,
+                         kMaxFreeDirectIOBuffers) {}
 
 void PosixEnv::Schedule(
     void (*background_work_function)(void* background_work_arg),
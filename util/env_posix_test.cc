@@ -212,6 +212,105 @@ TEST_F(EnvPosixTest, TestOpenOnRead) {
   ASSERT_LEVELDB_OK(env_->RemoveFile(test_file));
 }
 
+TEST_F(EnvPosixTest, TestMultiRead) {
+  std::string test_dir;
+  ASSERT_LEVELDB_OK(env_->GetTestDirectory(&test_dir));
+  std::string test_file = test_dir + "/multi_read.txt";
+  std::string data;
+  for (int i = 0; data.size() < 100000; i++) {
+    data.append(std::to_string(i));
+  }
+  ASSERT_LEVELDB_OK(WriteStringToFile(env_, data, test_file));
+
+  FileOptions file_options;
+  file_options.allow_mmap_reads = false;
+  leveldb::RandomAccessFile* file;
+  ASSERT_LEVELDB_OK(env_->NewRandomAccessFile(test_file, file_options, &file));
+
+  // More requests than fit in one submission, plus a read past the end.
+  const int kNumReads = 200;
+  const size_t kReadSize = 500;
+  std::vector<char> scratch((kNumReads + 1) * kReadSize);
+  std::vector<RandomAccessFile::ReadRequest> reqs(kNumReads + 1);
+  for (int i = 0; i < kNumReads; i++) {
+    reqs[i].offset = (i * 7919) % (data.size() - kReadSize);
+    reqs[i].n = kReadSize;
+    reqs[i].scratch = &scratch[i * kReadSize];
+  }
+  reqs[kNumReads].offset = data.size() + 10;
+  reqs[kNumReads].n = kReadSize;
+  reqs[kNumReads].scratch = &scratch[kNumReads * kReadSize];
+  file->MultiRead(reqs.data(), reqs.size());
+
+  for (int i = 0; i < kNumReads; i++) {
+    ASSERT_LEVELDB_OK(reqs[i].status);
+    ASSERT_EQ(data.substr(reqs[i].offset, kReadSize),
+              reqs[i].result.ToString());
+  }
+  ASSERT_LEVELDB_OK(reqs[kNumReads].status);
+  ASSERT_EQ(0, reqs[kNumReads].result.size());
+
+  delete file;
+  ASSERT_LEVELDB_OK(env_->RemoveFile(test_file));
+}
+
+TEST_F(EnvPosixTest, TestDirectIO) {
+  std::string test_dir;
+  ASSERT_LEVELDB_OK(env_->GetTestDirectory(&test_dir));
+  std::string test_file = test_dir + "/direct_io.txt";
+  std::string data;
+  for (int i = 0; data.size() < 300000; i++) {
+    data.append(std::to_string(i));
+  }
+
+  FileOptions file_options;
+  file_options.use_direct_io = true;
+  WritableFile* writable_file;
+  ASSERT_LEVELDB_OK(
+      env_->NewWritableFile(test_file, file_options, &writable_file));
+  // Unaligned appends, with syncs that write partial pages.
+  for (size_t pos = 0; pos < data.size(); pos += 7001) {
+    ASSERT_LEVELDB_OK(writable_file->Append(data.substr(pos, 7001)));
+    if (pos % 3 == 0) {
+      ASSERT_LEVELDB_OK(writable_file->Sync());
+    }
+  }
+  ASSERT_LEVELDB_OK(writable_file->Close());
+  delete writable_file;
+
+  std::string contents;
+  ASSERT_LEVELDB_OK(ReadFileToString(env_, test_file, &contents));
+  ASSERT_EQ(data, contents);
+
+  RandomAccessFile* file;
+  ASSERT_LEVELDB_OK(env_->NewRandomAccessFile(test_file, file_options, &file));
+  char scratch[10000];
+  Slice result;
+  ASSERT_LEVELDB_OK(file->Read(4095, 5000, &result, scratch));
+  ASSERT_EQ(data.substr(4095, 5000), result.ToString());
+  ASSERT_LEVELDB_OK(file->Read(data.size() - 10, 100, &result, scratch));
+  ASSERT_EQ(data.substr(data.size() - 10), result.ToString());
+
+  const int kNumReads = 100;
+  const size_t kReadSize = 3000;
+  std::vector<char> multi_scratch(kNumReads * kReadSize);
+  std::vector<RandomAccessFile::ReadRequest> reqs(kNumReads);
+  for (int i = 0; i < kNumReads; i++) {
+    reqs[i].offset = (i * 7919) % (data.size() - kReadSize);
+    reqs[i].n = kReadSize;
+    reqs[i].scratch = &multi_scratch[i * kReadSize];
+  }
+  file->MultiRead(reqs.data(), reqs.size());
+  for (int i = 0; i < kNumReads; i++) {
+    ASSERT_LEVELDB_OK(reqs[i].status);
+    ASSERT_EQ(data.substr(reqs[i].offset, kReadSize),
+              reqs[i].result.ToString());
+  }
+
+  delete file;
+  ASSERT_LEVELDB_OK(env_->RemoveFile(test_file));
+}
+
 #if HAVE_O_CLOEXEC
 
 TEST_F(EnvPosixTest, TestCloseOnExecSequentialFile) {
@@ -0,0 +1,81 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/frequency_sketch.h"
+
+namespace leveldb {
+
+static const uint32_t kRowSeeds[] = {0x97cb3127, 0xb492b66f, 0x9ae16a3b,
+                                     0xcbf29ce5};
+
+FrequencySketch::FrequencySketch(size_t expected_entries)
+    : additions_(0) {
+  if (expected_entries < 64) {
+    expected_entries = 64;
+  }
+  size_t num_counters = 64;
+  while (num_counters < expected_entries * 16) {
+    num_counters <<= 1;
+  }
+  words_ = new std::atomic<uint64_t>[num_counters / 16];
+  for (size_t i = 0; i < num_counters / 16; i++) {
+    words_[i].store(0, std::memory_order_relaxed);
+  }
+  counter_mask_ = num_counters - 1;
+  sample_size_ = expected_entries * 10;
+}
+
+FrequencySketch::~FrequencySketch() { delete[] words_; }
+
+size_t FrequencySketch::CounterIndex(uint32_t hash, int row) const {
+  uint32_t h = hash * kRowSeeds[row];
+  h ^= h >> 15;
+  return h & counter_mask_;
+}
+
+void FrequencySketch::Increment(uint32_t hash) {
+  bool incremented = false;
+  for (int row = 0; row < kDepth; row++) {
+    const size_t index = CounterIndex(hash, row);
+    std::atomic<uint64_t>& word = words_[index / 16];
+    const int shift = (index % 16) * 4;
+    uint64_t w = word.load(std::memory_order_relaxed);
+    while (((w >> shift) & 0xf) != 0xf) {
+      if (word.compare_exchange_weak(w, w + (uint64_t{1} << shift),
+                                     std::memory_order_relaxed)) {
+        incremented = true;
+        break;
+      }
+    }
+  }
+  if (incremented && additions_.fetch_add(1, std::memory_order_relaxed) + 1 ==
+                         sample_size_) {
+    Halve();
+  }
+}
+
+int FrequencySketch::Estimate(uint32_t hash) const {
+  int result = 15;
+  for (int row = 0; row < kDepth; row++) {
+    const size_t index = CounterIndex(hash, row);
+    const uint64_t w = words_[index / 16].load(std::memory_order_relaxed);
+    const int count = static_cast<int>((w >> ((index % 16) * 4)) & 0xf);
+    if (count < result) {
+      result = count;
+    }
+  }
+  return result;
+}
+
+void FrequencySketch::Halve() {
+  for (size_t i = 0; i <= counter_mask_ / 16; i++) {
+    uint64_t w = words_[i].load(std::memory_order_relaxed);
+    while (!words_[i].compare_exchange_weak(
+        w, (w >> 1) & 0x7777777777777777ull, std::memory_order_relaxed)) {
+    }
+  }
+  additions_.fetch_sub(sample_size_ / 2, std::memory_order_relaxed);
+}
+
+}  // namespace leveldb
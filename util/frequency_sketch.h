@@ -0,0 +1,52 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_UTIL_FREQUENCY_SKETCH_H_
+#define STORAGE_LEVELDB_UTIL_FREQUENCY_SKETCH_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace leveldb {
+
+// A count-min sketch of 4-bit counters that estimates how often each key
+// hash was seen recently, as used by the TinyLFU admission policy.  All
+// counters are halved after every 10 * expected_entries increments so
+// that old popularity fades.
+//
+// Safe for concurrent use without external synchronization; concurrent
+// updates may occasionally be lost, which only makes the estimates a
+// little less precise.
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(size_t expected_entries);
+  ~FrequencySketch();
+
+  FrequencySketch(const FrequencySketch&) = delete;
+  FrequencySketch& operator=(const FrequencySketch&) = delete;
+
+  // Records one access to "hash".
+  void Increment(uint32_t hash);
+
+  // Returns the estimated number of recent accesses to "hash", at most 15.
+  int Estimate(uint32_t hash) const;
+
+ private:
+  static const int kDepth = 4;
+
+  // Returns the index of the counter for "hash" in the given row.
+  size_t CounterIndex(uint32_t hash, int row) const;
+
+  void Halve();
+
+  std::atomic<uint64_t>* words_;  // 16 counters per word
+  size_t counter_mask_;
+  size_t sample_size_;
+  std::atomic<size_t> additions_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_FREQUENCY_SKETCH_H_
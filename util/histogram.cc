@@ -4,6 +4,7 @@
 
 #include "util/histogram.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 
@@ -179,13 +180,16 @@ void Histogram::Clear() {
   }
 }
 
+int Histogram::BucketFor(double value) {
+  // The last bucket takes everything beyond the second to last limit.
+  return static_cast<int>(std::upper_bound(kBucketLimit,
+                                           kBucketLimit + kNumBuckets - 1,
+                                           value) -
+                          kBucketLimit);
+}
+
 void Histogram::Add(double value) {
-  // Linear search is fast enough for our usage in db_bench
-  int b = 0;
-  while (b < kNumBuckets - 1 && kBucketLimit[b] <= value) {
-    b++;
-  }
-  buckets_[b] += 1.0;
+  buckets_[BucketFor(value)] += 1.0;
   if (min_ > value) min_ = value;
   if (max_ < value) max_ = value;
   num_++;
@@ -194,13 +198,19 @@ void Histogram::Add(double value) {
 }
 
 void Histogram::Merge(const Histogram& other) {
-  if (other.min_ < min_) min_ = other.min_;
-  if (other.max_ > max_) max_ = other.max_;
-  num_ += other.num_;
-  sum_ += other.sum_;
-  sum_squares_ += other.sum_squares_;
+  Merge(other.min_, other.max_, other.num_, other.sum_, other.sum_squares_,
+        other.buckets_);
+}
+
+void Histogram::Merge(double min, double max, double num, double sum,
+                      double sum_squares, const double* buckets) {
+  if (min < min_) min_ = min;
+  if (max > max_) max_ = max;
+  num_ += num;
+  sum_ += sum;
+  sum_squares_ += sum_squares;
   for (int b = 0; b < kNumBuckets; b++) {
-    buckets_[b] += other.buckets_[b];
+    buckets_[b] += buckets[b];
   }
 }
 
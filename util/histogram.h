@@ -18,16 +18,26 @@ class Histogram {
   void Add(double value);
   void Merge(const Histogram& other);
 
-  std::string ToString() const;
-
- private:
   enum { kNumBuckets = 154 };
 
+  // Return the index of the bucket that Add(value) counts "value" in.
+  static int BucketFor(double value);
+
+  // Add samples that were tallied elsewhere with BucketFor().  "buckets"
+  // holds kNumBuckets counts; the other arguments cover all the samples.
+  void Merge(double min, double max, double num, double sum,
+             double sum_squares, const double* buckets);
+
+  double Count() const { return num_; }
+  double Max() const { return max_; }
   double Median() const;
   double Percentile(double p) const;
   double Average() const;
   double StandardDeviation() const;
 
+  std::string ToString() const;
+
+ private:
   static const double kBucketLimit[kNumBuckets];
 
   double min_;
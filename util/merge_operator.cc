@@ -0,0 +1,68 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/merge_operator.h"
+
+#include "leveldb/slice.h"
+#include "util/coding.h"
+
+namespace leveldb {
+
+MergeOperator::~MergeOperator() = default;
+
+bool MergeOperator::PartialMerge(const Slice& key, const Slice& left,
+                                 const Slice& right,
+                                 std::string* new_value) const {
+  return false;
+}
+
+namespace {
+
+class UInt64AddOperator : public MergeOperator {
+ public:
+  const char* Name() const override { return "leveldb.UInt64AddOperator"; }
+
+  bool FullMerge(const Slice& key, const Slice* existing_value,
+                 const std::vector<Slice>& operands,
+                 std::string* new_value) const override {
+    uint64_t sum = 0;
+    if (existing_value != nullptr && !Add(*existing_value, &sum)) {
+      return false;
+    }
+    for (const Slice& operand : operands) {
+      if (!Add(operand, &sum)) {
+        return false;
+      }
+    }
+    new_value->clear();
+    PutFixed64(new_value, sum);
+    return true;
+  }
+
+  bool PartialMerge(const Slice& key, const Slice& left, const Slice& right,
+                    std::string* new_value) const override {
+    uint64_t sum = 0;
+    if (!Add(left, &sum) || !Add(right, &sum)) {
+      return false;
+    }
+    new_value->clear();
+    PutFixed64(new_value, sum);
+    return true;
+  }
+
+ private:
+  static bool Add(const Slice& value, uint64_t* sum) {
+    if (value.size() != 8) {
+      return false;
+    }
+    *sum += DecodeFixed64(value.data());
+    return true;
+  }
+};
+
+}  // namespace
+
+const MergeOperator* NewUInt64AddOperator() { return new UInt64AddOperator; }
+
+}  // namespace leveldb
@@ -1,60 +1,63 @@
 #include "my_log.h"
-namespace leveldb {
-void init_log_file() {
-  FILE* fp;
-#ifdef LZW_INFO
-  fp = fopen(log_file1.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  fclose(fp);
-  RECORD_INFO(1, "now,bw,iops,size,average bw,average iops\n");
 
-  fp = fopen(log_file2.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  fclose(fp);
+#include <sys/stat.h>
 
-  fp = fopen(log_file3.c_str(), "w");
-  if(fp == nullptr) printf("log failed\n");
-  fclose(fp);
-  RECORD_INFO(3, "relative_start,relative_end,time\n");
-
-  fp = fopen(log_file4.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  RECORD_INFO(4, "relative_start,relative_end,time\n");
-  fclose(fp);
-
-  fp = fopen(log_file5.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  RECORD_INFO(5, "relative_start,relative_end,time\n");
-  fclose(fp);
+#include <cstdio>
 
-  fp = fopen(log_file6.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  RECORD_INFO(6, "relative_start,relative_end,time\n");
-  fclose(fp);
-
-  fp = fopen(log_file7.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  RECORD_INFO(7, "relative_start,relative_end,time\n");
-  fclose(fp);
+namespace leveldb {
 
-  fp = fopen(log_file8.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  RECORD_INFO(8, "relative_start,relative_end,time\n");
-  fclose(fp);
+static std::string log_dir = "./perf_log";
 
-  fp = fopen(log_file9.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  RECORD_INFO(9, "relative_time\n");
-  fclose(fp);
+static std::string LogFilePath(int file_num) {
+  return log_dir + "/" + kLogFileNames[file_num];
+}
 
-  fp = fopen(log_file10.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
+// Truncates trace file "file_num".  Reports the failure and returns
+// false if the file cannot be opened.
+static bool ResetLogFile(int file_num) {
+  const std::string path = LogFilePath(file_num);
+  FILE* fp = fopen(path.c_str(), "w");
+  if (fp == nullptr) {
+    fprintf(stderr, "cannot open trace file %s\n", path.c_str());
+    return false;
+  }
   fclose(fp);
+  return true;
+}
 
-  fp = fopen(log_file11.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  RECORD_INFO(11, "relative_start,relative_end,time\n");
-  fclose(fp);
+void init_log_file(const std::string& dir) {
+  log_dir = dir;
+  mkdir(log_dir.c_str(), 0755);
+#ifdef LZW_INFO
+  if (ResetLogFile(1)) {
+    RECORD_INFO(1, "now,bw,iops,size,average bw,average iops\n");
+  }
+  ResetLogFile(2);
+  if (ResetLogFile(3)) {
+    RECORD_INFO(3, "relative_start,relative_end,time\n");
+  }
+  if (ResetLogFile(4)) {
+    RECORD_INFO(4, "relative_start,relative_end,time\n");
+  }
+  if (ResetLogFile(5)) {
+    RECORD_INFO(5, "relative_start,relative_end,time\n");
+  }
+  if (ResetLogFile(6)) {
+    RECORD_INFO(6, "relative_start,relative_end,time\n");
+  }
+  if (ResetLogFile(7)) {
+    RECORD_INFO(7, "relative_start,relative_end,time\n");
+  }
+  if (ResetLogFile(8)) {
+    RECORD_INFO(8, "relative_start,relative_end,time\n");
+  }
+  if (ResetLogFile(9)) {
+    RECORD_INFO(9, "relative_time\n");
+  }
+  ResetLogFile(10);
+  if (ResetLogFile(11)) {
+    RECORD_INFO(11, "relative_start,relative_end,time\n");
+  }
 
   // fp = fopen(log_file4.c_str(), "w");
   // if(fp == nullptr) printf("log failed\n");
@@ -68,13 +71,8 @@ void init_log_file() {
 #endif
 
 #ifdef LZW_DEBUG
-  fp = fopen(log_file0.c_str(), "w");
-  if (fp == nullptr) printf("log failed\n");
-  fclose(fp);
-
+  ResetLogFile(0);
 #endif
-
-
 }
 
 void LZW_LOG(int file_num, const char* format, ...) {
@@ -84,50 +82,16 @@ void LZW_LOG(int file_num, const char* format, ...) {
   vsprintf(buf, format, ap);
   va_end(ap);
 
-  const std::string* log_file;
-  switch (file_num) {
-    case 0:
-      log_file = &log_file0;
-      break;
-    case 1:
-      log_file = &log_file1;
-      break;
-    case 2:
-      log_file = &log_file2;
-      break;
-    case 3:
-      log_file = &log_file3;
-      break;
-    case 4:
-      log_file = &log_file4;
-      break;
-    case 5:
-      log_file = &log_file5;
-      break;
-    case 6:
-      log_file = &log_file6;
-      break;
-    case 7:
-      log_file = &log_file7;
-      break;
-    case 8:
-      log_file = &log_file8;
-      break;
-    case 9:
-      log_file = &log_file9;
-      break;
-    case 10:
-      log_file = &log_file10;
-      break;
-    case 11:
-      log_file = &log_file11;
-      break;
-    default:
-      return;
+  if (file_num < 0 || file_num >= kNumLogFiles) {
+    return;
   }
 
-  FILE* fp = fopen(log_file->c_str(), "a");
-  if (fp == nullptr) printf("log failed\n");
+  const std::string path = LogFilePath(file_num);
+  FILE* fp = fopen(path.c_str(), "a");
+  if (fp == nullptr) {
+    fprintf(stderr, "cannot open trace file %s\n", path.c_str());
+    return;
+  }
   fprintf(fp, "%s", buf);
   fclose(fp);
 }
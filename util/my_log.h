@@ -31,23 +31,26 @@ namespace leveldb {
 #endif
 
 
-const std::string log_file0(".//perf_log//RUN_LOG");
-const std::string log_file1(".//perf_log//OP_TIME.csv");
-const std::string log_file2(".//perf_log//OP_DATA");
-const std::string log_file3(".//perf_log//STALL_SLEEP.csv");
-const std::string log_file4(".//perf_log//STALL_MINOR_COMPACTION.csv");
-const std::string log_file5(".//perf_log//STALL_MAJOR_COMPACTION.csv");
-const std::string log_file6(".//perf_log//BACKGROUND_MINOR_COMPACTION.csv");
-const std::string log_file7(".//perf_log//BACKGROUND_MAJOR_COMPACTION.csv");
-const std::string log_file8(".//perf_log//BACKGROUND_COMPACTION.csv");
-const std::string log_file9(".//perf_log//SWITCH_MEMTABLE.csv");
-const std::string log_file10(".//perf_log//PERF_LOG");
-const std::string log_file11(".//perf_log//BACKGROUND_MAJOR_INNER_MINOR_COMPACTION.csv");
-// const std::string log_file4("Latency.csv");
-// const std::string log_file5("PerSecondLatency.csv");
-
-
-extern void init_log_file();
+// Trace files written by RECORD_INFO(file_num, ...), indexed by file_num
+// and kept in the directory passed to init_log_file().
+const char* const kLogFileNames[] = {
+    "RUN_LOG",
+    "OP_TIME.csv",
+    "OP_DATA",
+    "STALL_SLEEP.csv",
+    "STALL_MINOR_COMPACTION.csv",
+    "STALL_MAJOR_COMPACTION.csv",
+    "BACKGROUND_MINOR_COMPACTION.csv",
+    "BACKGROUND_MAJOR_COMPACTION.csv",
+    "BACKGROUND_COMPACTION.csv",
+    "SWITCH_MEMTABLE.csv",
+    "PERF_LOG",
+    "BACKGROUND_MAJOR_INNER_MINOR_COMPACTION.csv"};
+const int kNumLogFiles = sizeof(kLogFileNames) / sizeof(kLogFileNames[0]);
+
+// Create "dir" if needed and truncate the trace files in it.  Until this
+// is called, traces go to ./perf_log.
+extern void init_log_file(const std::string& dir = "./perf_log");
 
 extern void LZW_LOG(int file_num,const char* format, ...);
 
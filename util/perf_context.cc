@@ -0,0 +1,99 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/perf_context.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "db/dbformat.h"
+#include "util/perf_context_imp.h"
+
+namespace leveldb {
+
+static_assert(kPerfContextLevels == config::kNumLevels,
+              "PerfContext keeps one timer per level");
+
+thread_local PerfLevel perf_level = kPerfDisabled;
+thread_local PerfContext perf_context;
+thread_local IOStatsContext iostats_context;
+
+void SetPerfLevel(PerfLevel level) { perf_level = level; }
+
+PerfLevel GetPerfLevel() { return perf_level; }
+
+PerfContext* GetPerfContext() { return &perf_context; }
+
+IOStatsContext* GetIOStatsContext() { return &iostats_context; }
+
+namespace {
+
+void AppendCounter(std::string* r, const char* name, uint64_t value,
+                   bool exclude_zero_counters) {
+  if (exclude_zero_counters && value == 0) {
+    return;
+  }
+  char buf[100];
+  std::snprintf(buf, sizeof(buf), "%s = %" PRIu64 ", ", name, value);
+  r->append(buf);
+}
+
+// Drop the separator after the last counter.
+std::string Finish(std::string r) {
+  if (r.size() >= 2) {
+    r.resize(r.size() - 2);
+  }
+  return r;
+}
+
+}  // namespace
+
+void PerfContext::Reset() { *this = PerfContext(); }
+
+std::string PerfContext::ToString(bool exclude_zero_counters) const {
+  std::string r;
+  const bool z = exclude_zero_counters;
+  AppendCounter(&r, "db_mutex_lock_nanos", db_mutex_lock_nanos, z);
+  AppendCounter(&r, "get_from_memtable_nanos", get_from_memtable_nanos, z);
+  AppendCounter(&r, "get_from_imm_nanos", get_from_imm_nanos, z);
+  AppendCounter(&r, "get_from_memtable_count", get_from_memtable_count, z);
+  AppendCounter(&r, "get_from_nvm_memtable_nanos",
+                get_from_nvm_memtable_nanos, z);
+  AppendCounter(&r, "get_from_output_files_nanos",
+                get_from_output_files_nanos, z);
+  for (int level = 0; level < kPerfContextLevels; level++) {
+    char name[50];
+    std::snprintf(name, sizeof(name), "get_from_level%d_nanos", level);
+    AppendCounter(&r, name, get_from_level_nanos[level], z);
+  }
+  AppendCounter(&r, "table_files_searched_count", table_files_searched_count,
+                z);
+  AppendCounter(&r, "find_table_nanos", find_table_nanos, z);
+  AppendCounter(&r, "row_cache_hit_count", row_cache_hit_count, z);
+  AppendCounter(&r, "block_cache_hit_count", block_cache_hit_count, z);
+  AppendCounter(&r, "secondary_cache_hit_count", secondary_cache_hit_count,
+                z);
+  AppendCounter(&r, "block_read_count", block_read_count, z);
+  AppendCounter(&r, "block_read_byte", block_read_byte, z);
+  AppendCounter(&r, "block_read_nanos", block_read_nanos, z);
+  AppendCounter(&r, "filter_check_nanos", filter_check_nanos, z);
+  AppendCounter(&r, "bloom_filter_useful", bloom_filter_useful, z);
+  return Finish(r);
+}
+
+void IOStatsContext::Reset() { *this = IOStatsContext(); }
+
+std::string IOStatsContext::ToString(bool exclude_zero_counters) const {
+  std::string r;
+  const bool z = exclude_zero_counters;
+  AppendCounter(&r, "bytes_read", bytes_read, z);
+  AppendCounter(&r, "read_nanos", read_nanos, z);
+  AppendCounter(&r, "bytes_written", bytes_written, z);
+  AppendCounter(&r, "write_nanos", write_nanos, z);
+  AppendCounter(&r, "fsync_nanos", fsync_nanos, z);
+  AppendCounter(&r, "open_nanos", open_nanos, z);
+  return Finish(r);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,62 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Helpers for filling in the thread-local PerfContext and IOStatsContext.
+// Each one checks the perf level of the calling thread first, so they cost
+// a thread-local load when collection is off.
+
+#ifndef STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
+#define STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "leveldb/perf_context.h"
+
+namespace leveldb {
+
+extern thread_local PerfLevel perf_level;
+extern thread_local PerfContext perf_context;
+extern thread_local IOStatsContext iostats_context;
+
+inline void PerfCount(uint64_t* counter, uint64_t n = 1) {
+  if (perf_level >= kPerfEnableCount) {
+    *counter += n;
+  }
+}
+
+// Adds the time from its construction until Stop() or its destruction,
+// whichever comes first, to *timer.
+class PerfTimer {
+ public:
+  explicit PerfTimer(uint64_t* timer)
+      : timer_(perf_level >= kPerfEnableTime ? timer : nullptr),
+        start_(timer_ != nullptr ? NowNanos() : 0) {}
+
+  PerfTimer(const PerfTimer&) = delete;
+  PerfTimer& operator=(const PerfTimer&) = delete;
+
+  ~PerfTimer() { Stop(); }
+
+  void Stop() {
+    if (timer_ != nullptr) {
+      *timer_ += NowNanos() - start_;
+      timer_ = nullptr;
+    }
+  }
+
+ private:
+  static uint64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  uint64_t* timer_;
+  const uint64_t start_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
@@ -0,0 +1,138 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+RateLimiter::~RateLimiter() = default;
+
+namespace {
+
+// Rate of an auto-tuned limiter at full pressure, relative to its base rate.
+constexpr double kMaxAutoTunedSpeedup = 8.0;
+
+// An idle limiter saves up at most this much time's worth of bytes.
+constexpr double kMaxBurstSeconds = 0.1;
+
+// Longest single sleep, well within the int taken by SleepForMicroseconds().
+constexpr double kMaxSleepMicros = 1e6;
+
+// Tokens accrue continuously at the current rate.  A request takes its bytes
+// even if that leaves the bucket in debt, and then sleeps until the debt
+// would be paid off; later requests queue up behind it that way.
+class GenericRateLimiter : public RateLimiter {
+ public:
+  GenericRateLimiter(int64_t bytes_per_second, bool auto_tuned)
+      : env_(Env::Default()),
+        auto_tuned_(auto_tuned),
+        base_rate_(bytes_per_second),
+        rate_(bytes_per_second),
+        available_(0),
+        last_refill_micros_(env_->NowMicros()),
+        total_bytes_through_(0) {
+    assert(bytes_per_second > 0);
+  }
+
+  void Request(int64_t bytes) override {
+    double wait_seconds = 0;
+    {
+      MutexLock l(&mu_);
+      Refill();
+      available_ -= bytes;
+      total_bytes_through_ += bytes;
+      if (available_ < 0) {
+        wait_seconds = -available_ / rate_;
+      }
+    }
+    // A large request at a low rate may have to wait longer than one
+    // sleep can last.
+    double wait_micros = wait_seconds * 1e6;
+    while (wait_micros >= 1) {
+      const double step = std::min(wait_micros, kMaxSleepMicros);
+      env_->SleepForMicroseconds(static_cast<int>(step));
+      wait_micros -= step;
+    }
+  }
+
+  void SetBytesPerSecond(int64_t bytes_per_second) override {
+    assert(bytes_per_second > 0);
+    MutexLock l(&mu_);
+    Refill();
+    base_rate_ = bytes_per_second;
+    UpdateRate();
+  }
+
+  int64_t GetBytesPerSecond() const override {
+    MutexLock l(&mu_);
+    return static_cast<int64_t>(rate_);
+  }
+
+  int64_t GetTotalBytesThrough() const override {
+    MutexLock l(&mu_);
+    return total_bytes_through_;
+  }
+
+  void SetCompactionPressure(const void* db, double pressure) override {
+    if (!auto_tuned_) {
+      return;
+    }
+    MutexLock l(&mu_);
+    Refill();
+    if (pressure > 0) {
+      pressures_[db] = std::min(pressure, 1.0);
+    } else {
+      pressures_.erase(db);
+    }
+    UpdateRate();
+  }
+
+ private:
+  // Adds the tokens accrued since the last refill at the current rate.
+  void Refill() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const uint64_t now = env_->NowMicros();
+    if (now > last_refill_micros_) {
+      available_ = std::min(
+          available_ + (now - last_refill_micros_) * 1e-6 * rate_,
+          kMaxBurstSeconds * rate_);
+      last_refill_micros_ = now;
+    }
+  }
+
+  void UpdateRate() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    double pressure = 0;
+    for (const auto& kv : pressures_) {
+      pressure = std::max(pressure, kv.second);
+    }
+    rate_ = base_rate_ * (1 + (kMaxAutoTunedSpeedup - 1) * pressure);
+  }
+
+  Env* const env_;
+  const bool auto_tuned_;
+
+  mutable port::Mutex mu_;
+  double base_rate_ GUARDED_BY(mu_);
+  double rate_ GUARDED_BY(mu_);       // Bytes per second.
+  double available_ GUARDED_BY(mu_);  // Negative while in debt.
+  uint64_t last_refill_micros_ GUARDED_BY(mu_);
+  int64_t total_bytes_through_ GUARDED_BY(mu_);
+  std::map<const void*, double> pressures_ GUARDED_BY(mu_);  // Non-zero only.
+};
+
+}  // namespace
+
+RateLimiter* NewGenericRateLimiter(int64_t bytes_per_second, bool auto_tuned) {
+  return new GenericRateLimiter(bytes_per_second, auto_tuned);
+}
+
+}  // namespace leveldb
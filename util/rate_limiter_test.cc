@@ -0,0 +1,70 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "leveldb/env.h"
+
+namespace leveldb {
+
+TEST(RateLimiterTest, Throttles) {
+  RateLimiter* limiter = NewGenericRateLimiter(1 << 20);
+  Env* env = Env::Default();
+  const uint64_t start = env->NowMicros();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([limiter]() {
+      for (int j = 0; j < 8; j++) {
+        limiter->Request(16 << 10);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  // 512KB at 1MB/s.
+  ASSERT_GE(env->NowMicros() - start, 450000);
+  ASSERT_EQ(512 << 10, limiter->GetTotalBytesThrough());
+  delete limiter;
+}
+
+TEST(RateLimiterTest, SetBytesPerSecond) {
+  RateLimiter* limiter = NewGenericRateLimiter(1 << 20);
+  ASSERT_EQ(1 << 20, limiter->GetBytesPerSecond());
+  limiter->SetBytesPerSecond(2 << 20);
+  ASSERT_EQ(2 << 20, limiter->GetBytesPerSecond());
+
+  // Reports are ignored unless the limiter is auto-tuned.
+  int db;
+  limiter->SetCompactionPressure(&db, 1.0);
+  ASSERT_EQ(2 << 20, limiter->GetBytesPerSecond());
+  delete limiter;
+}
+
+TEST(RateLimiterTest, AutoTuned) {
+  RateLimiter* limiter = NewGenericRateLimiter(1000, true);
+  int db1, db2;
+  limiter->SetCompactionPressure(&db1, 0.5);
+  ASSERT_EQ(4500, limiter->GetBytesPerSecond());
+  limiter->SetCompactionPressure(&db2, 2.0);
+  ASSERT_EQ(8000, limiter->GetBytesPerSecond());
+  limiter->SetCompactionPressure(&db2, 0);
+  ASSERT_EQ(4500, limiter->GetBytesPerSecond());
+  limiter->SetBytesPerSecond(2000);
+  ASSERT_EQ(9000, limiter->GetBytesPerSecond());
+  limiter->SetCompactionPressure(&db1, 0);
+  ASSERT_EQ(2000, limiter->GetBytesPerSecond());
+  delete limiter;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
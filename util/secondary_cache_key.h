@@ -0,0 +1,34 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_UTIL_SECONDARY_CACHE_KEY_H_
+#define STORAGE_LEVELDB_UTIL_SECONDARY_CACHE_KEY_H_
+
+#include <cstdint>
+#include <string>
+
+#include "leveldb/slice.h"
+#include "util/coding.h"
+
+namespace leveldb {
+
+// Cache keys are only unique within one Cache, so each cache stores its
+// entries in the secondary cache under its own keys prefixed with an id
+// that is unique within the process.  Caches sharing a SecondaryCache
+// then never see each other's entries.
+
+// Returns a new id for a cache.  Thread-safe.
+uint64_t NewSecondaryCacheId();
+
+inline std::string SecondaryCacheKey(uint64_t cache_id, const Slice& key) {
+  std::string result;
+  result.reserve(8 + key.size());
+  PutFixed64(&result, cache_id);
+  result.append(key.data(), key.size());
+  return result;
+}
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_SECONDARY_CACHE_KEY_H_
@@ -0,0 +1,282 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/statistics.h"
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#include "port/port.h"
+#include "util/histogram.h"
+
+namespace leveldb {
+
+const char* TickerName(Ticker ticker) {
+  switch (ticker) {
+    case kStallMicros:
+      return "leveldb.stall.micros";
+    case kMemtableHit:
+      return "leveldb.memtable.hit";
+    case kMemtableMiss:
+      return "leveldb.memtable.miss";
+    case kGetHitL0:
+      return "leveldb.l0.hit";
+    case kGetHitL1AndUp:
+      return "leveldb.l1andup.hit";
+    case kBloomFilterUseful:
+      return "leveldb.bloom.filter.useful";
+    case kBytesWritten:
+      return "leveldb.bytes.written";
+    case kBytesRead:
+      return "leveldb.bytes.read";
+    case kKeysWritten:
+      return "leveldb.number.keys.written";
+    case kKeysRead:
+      return "leveldb.number.keys.read";
+    case kFlushWriteBytes:
+      return "leveldb.flush.write.bytes";
+    case kCompactReadBytes:
+      return "leveldb.compact.read.bytes";
+    case kCompactWriteBytes:
+      return "leveldb.compact.write.bytes";
+    case kNvmPersists:
+      return "leveldb.nvm.persists";
+    case kTickerEnumMax:
+      break;
+  }
+  return "leveldb.unknown";
+}
+
+const char* HistogramName(HistogramType type) {
+  switch (type) {
+    case kDbGetMicros:
+      return "leveldb.db.get.micros";
+    case kDbWriteMicros:
+      return "leveldb.db.write.micros";
+    case kGetMemtableMicros:
+      return "leveldb.get.memtable.micros";
+    case kGetVersionMicros:
+      return "leveldb.get.version.micros";
+    case kWriteWalMicros:
+      return "leveldb.write.wal.micros";
+    case kWriteMemtableMicros:
+      return "leveldb.write.memtable.micros";
+    case kWriteStallMicros:
+      return "leveldb.write.stall.micros";
+    case kHistogramEnumMax:
+      break;
+  }
+  return "leveldb.unknown";
+}
+
+Statistics::~Statistics() = default;
+
+std::string Statistics::ToString() const {
+  std::string r;
+  char buf[200];
+  for (int t = 0; t < kTickerEnumMax; t++) {
+    Ticker ticker = static_cast<Ticker>(t);
+    std::snprintf(buf, sizeof(buf), "%s COUNT : %llu\n", TickerName(ticker),
+                  static_cast<unsigned long long>(GetTickerCount(ticker)));
+    r.append(buf);
+  }
+  for (int h = 0; h < kHistogramEnumMax; h++) {
+    HistogramType type = static_cast<HistogramType>(h);
+    r.append(HistogramName(type));
+    r.append(" ");
+    r.append(GetHistogramString(type));
+    r.append("\n");
+  }
+  return r;
+}
+
+namespace {
+
+// Samples of one histogram recorded on one shard.  Buckets follow the
+// layout of leveldb::Histogram so that shards can be summed into one.
+struct HistogramShard {
+  std::atomic<uint64_t> num;
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> sum_squares;
+  std::atomic<uint64_t> min;
+  std::atomic<uint64_t> max;
+  std::atomic<uint64_t> buckets[Histogram::kNumBuckets];
+
+  void Clear() {
+    num.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    sum_squares.store(0, std::memory_order_relaxed);
+    min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint64_t>& bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void Add(uint64_t value) {
+    buckets[Histogram::BucketFor(static_cast<double>(value))].fetch_add(
+        1, std::memory_order_relaxed);
+    num.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    sum_squares.fetch_add(value * value, std::memory_order_relaxed);
+    uint64_t old = min.load(std::memory_order_relaxed);
+    while (value < old &&
+           !min.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+    }
+    old = max.load(std::memory_order_relaxed);
+    while (value > old &&
+           !max.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  void MergeInto(Histogram* histogram) const {
+    const uint64_t n = num.load(std::memory_order_relaxed);
+    if (n == 0) {
+      return;
+    }
+    double counts[Histogram::kNumBuckets];
+    for (int b = 0; b < Histogram::kNumBuckets; b++) {
+      counts[b] = buckets[b].load(std::memory_order_relaxed);
+    }
+    histogram->Merge(min.load(std::memory_order_relaxed),
+                     max.load(std::memory_order_relaxed), n,
+                     sum.load(std::memory_order_relaxed),
+                     sum_squares.load(std::memory_order_relaxed), counts);
+  }
+};
+
+// Everything one CPU records.  The padding keeps the hot counters at the
+// front of a shard off the cache line that ends the previous shard.
+struct Shard {
+  std::atomic<uint64_t> tickers[kTickerEnumMax];
+  HistogramShard histograms[kHistogramEnumMax];
+  char padding[64];
+};
+
+class StatisticsImpl : public Statistics {
+ public:
+  StatisticsImpl()
+      : num_shards_(ShardCount()), shards_(new Shard[num_shards_]) {
+    Reset();
+  }
+
+  ~StatisticsImpl() override { delete[] shards_; }
+
+  void RecordTick(Ticker ticker, uint64_t count) override {
+    if (stats_level() == kStatsDisabled) {
+      return;
+    }
+    CurrentShard()->tickers[ticker].fetch_add(count,
+                                              std::memory_order_relaxed);
+  }
+
+  uint64_t GetTickerCount(Ticker ticker) const override {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < num_shards_; i++) {
+      sum += shards_[i].tickers[ticker].load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  void MeasureTime(HistogramType type, uint64_t micros) override {
+    if (stats_level() < kStatsAll) {
+      return;
+    }
+    CurrentShard()->histograms[type].Add(micros);
+  }
+
+  void GetHistogramData(HistogramType type,
+                        HistogramData* data) const override {
+    Histogram histogram;
+    histogram.Clear();
+    for (size_t i = 0; i < num_shards_; i++) {
+      shards_[i].histograms[type].MergeInto(&histogram);
+    }
+    *data = HistogramData();
+    data->count = static_cast<uint64_t>(HistogramCount(type));
+    data->sum = static_cast<uint64_t>(HistogramSum(type));
+    if (data->count > 0) {
+      data->median = histogram.Median();
+      data->percentile95 = histogram.Percentile(95.0);
+      data->percentile99 = histogram.Percentile(99.0);
+      data->percentile999 = histogram.Percentile(99.9);
+      data->max = histogram.Max();
+      data->average = histogram.Average();
+    }
+  }
+
+  std::string GetHistogramString(HistogramType type) const override {
+    HistogramData data;
+    GetHistogramData(type, &data);
+    char buf[200];
+    std::snprintf(buf, sizeof(buf),
+                  "P50 : %.2f P95 : %.2f P99 : %.2f P100 : %.2f "
+                  "COUNT : %llu SUM : %llu",
+                  data.median, data.percentile95, data.percentile99, data.max,
+                  static_cast<unsigned long long>(data.count),
+                  static_cast<unsigned long long>(data.sum));
+    return buf;
+  }
+
+  // Samples recorded while a Reset() is running may be partially lost.
+  void Reset() override {
+    for (size_t i = 0; i < num_shards_; i++) {
+      for (std::atomic<uint64_t>& ticker : shards_[i].tickers) {
+        ticker.store(0, std::memory_order_relaxed);
+      }
+      for (HistogramShard& histogram : shards_[i].histograms) {
+        histogram.Clear();
+      }
+    }
+  }
+
+ private:
+  // One shard per CPU, rounded up to a power of two.
+  static size_t ShardCount() {
+    size_t n = 1;
+    while (n < std::thread::hardware_concurrency()) {
+      n *= 2;
+    }
+    return n;
+  }
+
+  Shard* CurrentShard() {
+    int cpu = port::CurrentCpu();
+    if (cpu < 0) {
+      // Without a CPU id, spread threads over the shards instead.
+      static thread_local const size_t thread_hash =
+          std::hash<std::thread::id>()(std::this_thread::get_id());
+      return &shards_[thread_hash & (num_shards_ - 1)];
+    }
+    return &shards_[static_cast<size_t>(cpu) & (num_shards_ - 1)];
+  }
+
+  double HistogramCount(HistogramType type) const {
+    double n = 0;
+    for (size_t i = 0; i < num_shards_; i++) {
+      n += shards_[i].histograms[type].num.load(std::memory_order_relaxed);
+    }
+    return n;
+  }
+
+  double HistogramSum(HistogramType type) const {
+    double sum = 0;
+    for (size_t i = 0; i < num_shards_; i++) {
+      sum += shards_[i].histograms[type].sum.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  const size_t num_shards_;
+  Shard* const shards_;
+};
+
+}  // namespace
+
+Statistics* NewStatistics() { return new StatisticsImpl; }
+
+}  // namespace leveldb
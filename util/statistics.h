@@ -0,0 +1,56 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Helpers for recording into an optional Statistics object.
+
+#ifndef STORAGE_LEVELDB_UTIL_STATISTICS_H_
+#define STORAGE_LEVELDB_UTIL_STATISTICS_H_
+
+#include <cstdint>
+
+#include "leveldb/env.h"
+#include "leveldb/statistics.h"
+
+namespace leveldb {
+
+inline void RecordTick(Statistics* statistics, Ticker ticker,
+                       uint64_t count = 1) {
+  if (statistics != nullptr) {
+    statistics->RecordTick(ticker, count);
+  }
+}
+
+// Adds the time between its construction and its destruction to a
+// histogram.  The clock is not read at all unless "statistics" is
+// collecting timers.
+class StopWatch {
+ public:
+  StopWatch(Env* env, Statistics* statistics, HistogramType type)
+      : env_(env),
+        statistics_(statistics != nullptr &&
+                            statistics->stats_level() >= kStatsAll
+                        ? statistics
+                        : nullptr),
+        type_(type),
+        start_micros_(statistics_ != nullptr ? env->NowMicros() : 0) {}
+
+  StopWatch(const StopWatch&) = delete;
+  StopWatch& operator=(const StopWatch&) = delete;
+
+  ~StopWatch() {
+    if (statistics_ != nullptr) {
+      statistics_->MeasureTime(type_, env_->NowMicros() - start_micros_);
+    }
+  }
+
+ private:
+  Env* const env_;
+  Statistics* const statistics_;
+  const HistogramType type_;
+  const uint64_t start_micros_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_STATISTICS_H_
@@ -0,0 +1,92 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/statistics.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+TEST(StatisticsTest, Tickers) {
+  Statistics* statistics = NewStatistics();
+  ASSERT_EQ(0, statistics->GetTickerCount(kBytesWritten));
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([statistics]() {
+      for (int i = 0; i < 1000; i++) {
+        statistics->RecordTick(kBytesWritten, 3);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(12000, statistics->GetTickerCount(kBytesWritten));
+  ASSERT_EQ(0, statistics->GetTickerCount(kBytesRead));
+
+  statistics->Reset();
+  ASSERT_EQ(0, statistics->GetTickerCount(kBytesWritten));
+  delete statistics;
+}
+
+TEST(StatisticsTest, Histograms) {
+  Statistics* statistics = NewStatistics();
+  for (uint64_t micros = 1; micros <= 100; micros++) {
+    statistics->MeasureTime(kDbGetMicros, micros);
+  }
+  std::string summary = statistics->GetHistogramString(kDbGetMicros);
+  ASSERT_NE(std::string::npos, summary.find("P100 : 100.00")) << summary;
+  ASSERT_NE(std::string::npos, summary.find("COUNT : 100 SUM : 5050"))
+      << summary;
+  ASSERT_EQ(
+      "P50 : 0.00 P95 : 0.00 P99 : 0.00 P100 : 0.00 COUNT : 0 SUM : 0",
+      statistics->GetHistogramString(kDbWriteMicros));
+
+  HistogramData data;
+  statistics->GetHistogramData(kDbGetMicros, &data);
+  ASSERT_EQ(100, data.count);
+  ASSERT_EQ(5050, data.sum);
+  ASSERT_DOUBLE_EQ(50.5, data.average);
+  ASSERT_DOUBLE_EQ(100.0, data.max);
+  ASSERT_LE(data.median, data.percentile99);
+  ASSERT_LE(data.percentile99, data.percentile999);
+  statistics->GetHistogramData(kDbWriteMicros, &data);
+  ASSERT_EQ(0, data.count);
+  ASSERT_EQ(0.0, data.max);
+  statistics->MeasureTime(kDbWriteMicros, 1234567);
+  statistics->GetHistogramData(kDbWriteMicros, &data);
+  ASSERT_DOUBLE_EQ(1234567.0, data.max);
+
+  std::string all = statistics->ToString();
+  ASSERT_NE(std::string::npos, all.find("leveldb.db.get.micros P50 : "));
+  ASSERT_NE(std::string::npos, all.find("leveldb.bytes.written COUNT : 0\n"));
+  delete statistics;
+}
+
+TEST(StatisticsTest, StatsLevel) {
+  Statistics* statistics = NewStatistics();
+  statistics->set_stats_level(kStatsExceptTimers);
+  statistics->RecordTick(kKeysRead, 1);
+  statistics->MeasureTime(kDbGetMicros, 10);
+  ASSERT_EQ(1, statistics->GetTickerCount(kKeysRead));
+  ASSERT_NE(std::string::npos,
+            statistics->GetHistogramString(kDbGetMicros).find("COUNT : 0 "));
+
+  statistics->set_stats_level(kStatsDisabled);
+  statistics->RecordTick(kKeysRead, 1);
+  ASSERT_EQ(1, statistics->GetTickerCount(kKeysRead));
+  delete statistics;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}